@@ -125,6 +125,9 @@ class LowerCinnFusionOpPass : public pir::PatternRewritePass {
   LowerCinnFusionOpPass()
       : pir::PatternRewritePass("lower_cinn_fusion_op", 1) {}
 
+  // The patterns compile the groups, which is kept on one thread.
+  std::unique_ptr<pir::Pass> Clone() const override { return nullptr; }
+
   pir::RewritePatternSet InitializePatterns(pir::IrContext* context) override {
     context->GetOrRegisterDialect<cinn::dialect::RuntimeDialect>();
     context->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
@@ -164,6 +167,9 @@ class LowerCinnDyShapeFusionOpPass : public pir::PatternRewritePass {
   LowerCinnDyShapeFusionOpPass()
       : pir::PatternRewritePass("lower_cinn_dynamic_shape_fusion_op", 1) {}
 
+  // The patterns compile the groups, which is kept on one thread.
+  std::unique_ptr<pir::Pass> Clone() const override { return nullptr; }
+
   pir::RewritePatternSet InitializePatterns(pir::IrContext* context) override {
     context->GetOrRegisterDialect<cinn::dialect::RuntimeDialect>();
     context->GetOrRegisterDialect<cinn::dialect::OperatorDialect>();
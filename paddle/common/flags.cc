@@ -672,6 +672,22 @@ PHI_DEFINE_EXPORTED_bool(
     "If set true, the queue.pop will only get data from queue but not "
     "remove the data from queue for speed testing");
 
+/**
+ * Reader related FLAG
+ * Name: FLAGS_reader_pipeline_num_workers
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_reader_pipeline_num_workers=4 reads the batches of the
+ * double buffer readers on CPU through a PipelinedReader of 4 workers.
+ * Note: 0 keeps the BufferedReader. The readers on the devices always use
+ * the BufferedReader.
+ */
+PHI_DEFINE_EXPORTED_int32(
+    reader_pipeline_num_workers,
+    0,
+    "The number of workers of the PipelinedReader used by the double buffer "
+    "readers on CPU, 0 to use the BufferedReader.");
+
 /**
  * MKLDNN related FLAG
  * Name: use_mkldnn
@@ -1192,6 +1208,14 @@ PD_DEFINE_bool(enable_slotpool_wait_release,  // NOLINT
 PD_DEFINE_bool(enable_slotrecord_reset_shrink,  // NOLINT
                false,
                "enable slotrecord object reset shrink memory, default false");
+PD_DEFINE_int32(slotpool_local_cache_size,
+                1024,
+                "SlotRecordDataset slot pool per-thread cache size, "
+                "0 disables the per-thread cache");
+PD_DEFINE_int64(slotrecord_reuse_max_feasign_num,
+                65536,
+                "max feasign buffer capacity kept when a pooled slotrecord "
+                "object is reset, larger buffers are released");
 PD_DEFINE_bool(enable_ins_parser_file,  // NOLINT
                false,
                "enable parser ins file, default false");
@@ -1457,6 +1481,36 @@ PHI_DEFINE_EXPORTED_bool(dataloader_use_file_descriptor,
                          false,
                          "Use file descriptor in mmap_allocator.");
 
+/**
+ * mmap_allocator related FLAG
+ * Name: dataloader_shm_ring_arena_size
+ * Since Version: 3.0.0
+ * Value Range: int64, default=0
+ * Example: FLAGS_dataloader_shm_ring_arena_size=268435456
+ * Note: . If greater than 0, each DataLoader worker passes CPU tensors through
+ * a persistent shared memory ring arena of this size in bytes instead of
+ * creating a shared memory file per tensor.
+ */
+PHI_DEFINE_EXPORTED_int64(dataloader_shm_ring_arena_size,
+                          0,
+                          "Size of the shared memory ring arena of each "
+                          "DataLoader worker, 0 means disabled.");
+
+/**
+ * mmap_allocator related FLAG
+ * Name: dataloader_shm_ring_block_timeout
+ * Since Version: 3.0.0
+ * Value Range: int64, default=300
+ * Example: FLAGS_dataloader_shm_ring_block_timeout=600
+ * Note: The seconds a tensor pickled into the shared memory ring arena waits
+ * to be unpickled. After that the producer may reclaim its block, and
+ * unpickling it fails.
+ */
+PHI_DEFINE_EXPORTED_int64(dataloader_shm_ring_block_timeout,
+                          300,
+                          "Seconds the block of a tensor pickled into the "
+                          "shared memory ring arena is kept for unpickling.");
+
 /**
  * Tensor operants related FLAG
  * Name: tensor_operants_mode
@@ -1553,6 +1607,20 @@ PHI_DEFINE_EXPORTED_bool(pir_apply_inplace_pass,
                          "Whether to apply inplace pass on lowering "
                          "::pir::Program to Kernel Dialect");
 
+/**
+ * Combine the pattern passes of the PIR inference pipeline FLAG
+ * Name: pir_combine_pattern_passes
+ * Since Version: 3.0.0
+ * Value Range: bool, default=true
+ * Example:
+ * Note: If True, the passes of kPirCombinablePasses next to each other in
+ * the PIR inference pipeline match their patterns in one traversal.
+ */
+PHI_DEFINE_EXPORTED_bool(pir_combine_pattern_passes,
+                         true,
+                         "Whether to run the combinable pattern passes of "
+                         "the PIR inference pipeline as one pass");
+
 PHI_DEFINE_EXPORTED_string(
     ir_inplace_kernel_blacklist,
     "",
@@ -1780,6 +1848,103 @@ PHI_DEFINE_EXPORTED_int32(
     -1,
     "Max count of eliminate redundant computation in CSE, for debug usage");
 
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_eager_backward_num_threads
+ * Since Version: 3.0.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_eager_backward_num_threads=4
+ * Note: If 0, backward runs with the default engine. Otherwise backward runs
+ *       with the engine keeping the in-degrees on the grad nodes, and the
+ *       independent branches of the backward graph run on this many threads,
+ *       including the thread calling backward. Only the backward of CPU
+ *       tensors runs on more than one thread. Paddle.grad, create_graph, the
+ *       force sequential nodes and a backward called inside backward always
+ *       use the default engine.
+ */
+PHI_DEFINE_EXPORTED_int32(
+    eager_backward_num_threads,
+    0,
+    "The number of threads running the backward of dygraph, 0 to use the "
+    "default engine.");
+
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_eager_saved_tensors_compression
+ * Since Version: 3.0.0
+ * Value Range: string, {"", "zero", "bf16", "fp8"}, default=""
+ * Example: FLAGS_eager_saved_tensors_compression="zero"
+ * Note: How the cpu activations saved for backward are packed. "zero" packs
+ *       them losslessly by their zeros, "bf16" rounds the float32 ones to
+ *       bfloat16 and "fp8" scales them to float8_e4m3fn, which lose
+ *       precision.
+ */
+PHI_DEFINE_EXPORTED_string(
+    eager_saved_tensors_compression,
+    "",
+    "How the activations saved for backward are packed, one of \"\", "
+    "\"zero\", \"bf16\" and \"fp8\".");
+
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_eager_saved_tensors_memory_budget_mb
+ * Since Version: 3.0.0
+ * Value Range: int64, default=0
+ * Example: FLAGS_eager_saved_tensors_memory_budget_mb=4096
+ * Note: If positive and FLAGS_eager_saved_tensors_spill_dir is set, the cpu
+ *       activations saved for backward beyond this many MB are spilled to
+ *       the files in FLAGS_eager_saved_tensors_spill_dir, and read back ahead
+ *       of their use by backward.
+ */
+PHI_DEFINE_EXPORTED_int64(
+    eager_saved_tensors_memory_budget_mb,
+    0,
+    "The MB of the activations saved for backward kept in memory, 0 to keep "
+    "all of them.");
+
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_eager_saved_tensors_spill_dir
+ * Since Version: 3.0.0
+ * Value Range: string, default=""
+ * Example: FLAGS_eager_saved_tensors_spill_dir="/data/spill"
+ * Note: The directory of the files the activations saved for backward beyond
+ *       FLAGS_eager_saved_tensors_memory_budget_mb are spilled to. If empty,
+ *       spilling is off. It must be on a disk, a directory in memory like a
+ *       tmpfs /tmp would only move the activations from one part of the host
+ *       memory to another.
+ */
+PHI_DEFINE_EXPORTED_string(
+    eager_saved_tensors_spill_dir,
+    "",
+    "The directory on disk of the files the activations saved for backward "
+    "are spilled to, empty to not spill them.");
+
+/**
+ * Dygraph related FLAG
+ * Name: FLAGS_eager_recompute_memory_budget_mb
+ * Since Version: 3.0.0
+ * Value Range: int64, default=-1
+ * Example: FLAGS_eager_recompute_memory_budget_mb=1024
+ * Note: If not negative, once the dense activations saved for backward
+ *       exceed this many MB, the ones which are cheap to recompute by the
+ *       cost of FLAGS_eager_recompute_max_flops_per_byte are not saved, and
+ *       backward replays the forward ops producing them. 0 recomputes all of
+ *       the cheap ones. Leaves and parameters don't count, and a tensor
+ *       saved more than once counts once.
+ */
+PHI_DEFINE_EXPORTED_int64(
+    eager_recompute_memory_budget_mb,
+    -1,
+    "The MB of the activations saved for backward beyond which the cheap "
+    "ones are recomputed, -1 to save all of them.");
+
+PHI_DEFINE_EXPORTED_double(
+    eager_recompute_max_flops_per_byte,
+    8.0,
+    "The max flops per byte of an activation recomputed in backward instead "
+    "of being saved.");
+
 PHI_DEFINE_EXPORTED_bool(
     use_xqa_optim,
     false,
@@ -0,0 +1,143 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/eager/activation_recompute.h"
+
+#include "paddle/common/flags.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+COMMON_DECLARE_int64(eager_recompute_memory_budget_mb);
+COMMON_DECLARE_double(eager_recompute_max_flops_per_byte);
+
+namespace egr {
+
+namespace {
+
+const phi::DenseTensor* SavedDenseTensor(const paddle::Tensor& tensor) {
+  if (!tensor.initialized() || !tensor.is_dense_tensor()) {
+    return nullptr;
+  }
+  return static_cast<const phi::DenseTensor*>(tensor.impl().get());
+}
+
+int64_t BytesOf(const phi::DenseTensor& tensor) {
+  return tensor.numel() * static_cast<int64_t>(phi::SizeOf(tensor.dtype()));
+}
+
+}  // namespace
+
+SavedBytes::SavedBytes(const phi::Allocation* holder, int64_t bytes)
+    : holder_(holder), bytes_(bytes) {
+  auto& recompute = ActivationRecompute::Instance();
+  int64_t saved = recompute.saved_bytes_.fetch_add(bytes_) + bytes_;
+  int64_t peak = recompute.peak_saved_bytes_.load();
+  while (saved > peak &&
+         !recompute.peak_saved_bytes_.compare_exchange_weak(peak, saved)) {
+  }
+}
+
+SavedBytes::~SavedBytes() {
+  auto& recompute = ActivationRecompute::Instance();
+  recompute.saved_bytes_.fetch_sub(bytes_);
+  std::lock_guard<std::mutex> guard(recompute.mutex_);
+  auto iter = recompute.saved_holders_.find(holder_);
+  // The entry may be of a new holder at the same address already.
+  if (iter != recompute.saved_holders_.end() &&
+      iter->second.saved_bytes.expired()) {
+    recompute.saved_holders_.erase(iter);
+  }
+}
+
+ActivationRecompute& ActivationRecompute::Instance() {
+  static ActivationRecompute* recompute = new ActivationRecompute();
+  return *recompute;
+}
+
+bool ActivationRecompute::IsEnabled() {
+  return FLAGS_eager_recompute_memory_budget_mb >= 0;
+}
+
+bool ActivationRecompute::ShouldDrop(const paddle::Tensor& tensor,
+                                     double flops_per_element) const {
+  const phi::DenseTensor* dense_tensor = SavedDenseTensor(tensor);
+  // The producer writes its output contiguously from the beginning, so a
+  // view of it can't be recomputed.
+  if (flops_per_element <= 0 || dense_tensor == nullptr ||
+      !dense_tensor->meta().is_contiguous() ||
+      dense_tensor->meta().offset != 0) {
+    return false;
+  }
+  int64_t bytes = BytesOf(*dense_tensor);
+  // Dropping a tensor whose holder is saved by another wrapper saves nothing.
+  if (bytes == 0 || FindSaved(dense_tensor->Holder().get()) != nullptr ||
+      flops_per_element / static_cast<double>(phi::SizeOf(tensor.dtype())) >
+          FLAGS_eager_recompute_max_flops_per_byte) {
+    return false;
+  }
+  return saved_bytes_.load() + bytes >
+         (FLAGS_eager_recompute_memory_budget_mb << 20);
+}
+
+std::shared_ptr<SavedBytes> ActivationRecompute::FindSaved(
+    const phi::Allocation* holder) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto iter = saved_holders_.find(holder);
+  if (iter == saved_holders_.end() || iter->second.holder.expired()) {
+    return nullptr;
+  }
+  return iter->second.saved_bytes.lock();
+}
+
+std::shared_ptr<SavedBytes> ActivationRecompute::Save(
+    const paddle::Tensor& tensor) {
+  const phi::DenseTensor* dense_tensor = SavedDenseTensor(tensor);
+  if (dense_tensor == nullptr || dense_tensor->Holder() == nullptr) {
+    return nullptr;
+  }
+  const std::shared_ptr<phi::Allocation>& holder = dense_tensor->Holder();
+  std::lock_guard<std::mutex> guard(mutex_);
+  SavedHolder& saved = saved_holders_[holder.get()];
+  std::shared_ptr<SavedBytes> saved_bytes;
+  if (!saved.holder.expired()) {
+    saved_bytes = saved.saved_bytes.lock();
+  }
+  if (saved_bytes == nullptr) {
+    saved_bytes =
+        std::make_shared<SavedBytes>(holder.get(), BytesOf(*dense_tensor));
+    saved.holder = holder;
+    saved.saved_bytes = saved_bytes;
+  }
+  return saved_bytes;
+}
+
+void ActivationRecompute::RecordDrop(const paddle::Tensor& tensor) {
+  const phi::DenseTensor* dense_tensor = SavedDenseTensor(tensor);
+  if (dense_tensor != nullptr) {
+    dropped_bytes_.fetch_add(BytesOf(*dense_tensor));
+  }
+}
+
+void ActivationRecompute::RecordRecompute(int64_t numel,
+                                          double flops_per_element) {
+  recomputed_flops_.fetch_add(
+      static_cast<int64_t>(static_cast<double>(numel) * flops_per_element));
+}
+
+void ActivationRecompute::ResetStats() {
+  peak_saved_bytes_.store(saved_bytes_.load());
+  dropped_bytes_.store(0);
+  recomputed_flops_.store(0);
+}
+
+}  // namespace egr
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "paddle/phi/api/include/tensor.h"
+#include "paddle/phi/core/allocator.h"
+
+namespace egr {
+
+/**
+ * The bytes of a tensor saved by TensorWrapper, charged to the budget of
+ * ActivationRecompute until it's released. The wrappers saving the same
+ * holder share one SavedBytes.
+ * **/
+class SavedBytes {
+ public:
+  SavedBytes(const phi::Allocation* holder, int64_t bytes);
+  ~SavedBytes();
+
+  SavedBytes(const SavedBytes&) = delete;
+  SavedBytes& operator=(const SavedBytes&) = delete;
+
+ private:
+  const phi::Allocation* holder_;
+  int64_t bytes_;
+};
+
+/**
+ * ActivationRecompute decides which activations TensorWrapper doesn't save
+ * for backward, configured by
+ *
+ *   FLAGS_eager_recompute_memory_budget_mb: the MB of the dense activations
+ *   saved before the cheap ones are recomputed, -1 to save all of them.
+ *   FLAGS_eager_recompute_max_flops_per_byte: an activation is cheap if its
+ *   producer recomputes a byte of it in at most this many flops.
+ *
+ * The cost model trades the bytes of an activation for the flops replaying
+ * its producer, see GradNodeBase::RecomputeFlopsPerElement. Forward saves
+ * the activations greedily in order, and once the saved ones are over the
+ * budget the cheap ones are dropped, which backward uses first.
+ * **/
+class ActivationRecompute {
+ public:
+  static ActivationRecompute& Instance();
+
+  static bool IsEnabled();
+
+  // Whether the dense tensor, whose producer recomputes an element in
+  // flops_per_element, is dropped instead of saved.
+  bool ShouldDrop(const paddle::Tensor& tensor,
+                  double flops_per_element) const;
+
+  // Charges the bytes of a saved activation to the budget, once for all the
+  // tensors sharing its holder, null if it isn't a dense tensor. Leaves and
+  // parameters are not activations and are not charged.
+  std::shared_ptr<SavedBytes> Save(const paddle::Tensor& tensor);
+
+  // Records a dropped tensor and its recomputation by backward.
+  void RecordDrop(const paddle::Tensor& tensor);
+  void RecordRecompute(int64_t numel, double flops_per_element);
+
+  int64_t saved_bytes() const { return saved_bytes_.load(); }
+  int64_t peak_saved_bytes() const { return peak_saved_bytes_.load(); }
+  int64_t dropped_bytes() const { return dropped_bytes_.load(); }
+  int64_t recomputed_flops() const { return recomputed_flops_.load(); }
+  void ResetStats();
+
+ private:
+  friend class SavedBytes;
+
+  ActivationRecompute() = default;
+
+  // The saved holders, whose addresses may be reused once they are freed
+  struct SavedHolder {
+    std::weak_ptr<phi::Allocation> holder;
+    std::weak_ptr<SavedBytes> saved_bytes;
+  };
+  std::shared_ptr<SavedBytes> FindSaved(const phi::Allocation* holder) const;
+
+  mutable std::mutex mutex_;
+  std::unordered_map<const phi::Allocation*, SavedHolder> saved_holders_;
+  std::atomic<int64_t> saved_bytes_{0};
+  std::atomic<int64_t> peak_saved_bytes_{0};
+  std::atomic<int64_t> dropped_bytes_{0};
+  std::atomic<int64_t> recomputed_flops_{0};
+};
+
+}  // namespace egr
@@ -236,6 +236,32 @@ ATTRIBUTE_MEMBER_WITH_DEFAULT_TEMPLATE = """  {} {} = {};
 ATTRIBUTE_MEMBER_TEMPLATE = """  {} {};
 """
 
+RECOMPUTE_METHODS_TEMPLATE = """
+  double RecomputeFlopsPerElement() override {{ return {}; }}
+
+  paddle::Tensor RecomputeForwardOutput() override {{
+{}    return paddle::experimental::{}({});
+  }}
+"""
+
+RECOVER_RECOMPUTE_INPUT_TEMPLATE = """    auto {} = egr::EagerUtils::RecoverTensorWrapper(&this->{});
+"""
+
+# The flops per element of the cheap elementwise ops, whose grad nodes can
+# replay them to recompute their outputs, see FLAGS_eager_recompute_*.
+recompute_flops_per_element = {
+    "cos": 8,
+    "gelu": 16,
+    "hardswish": 4,
+    "leaky_relu": 2,
+    "mish": 24,
+    "multiply": 1,
+    "sin": 8,
+    "softplus": 16,
+    "square": 1,
+    "swish": 8,
+}
+
 NODE_DECLARATION_TEMPLATE = """
 class {} : public egr::GradNodeBase {{
  public:
@@ -257,7 +283,7 @@ class {} : public egr::GradNodeBase {{
     auto copied_node = std::shared_ptr<{}>(new {}(*this));
     return copied_node;
   }}
-
+{}
   // SetTensorWrapperX, SetTensorWrapperY, ...
 {}
   // SetAttributes
@@ -2284,6 +2310,54 @@ class DygraphNodeGenerator(DygraphFunctionGeneratorBase):
             None,
         )
 
+    def GenerateRecomputeMethods(self):
+        # The node replays its forward op only if it saves all the inputs and
+        # attributes of the op but no output, otherwise dropping the output
+        # saved by the next ops doesn't release it.
+        forward_api_name = self.forward_api_name
+        if (
+            self.namespace != ""
+            or forward_api_name not in recompute_flops_per_element
+            or len(self.forward_outputs_position_map) != 1
+        ):
+            return ""
+        backward_forward_inputs_map = self.backward_forward_inputs_map
+        backward_attr_names = [attr[0] for attr in self.backward_attrs_list]
+        call_args = {}
+        recover_inputs_str = ""
+        for name, (ttype, pos) in self.forward_inputs_position_map.items():
+            if (
+                not IsPlainTensorType(ttype)
+                or name not in backward_forward_inputs_map
+                or not backward_forward_inputs_map[name][1]
+                or name in self.no_need_buffers
+                or name in self.optional_inputs
+            ):
+                return ""
+            recover_inputs_str += RECOVER_RECOMPUTE_INPUT_TEMPLATE.format(
+                name, GetSavedName(name)
+            )
+            call_args[pos] = name
+        for name, _, _, pos in self.forward_attrs_list:
+            if name not in backward_attr_names:
+                return ""
+            call_args[pos] = f"this->{GetSavedName(name)}"
+        if any(
+            not is_fwd_input
+            for _, is_fwd_input, _ in backward_forward_inputs_map.values()
+        ):
+            return ""
+
+        call_args_str = ", ".join(
+            call_args[pos] for pos in sorted(call_args.keys())
+        )
+        return RECOMPUTE_METHODS_TEMPLATE.format(
+            recompute_flops_per_element[forward_api_name],
+            recover_inputs_str,
+            forward_api_name,
+            call_args_str,
+        )
+
     def GenerateNodeDeclaration(self):
         forward_op_name = self.forward_api_name
         backward_forward_inputs_map = self.backward_forward_inputs_map
@@ -2366,6 +2440,7 @@ class DygraphNodeGenerator(DygraphFunctionGeneratorBase):
             clear_tensor_wrapper_str,
             grad_node_name,
             grad_node_name,
+            self.GenerateRecomputeMethods(),
             set_tensor_wrapper_methods_str,
             set_attribute_methods_str,
             tensor_wrapper_members_str,
@@ -14,10 +14,21 @@
 
 #include "paddle/fluid/eager/backward.h"
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
+
+#include "paddle/common/flags.h"
 #include "paddle/fluid/eager/general_grad.h"
+#include "paddle/fluid/eager/saved_tensors_pool.h"
+#include "paddle/fluid/memory/allocation/spin_lock.h"
 #include "paddle/fluid/memory/stats.h"
 #include "paddle/phi/kernels/autotune/switch_autotune.h"
 
+COMMON_DECLARE_int32(eager_backward_num_threads);
+
 namespace egr {
 
 std::unordered_map<GradNodeBase*, int> getInDegreeMap(
@@ -102,6 +113,460 @@ void DuplicateCheck(const std::vector<paddle::Tensor>& inputs, bool is_input) {
 
 GeneralGrad* GeneralGrad::general_grad_ = new GeneralGrad();
 
+namespace {
+
+// A free list of the GradTensorHolders of the backward engine, so that the
+// buffers of the holders are reused by the nodes run later. A holder may be
+// put back on another thread than the one it was got from.
+class GradTensorHolderPool {
+ public:
+  static GradTensorHolderPool& Instance() {
+    thread_local GradTensorHolderPool pool;
+    return pool;
+  }
+
+  std::unique_ptr<GradTensorHolder> Get(
+      const paddle::small_vector<std::vector<GradSlotMeta>,
+                                 kSlotSmallVectorSize>& metas) {
+    if (holders_.empty()) {
+      return std::make_unique<GradTensorHolder>(metas);
+    }
+    std::unique_ptr<GradTensorHolder> holder = std::move(holders_.back());
+    holders_.pop_back();
+    holder->Reset(metas);
+    return holder;
+  }
+
+  void Put(std::unique_ptr<GradTensorHolder> holder) {
+    if (holders_.size() < kMaxHolders) {
+      // Drop the grads now instead of on reuse to release their memory.
+      holder->Clear();
+      holders_.push_back(std::move(holder));
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxHolders = 64;
+  std::vector<std::unique_ptr<GradTensorHolder>> holders_;
+};
+
+// The threads running the backward engine besides the calling thread. They
+// are never joined, like the other thread pools of the framework.
+class BackwardThreadPool {
+ public:
+  static BackwardThreadPool& Instance() {
+    static BackwardThreadPool* pool = new BackwardThreadPool();
+    return *pool;
+  }
+
+  // Runs task on the calling thread and num_workers threads of the pool, and
+  // returns after all of them finish.
+  void Run(const std::function<void()>& task, size_t num_workers) {
+    std::lock_guard<std::mutex> run_guard(run_mutex_);
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      for (; num_threads_ < num_workers; ++num_threads_) {
+        std::thread(&BackwardThreadPool::WorkerLoop, this, num_threads_)
+            .detach();
+      }
+      task_ = &task;
+      num_workers_ = num_workers;
+      running_ = num_workers;
+      ++generation_;
+    }
+    cv_.notify_all();
+    task();
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return running_ == 0; });
+  }
+
+ private:
+  void WorkerLoop(size_t index) {
+    uint64_t generation = 0;
+    while (true) {
+      const std::function<void()>* task = nullptr;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return generation_ != generation; });
+        generation = generation_;
+        if (index >= num_workers_) {
+          continue;
+        }
+        task = task_;
+      }
+      (*task)();
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (--running_ == 0) {
+        done_cv_.notify_all();
+      }
+    }
+  }
+
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::condition_variable done_cv_;
+  size_t num_threads_{0};
+  const std::function<void()>* task_{nullptr};
+  size_t num_workers_{0};
+  uint64_t generation_{0};
+  size_t running_{0};
+};
+
+// Whether the thread runs a node of the threaded engine. A node calling
+// backward again, like a PyLayer whose backward calls backward, runs the
+// nested backward with the default engine, since the pool is taken by the
+// outer backward.
+thread_local bool in_backward_on_threads = false;
+
+class BackwardOnThreadsGuard {
+ public:
+  BackwardOnThreadsGuard() : pre_in_backward_(in_backward_on_threads) {
+    in_backward_on_threads = true;
+  }
+  ~BackwardOnThreadsGuard() { in_backward_on_threads = pre_in_backward_; }
+
+ private:
+  bool pre_in_backward_;
+};
+
+// The shared state of a run of the backward engine. The in-degrees and the
+// grads of the nodes are kept on the nodes, see GradNodeBackwardState.
+struct BackwardRun {
+  // The nodes ready to run on any thread and the nodes ready to run on the
+  // calling thread. They are lock-free stacks linked through next_ready, and
+  // since a node is pushed at most once per run, popping has no ABA problem.
+  std::atomic<GradNodeBase*> ready{nullptr};
+  std::atomic<GradNodeBase*> caller_ready{nullptr};
+  // The number of the nodes scheduled and not finished, the run is done when
+  // it drops to 0.
+  std::atomic<int64_t> active{0};
+  std::atomic<bool> failed{false};
+  // The threads finding no ready node wait on ready_cv.
+  std::mutex wait_mutex;
+  std::condition_variable ready_cv;
+  std::atomic<int> num_waiting{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  bool retain_graph{false};
+  phi::Place place;
+};
+
+void PushReadyNode(std::atomic<GradNodeBase*>* list, GradNodeBase* node) {
+  GradNodeBackwardState* state = node->MutableBackwardState();
+  GradNodeBase* head = list->load(std::memory_order_relaxed);
+  do {
+    state->next_ready = head;
+  } while (!list->compare_exchange_weak(
+      head, node, std::memory_order_release, std::memory_order_relaxed));
+}
+
+GradNodeBase* PopReadyNode(std::atomic<GradNodeBase*>* list) {
+  GradNodeBase* head = list->load(std::memory_order_acquire);
+  while (head != nullptr &&
+         !list->compare_exchange_weak(
+             head,
+             head->MutableBackwardState()->next_ready,
+             std::memory_order_acquire,
+             std::memory_order_acquire)) {
+  }
+  return head;
+}
+
+void WakeWaitingThreads(BackwardRun* run) {
+  // Taking the lock orders the wakeup after the check of a thread about to
+  // wait.
+  { std::lock_guard<std::mutex> guard(run->wait_mutex); }
+  run->ready_cv.notify_all();
+}
+
+void ScheduleNode(GradNodeBase* node, BackwardRun* run) {
+  run->active.fetch_add(1, std::memory_order_relaxed);
+  PushReadyNode(node->MutableBackwardState()->on_caller_thread
+                    ? &run->caller_ready
+                    : &run->ready,
+                node);
+  // Pairs with the fence in WaitForReadyNode, either the waiting thread sees
+  // the node or the node is pushed after it counts as waiting.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (run->num_waiting.load(std::memory_order_relaxed) > 0) {
+    WakeWaitingThreads(run);
+  }
+}
+
+// Blocks until a node the thread may run is ready or the run is done.
+void WaitForReadyNode(BackwardRun* run, bool is_caller_thread) {
+  run->num_waiting.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  {
+    std::unique_lock<std::mutex> lock(run->wait_mutex);
+    run->ready_cv.wait(lock, [&] {
+      return run->active.load(std::memory_order_acquire) == 0 ||
+             run->failed.load(std::memory_order_relaxed) ||
+             run->ready.load(std::memory_order_relaxed) != nullptr ||
+             (is_caller_thread &&
+              run->caller_ready.load(std::memory_order_relaxed) != nullptr);
+    });
+  }
+  run->num_waiting.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// Python nodes and the nodes with hooks, which may call into python or
+// communicate, keep running on the calling thread as in the default engine.
+bool RunsOnCallerThread(GradNodeBase* node) {
+  GradNodeBackwardState* state = node->MutableBackwardState();
+  // The type of a node never changes, the hooks may.
+  if (!state->type_checked) {
+    state->caller_thread_type =
+        dynamic_cast<egr::GradNodeAccumulation*>(node) != nullptr ||
+        node->name().rfind("GradNodePyLayer", 0) == 0;
+    state->type_checked = true;
+  }
+  return state->caller_thread_type || node->GradientHooksRegistered();
+}
+
+void RunReadyNode(GradNodeBase* node, BackwardRun* run) {
+  GradNodeBackwardState* state = node->MutableBackwardState();
+  std::unique_ptr<GradTensorHolder> node_input_buffer(state->input_buffer);
+  state->input_buffer = nullptr;
+  // As in the default engine, a node is only scheduled after it got grads.
+  PADDLE_ENFORCE_NOT_NULL(
+      node_input_buffer,
+      phi::errors::Fatal(
+          "Unable to find next node in the GradTensorHolder \n"
+          "Trying to run Node without configuring its GradTensorHolder."));
+
+  EnforceGradNodeHasInput(node);
+  paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+      grad_output_tensors;
+  {
+    paddle::platform::RecordEvent grad_node_record_event(
+        "Global_" + std::string((*node).name()),
+        paddle::platform::TracerEventType::Operator,
+        1);
+    grad_output_tensors = (*node)(node_input_buffer->Buffers());
+  }
+  if (!run->retain_graph) {
+    node->ClearTensorWrappers();
+  }
+  GradTensorHolderPool::Instance().Put(std::move(node_input_buffer));
+
+  const paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>&
+      metas = node->OutputMeta();
+  PADDLE_ENFORCE(metas.size() == grad_output_tensors.size() || metas.empty(),
+                 phi::errors::Fatal(
+                     "Number of edges should be either empty ( for leaf node "
+                     ") or the same as number of output grad tensors, but we "
+                     "got edges size is: %d, grad_output size is: %d",
+                     metas.size(),
+                     grad_output_tensors.size()));
+  for (size_t i = 0; i < metas.size(); i++) {
+    for (size_t j = 0; j < metas[i].size(); j++) {
+      const Edge& edge = metas[i][j].GetEdge();
+      if (!edge.IsInitialized()) {
+        continue;
+      }
+      // The next nodes of an empty slot are not released, as in the default
+      // engine.
+      if (grad_output_tensors[i].empty()) {
+        continue;
+      }
+      GradNodeBase* next_node = edge.GetMutableGradNode().get();
+      GradNodeBackwardState* next_state = next_node->MutableBackwardState();
+      PADDLE_ENFORCE_LT(
+          j,
+          grad_output_tensors[i].size(),
+          phi::errors::Fatal(
+              "Rank of grad_output_tensors should be less than "
+              "grad_output_tensors[i].size(), which is: %d. This error may "
+              "indicate autoprune or autograd api error. ",
+              grad_output_tensors.size()));
+      auto edge_rank = edge.GetEdgeRankInfo();
+      while (next_state->buffer_lock.exchange(true,
+                                              std::memory_order_acquire)) {
+        paddle::memory::CpuRelax();
+      }
+      if (next_state->input_buffer == nullptr) {
+        next_state->input_buffer = GradTensorHolderPool::Instance()
+                                       .Get(next_node->InputMeta())
+                                       .release();
+      }
+      next_state->input_buffer->add(
+          edge_rank.first, edge_rank.second, grad_output_tensors[i][j]);
+      next_state->buffer_lock.store(false, std::memory_order_release);
+      int in_degree =
+          next_state->in_degree.fetch_sub(1, std::memory_order_acq_rel) - 1;
+      PADDLE_ENFORCE(
+          in_degree >= 0,
+          phi::errors::Fatal(
+              "Detected in-degree value smaller than zero. For Node: %s"
+              "Node's in-degree cannot be negative.",
+              next_node->name()));
+      if (in_degree == 0) {
+        ScheduleNode(next_node, run);
+      }
+    }
+  }
+  paddle::memory::LogDeviceMemoryStats(run->place,
+                                       std::string((*node).name()));
+}
+
+// Runs the ready nodes until all the nodes finish or a node fails.
+void RunBackwardWorker(BackwardRun* run, bool is_caller_thread) {
+  while (!run->failed.load(std::memory_order_relaxed)) {
+    GradNodeBase* node = nullptr;
+    if (is_caller_thread) {
+      node = PopReadyNode(&run->caller_ready);
+    }
+    if (node == nullptr) {
+      node = PopReadyNode(&run->ready);
+    }
+    if (node == nullptr) {
+      if (run->active.load(std::memory_order_acquire) == 0) {
+        return;
+      }
+      WaitForReadyNode(run, is_caller_thread);
+      continue;
+    }
+    try {
+      RunReadyNode(node, run);
+    } catch (...) {
+      {
+        std::lock_guard<std::mutex> guard(run->error_mutex);
+        if (!run->error) {
+          run->error = std::current_exception();
+        }
+      }
+      run->failed.store(true, std::memory_order_relaxed);
+      WakeWaitingThreads(run);
+    }
+    // The next nodes of the node are scheduled before it finishes, so the
+    // count only drops to 0 after the last node.
+    if (run->active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      WakeWaitingThreads(run);
+    }
+  }
+}
+
+// The engine of FLAGS_eager_backward_num_threads. The in-degrees are counted
+// once on the nodes, a node is scheduled when its last input edge is done,
+// and the independent branches run on the threads of BackwardThreadPool.
+void RunBackwardOnThreads(
+    const std::deque<GradNodeBase*>& start_nodes,
+    std::unordered_map<GradNodeBase*, std::unique_ptr<GradTensorHolder>>*
+        node_input_buffers_dict,
+    bool retain_graph,
+    const phi::Place& place) {
+  static std::atomic<uint64_t> run_counter{0};
+  uint64_t run_id = run_counter.fetch_add(1, std::memory_order_relaxed) + 1;
+
+  // Precompute the in-degrees and where the nodes run, the visited nodes
+  // double as the queue of the traversal.
+  std::vector<GradNodeBase*> nodes;
+  for (GradNodeBase* node : start_nodes) {
+    GradNodeBackwardState* state = node->MutableBackwardState();
+    if (state->run_id != run_id) {
+      state->run_id = run_id;
+      nodes.push_back(node);
+    }
+  }
+  for (size_t k = 0; k < nodes.size(); k++) {
+    GradNodeBase* node = nodes[k];
+    node->MutableBackwardState()->on_caller_thread = RunsOnCallerThread(node);
+    for (const auto& meta_list : node->OutputMeta()) {
+      for (const GradSlotMeta& meta : meta_list) {
+        const Edge& edge = meta.GetEdge();
+        if (!edge.IsInitialized()) {
+          continue;
+        }
+        GradNodeBase* next_node = edge.GetMutableGradNode().get();
+        GradNodeBackwardState* next_state = next_node->MutableBackwardState();
+        next_state->in_degree.fetch_add(1, std::memory_order_relaxed);
+        if (next_state->run_id != run_id) {
+          next_state->run_id = run_id;
+          nodes.push_back(next_node);
+        }
+      }
+    }
+  }
+  for (auto& node_and_buffer : *node_input_buffers_dict) {
+    node_and_buffer.first->MutableBackwardState()->input_buffer =
+        node_and_buffer.second.release();
+  }
+  node_input_buffers_dict->clear();
+
+  BackwardRun run;
+  run.retain_graph = retain_graph;
+  run.place = place;
+  for (GradNodeBase* node : start_nodes) {
+    if (node->MutableBackwardState()->in_degree.load() == 0) {
+      ScheduleNode(node, &run);
+    }
+  }
+  VLOG(5) << "Run backward of " << nodes.size() << " nodes on "
+          << FLAGS_eager_backward_num_threads << " threads";
+
+  // The workers only run the nodes of CPU tensors. The nodes of a device
+  // would share the device context of the calling thread, and its stream
+  // is not thread safe.
+  size_t num_workers = 0;
+  if (phi::is_cpu_place(place)) {
+    num_workers = std::min<size_t>(FLAGS_eager_backward_num_threads - 1,
+                                   nodes.size() - 1);
+  }
+  BackwardOnThreadsGuard guard;
+  if (num_workers == 0) {
+    RunBackwardWorker(&run, /*is_caller_thread=*/true);
+  } else {
+    // The tracer, the grad mode, the amp state and the layout autotune state
+    // of the workers, all thread local, follow the calling thread.
+    auto tracer = egr::Controller::Instance().GetCurrentTracer();
+    bool has_grad = egr::Controller::Instance().HasGrad();
+    bool use_layout_autotune = egr::Controller::Instance().UseLayoutAutoTune();
+    const auto& amp_attrs = egr::Controller::Instance().GetCurrentAmpAttrs();
+    bool use_promote = amp_attrs->GetUsePromote();
+    paddle::imperative::AmpLevel amp_level = amp_attrs->GetAmpLevel();
+    std::string amp_dtype = amp_attrs->GetAmpDtype();
+    std::thread::id caller_id = std::this_thread::get_id();
+    BackwardThreadPool::Instance().Run(
+        [&] {
+          bool is_caller_thread = std::this_thread::get_id() == caller_id;
+          if (is_caller_thread) {
+            RunBackwardWorker(&run, is_caller_thread);
+            return;
+          }
+          egr::Controller::Instance().SetCurrentTracer(tracer);
+          egr::Controller::Instance().SetHasGrad(has_grad);
+          if (use_layout_autotune) {
+            egr::Controller::Instance().EnableLayoutAutoTune();
+          } else {
+            egr::Controller::Instance().DisableLayoutAutoTune();
+          }
+          const auto& worker_amp_attrs =
+              egr::Controller::Instance().GetCurrentAmpAttrs();
+          worker_amp_attrs->SetUsePromote(use_promote);
+          worker_amp_attrs->SetAmpLevel(amp_level);
+          worker_amp_attrs->SetAmpDtype(amp_dtype);
+          BackwardOnThreadsGuard worker_guard;
+          RunBackwardWorker(&run, is_caller_thread);
+        },
+        num_workers);
+  }
+
+  // The nodes left by a failure must not keep their state to the next run.
+  for (GradNodeBase* node : nodes) {
+    GradNodeBackwardState* state = node->MutableBackwardState();
+    state->in_degree.store(0, std::memory_order_relaxed);
+    delete state->input_buffer;
+    state->input_buffer = nullptr;
+  }
+  if (run.error) {
+    std::rethrow_exception(run.error);
+  }
+}
+
+}  // namespace
+
 std::vector<paddle::Tensor> RunBackward(
     const std::vector<paddle::Tensor>& tensors,  // output
     const std::vector<paddle::Tensor>& grad_tensors,
@@ -218,6 +683,27 @@ std::vector<paddle::Tensor> RunBackward(
         inputs, no_grad_vars, orig_queue, &queue, node_input_buffers_dict);
   }
 
+  // The saved tensors spilled last are used first.
+  if (SavedTensorsPool::IsEnabled()) {
+    SavedTensorsPool::Instance().PrefetchForBackward();
+  }
+
+  if (FLAGS_eager_backward_num_threads > 0 && !in_backward_on_threads &&
+      !is_general_grad && !create_graph &&
+      egr::Controller::Instance().GetForceSequentialNodes().empty()) {
+    if (!queue.empty()) {
+      RunBackwardOnThreads(
+          queue, &node_input_buffers_dict, retain_graph, place);
+    }
+    VLOG(7) << "Run Backward Final hook size: "
+            << egr::Controller::Instance().FinalBackwardHooks().size();
+    for (auto& hook : egr::Controller::Instance().FinalBackwardHooks()) {
+      (*hook)();
+    }
+    egr::Controller::Instance().ClearFinalBackwardHooks();
+    return {};
+  }
+
   VLOG(5) << "Update In degree Map for backward";
   // 3. Compute in_degree for each node
   std::unordered_map<GradNodeBase*, int> node_in_degree_map =
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 
 #include "paddle/fluid/eager/api/utils/global_utils.h"
@@ -194,6 +195,38 @@ class GradSlotMeta {
   bool is_dist_meta_{false};
 };
 
+class GradTensorHolder;
+
+/**
+ * The state of a GradNodeBase during a run of the backward engine enabled by
+ * FLAGS_eager_backward_num_threads. It is kept on the node so that the engine
+ * needs no maps keyed by the nodes, and it is not copied with the node.
+ * **/
+struct GradNodeBackwardState {
+  GradNodeBackwardState() = default;
+  GradNodeBackwardState(const GradNodeBackwardState&) {}
+  GradNodeBackwardState& operator=(const GradNodeBackwardState&) {
+    return *this;
+  }
+
+  // The number of the edges from the nodes not run yet
+  std::atomic<int> in_degree{0};
+  // The id of the run which visited the node last
+  uint64_t run_id{0};
+  // Whether the node has to run on the thread calling backward
+  bool on_caller_thread{false};
+  // Whether the type of the node, checked once, makes it run on the thread
+  // calling backward
+  bool type_checked{false};
+  bool caller_thread_type{false};
+  // The grads accumulated for the node, owned by the engine and guarded by
+  // buffer_lock
+  GradTensorHolder* input_buffer{nullptr};
+  std::atomic<bool> buffer_lock{false};
+  // The next node of the ready list holding the node
+  GradNodeBase* next_ready{nullptr};
+};
+
 class GradNodeBase {
  public:
   GradNodeBase() { VLOG(7) << "Construct GradNodeBase"; }
@@ -225,6 +258,20 @@ class GradNodeBase {
    * **/
   virtual std::shared_ptr<GradNodeBase> Copy() const = 0;
 
+  /**
+   * The following interfaces are designed for activation recomputation.
+   * A node whose forward op is cheap and whose tensor wrappers hold all the
+   * inputs of the op can replay the op, so the tensors other nodes save from
+   * its output can be dropped in forward and recomputed in backward.
+   * **/
+  // The flops to recompute an element of the output, 0 if the node can't.
+  virtual double RecomputeFlopsPerElement() { return 0; }
+
+  virtual paddle::Tensor RecomputeForwardOutput() {
+    PADDLE_THROW(phi::errors::Unimplemented(
+        "%s can't recompute the output of its forward op.", name()));
+  }
+
   // adj_edges were moved inside OutputMeta(), so no available direct access
   // from GradNodeBase.
   // To access Edges, get GradSlotMeta by calling OutputMeta(), then use
@@ -340,6 +387,11 @@ class GradNodeBase {
     is_run_auto_parallel_ = is_run_auto_parallel;
   }
 
+  /**
+   * The following interfaces are designed for the backward engine
+   * **/
+  GradNodeBackwardState* MutableBackwardState() { return &backward_state_; }
+
  private:
   // bwd_out_meta_ is used to record Grad output info for backward
   paddle::small_vector<std::vector<GradSlotMeta>, kSlotSmallVectorSize>
@@ -371,6 +423,8 @@ class GradNodeBase {
   // With this flag, short-circuit the backward traversal of Tensor and
   // set the DistAttr to reduce the impact on scheduling performance
   bool is_run_auto_parallel_{false};
+
+  GradNodeBackwardState backward_state_;
 };
 
 }  // namespace egr
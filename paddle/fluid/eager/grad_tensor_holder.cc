@@ -31,6 +31,22 @@ void GradTensorHolder::SetBufferSlotRankZeros(size_t slot_id, size_t rank) {
       paddle::experimental::zeros_like(buffer_[slot_id][rank]);
 }
 
+void GradTensorHolder::Clear() {
+  for (auto& slot : buffer_) {
+    slot.clear();
+  }
+}
+
+void GradTensorHolder::Reset(
+    const paddle::small_vector<std::vector<GradSlotMeta>,
+                               kSlotSmallVectorSize>& metas) {
+  Clear();
+  buffer_.resize(metas.size());
+  for (size_t i = 0; i < buffer_.size(); i++) {
+    buffer_[i].resize(metas[i].size());
+  }
+}
+
 void GradTensorHolder::CopyValueFromTensor(size_t slot_id,
                                            size_t rank,
                                            const paddle::Tensor& t,
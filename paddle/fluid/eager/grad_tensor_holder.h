@@ -66,6 +66,14 @@ class GradTensorHolder {
 
   void SetBufferSlotRankZeros(size_t slot_id, size_t rank);
 
+  // Drops the tensors held, keeping the memory of the buffers.
+  void Clear();
+
+  // Prepares the holder for the metas like the constructor does, reusing the
+  // memory of the buffers.
+  void Reset(const paddle::small_vector<std::vector<GradSlotMeta>,
+                                        kSlotSmallVectorSize>& metas);
+
  private:
   paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
       buffer_;
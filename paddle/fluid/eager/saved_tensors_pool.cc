@@ -0,0 +1,518 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/eager/saved_tensors_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <sys/vfs.h>
+#endif
+
+#include "glog/logging.h"
+#include "paddle/common/flags.h"
+#include "paddle/fluid/eager/utils.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+#include "paddle/phi/common/float8_e4m3fn.h"
+#include "paddle/phi/common/memory_utils.h"
+#include "paddle/phi/core/enforce.h"
+
+COMMON_DECLARE_string(eager_saved_tensors_compression);
+COMMON_DECLARE_int64(eager_saved_tensors_memory_budget_mb);
+COMMON_DECLARE_string(eager_saved_tensors_spill_dir);
+
+namespace egr {
+
+namespace {
+
+// The tensors smaller than this are saved as they are.
+constexpr int64_t kMinPackBytes = 64 * 1024;
+// The bytes of a spill segment, a larger tensor gets a segment of its own.
+constexpr size_t kSpillSegmentBytes = 64 * 1024 * 1024;
+// The number of spilled tensors read back ahead of the one used.
+constexpr int kPrefetchDistance = 4;
+// The max of float8_e4m3fn
+constexpr float kFloat8Max = 448.0f;
+
+bool IsZero(const char* value, size_t size) {
+  switch (size) {
+    case 2: {
+      uint16_t bits;
+      std::memcpy(&bits, value, size);
+      return bits == 0;
+    }
+    case 4: {
+      uint32_t bits;
+      std::memcpy(&bits, value, size);
+      return bits == 0;
+    }
+    case 8: {
+      uint64_t bits;
+      std::memcpy(&bits, value, size);
+      return bits == 0;
+    }
+    default:
+      return std::all_of(
+          value, value + size, [](char byte) { return byte == 0; });
+  }
+}
+
+// Packs the bitmap of the nonzero elements and then the nonzero elements,
+// returns false if it's not smaller than the tensor.
+bool EncodeZero(const char* src,
+                int64_t numel,
+                size_t elem_size,
+                std::unique_ptr<char[]>* out,
+                size_t* out_size) {
+  int64_t nnz = 0;
+  for (int64_t i = 0; i < numel; ++i) {
+    nnz += !IsZero(src + i * elem_size, elem_size);
+  }
+  size_t bitmap_size = (numel + 7) / 8;
+  size_t size = bitmap_size + nnz * elem_size;
+  if (size >= numel * elem_size) {
+    return false;
+  }
+  out->reset(new char[size]);
+  auto* bitmap = reinterpret_cast<uint8_t*>(out->get());
+  std::memset(bitmap, 0, bitmap_size);
+  char* values = out->get() + bitmap_size;
+  for (int64_t i = 0; i < numel; ++i) {
+    const char* value = src + i * elem_size;
+    if (!IsZero(value, elem_size)) {
+      bitmap[i / 8] |= 1 << (i % 8);
+      std::memcpy(values, value, elem_size);
+      values += elem_size;
+    }
+  }
+  *out_size = size;
+  return true;
+}
+
+void DecodeZero(const char* data, int64_t numel, size_t elem_size, char* dst) {
+  const auto* bitmap = reinterpret_cast<const uint8_t*>(data);
+  const char* values = data + (numel + 7) / 8;
+  for (int64_t i = 0; i < numel; i += 8) {
+    uint8_t bits = bitmap[i / 8];
+    int64_t n = std::min<int64_t>(8, numel - i);
+    char* out = dst + i * elem_size;
+    if (bits == 0) {
+      std::memset(out, 0, n * elem_size);
+      continue;
+    }
+    for (int64_t k = 0; k < n; ++k) {
+      if (bits & (1 << k)) {
+        std::memcpy(out + k * elem_size, values, elem_size);
+        values += elem_size;
+      } else {
+        std::memset(out + k * elem_size, 0, elem_size);
+      }
+    }
+  }
+}
+
+// Scales the tensor by its max absolute value to the range of float8,
+// returns false if the tensor has infinities or nans.
+template <typename T>
+bool EncodeFloat8(const char* src,
+                  int64_t numel,
+                  std::unique_ptr<char[]>* out,
+                  float* scale) {
+  const T* values = reinterpret_cast<const T*>(src);
+  float amax = 0.0f;
+  for (int64_t i = 0; i < numel; ++i) {
+    amax = std::max(amax, std::abs(static_cast<float>(values[i])));
+  }
+  if (!std::isfinite(amax)) {
+    return false;
+  }
+  *scale = amax > 0.0f ? kFloat8Max / amax : 1.0f;
+  out->reset(new char[numel]);
+  auto* dst = reinterpret_cast<phi::dtype::float8_e4m3fn*>(out->get());
+  for (int64_t i = 0; i < numel; ++i) {
+    dst[i] = phi::dtype::float8_e4m3fn(static_cast<float>(values[i]) * *scale);
+  }
+  return true;
+}
+
+template <typename T>
+void DecodeFloat8(const char* data, int64_t numel, float scale, char* dst) {
+  const auto* values = reinterpret_cast<const phi::dtype::float8_e4m3fn*>(data);
+  T* out = reinterpret_cast<T*>(dst);
+  for (int64_t i = 0; i < numel; ++i) {
+    out[i] = static_cast<T>(static_cast<float>(values[i]) / scale);
+  }
+}
+
+size_t PageSize() {
+#if !defined(_WIN32)
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+#else
+  return 4096;
+#endif
+}
+
+}  // namespace
+
+/**
+ * A file of the spilled tensors, unlinked once created and mapped as a
+ * whole. The tensors are appended to it, and it is removed with the last
+ * tensor spilled to it.
+ * **/
+class SpillSegment {
+ public:
+  explicit SpillSegment(size_t size) : size_(size) {
+#if !defined(_WIN32)
+    const std::string& dir = FLAGS_eager_saved_tensors_spill_dir;
+#if defined(__linux__)
+    // Spilling to memory only costs the copies.
+    constexpr int64_t kTmpfsMagic = 0x01021994;
+    constexpr int64_t kRamfsMagic = 0x858458f6;
+    struct statfs fs;
+    PADDLE_ENFORCE_EQ(
+        statfs(dir.c_str(), &fs),
+        0,
+        phi::errors::InvalidArgument(
+            "Failed to stat the directory %s to spill the saved tensors, "
+            "please check FLAGS_eager_saved_tensors_spill_dir.",
+            dir));
+    PADDLE_ENFORCE_EQ(
+        static_cast<int64_t>(fs.f_type) != kTmpfsMagic &&
+            static_cast<int64_t>(fs.f_type) != kRamfsMagic,
+        true,
+        phi::errors::InvalidArgument(
+            "The directory %s to spill the saved tensors is in memory, please "
+            "set FLAGS_eager_saved_tensors_spill_dir to a directory on disk.",
+            dir));
+#endif
+    std::string path = dir + "/paddle_saved_tensors_XXXXXX";
+    fd_ = mkstemp(&path[0]);
+    PADDLE_ENFORCE_NE(
+        fd_,
+        -1,
+        phi::errors::Unavailable(
+            "Failed to create the file %s to spill the saved tensors, please "
+            "check FLAGS_eager_saved_tensors_spill_dir.",
+            path));
+    unlink(path.c_str());
+    void* data = MAP_FAILED;
+    if (ftruncate(fd_, static_cast<off_t>(size)) == 0) {
+      data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    }
+    if (data == MAP_FAILED) {
+      close(fd_);
+    }
+    PADDLE_ENFORCE_NE(data,
+                      MAP_FAILED,
+                      phi::errors::ResourceExhausted(
+                          "Failed to map %d bytes of %s to spill the saved "
+                          "tensors.",
+                          size,
+                          path));
+    data_ = static_cast<char*>(data);
+#else
+    PADDLE_THROW(phi::errors::Unimplemented(
+        "Spilling the saved tensors is not supported on windows."));
+#endif
+  }
+
+  ~SpillSegment() {
+#if !defined(_WIN32)
+    munmap(data_, size_);
+    close(fd_);
+#endif
+  }
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+  size_t* mutable_used() { return &used_; }
+
+  // Advises the kernel on the pages of [offset, offset + size).
+  void Advise(size_t offset, size_t size, int advice) {
+#if !defined(_WIN32)
+    size_t begin = offset / PageSize() * PageSize();
+    size_t end = std::min(size_, (offset + size + PageSize() - 1) /
+                                     PageSize() * PageSize());
+    madvise(data_ + begin, end - begin, advice);
+#endif
+  }
+
+ private:
+  size_t size_;
+  size_t used_{0};
+  char* data_{nullptr};
+  int fd_{-1};
+};
+
+PackedTensor::~PackedTensor() { SavedTensorsPool::Instance().Release(this); }
+
+const char* PackedTensor::data() const {
+  return segment_ ? segment_->data() + offset_ : data_.get();
+}
+
+SavedTensorsPool& SavedTensorsPool::Instance() {
+  static SavedTensorsPool* pool = new SavedTensorsPool();
+  return *pool;
+}
+
+bool SavedTensorsPool::IsEnabled() {
+  return !FLAGS_eager_saved_tensors_compression.empty() ||
+         (FLAGS_eager_saved_tensors_memory_budget_mb > 0 &&
+          !FLAGS_eager_saved_tensors_spill_dir.empty());
+}
+
+bool SavedTensorsPool::ShouldPack(const paddle::Tensor& tensor) const {
+  if (!tensor.initialized() || !tensor.is_dense_tensor() ||
+      !phi::is_cpu_place(tensor.place())) {
+    return false;
+  }
+  auto* dense_tensor = static_cast<phi::DenseTensor*>(tensor.impl().get());
+  if (!dense_tensor->meta().is_contiguous() ||
+      dense_tensor->numel() *
+              static_cast<int64_t>(phi::SizeOf(dense_tensor->dtype())) <
+          kMinPackBytes) {
+    return false;
+  }
+  auto dtype = dense_tensor->dtype();
+  if (dtype != phi::DataType::FLOAT32 && dtype != phi::DataType::FLOAT16 &&
+      dtype != phi::DataType::BFLOAT16) {
+    return false;
+  }
+  // The parameters and the inputs stay alive anyway.
+  return !EagerUtils::IsLeafTensor(tensor);
+}
+
+std::shared_ptr<PackedTensor> SavedTensorsPool::Pack(
+    const phi::DenseTensor& tensor, uint32_t inplace_version) {
+  const std::shared_ptr<phi::Allocation>& holder = tensor.Holder();
+  {
+    std::lock_guard<std::mutex> guard(sources_mutex_);
+    auto it = sources_.find(holder.get());
+    if (it != sources_.end() && it->second.holder.lock() == holder &&
+        it->second.offset == tensor.meta().offset &&
+        it->second.inplace_version == inplace_version) {
+      std::shared_ptr<PackedTensor> packed = it->second.packed.lock();
+      if (packed && packed->dtype_ == tensor.dtype() &&
+          packed->numel_ == tensor.numel()) {
+        return packed;
+      }
+    }
+  }
+  std::shared_ptr<PackedTensor> packed = Encode(tensor);
+  packed->source_ = holder.get();
+  std::lock_guard<std::mutex> guard(sources_mutex_);
+  sources_[holder.get()] =
+      PackedSource{holder, packed, tensor.meta().offset, inplace_version};
+  return packed;
+}
+
+std::shared_ptr<PackedTensor> SavedTensorsPool::Encode(
+    const phi::DenseTensor& tensor) {
+  auto packed = std::make_shared<PackedTensor>();
+  packed->id_ = next_id_.fetch_add(1, std::memory_order_relaxed);
+  packed->dtype_ = tensor.dtype();
+  packed->numel_ = tensor.numel();
+  const char* src = static_cast<const char*>(tensor.data());
+  size_t elem_size = phi::SizeOf(tensor.dtype());
+
+  const std::string& compression = FLAGS_eager_saved_tensors_compression;
+  bool encoded = false;
+  if (compression == "zero") {
+    encoded = EncodeZero(
+        src, packed->numel_, elem_size, &packed->data_, &packed->size_);
+    packed->codec_ = PackedTensor::Codec::kZero;
+  } else if (compression == "bf16") {
+    if (packed->dtype_ == phi::DataType::FLOAT32) {
+      packed->data_.reset(new char[packed->numel_ * 2]);
+      auto* dst =
+          reinterpret_cast<phi::dtype::bfloat16*>(packed->data_.get());
+      const auto* values = reinterpret_cast<const float*>(src);
+      for (int64_t i = 0; i < packed->numel_; ++i) {
+        dst[i] = phi::dtype::bfloat16(values[i]);
+      }
+      packed->size_ = packed->numel_ * 2;
+      packed->codec_ = PackedTensor::Codec::kBFloat16;
+      encoded = true;
+    }
+  } else if (compression == "fp8") {
+    switch (packed->dtype_) {
+      case phi::DataType::FLOAT32:
+        encoded = EncodeFloat8<float>(
+            src, packed->numel_, &packed->data_, &packed->scale_);
+        break;
+      case phi::DataType::FLOAT16:
+        encoded = EncodeFloat8<phi::dtype::float16>(
+            src, packed->numel_, &packed->data_, &packed->scale_);
+        break;
+      default:
+        encoded = EncodeFloat8<phi::dtype::bfloat16>(
+            src, packed->numel_, &packed->data_, &packed->scale_);
+        break;
+    }
+    packed->size_ = packed->numel_;
+    packed->codec_ = PackedTensor::Codec::kFloat8;
+  } else if (!compression.empty()) {
+    PADDLE_THROW(phi::errors::InvalidArgument(
+        "FLAGS_eager_saved_tensors_compression should be one of \"\", "
+        "\"zero\", \"bf16\" and \"fp8\", but got \"%s\".",
+        compression));
+  }
+  if (!encoded) {
+    packed->size_ = packed->numel_ * elem_size;
+    packed->data_.reset(new char[packed->size_]);
+    std::memcpy(packed->data_.get(), src, packed->size_);
+    packed->codec_ = PackedTensor::Codec::kRaw;
+  }
+
+  MaybeSpill(packed.get());
+  if (!packed->IsSpilled()) {
+    int64_t bytes = memory_bytes_.fetch_add(packed->size_) + packed->size_;
+    int64_t peak = peak_memory_bytes_.load(std::memory_order_relaxed);
+    while (bytes > peak &&
+           !peak_memory_bytes_.compare_exchange_weak(peak, bytes)) {
+    }
+  }
+  VLOG(7) << "Pack saved tensor " << packed->id_ << " of "
+          << packed->numel_ * elem_size << " bytes to " << packed->size_
+          << " bytes" << (packed->IsSpilled() ? ", spilled" : "");
+  return packed;
+}
+
+void SavedTensorsPool::MaybeSpill(PackedTensor* packed) {
+#if !defined(_WIN32)
+  int64_t budget = FLAGS_eager_saved_tensors_memory_budget_mb << 20;
+  if (budget <= 0 || FLAGS_eager_saved_tensors_spill_dir.empty() ||
+      memory_bytes_.load(std::memory_order_relaxed) +
+              static_cast<int64_t>(packed->size_) <=
+          budget) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  if (!segment_ ||
+      *segment_->mutable_used() + packed->size_ > segment_->size()) {
+    segment_ = std::make_shared<SpillSegment>(
+        std::max(kSpillSegmentBytes, packed->size_));
+  }
+  size_t* used = segment_->mutable_used();
+  packed->segment_ = segment_;
+  packed->offset_ = *used;
+  // Keep the tensors page aligned, so dropping the pages of one doesn't
+  // drop the pages of its neighbors about to be used.
+  *used = (*used + packed->size_ + PageSize() - 1) / PageSize() * PageSize();
+  std::memcpy(segment_->data() + packed->offset_,
+              packed->data_.get(),
+              packed->size_);
+  packed->data_.reset();
+#if defined(MADV_PAGEOUT)
+  segment_->Advise(packed->offset_, packed->size_, MADV_PAGEOUT);
+#else
+  segment_->Advise(packed->offset_, packed->size_, MADV_DONTNEED);
+#endif
+  spilled_.emplace(packed->id_, packed);
+  spilled_bytes_.fetch_add(packed->size_);
+#endif
+}
+
+void SavedTensorsPool::Prefetch(
+    std::map<uint64_t, PackedTensor*>::iterator end) {
+#if !defined(_WIN32)
+  for (int i = 0; i < kPrefetchDistance && end != spilled_.begin(); ++i) {
+    --end;
+    PackedTensor* packed = end->second;
+    packed->segment_->Advise(packed->offset_, packed->size_, MADV_WILLNEED);
+  }
+#endif
+}
+
+void SavedTensorsPool::PrefetchForBackward() {
+  if (spilled_bytes_.load(std::memory_order_relaxed) == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  Prefetch(spilled_.end());
+}
+
+std::shared_ptr<phi::Allocation> SavedTensorsPool::Unpack(
+    const PackedTensor& packed) {
+  if (packed.IsSpilled()) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    Prefetch(spilled_.lower_bound(packed.id_));
+  }
+  size_t elem_size = phi::SizeOf(packed.dtype_);
+  auto holder = phi::memory_utils::AllocShared(phi::CPUPlace(),
+                                               packed.numel_ * elem_size);
+  char* dst = static_cast<char*>(holder->ptr());
+  const char* data = packed.data();
+  switch (packed.codec_) {
+    case PackedTensor::Codec::kRaw:
+      std::memcpy(dst, data, packed.size_);
+      break;
+    case PackedTensor::Codec::kZero:
+      DecodeZero(data, packed.numel_, elem_size, dst);
+      break;
+    case PackedTensor::Codec::kBFloat16: {
+      const auto* values = reinterpret_cast<const phi::dtype::bfloat16*>(data);
+      float* out = reinterpret_cast<float*>(dst);
+      for (int64_t i = 0; i < packed.numel_; ++i) {
+        out[i] = static_cast<float>(values[i]);
+      }
+      break;
+    }
+    case PackedTensor::Codec::kFloat8:
+      switch (packed.dtype_) {
+        case phi::DataType::FLOAT32:
+          DecodeFloat8<float>(data, packed.numel_, packed.scale_, dst);
+          break;
+        case phi::DataType::FLOAT16:
+          DecodeFloat8<phi::dtype::float16>(
+              data, packed.numel_, packed.scale_, dst);
+          break;
+        default:
+          DecodeFloat8<phi::dtype::bfloat16>(
+              data, packed.numel_, packed.scale_, dst);
+          break;
+      }
+      break;
+  }
+  return holder;
+}
+
+void SavedTensorsPool::Release(PackedTensor* packed) {
+  if (packed->source_) {
+    std::lock_guard<std::mutex> guard(sources_mutex_);
+    auto it = sources_.find(packed->source_);
+    // The entry may be of another tensor packed from the holder since.
+    if (it != sources_.end() && it->second.packed.expired()) {
+      sources_.erase(it);
+    }
+  }
+  if (!packed->IsSpilled()) {
+    memory_bytes_.fetch_sub(packed->size_);
+    return;
+  }
+  std::lock_guard<std::mutex> guard(mutex_);
+  spilled_.erase(packed->id_);
+  spilled_bytes_.fetch_sub(packed->size_);
+}
+
+}  // namespace egr
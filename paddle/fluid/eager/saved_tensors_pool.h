@@ -0,0 +1,152 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "paddle/phi/api/include/tensor.h"
+#include "paddle/phi/core/allocator.h"
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace egr {
+
+class SpillSegment;
+
+/**
+ * A tensor saved by TensorWrapper in the compact form of SavedTensorsPool.
+ * The packed data is either held in memory or spilled to a file of the pool,
+ * and is released with the PackedTensor.
+ * **/
+class PackedTensor {
+ public:
+  PackedTensor() = default;
+  ~PackedTensor();
+
+  PackedTensor(const PackedTensor&) = delete;
+  PackedTensor& operator=(const PackedTensor&) = delete;
+
+  bool IsSpilled() const { return segment_ != nullptr; }
+
+  // The bytes of the packed data
+  size_t size() const { return size_; }
+
+ private:
+  friend class SavedTensorsPool;
+
+  enum class Codec : uint8_t {
+    // A plain copy
+    kRaw = 0,
+    // A bitmap of the nonzero elements followed by them, lossless
+    kZero = 1,
+    // Float32 rounded to bfloat16
+    kBFloat16 = 2,
+    // Scaled to float8_e4m3fn by the max absolute value of the tensor
+    kFloat8 = 3,
+  };
+
+  const char* data() const;
+
+  uint64_t id_{0};
+  // The holder of the tensor packed
+  const phi::Allocation* source_{nullptr};
+  phi::DataType dtype_{phi::DataType::UNDEFINED};
+  int64_t numel_{0};
+  Codec codec_{Codec::kRaw};
+  float scale_{1.0f};
+  size_t size_{0};
+  std::unique_ptr<char[]> data_;
+  std::shared_ptr<SpillSegment> segment_;
+  size_t offset_{0};
+};
+
+/**
+ * SavedTensorsPool is the native counterpart of the saved tensors hooks for
+ * the activations TensorWrapper saves for backward, configured by
+ *
+ *   FLAGS_eager_saved_tensors_compression: "zero" packs the tensors losslessly
+ *   by their zeros, "bf16" and "fp8" downcast the float tensors.
+ *   FLAGS_eager_saved_tensors_memory_budget_mb: the packed tensors beyond the
+ *   budget are spilled to files mapped in FLAGS_eager_saved_tensors_spill_dir,
+ *   a directory on disk, if it is set.
+ *
+ * Backward consumes the saved tensors about in the reverse order of forward,
+ * so the spilled tensors are read back ahead in that order.
+ * **/
+class SavedTensorsPool {
+ public:
+  static SavedTensorsPool& Instance();
+
+  static bool IsEnabled();
+
+  // Whether the tensor is worth packing: a contiguous floating point dense
+  // tensor on cpu which is not a leaf.
+  bool ShouldPack(const paddle::Tensor& tensor) const;
+
+  // A tensor saved by several wrappers, like the output of an op used by
+  // the next op, is packed once for the same inplace version.
+  std::shared_ptr<PackedTensor> Pack(const phi::DenseTensor& tensor,
+                                     uint32_t inplace_version);
+
+  // Returns a new holder with the data of the packed tensor.
+  std::shared_ptr<phi::Allocation> Unpack(const PackedTensor& packed);
+
+  // Reads back the spilled tensors used first by backward.
+  void PrefetchForBackward();
+
+  int64_t memory_bytes() const { return memory_bytes_.load(); }
+  int64_t peak_memory_bytes() const { return peak_memory_bytes_.load(); }
+  int64_t spilled_bytes() const { return spilled_bytes_.load(); }
+  void ResetPeakMemoryBytes() { peak_memory_bytes_.store(memory_bytes()); }
+
+ private:
+  friend class PackedTensor;
+
+  SavedTensorsPool() = default;
+
+  struct PackedSource {
+    std::weak_ptr<phi::Allocation> holder;
+    std::weak_ptr<PackedTensor> packed;
+    size_t offset;
+    uint32_t inplace_version;
+  };
+
+  std::shared_ptr<PackedTensor> Encode(const phi::DenseTensor& tensor);
+
+  // Moves the packed data to a spill segment if it's beyond the budget.
+  void MaybeSpill(PackedTensor* packed);
+  void Prefetch(std::map<uint64_t, PackedTensor*>::iterator end);
+  void Release(PackedTensor* packed);
+
+  std::atomic<uint64_t> next_id_{0};
+  std::atomic<int64_t> memory_bytes_{0};
+  std::atomic<int64_t> peak_memory_bytes_{0};
+  std::atomic<int64_t> spilled_bytes_{0};
+
+  // Guards the tensors packed by their holders
+  std::mutex sources_mutex_;
+  std::unordered_map<const phi::Allocation*, PackedSource> sources_;
+
+  // Guards the spill segments and the spilled tensors
+  std::mutex mutex_;
+  std::shared_ptr<SpillSegment> segment_;
+  std::map<uint64_t, PackedTensor*> spilled_;
+};
+
+}  // namespace egr
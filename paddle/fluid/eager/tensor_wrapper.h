@@ -25,8 +25,10 @@
  * with no grad **/
 
 #pragma once
+#include "paddle/fluid/eager/activation_recompute.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/grad_node_info.h"
+#include "paddle/fluid/eager/saved_tensors_pool.h"
 #include "paddle/fluid/eager/utils.h"
 #include "paddle/phi/api/lib/utils/allocator.h"
 #ifndef PADDLE_NO_PYTHON
@@ -122,7 +124,38 @@ class TensorWrapper {
         packed_value_ = (*pack_hook)(tensor);
       } else {
 #endif
-        intermidiate_tensor_.set_impl(tensor.impl());
+        std::shared_ptr<GradNodeBase> producer =
+            ActivationRecompute::IsEnabled() && tensor_autograd_meta
+                ? tensor_autograd_meta->GetMutableGradNode()
+                : nullptr;
+        if (producer && ActivationRecompute::Instance().ShouldDrop(
+                            tensor, producer->RecomputeFlopsPerElement())) {
+          // Only keep the meta, backward recomputes the data by the producer
+          phi::DenseTensor* dense_tensor =
+              static_cast<phi::DenseTensor*>(tensor.impl().get());
+          intermidiate_tensor_.set_impl(std::make_shared<phi::DenseTensor>(
+              std::make_shared<phi::Allocation>(nullptr, 0, tensor.place()),
+              dense_tensor->meta()));
+          ActivationRecompute::Instance().RecordDrop(tensor);
+          recompute_ = true;
+        } else if (SavedTensorsPool::IsEnabled() &&
+                   SavedTensorsPool::Instance().ShouldPack(tensor)) {
+          phi::DenseTensor* dense_tensor =
+              static_cast<phi::DenseTensor*>(tensor.impl().get());
+          phi::DenseTensorMeta meta = dense_tensor->meta();
+          meta.offset = 0;
+          intermidiate_tensor_.set_impl(std::make_shared<phi::DenseTensor>(
+              std::make_shared<phi::Allocation>(nullptr, 0, tensor.place()),
+              meta));
+          packed_tensor_ = SavedTensorsPool::Instance().Pack(
+              *dense_tensor, inplace_version_snapshot_);
+        } else {
+          intermidiate_tensor_.set_impl(tensor.impl());
+        }
+        if (!recompute_ && ActivationRecompute::IsEnabled() &&
+            !EagerUtils::IsLeafTensor(tensor)) {
+          saved_bytes_ = ActivationRecompute::Instance().Save(tensor);
+        }
 #ifndef PADDLE_NO_PYTHON
       }
 #endif
@@ -185,12 +218,26 @@ class TensorWrapper {
       }
     } else {
 #endif
-      check_inplace_version();
+      // The packed tensor is a copy, which inplace ops can't change, and the
+      // recomputed one is from the inputs of its producer.
+      if (!packed_tensor_ && !recompute_) {
+        check_inplace_version();
+      }
 #ifndef PADDLE_NO_PYTHON
     }
 #endif
 
     paddle::Tensor recovered_tensor = intermidiate_tensor_;
+    if (recompute_) {
+      recovered_tensor.set_impl(recompute());
+    } else if (packed_tensor_) {
+      // Only the recovered tensor holds the unpacked data, so the wrapper
+      // keeps the packed one for retain_graph.
+      recovered_tensor.set_impl(std::make_shared<phi::DenseTensor>(
+          SavedTensorsPool::Instance().Unpack(*packed_tensor_),
+          static_cast<phi::DenseTensor*>(intermidiate_tensor_.impl().get())
+              ->meta()));
+    }
 
     std::shared_ptr<GradNodeBase> new_grad_node = weak_grad_node_.lock();
     if (new_grad_node) {
@@ -216,9 +263,39 @@ class TensorWrapper {
 
   paddle::Tensor get_intermidiate_tensor() { return intermidiate_tensor_; }
 
-  void clear() { intermidiate_tensor_.reset(); }
+  void clear() {
+    intermidiate_tensor_.reset();
+    packed_tensor_.reset();
+    saved_bytes_.reset();
+    recompute_ = false;
+  }
 
  private:
+  std::shared_ptr<phi::TensorBase> recompute() {
+    std::shared_ptr<GradNodeBase> producer = weak_grad_node_.lock();
+    PADDLE_ENFORCE_NOT_NULL(
+        producer,
+        phi::errors::PreconditionNotMet(
+            "The grad node recomputing Tensor '%s' has been released.",
+            intermidiate_tensor_.name()));
+    VLOG(6) << "Recompute tensor: " << intermidiate_tensor_.name() << " by "
+            << producer->name();
+    paddle::Tensor recomputed = producer->RecomputeForwardOutput();
+    PADDLE_ENFORCE_EQ(
+        recomputed.initialized() &&
+            recomputed.dims() == intermidiate_tensor_.dims() &&
+            recomputed.dtype() == intermidiate_tensor_.dtype(),
+        true,
+        phi::errors::PreconditionNotMet(
+            "%s failed to recompute Tensor '%s', please check whether the "
+            "backward of its forward op has run already.",
+            producer->name(),
+            intermidiate_tensor_.name()));
+    ActivationRecompute::Instance().RecordRecompute(
+        recomputed.numel(), producer->RecomputeFlopsPerElement());
+    return recomputed.impl();
+  }
+
   void check_inplace_version() {
     if (no_need_buffer_) {
       VLOG(7) << "There's no need to check inplace_version because "
@@ -270,6 +347,10 @@ class TensorWrapper {
   paddle::Tensor intermidiate_tensor_;
   std::weak_ptr<egr::GradNodeBase> weak_grad_node_;
   uint32_t inplace_version_snapshot_ = 0;
+  std::shared_ptr<PackedTensor> packed_tensor_;
+  // The data isn't saved but recomputed by the grad node of the tensor
+  bool recompute_ = false;
+  std::shared_ptr<SavedBytes> saved_bytes_;
 #ifndef PADDLE_NO_PYTHON
   std::shared_ptr<egr::PyObjectHolderBase> packed_value_;
   std::shared_ptr<egr::UnPackHookBase> unpack_hook_;
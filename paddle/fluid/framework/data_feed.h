@@ -19,6 +19,8 @@ limitations under the License. */
 #define _LINUX
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
 #include <memory>
@@ -54,6 +56,8 @@ COMMON_DECLARE_int32(record_pool_max_size);
 COMMON_DECLARE_int32(slotpool_thread_num);
 COMMON_DECLARE_bool(enable_slotpool_wait_release);
 COMMON_DECLARE_bool(enable_slotrecord_reset_shrink);
+COMMON_DECLARE_int32(slotpool_local_cache_size);
+COMMON_DECLARE_int64(slotrecord_reuse_max_feasign_num);
 
 namespace paddle {
 namespace framework {
@@ -133,6 +137,15 @@ struct SlotValues {
       slot_offsets.shrink_to_fit();
     }
   }
+  // keep buffers within max_reuse_num values for reuse, release oversized
+  // ones so that a few huge records do not pin pool memory
+  void clear(bool shrink, size_t max_reuse_num) {
+    clear(shrink || slot_values.capacity() > max_reuse_num);
+  }
+  size_t memory_bytes() const {
+    return slot_values.capacity() * sizeof(T) +
+           slot_offsets.capacity() * sizeof(uint32_t);
+  }
 };
 union FeatureFeasign {
   uint64_t uint64_feasign_;
@@ -186,12 +199,30 @@ struct SlotRecordObject {
   SlotValues<uint64_t> slot_uint64_feasigns_;
   SlotValues<float> slot_float_feasigns_;
 
+  SlotRecordObject() = default;
+  SlotRecordObject(const SlotRecordObject&) = delete;
+  SlotRecordObject& operator=(const SlotRecordObject&) = delete;
+  SlotRecordObject(SlotRecordObject&&) = default;
+  SlotRecordObject& operator=(SlotRecordObject&&) = default;
   ~SlotRecordObject() { clear(true); }
-  void reset(void) { clear(FLAGS_enable_slotrecord_reset_shrink); }
+  void reset(void) {
+    size_t max_reuse_num =
+        static_cast<size_t>(FLAGS_slotrecord_reuse_max_feasign_num);
+    slot_uint64_feasigns_.clear(FLAGS_enable_slotrecord_reset_shrink,
+                                max_reuse_num);
+    slot_float_feasigns_.clear(FLAGS_enable_slotrecord_reset_shrink,
+                               max_reuse_num);
+  }
   void clear(bool shrink) {
     slot_uint64_feasigns_.clear(shrink);
     slot_float_feasigns_.clear(shrink);
   }
+  // bytes held by this object, including the reusable feasign buffers
+  size_t memory_bytes() const {
+    return sizeof(SlotRecordObject) + ins_id_.capacity() +
+           slot_uint64_feasigns_.memory_bytes() +
+           slot_float_feasigns_.memory_bytes();
+  }
 };
 using SlotRecord = SlotRecordObject*;
 // sizeof Record is much less than std::vector<MultiSlotType>
@@ -262,10 +293,21 @@ class SlotObjAllocator {
   std::function<void(T*)> deleter_ = nullptr;
 };
 static const int OBJPOOL_BLOCK_SIZE = 10000;
+// SlotObjPool hands out reset SlotRecordObjects in batches. Hot get/put
+// calls are served from a per-thread magazine first, the shared free list is
+// only touched (under mutex_) when the magazine under- or over-flows, and
+// records that do not fit anywhere are reset/freed by the release threads.
+// The records pooled in the magazines and the shared free list together are
+// kept within max_capacity_.
+// NOTE: the per-thread magazine is bound to one pool, only the global
+// SlotRecordPool() enables it.
 class SlotObjPool {
  public:
-  SlotObjPool()
-      : max_capacity_(FLAGS_record_pool_max_size), alloc_(free_slotrecord) {
+  SlotObjPool() : SlotObjPool(0) {}
+  explicit SlotObjPool(int local_cache_size)
+      : max_capacity_(FLAGS_record_pool_max_size),
+        local_cache_size_(local_cache_size > 0 ? local_cache_size : 0),
+        alloc_(free_slotrecord) {
     ins_chan_ = MakeChannel<SlotRecord>();
     ins_chan_->SetBlockSize(OBJPOOL_BLOCK_SIZE);
     for (int i = 0; i < FLAGS_slotpool_thread_num; ++i) {
@@ -273,12 +315,20 @@ class SlotObjPool {
     }
     disable_pool_ = false;
     count_ = 0;
+    local_num_ = 0;
+    shared_num_ = 0;
+    shared_bytes_ = 0;
+    local_bytes_ = 0;
   }
   ~SlotObjPool() {
     ins_chan_->Close();
     for (auto& t : threads_) {
       t.join();
     }
+    std::lock_guard<std::mutex> lock(caches_mutex_);
+    for (auto* cache : caches_) {
+      cache->drop(true);
+    }
   }
   void disable_pool(bool disable) { disable_pool_ = disable; }
   void set_max_capacity(size_t max_capacity) { max_capacity_ = max_capacity; }
@@ -288,15 +338,20 @@ class SlotObjPool {
   }
   void get(SlotRecord* output, int n) {
     int size = 0;
-    mutex_.lock();
-    int left = static_cast<int>(alloc_.capacity());
-    if (left > 0) {
-      size = (left >= n) ? n : left;
-      for (int i = 0; i < size; ++i) {
-        output[i] = alloc_.acquire();
+    if (local_cache_size_ > 0) {
+      size = local_cache().pop(output, n);
+    }
+    if (size < n) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      int left = static_cast<int>(alloc_.capacity());
+      int num = std::min(left, n - size);
+      for (int i = 0; i < num; ++i) {
+        output[size] = alloc_.acquire();
+        shared_bytes_ -= output[size]->memory_bytes();
+        ++size;
       }
+      shared_num_ -= num;
     }
-    mutex_.unlock();
     count_ += n;
     if (size == n) {
       return;
@@ -314,7 +369,16 @@ class SlotObjPool {
     input->clear();
   }
   void put(SlotRecord* input, size_t size) {
-    CHECK(ins_chan_->WriteMove(size, input) == size);
+    size_t cached = 0;
+    if (local_cache_size_ > 0 && !disable_pool_) {
+      cached = local_cache().push(input, size);
+      count_ -= cached;
+    }
+    if (cached == size) {
+      return;
+    }
+    CHECK(ins_chan_->WriteMove(size - cached, input + cached) ==
+          size - cached);
   }
   void run(void) {
     std::vector<SlotRecord> input;
@@ -330,14 +394,12 @@ class SlotObjPool {
           free_slotrecord(t);
         }
       } else {
+        int64_t bytes = 0;
         for (auto& t : input) {
           t->reset();
+          bytes += t->memory_bytes();
         }
-        mutex_.lock();
-        for (auto& t : input) {
-          alloc_.release(t);
-        }
-        mutex_.unlock();
+        release(&input[0], n, bytes);
       }
       input.clear();
     }
@@ -345,8 +407,17 @@ class SlotObjPool {
   void clear(void) {
     platform::Timer timeline;
     timeline.Start();
+    {
+      // free the records in the magazines of all the threads
+      std::lock_guard<std::mutex> lock(caches_mutex_);
+      for (auto* cache : caches_) {
+        cache->drop(false);
+      }
+    }
     mutex_.lock();
     alloc_.clear();
+    shared_num_ = 0;
+    shared_bytes_ = 0;
     mutex_.unlock();
     // wait release channel data
     if (FLAGS_enable_slotpool_wait_release) {
@@ -358,25 +429,141 @@ class SlotObjPool {
     VLOG(3) << "clear slot pool data size=" << count_.load()
             << ", span=" << timeline.ElapsedSec();
   }
+  // number of pooled records, including the per-thread magazines
   size_t capacity(void) {
     mutex_.lock();
     size_t total = alloc_.capacity();
     mutex_.unlock();
-    return total;
+    return total + local_num_.load();
+  }
+  // bytes retained by pooled records for reuse
+  int64_t memory_size(void) const {
+    return shared_bytes_.load() + local_bytes_.load();
+  }
+
+ private:
+  // per-thread magazine of reset records, returned to the shared free list
+  // when the owning thread exits. The magazines are registered in caches_ of
+  // their pool, so that clear() frees the records of every thread; mutex is
+  // only contended by such a clear() from another thread.
+  struct LocalCache {
+    SlotObjPool* pool = nullptr;
+    std::mutex mutex;
+    std::vector<SlotRecord> records;
+
+    ~LocalCache() { detach(); }
+    int pop(SlotRecord* output, int n) {
+      std::lock_guard<std::mutex> lock(mutex);
+      int num = std::min(n, static_cast<int>(records.size()));
+      int64_t bytes = 0;
+      for (int i = 0; i < num; ++i) {
+        output[i] = records.back();
+        records.pop_back();
+        bytes += output[i]->memory_bytes();
+      }
+      pool->local_num_ -= num;
+      pool->local_bytes_ -= bytes;
+      return num;
+    }
+    size_t push(SlotRecord* input, size_t size) {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t pooled = pool->local_num_.load() + pool->shared_num_.load();
+      size_t room = pool->max_capacity_ > pooled
+                        ? pool->max_capacity_ - pooled
+                        : static_cast<size_t>(0);
+      size_t num = std::min(
+          {size, pool->local_cache_size_ - records.size(), room});
+      int64_t bytes = 0;
+      for (size_t i = 0; i < num; ++i) {
+        input[i]->reset();
+        bytes += input[i]->memory_bytes();
+        records.push_back(input[i]);
+      }
+      pool->local_num_ += num;
+      pool->local_bytes_ += bytes;
+      return num;
+    }
+    // frees the records, called with caches_mutex_ of the pool held. The
+    // magazine is unbound when the pool is destroyed.
+    void drop(bool unbind) {
+      std::lock_guard<std::mutex> lock(mutex);
+      int64_t bytes = 0;
+      for (auto& t : records) {
+        bytes += t->memory_bytes();
+        free_slotrecord(t);
+      }
+      pool->local_num_ -= records.size();
+      pool->local_bytes_ -= bytes;
+      records.clear();
+      if (unbind) {
+        pool = nullptr;
+      }
+    }
+    // returns the records to the shared free list and unregisters
+    void detach() {
+      SlotObjPool* owner = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        owner = pool;
+        if (owner == nullptr) {
+          return;
+        }
+        if (!records.empty()) {
+          size_t num = records.size();
+          int64_t bytes = 0;
+          for (auto& t : records) {
+            bytes += t->memory_bytes();
+          }
+          owner->release(&records[0], num, bytes);
+          owner->local_num_ -= num;
+          owner->local_bytes_ -= bytes;
+          records.clear();
+        }
+        pool = nullptr;
+      }
+      std::lock_guard<std::mutex> lock(owner->caches_mutex_);
+      owner->caches_.erase(this);
+    }
+  };
+  LocalCache& local_cache() {
+    thread_local LocalCache cache;
+    if (cache.pool != this) {
+      cache.detach();
+      cache.pool = this;
+      cache.records.reserve(local_cache_size_);
+      std::lock_guard<std::mutex> lock(caches_mutex_);
+      caches_.insert(&cache);
+    }
+    return cache;
+  }
+  void release(SlotRecord* input, size_t n, int64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < n; ++i) {
+      alloc_.release(input[i]);
+    }
+    shared_num_ += n;
+    shared_bytes_ += bytes;
   }
 
  private:
   size_t max_capacity_;
+  size_t local_cache_size_;
   Channel<SlotRecord> ins_chan_;
   std::vector<std::thread> threads_;
   std::mutex mutex_;
   SlotObjAllocator<SlotRecordObject> alloc_;
   bool disable_pool_;
-  std::atomic<long> count_;  // NOLINT
+  std::atomic<long> count_;       // NOLINT
+  std::atomic<long> local_num_;   // NOLINT
+  std::atomic<long> shared_num_;  // NOLINT
+  std::atomic<int64_t> shared_bytes_;
+  std::atomic<int64_t> local_bytes_;
+  std::mutex caches_mutex_;
+  std::unordered_set<LocalCache*> caches_;
 };
 
 inline SlotObjPool& SlotRecordPool() {
-  static SlotObjPool pool;
+  static SlotObjPool pool(FLAGS_slotpool_local_cache_size);
   return pool;
 }
 struct PvInstanceObject {
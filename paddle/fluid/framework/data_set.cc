@@ -1954,9 +1954,14 @@ void SlotRecordDataset::ReleaseMemory() {
   VLOG(3) << "total_feasign_num_(" << STAT_GET(STAT_total_feasign_num_in_mem)
           << ") - current_fea_num_(" << total_fea_num_ << ") = ("
           << STAT_GET(STAT_total_feasign_num_in_mem) - total_fea_num_ << ")"
-          << " object pool size=" << SlotRecordPool().capacity();  // For Debug
+          << " object pool size=" << SlotRecordPool().capacity()
+          << " object pool bytes=" << SlotRecordPool().memory_size();
   STAT_SUB(STAT_total_feasign_num_in_mem, total_fea_num_);
 }
+
+int64_t SlotRecordDataset::GetRecordPoolMemorySize() {
+  return SlotRecordPool().memory_size();
+}
 void SlotRecordDataset::GlobalShuffle(int thread_num) {
   // TODO(yaoxuefeng)
   return;
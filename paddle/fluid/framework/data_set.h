@@ -136,6 +136,8 @@ class Dataset {
   virtual int64_t GetMemoryDataSize() = 0;
   // get memory data size in input_pv_channel_
   virtual int64_t GetPvDataSize() = 0;
+  // get bytes retained by the record object pool for reuse
+  virtual int64_t GetRecordPoolMemorySize() = 0;
   // get shuffle data size
   virtual int64_t GetShuffleDataSize() = 0;
   // merge by ins id
@@ -257,6 +259,7 @@ class DatasetImpl : public Dataset {
   virtual void DestroyReaders();
   virtual int64_t GetMemoryDataSize();
   virtual int64_t GetPvDataSize();
+  virtual int64_t GetRecordPoolMemorySize() { return 0; }
   virtual int64_t GetShuffleDataSize();
   virtual void MergeByInsId() {}
   virtual void PreprocessInstance() {}
@@ -439,6 +442,7 @@ class SlotRecordDataset : public DatasetImpl<SlotRecord> {
                                        bool discard_remaining_ins);
   virtual void PrepareTrain();
   virtual void DynamicAdjustReadersNum(int thread_num);
+  virtual int64_t GetRecordPoolMemorySize();
   void DynamicAdjustBatchNum();
 
  protected:
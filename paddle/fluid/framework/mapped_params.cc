@@ -0,0 +1,318 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/mapped_params.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/convert_utils.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/platform/enforce.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// The padding is an unknown, length delimited field of TensorDesc. Its field
+// number 2000 is far away from the fields of framework.proto, the tag takes
+// two bytes as a varint and the length one byte, so 3 to 130 bytes can be
+// padded.
+constexpr uint8_t kPaddingTag[2] = {0x82, 0x7D};
+constexpr size_t kMinPadding = 3;
+constexpr size_t kMaxPadding = 130;
+
+// Appends padding to the serialized `desc` so that the payload which follows
+// it, written at `payload_offset` without padding, starts at a multiple of
+// `alignment`.
+void PadTensorDesc(std::string* desc, size_t payload_offset, size_t alignment) {
+  size_t padding =
+      (alignment - (payload_offset + kMinPadding) % alignment) % alignment +
+      kMinPadding;
+  desc->push_back(static_cast<char>(kPaddingTag[0]));
+  desc->push_back(static_cast<char>(kPaddingTag[1]));
+  desc->push_back(static_cast<char>(padding - kMinPadding));
+  desc->append(padding - kMinPadding, '\0');
+}
+
+template <typename T>
+void ReadPod(std::istream& is, T* value, const std::string& file_path) {
+  is.read(reinterpret_cast<char*>(value), sizeof(T));
+  PADDLE_ENFORCE_EQ(
+      is.good(),
+      true,
+      phi::errors::Unavailable("Params file %s is truncated or damaged.",
+                               file_path));
+}
+
+template <typename T>
+void WritePod(std::ostream& os, const T& value, size_t* offset) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  *offset += sizeof(T);
+}
+
+void CopyBytes(std::istream& is,
+               std::ostream& os,
+               size_t size,
+               size_t* offset,
+               const std::string& file_path) {
+  constexpr size_t kChunkSize = 1 << 20;
+  std::unique_ptr<char[]> buf(new char[std::min(size, kChunkSize) + 1]);
+  for (size_t done = 0; done < size;) {
+    size_t n = std::min(size - done, kChunkSize);
+    is.read(buf.get(), static_cast<std::streamsize>(n));
+    PADDLE_ENFORCE_EQ(
+        is.good(),
+        true,
+        phi::errors::Unavailable("Params file %s is truncated or damaged.",
+                                 file_path));
+    os.write(buf.get(), static_cast<std::streamsize>(n));
+    done += n;
+  }
+  *offset += size;
+}
+
+#ifndef _WIN32
+// Reads the fields of a mapped params file in place.
+class MappedParamsReader {
+ public:
+  explicit MappedParamsReader(
+      std::shared_ptr<memory::allocation::MappedFile> file)
+      : file_(std::move(file)) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    std::memcpy(&value, Skip(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  const char* Skip(size_t size) {
+    PADDLE_ENFORCE_LE(
+        size,
+        file_->size() - offset_,
+        phi::errors::Unavailable(
+            "Params file %s is truncated or damaged, %d bytes are expected at "
+            "offset %d but the file has only %d bytes.",
+            file_->path(),
+            size,
+            offset_,
+            file_->size()));
+    const char* ptr = file_->data() + offset_;
+    offset_ += size;
+    return ptr;
+  }
+
+  size_t offset() const { return offset_; }
+  bool eof() const { return offset_ == file_->size(); }
+
+ private:
+  std::shared_ptr<memory::allocation::MappedFile> file_;
+  size_t offset_{0};
+};
+#endif
+
+}  // namespace
+
+bool IsMappedParamsSupported() {
+#ifndef _WIN32
+  return true;
+#else
+  return false;
+#endif
+}
+
+MappedParamsStats LoadCombinedParamsFromMappedFile(
+    const std::string& file_path,
+    const std::vector<phi::DenseTensor*>& tensors,
+    const phi::Place& place) {
+#ifndef _WIN32
+  auto file = memory::allocation::MappedFile::Open(file_path);
+  MappedParamsReader reader(file);
+  MappedParamsStats stats;
+  for (auto* tensor : tensors) {
+    // the same layout as DeserializeFromStream and TensorFromStream
+    auto version = reader.Read<uint32_t>();
+    PADDLE_ENFORCE_EQ(
+        version,
+        0U,
+        phi::errors::InvalidArgument(
+            "Deserialize to tensor failed, maybe the loaded file is "
+            "not a paddle model(expected file format: 0, but %u found).",
+            version));
+    auto lod_level = reader.Read<uint64_t>();
+    auto& lod = *tensor->mutable_lod();
+    lod.resize(lod_level);
+    for (uint64_t i = 0; i < lod_level; ++i) {
+      auto size = reader.Read<uint64_t>();
+      const char* level = reader.Skip(size);
+      lod[i].resize(size / sizeof(size_t));
+      std::memcpy(lod[i].data(), level, size);
+    }
+
+    version = reader.Read<uint32_t>();
+    PADDLE_ENFORCE_EQ(
+        version,
+        0U,
+        phi::errors::InvalidArgument(
+            "tensor version %u is not supported, Only version 0 is supported",
+            version));
+    auto desc_size = reader.Read<int32_t>();
+    PADDLE_ENFORCE_GE(desc_size,
+                      0,
+                      phi::errors::InvalidArgument(
+                          "phi::DenseTensor desc size should >= 0"));
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE_EQ(desc.ParseFromArray(reader.Skip(desc_size), desc_size),
+                      true,
+                      phi::errors::InvalidArgument("Cannot parse tensor desc"));
+
+    std::vector<int64_t> dims(desc.dims().begin(), desc.dims().end());
+    tensor->Resize(common::make_ddim(dims));
+    auto dtype = TransToPhiDataType(desc.data_type());
+    size_t size = tensor->numel() * SizeOfType(desc.data_type());
+    size_t offset = reader.offset();
+    reader.Skip(size);
+
+    // non cpu tensors are copied to the place from a cpu alias of the file
+    bool aligned = offset % kMappedParamsAlignment == 0;
+    phi::DenseTensor cpu_tensor;
+    phi::DenseTensor* dst = phi::is_cpu_place(place) ? tensor : &cpu_tensor;
+    dst->Resize(tensor->dims());
+    if (aligned) {
+      dst->ResetHolderWithType(
+          std::make_shared<memory::allocation::MappedFileAllocation>(
+              file, offset, size),
+          dtype);
+    } else {
+      void* buf = dst->mutable_data(phi::CPUPlace(), dtype);
+      std::memcpy(buf, file->data() + offset, size);
+    }
+    if (dst != tensor) {
+      TensorCopySync(*dst, place, tensor);
+    }
+    if (aligned && dst == tensor) {
+      ++stats.mapped_num;
+      stats.mapped_bytes += size;
+    } else {
+      stats.copied_bytes += size;
+    }
+    ++stats.tensor_num;
+  }
+  PADDLE_ENFORCE_EQ(
+      reader.eof(),
+      true,
+      phi::errors::Unavailable("Not allowed to load partial data via "
+                               "load_combine_op, please use load_op instead."));
+  VLOG(3) << "Load " << stats.tensor_num << " tensors from " << file_path
+          << ", " << stats.mapped_num << " mapped (" << stats.mapped_bytes
+          << " bytes), " << stats.copied_bytes << " bytes copied";
+  return stats;
+#else
+  PADDLE_THROW(phi::errors::Unimplemented(
+      "Memory mapped params are not supported on windows."));
+#endif
+}
+
+void AlignCombinedParamsFile(const std::string& src,
+                             const std::string& dst,
+                             size_t alignment) {
+  PADDLE_ENFORCE_EQ(
+      alignment > 0 && alignment <= kMaxPadding - kMinPadding + 1,
+      true,
+      phi::errors::InvalidArgument(
+          "The alignment of params should be in [1, %d], but got %d.",
+          kMaxPadding - kMinPadding + 1,
+          alignment));
+  std::ifstream fin(src, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin),
+                    true,
+                    phi::errors::Unavailable(
+                        "Cannot open file %s for reading params.", src));
+  std::ofstream fout(dst, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fout),
+                    true,
+                    phi::errors::Unavailable(
+                        "Cannot open file %s for writing params.", dst));
+
+  size_t offset = 0;
+  size_t tensor_num = 0;
+  while (fin.peek() != EOF) {
+    uint32_t version = 0;
+    ReadPod(fin, &version, src);
+    WritePod(fout, version, &offset);
+    uint64_t lod_level = 0;
+    ReadPod(fin, &lod_level, src);
+    WritePod(fout, lod_level, &offset);
+    for (uint64_t i = 0; i < lod_level; ++i) {
+      uint64_t size = 0;
+      ReadPod(fin, &size, src);
+      WritePod(fout, size, &offset);
+      CopyBytes(fin, fout, size, &offset, src);
+    }
+
+    ReadPod(fin, &version, src);
+    WritePod(fout, version, &offset);
+    int32_t desc_size = 0;
+    ReadPod(fin, &desc_size, src);
+    PADDLE_ENFORCE_GE(desc_size,
+                      0,
+                      phi::errors::InvalidArgument(
+                          "phi::DenseTensor desc size should >= 0"));
+    std::string buf(desc_size, '\0');
+    fin.read(&buf[0], desc_size);
+    proto::VarType::TensorDesc desc;
+    PADDLE_ENFORCE_EQ(desc.ParseFromString(buf),
+                      true,
+                      phi::errors::InvalidArgument("Cannot parse tensor desc"));
+    // drop the padding of a file which was aligned before
+    desc.DiscardUnknownFields();
+    buf = desc.SerializeAsString();
+    PadTensorDesc(&buf, offset + sizeof(int32_t) + buf.size(), alignment);
+    WritePod(fout, static_cast<int32_t>(buf.size()), &offset);
+    fout.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+    offset += buf.size();
+
+    int64_t numel = 1;
+    for (auto dim : desc.dims()) {
+      numel *= dim;
+    }
+    CopyBytes(fin,
+              fout,
+              static_cast<size_t>(numel) * SizeOfType(desc.data_type()),
+              &offset,
+              src);
+    ++tensor_num;
+  }
+  fout.close();
+  PADDLE_ENFORCE_EQ(
+      static_cast<bool>(fout),
+      true,
+      phi::errors::Unavailable("Failed to write params file %s.", dst));
+  VLOG(3) << "Align " << tensor_num << " tensors of " << src << " to "
+          << alignment << " bytes in " << dst;
+}
+
+}  // namespace framework
+}  // namespace paddle
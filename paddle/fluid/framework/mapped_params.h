@@ -0,0 +1,65 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "paddle/phi/common/place.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/utils/test_macros.h"
+
+namespace paddle {
+namespace framework {
+
+// Tensor payloads starting at a multiple of this offset in a params file can
+// be used in place from the mapped file.
+constexpr size_t kMappedParamsAlignment = 64;
+
+struct MappedParamsStats {
+  size_t tensor_num{0};
+  // tensors aliasing the mapped file, and their bytes
+  size_t mapped_num{0};
+  size_t mapped_bytes{0};
+  // bytes copied out of the mapped file, unaligned or non cpu tensors
+  size_t copied_bytes{0};
+};
+
+// Whether params files can be memory mapped on this platform.
+TEST_API bool IsMappedParamsSupported();
+
+// Loads the tensors of a combined params file, in the format written by
+// save_combine, from a private memory mapping of the file. On CPU place the
+// tensors whose payload is aligned to kMappedParamsAlignment alias the file
+// pages, which are shared by all the processes mapping the same file through
+// the page cache and only copied when written. Other tensors are copied out
+// of the mapping. Like load_combine, the whole file must be consumed.
+TEST_API MappedParamsStats
+LoadCombinedParamsFromMappedFile(const std::string& file_path,
+                                 const std::vector<phi::DenseTensor*>& tensors,
+                                 const phi::Place& place);
+
+// Rewrites the combined params file `src` to `dst` so that every tensor
+// payload starts at a multiple of `alignment`. The padding is stored as an
+// unknown field of the tensor desc, so `dst` is still a valid params file
+// for load_combine and older versions of paddle.
+TEST_API void AlignCombinedParamsFile(
+    const std::string& src,
+    const std::string& dst,
+    size_t alignment = kMappedParamsAlignment);
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,121 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/memory_offset_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) & ~(alignment - 1);
+}
+
+void CheckAlignment(size_t alignment) {
+  PADDLE_ENFORCE_EQ(
+      alignment > 0 && (alignment & (alignment - 1)) == 0,
+      true,
+      platform::errors::InvalidArgument(
+          "The alignment should be a power of two, but got %d.", alignment));
+}
+
+bool Overlap(const TensorLifetime& a, const TensorLifetime& b) {
+  return a.first_use <= b.last_use && b.first_use <= a.last_use;
+}
+
+}  // namespace
+
+MemoryOffsetPlan MakeMemoryOffsetPlan(
+    const std::vector<TensorLifetime>& lifetimes, size_t alignment) {
+  CheckAlignment(alignment);
+  MemoryOffsetPlan plan;
+  plan.alignment = alignment;
+  plan.offsets.assign(lifetimes.size(), 0);
+  plan.sizes.resize(lifetimes.size());
+  for (size_t i = 0; i < lifetimes.size(); ++i) {
+    plan.sizes[i] = AlignUp(lifetimes[i].size, alignment);
+  }
+
+  std::vector<size_t> order(lifetimes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    if (plan.sizes[a] != plan.sizes[b]) return plan.sizes[a] > plan.sizes[b];
+    return lifetimes[a].first_use < lifetimes[b].first_use;
+  });
+
+  // The tensors placed so far, ordered by offset.
+  std::vector<size_t> placed;
+  for (size_t id : order) {
+    if (plan.sizes[id] == 0) continue;
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t prev_end = 0;
+    for (size_t other : placed) {
+      if (!Overlap(lifetimes[id], lifetimes[other])) continue;
+      size_t offset = plan.offsets[other];
+      if (offset > prev_end) {
+        size_t gap = offset - prev_end;
+        if (gap >= plan.sizes[id] && gap < best_gap) {
+          best_gap = gap;
+          best_offset = prev_end;
+        }
+      }
+      prev_end = std::max(prev_end, offset + plan.sizes[other]);
+    }
+    if (best_offset == std::numeric_limits<size_t>::max()) {
+      best_offset = prev_end;
+    }
+    plan.offsets[id] = best_offset;
+    plan.arena_size =
+        std::max(plan.arena_size, best_offset + plan.sizes[id]);
+    auto pos = std::upper_bound(
+        placed.begin(), placed.end(), best_offset, [&](size_t offset, size_t x) {
+          return offset < plan.offsets[x];
+        });
+    placed.insert(pos, id);
+  }
+  return plan;
+}
+
+size_t MemoryLowerBound(const std::vector<TensorLifetime>& lifetimes,
+                        size_t alignment) {
+  CheckAlignment(alignment);
+  // A tensor is freed after its last use, before the next op allocates.
+  std::vector<std::pair<int64_t, int64_t>> events;
+  events.reserve(lifetimes.size() * 2);
+  for (auto& lifetime : lifetimes) {
+    auto size = static_cast<int64_t>(AlignUp(lifetime.size, alignment));
+    events.emplace_back(lifetime.first_use, size);
+    events.emplace_back(static_cast<int64_t>(lifetime.last_use) + 1, -size);
+  }
+  std::sort(events.begin(), events.end());
+  int64_t live = 0;
+  int64_t peak = 0;
+  for (auto& event : events) {
+    live += event.second;
+    peak = std::max(peak, live);
+  }
+  return static_cast<size_t>(peak);
+}
+
+}  // namespace framework
+}  // namespace paddle
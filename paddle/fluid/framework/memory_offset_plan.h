@@ -0,0 +1,79 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/phi/core/allocator.h"
+#include "paddle/utils/test_macros.h"
+
+namespace paddle {
+namespace framework {
+
+// A tensor to place, it is live from the op first_use to the op last_use,
+// both included.
+struct TensorLifetime {
+  std::string name;
+  size_t size{0};
+  int first_use{0};
+  int last_use{0};
+};
+
+// MemoryOffsetPlan places every tensor at an offset of one arena, tensors
+// whose lifetimes overlap never overlap in the arena.
+struct MemoryOffsetPlan {
+  size_t alignment{1};
+  // The offsets and the aligned sizes, in the order of the lifetimes given.
+  std::vector<size_t> offsets;
+  std::vector<size_t> sizes;
+  size_t arena_size{0};
+};
+
+// Places the tensors greedy by size: the largest tensor first, each at the
+// smallest gap between the tensors placed before whose lifetimes overlap
+// with it, or after them if no gap fits. The offsets and sizes are multiples
+// of alignment, which should be a power of two.
+TEST_API MemoryOffsetPlan
+MakeMemoryOffsetPlan(const std::vector<TensorLifetime>& lifetimes,
+                     size_t alignment);
+
+// The most memory the tensors live at the same time take, no plan needs
+// less.
+TEST_API size_t
+MemoryLowerBound(const std::vector<TensorLifetime>& lifetimes,
+                 size_t alignment);
+
+// A slot of the arena of an offset plan. It keeps the arena alive, so a
+// tensor still holding the slot stays valid after the plan is made again.
+class ArenaSlot : public phi::Allocation {
+ public:
+  ArenaSlot(const std::shared_ptr<phi::Allocation>& arena,
+            size_t offset,
+            size_t size)
+      : phi::Allocation(static_cast<uint8_t*>(arena->ptr()) + offset,
+                        size,
+                        arena->place()),
+        arena_(arena) {}
+
+ private:
+  std::shared_ptr<phi::Allocation> arena_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,14 +14,19 @@
 
 #include "paddle/fluid/framework/naive_executor.h"
 
+#include <algorithm>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "paddle/fluid/framework/new_executor/interpreter/executor_plan.h"
+#include "paddle/fluid/framework/new_executor/pir_interpreter.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/denormal.h"
 #ifdef PADDLE_WITH_DNNL
 #include "paddle/fluid/platform/onednn_helper.h"
@@ -34,6 +39,7 @@
 #endif
 
 namespace paddle::framework {
+
 void NaiveExecutor::Prepare(Scope *scope,
                             const ProgramDesc &program_desc,
                             int block_id) {
@@ -59,7 +65,7 @@ void NaiveExecutor::PrepareInterpreterCore(
     Scope *scope,
     const ProgramDesc &program_desc,
     const framework::interpreter::ExecutionConfig &execution_config) {
-  interpreter_core_ = std::make_unique<framework::InterpreterCore>(
+  interpreter_core_ = std::make_shared<framework::InterpreterCore>(
       place_, program_desc.Block(0), scope, execution_config);
 }
 
@@ -68,13 +74,40 @@ void NaiveExecutor::PrepareInterpreterCore(
     const ::pir::Program &pir_program,
     const framework::interpreter::ExecutionConfig &execution_config) {
   interpreter_core_ =
-      std::make_unique<framework::InterpreterCore>(place_,
+      std::make_shared<framework::InterpreterCore>(place_,
                                                    std::vector<std::string>{},
                                                    pir_program.block(),
                                                    scope,
                                                    execution_config);
 }
 
+void NaiveExecutor::ShareBuildResultsFrom(const NaiveExecutor &src) {
+  PADDLE_ENFORCE_EQ(
+      interpreter_core_ && src.interpreter_core_,
+      true,
+      platform::errors::PreconditionNotMet(
+          "The interpreter core should be prepared before sharing."));
+  interpreter_core_->ShareBuildResultsFrom(src.interpreter_core_);
+}
+
+bool NaiveExecutor::SaveExecutorPlan(const std::string &path) const {
+  auto *impl = interpreter_core_ ? dynamic_cast<const PirInterpreter *>(
+                                       interpreter_core_->Impl())
+                                 : nullptr;
+  PADDLE_ENFORCE_NOT_NULL(
+      impl,
+      platform::errors::PreconditionNotMet(
+          "Only the interpreter core of a pir program has an executor plan."));
+  return interpreter::SaveExecutorPlan(*impl->ExportExecutorPlan(), path);
+}
+
+bool NaiveExecutor::ExecutorPlanApplied() const {
+  auto *impl = interpreter_core_ ? dynamic_cast<const PirInterpreter *>(
+                                       interpreter_core_->Impl())
+                                 : nullptr;
+  return impl != nullptr && impl->ExecutorPlanApplied();
+}
+
 void NaiveExecutor::RunInterpreterCore(
     const std::vector<std::string> &feed_names,
     bool need_fetch,
@@ -151,6 +184,9 @@ void NaiveExecutor::Run() {
       func(op.get(), scope_);
     }
   }
+  if (!planned_tensors_.empty()) {
+    UpdateOffsetPlan();
+  }
 #ifdef PADDLE_WITH_NVTX
   platform::CudaNvtxRangePop();
 #endif
@@ -291,6 +327,119 @@ void NaiveExecutor::MakeReusePlan(
   }
 }
 
+void NaiveExecutor::MakeOffsetPlan(const std::vector<std::string> &var_names) {
+  std::unordered_set<std::string> candidates(var_names.begin(),
+                                             var_names.end());
+  std::unordered_map<std::string, size_t> planned_ids;
+  planned_tensors_.clear();
+  for (int i = 0; i < static_cast<int>(ops_.size()); ++i) {
+    auto touch = [&](const std::string &name, bool is_output) {
+      auto iter = planned_ids.find(name);
+      if (iter != planned_ids.end()) {
+        planned_tensors_[iter->second].lifetime.last_use = i;
+        return;
+      }
+      if (!candidates.count(name)) return;
+      candidates.erase(name);
+      // A tensor read before it is written is fed, or kept between runs.
+      auto *var = scope_->FindVar(name);
+      if (!is_output || !var || !var->IsType<phi::DenseTensor>()) return;
+      PlannedTensor planned;
+      planned.tensor = var->GetMutable<phi::DenseTensor>();
+      planned.lifetime.name = name;
+      planned.lifetime.first_use = i;
+      planned.lifetime.last_use = i;
+      planned_ids.emplace(name, planned_tensors_.size());
+      planned_tensors_.emplace_back(std::move(planned));
+    };
+    for (auto &name : ops_[i]->InputVars()) {
+      touch(name, false);
+    }
+    for (auto &name : ops_[i]->OutputVars(true)) {
+      touch(name, true);
+    }
+  }
+  VLOG(3) << "Plan the offsets of " << planned_tensors_.size() << " of "
+          << var_names.size() << " tensors";
+}
+
+void NaiveExecutor::UpdateOffsetPlan() {
+  // The run shared whole buffers by the clusters of MakeReusePlan, which
+  // the offset plan takes over from. A buffer is only shared outside of the
+  // plan if it has more references than the tensors of its cluster.
+  bool from_clusters = !reuse_cache_.empty();
+  std::unordered_map<phi::Allocation *, int64_t> cluster_refs;
+  if (from_clusters) {
+    std::unordered_set<phi::DenseTensor *> cluster_tensors(
+        cluster_buffer_.begin(), cluster_buffer_.end());
+    for (auto &op_map : reuse_cache_) {
+      for (auto &it : op_map.second) {
+        cluster_tensors.insert(it.first);
+      }
+    }
+    for (auto *tensor : cluster_tensors) {
+      if (tensor && tensor->Holder()) {
+        ++cluster_refs[tensor->Holder().get()];
+      }
+    }
+    reuse_cache_.clear();
+    cluster_buffer_.clear();
+  }
+  bool replan = from_clusters;
+  for (auto &planned : planned_tensors_) {
+    if (planned.excluded) continue;
+    auto &holder = planned.tensor->Holder();
+    if (!holder) continue;
+    bool in_slot = holder == planned.slot;
+    // A buffer shared with another tensor lives longer than the lifetime of
+    // the tensor, so the tensor is left to the allocator.
+    int64_t own_refs = from_clusters ? cluster_refs[holder.get()] : 1;
+    bool shared =
+        (planned.slot && planned.slot.use_count() > (in_slot ? 2 : 1)) ||
+        (!in_slot && holder.use_count() > own_refs);
+    if (shared || !(holder->place() == place_) ||
+        planned.tensor->meta().offset != 0) {
+      VLOG(3) << "Leave " << planned.lifetime.name << " out of the plan";
+      planned.excluded = true;
+      replan = replan || planned.slot != nullptr;
+      continue;
+    }
+    // Kernels may allocate more than the dims take, e.g. for padded layouts.
+    if (!in_slot && (!planned.slot || planned.tensor->memory_size() >
+                                          planned.slot->size())) {
+      replan = true;
+    }
+  }
+  if (!replan) return;
+
+  std::vector<TensorLifetime> lifetimes;
+  std::vector<PlannedTensor *> tensors;
+  for (auto &planned : planned_tensors_) {
+    if (planned.excluded || !planned.tensor->Holder()) continue;
+    // the buffer of a cluster is as large as its largest tensor
+    size_t size = from_clusters ? planned.tensor->numel() *
+                                      phi::SizeOf(planned.tensor->dtype())
+                                : planned.tensor->memory_size();
+    planned.lifetime.size = std::max(planned.lifetime.size, size);
+    lifetimes.push_back(planned.lifetime);
+    tensors.push_back(&planned);
+  }
+  size_t alignment = platform::is_cpu_place(place_) ? 64 : 256;
+  auto plan = MakeMemoryOffsetPlan(lifetimes, alignment);
+  if (plan.arena_size == 0) return;
+  auto arena = memory::AllocShared(place_, plan.arena_size);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    if (plan.sizes[i] == 0) continue;
+    tensors[i]->slot =
+        std::make_shared<ArenaSlot>(arena, plan.offsets[i], plan.sizes[i]);
+    tensors[i]->tensor->ResetHolder(tensors[i]->slot);
+  }
+  VLOG(3) << "Place " << tensors.size() << " tensors in an arena of "
+          << plan.arena_size << " bytes, instead of "
+          << std::accumulate(plan.sizes.begin(), plan.sizes.end(), size_t{0})
+          << " bytes";
+}
+
 NaiveExecutor::~NaiveExecutor() {
 #ifdef PADDLE_WITH_DNNL
   // Clear mkl-dnn cache,
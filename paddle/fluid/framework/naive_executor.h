@@ -20,6 +20,7 @@
 #include <unordered_map>
 #include <vector>
 
+#include "paddle/fluid/framework/memory_offset_plan.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
@@ -70,6 +71,19 @@ class NaiveExecutor {
       const framework::interpreter::ExecutionConfig& execution_config =
           framework::interpreter::ExecutionConfig{});
 
+  // Share the dependency and event analysis of the interpreter core of src,
+  // which runs the same pir program. Nothing is shared before src has run.
+  void ShareBuildResultsFrom(const NaiveExecutor& src);
+
+  // Save the build results of the interpreter core of a pir program to path,
+  // see ExecutionConfig::executor_plan. Only valid after the first run.
+  // Returns false if the plan could not be written.
+  bool SaveExecutorPlan(const std::string& path) const;
+
+  // Whether the interpreter core used the executor plan of its
+  // ExecutionConfig instead of analysing the program.
+  bool ExecutorPlanApplied() const;
+
   // Create variables before head.
   // Create parameters if persistable is true, or create the temporary variables
   // instead.
@@ -93,6 +107,14 @@ class NaiveExecutor {
   void MakeReusePlan(
       const std::unordered_map<std::string, std::string>& reuse_table);
 
+  // Place the dense tensors of var_names at offsets of one arena instead,
+  // see MakeMemoryOffsetPlan. The lifetimes are taken in the order the ops
+  // run and the sizes from the last run, so the plan is made after the first
+  // run, and again after a run in which a tensor outgrows its slot. The
+  // first run still shares whole buffers if MakeReusePlan was called. A
+  // tensor read before it is written, or sharing its buffer, is left out.
+  void MakeOffsetPlan(const std::vector<std::string>& var_names);
+
   void ResetTrtOps(int num);
 
   void RegisterOutputHook(const HookFunc& hookfunc);
@@ -103,6 +125,8 @@ class NaiveExecutor {
  private:
   void CreateOps(const ProgramDesc& desc, int block_id);
 
+  void UpdateOffsetPlan();
+
  private:
   const phi::Place place_;
   // Catch the required resource to avoid recreate.
@@ -120,7 +144,15 @@ class NaiveExecutor {
       reuse_cache_;
   std::vector<phi::DenseTensor*> cluster_buffer_;
 
-  std::unique_ptr<framework::InterpreterCore> interpreter_core_;
+  struct PlannedTensor {
+    phi::DenseTensor* tensor;
+    TensorLifetime lifetime;
+    std::shared_ptr<phi::Allocation> slot;
+    bool excluded{false};
+  };
+  std::vector<PlannedTensor> planned_tensors_;
+
+  std::shared_ptr<framework::InterpreterCore> interpreter_core_;
 };
 
 }  // namespace framework
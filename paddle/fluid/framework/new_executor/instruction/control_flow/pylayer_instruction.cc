@@ -121,6 +121,9 @@ PyLayerInstruction::PyLayerInstruction(
   auto skip_gc_vars = execution_config.skip_gc_vars;
   execution_config.skip_gc_vars.clear();
   execution_config.create_local_scope = true;
+  execution_config.shape_plan_cache = nullptr;
+  execution_config.executor_plan = nullptr;
+  execution_config.run_stats = nullptr;
   fwd_inter_ = new PirInterpreter(place,
                                   {},
                                   &fwd_block,
@@ -17,6 +17,7 @@
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/stream_analyzer.h"
 #include "paddle/fluid/framework/new_executor/pir_adaptor/pir_adaptor_util.h"
+#include "paddle/fluid/framework/new_executor/shape_plan_cache.h"
 #include "paddle/fluid/framework/scope.h"
 #include "paddle/fluid/pir/dialect/operator/interface/infermeta.h"
 #include "paddle/fluid/pir/dialect/operator/interface/op_yaml_info.h"
@@ -26,6 +27,7 @@
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/phi/core/infermeta_utils.h"
 #include "paddle/phi/core/meta_tensor.h"
+#include "paddle/phi/core/tensor_utils.h"
 #include "paddle/phi/core/type_defs.h"
 
 #include "paddle/pir/include/core/builtin_attribute.h"
@@ -117,6 +119,17 @@ PhiKernelInstruction::PhiKernelInstruction(
       paddle::dialect::IsLegacyOp(op_name));
   VLOG(6) << "finish process yaml_info_parser";
 
+  // e.g. the shape of reshape or the axes of slice given as tensors, the
+  // output metas follow from their values and not only from the shapes
+  size_t input_num =
+      std::min(yaml_info_parser.InputNames().size(), op->num_operands());
+  for (size_t i = 0; i < input_num; ++i) {
+    if (yaml_info_parser.IsTensorAttribute(i) && op->operand_source(i)) {
+      has_tensor_attribute_ = true;
+      break;
+    }
+  }
+
   if (infer_meta_interface_) {
     BuildPhiContext<
         phi::InferMetaContext,
@@ -179,17 +192,93 @@ PhiKernelInstruction::PhiKernelInstruction(
 PhiKernelInstruction::~PhiKernelInstruction() { delete phi_kernel_; }
 
 void PhiKernelInstruction::Run() {
-  VLOG(6) << "Begin run op " << phi_op_name_ << " infer meta.";
-  if (infer_meta_interface_) {
-    infer_meta_interface_->infer_meta_(&(infer_meta_context_));
+  if (meta_plan_mode_ == MetaPlanMode::kReplay) {
+    VLOG(6) << "Replay op " << phi_op_name_ << " infer meta.";
+    ReplayMetaPlan();
+  } else {
+    VLOG(6) << "Begin run op " << phi_op_name_ << " infer meta.";
+    if (infer_meta_interface_) {
+      infer_meta_interface_->infer_meta_(&(infer_meta_context_));
+    }
+    VLOG(6) << "End run op " << phi_op_name_ << " infer meta.";
+    if (meta_plan_mode_ == MetaPlanMode::kRecord) {
+      RecordMetaPlan();
+    }
   }
-  VLOG(6) << "End run op " << phi_op_name_ << " infer meta.";
   for (auto& pair : this->InplaceInfo()) {
     ShareVarBuffer(pair.first, pair.second);
   }
   VLOG(6) << "Begin run op " << phi_op_name_ << " kernel.";
   (*(phi_kernel_))(&(kernel_context_));
   VLOG(6) << "End run op " << phi_op_name_ << " kernel.";
+  if (meta_plan_mode_ != MetaPlanMode::kNone) {
+    CheckMetaPlan();
+  }
+}
+
+void PhiKernelInstruction::RecordMetaPlan() {
+  if (has_tensor_attribute_) {
+    VLOG(6) << "Op " << phi_op_name_ << " has tensor attributes, it is not "
+            << "cacheable.";
+    meta_plan_->state = InstructionMetaPlan::State::kUncacheable;
+    return;
+  }
+  size_t output_num = kernel_context_.OutputsSize();
+  meta_plan_->output_metas.resize(output_num);
+  for (size_t i = 0; i < output_num; ++i) {
+    auto* output = kernel_context_.MutableOutputAt(i);
+    if (output == nullptr) {
+      meta_plan_->output_metas[i].reset();
+      continue;
+    }
+    // without InferMeta the kernel sets the output metas itself
+    if (!infer_meta_interface_ || !phi::DenseTensor::classof(output) ||
+        common::contain_unknown_dim(output->dims())) {
+      VLOG(6) << "Op " << phi_op_name_ << " is not cacheable.";
+      meta_plan_->state = InstructionMetaPlan::State::kUncacheable;
+      meta_plan_->output_metas.clear();
+      return;
+    }
+    meta_plan_->output_metas[i] = std::make_unique<phi::DenseTensorMeta>(
+        static_cast<phi::DenseTensor*>(output)->meta());
+  }
+  meta_plan_->state = InstructionMetaPlan::State::kRecorded;
+}
+
+void PhiKernelInstruction::ReplayMetaPlan() {
+  for (size_t i = 0; i < meta_plan_->output_metas.size(); ++i) {
+    auto& recorded = meta_plan_->output_metas[i];
+    if (recorded == nullptr) {
+      continue;
+    }
+    // keep the offset of the output, InferMeta does not set it either
+    auto* meta = phi::DenseTensorUtils::GetMutableMeta(
+        static_cast<phi::DenseTensor*>(kernel_context_.MutableOutputAt(i)));
+    meta->dims = recorded->dims;
+    meta->dtype = recorded->dtype;
+    meta->layout = recorded->layout;
+    meta->lod = recorded->lod;
+    meta->strides = recorded->strides;
+    meta->is_scalar = recorded->is_scalar;
+  }
+}
+
+void PhiKernelInstruction::CheckMetaPlan() {
+  if (meta_plan_->state != InstructionMetaPlan::State::kRecorded) {
+    return;
+  }
+  for (size_t i = 0; i < meta_plan_->output_metas.size(); ++i) {
+    auto& recorded = meta_plan_->output_metas[i];
+    if (recorded != nullptr &&
+        kernel_context_.MutableOutputAt(i)->dims() != recorded->dims) {
+      // the kernel computes the shape from the values of its inputs
+      VLOG(6) << "Op " << phi_op_name_ << " resized its output " << i
+              << ", it is not cacheable.";
+      // the recorded metas are kept, other runs may be replaying them
+      meta_plan_->state = InstructionMetaPlan::State::kUncacheable;
+      return;
+    }
+  }
 }
 
 }  // namespace framework
@@ -24,6 +24,7 @@ namespace paddle {
 namespace framework {
 class Scope;
 class ValueExecutionInfo;
+struct InstructionMetaPlan;
 
 class PhiKernelInstruction : public InstructionBase {
  public:
@@ -48,11 +49,33 @@ class PhiKernelInstruction : public InstructionBase {
 
   ::pir::Operation* Operation() const override { return op_; }
 
+  enum class MetaPlanMode {
+    kNone,
+    // Run InferMeta and record the output metas into the plan.
+    kRecord,
+    // Set the recorded output metas instead of running InferMeta.
+    kReplay,
+  };
+
+  // Sets the plan used by the next Run. In both modes the output dims are
+  // checked against the plan after the kernel, a kernel which resizes its
+  // outputs makes the plan uncacheable.
+  void SetMetaPlan(InstructionMetaPlan* plan, MetaPlanMode mode) {
+    meta_plan_ = plan;
+    meta_plan_mode_ = mode;
+  }
+
   void Run() override;
 
   const std::string& Name() const override { return phi_op_name_; }
 
  private:
+  void RecordMetaPlan();
+
+  void ReplayMetaPlan();
+
+  void CheckMetaPlan();
+
   paddle::dialect::InferMetaInterface::Concept* infer_meta_interface_{
       nullptr};  // not owned
 
@@ -67,6 +90,13 @@ class PhiKernelInstruction : public InstructionBase {
   ::pir::Operation* op_{nullptr};  // not owned
 
   const ValueExecutionInfo* value_exec_info_;  // not owned
+
+  InstructionMetaPlan* meta_plan_{nullptr};  // not owned
+
+  MetaPlanMode meta_plan_mode_{MetaPlanMode::kNone};
+
+  // Whether an IntArray or Scalar attribute is given by an input tensor.
+  bool has_tensor_attribute_{false};
 };
 
 }  // namespace framework
@@ -769,6 +769,14 @@ void PirDependencyBuilder::ShareDependencyFrom(
   is_build_ = true;
 }
 
+void PirDependencyBuilder::ShareDependency(
+    std::shared_ptr<std::map<size_t, std::set<size_t>>> op_downstream_map,
+    std::shared_ptr<std::vector<std::vector<bool>>> op_happens_before) {
+  op_downstream_map_ = std::move(op_downstream_map);
+  op_happens_before_ = std::move(op_happens_before);
+  is_build_ = true;
+}
+
 void DependencyBuilderSimplify::GetAllbehind() {
   auto update_op_happen_before = [this](size_t prior_op_idx,
                                         size_t posterior_op_idx) {
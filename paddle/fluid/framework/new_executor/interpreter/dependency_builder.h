@@ -124,6 +124,12 @@ class PirDependencyBuilder : public DependencyBuilder {
 
   void ShareDependencyFrom(const PirDependencyBuilder& src);
 
+  // Uses the dependency built before for the same instructions, e.g. the
+  // one in an ExecutorPlan.
+  void ShareDependency(
+      std::shared_ptr<std::map<size_t, std::set<size_t>>> op_downstream_map,
+      std::shared_ptr<std::vector<std::vector<bool>>> op_happens_before);
+
   bool IsSameDeviceContext(size_t op1, size_t op2) const {
     return &((instructions_)[op1]->DeviceContext()) ==
            &((instructions_)[op2]->DeviceContext());
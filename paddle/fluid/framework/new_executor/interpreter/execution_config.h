@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <memory>
 #include <set>
 #include <string>
 
@@ -21,7 +22,11 @@
 
 namespace paddle {
 namespace framework {
+class ShapePlanCache;
+class RunStatsCollector;
+
 namespace interpreter {
+struct ExecutorPlan;
 
 struct ExecutionConfig {
   bool create_local_scope{true};
@@ -38,6 +43,24 @@ struct ExecutionConfig {
   std::set<std::string> jit_input_vars;
   std::set<std::string> skip_gc_vars;
 
+  // Not owned. When set, the trace run replays the output metas of the
+  // input shapes seen before instead of running InferMeta.
+  ShapePlanCache* shape_plan_cache{nullptr};
+
+  // When set and made for the same instructions, the build results in the
+  // plan are used instead of analysing the program again.
+  std::shared_ptr<const ExecutorPlan> executor_plan;
+
+  // Not owned. When set, the trace run adds the time of the instructions and
+  // the gc to it.
+  RunStatsCollector* run_stats{nullptr};
+
+  // When set, the trace run places the dense tensors it frees again at
+  // offsets of one arena after the first run, see MakeMemoryOffsetPlan. The
+  // outputs of inplace ops share the variable of their input, and so their
+  // slot.
+  bool memory_offset_plan{false};
+
   void AnalyzeThreadPoolConfig(const phi::Place& place, size_t op_num);
   void Log(int log_level);
 };
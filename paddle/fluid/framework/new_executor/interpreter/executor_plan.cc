@@ -0,0 +1,317 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/interpreter/executor_plan.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "paddle/fluid/framework/commit.h"
+#include "paddle/fluid/framework/new_executor/interpreter/dependency_builder.h"
+#include "paddle/fluid/pir/dialect/kernel/ir/kernel_attribute.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/operation.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+namespace {
+
+constexpr char kExecutorPlanMagic[] = "PDEXPLAN";
+constexpr uint32_t kExecutorPlanVersion = 1;
+
+// FNV-1a, stable across processes unlike std::hash.
+class Fnv1aHasher {
+ public:
+  void Update(const void* data, size_t size) {
+    auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * 1099511628211ULL;
+    }
+  }
+  void Update(const std::string& str) {
+    Update(str.data(), str.size());
+    Update(static_cast<uint64_t>(str.size()));
+  }
+  void Update(uint64_t value) { Update(&value, sizeof(value)); }
+
+  uint64_t Hash() const { return hash_; }
+
+ private:
+  uint64_t hash_{14695981039346656037ULL};
+};
+
+class PlanWriter {
+ public:
+  explicit PlanWriter(std::ostream* os) : os_(os) {}
+
+  void Write(uint64_t value) {
+    os_->write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  void Write(const std::string& str) {
+    Write(static_cast<uint64_t>(str.size()));
+    os_->write(str.data(), static_cast<std::streamsize>(str.size()));
+  }
+  void Write(const std::vector<size_t>& values) {
+    Write(static_cast<uint64_t>(values.size()));
+    for (auto value : values) {
+      Write(static_cast<uint64_t>(value));
+    }
+  }
+  void Write(const std::map<size_t, std::set<size_t>>& map) {
+    Write(static_cast<uint64_t>(map.size()));
+    for (auto& pair : map) {
+      Write(static_cast<uint64_t>(pair.first));
+      Write(std::vector<size_t>(pair.second.begin(), pair.second.end()));
+    }
+  }
+  // Packs the rows of the square matrix into bits.
+  void Write(const std::vector<std::vector<bool>>& matrix) {
+    Write(static_cast<uint64_t>(matrix.size()));
+    std::string row_bits;
+    for (auto& row : matrix) {
+      row_bits.assign((row.size() + 7) / 8, '\0');
+      for (size_t i = 0; i < row.size(); ++i) {
+        if (row[i]) {
+          row_bits[i / 8] = static_cast<char>(row_bits[i / 8] | (1 << (i % 8)));
+        }
+      }
+      os_->write(row_bits.data(),
+                 static_cast<std::streamsize>(row_bits.size()));
+    }
+  }
+
+ private:
+  std::ostream* os_;
+};
+
+// Every read checks the stream, a truncated file fails the load instead of
+// reading garbage sizes. The sizes are bounded by the bytes left in the
+// file before anything is allocated, so that a corrupted size field fails
+// the load too instead of driving a huge allocation.
+class PlanReader {
+ public:
+  explicit PlanReader(std::istream* is) : is_(is) {
+    auto pos = is_->tellg();
+    is_->seekg(0, std::ios::end);
+    end_ = is_->tellg();
+    is_->seekg(pos);
+  }
+
+  bool Read(uint64_t* value) {
+    return static_cast<bool>(
+        is_->read(reinterpret_cast<char*>(value), sizeof(*value)));
+  }
+  bool Read(std::string* str) {
+    uint64_t size = 0;
+    if (!Read(&size) || size > Remaining()) return false;
+    str->resize(size);
+    return static_cast<bool>(
+        is_->read(&(*str)[0], static_cast<std::streamsize>(size)));
+  }
+  bool Read(std::vector<size_t>* values) {
+    uint64_t size = 0;
+    if (!Read(&size) || size > Remaining() / sizeof(uint64_t)) return false;
+    values->resize(size);
+    for (auto& value : *values) {
+      uint64_t item = 0;
+      if (!Read(&item)) return false;
+      value = static_cast<size_t>(item);
+    }
+    return true;
+  }
+  bool Read(std::map<size_t, std::set<size_t>>* map) {
+    uint64_t size = 0;
+    // every entry holds at least its key and the size of its values
+    if (!Read(&size) || size > Remaining() / (2 * sizeof(uint64_t))) {
+      return false;
+    }
+    for (uint64_t i = 0; i < size; ++i) {
+      uint64_t key = 0;
+      std::vector<size_t> values;
+      if (!Read(&key) || !Read(&values)) return false;
+      (*map)[key].insert(values.begin(), values.end());
+    }
+    return true;
+  }
+  bool Read(std::vector<std::vector<bool>>* matrix) {
+    uint64_t size = 0;
+    if (!Read(&size)) return false;
+    // size rows of (size + 7) / 8 bytes each
+    uint64_t remaining = Remaining();
+    if (size > remaining ||
+        (size > 0 && (size + 7) / 8 > remaining / size)) {
+      return false;
+    }
+    matrix->assign(size, std::vector<bool>(size, false));
+    std::string row_bits((size + 7) / 8, '\0');
+    for (auto& row : *matrix) {
+      if (!is_->read(&row_bits[0],
+                     static_cast<std::streamsize>(row_bits.size()))) {
+        return false;
+      }
+      for (size_t i = 0; i < size; ++i) {
+        row[i] = (row_bits[i / 8] >> (i % 8)) & 1;
+      }
+    }
+    return true;
+  }
+
+ private:
+  // bytes left in the file, 0 once the stream failed
+  uint64_t Remaining() {
+    auto pos = is_->tellg();
+    if (pos < 0 || end_ < pos) return 0;
+    return static_cast<uint64_t>(end_ - pos);
+  }
+
+  std::istream* is_;
+  std::streampos end_;
+};
+
+}  // namespace
+
+std::string BuildFingerprint() {
+  std::string fingerprint = paddle_version() + "-" + paddle_commit();
+#ifdef PADDLE_WITH_CUDA
+  fingerprint += "-cuda";
+#endif
+#ifdef PADDLE_WITH_HIP
+  fingerprint += "-hip";
+#endif
+#ifdef PADDLE_WITH_XPU
+  fingerprint += "-xpu";
+#endif
+#ifdef PADDLE_WITH_CUSTOM_DEVICE
+  fingerprint += "-custom_device";
+#endif
+#ifdef PADDLE_WITH_DNNL
+  fingerprint += "-onednn";
+#endif
+#ifdef PADDLE_WITH_CINN
+  fingerprint += "-cinn";
+#endif
+  return fingerprint;
+}
+
+uint64_t ProgramFingerprint(
+    const std::vector<std::unique_ptr<InstructionBase>>& instructions) {
+  Fnv1aHasher hasher;
+  hasher.Update(static_cast<uint64_t>(instructions.size()));
+  hasher.Update(static_cast<uint64_t>(FLAGS_new_executor_sequential_run));
+  for (auto& instr : instructions) {
+    hasher.Update(instr->Name());
+    auto* op = instr->Operation();
+    if (op != nullptr && op->HasAttribute("kernel_name")) {
+      hasher.Update(
+          op->attribute<::pir::StrAttribute>("kernel_name").AsString());
+    }
+    if (op != nullptr && op->HasAttribute("kernel_key")) {
+      std::stringstream ss;
+      ss << op->attribute<paddle::dialect::KernelAttribute>("kernel_key")
+                .data();
+      hasher.Update(ss.str());
+    }
+    // the ids of a value are ordered, the values are not
+    for (auto* vars : {&instr->Inputs(), &instr->Outputs()}) {
+      std::vector<std::vector<int>> ids;
+      for (auto& pair : *vars) {
+        ids.push_back(pair.second);
+      }
+      std::sort(ids.begin(), ids.end());
+      hasher.Update(static_cast<uint64_t>(ids.size()));
+      for (auto& value_ids : ids) {
+        hasher.Update(static_cast<uint64_t>(value_ids.size()));
+        for (int id : value_ids) {
+          hasher.Update(static_cast<uint64_t>(id));
+        }
+      }
+    }
+  }
+  return hasher.Hash();
+}
+
+bool SaveExecutorPlan(const ExecutorPlan& plan, const std::string& path) {
+  std::ofstream fout(path, std::ios::binary);
+  if (!fout) {
+    LOG(WARNING) << "Cannot open " << path << " to save the executor plan.";
+    return false;
+  }
+  fout.write(kExecutorPlanMagic, sizeof(kExecutorPlanMagic) - 1);
+  PlanWriter writer(&fout);
+  writer.Write(static_cast<uint64_t>(kExecutorPlanVersion));
+  writer.Write(plan.build_fingerprint);
+  writer.Write(plan.program_fingerprint);
+  writer.Write(plan.trace_execute_order);
+  writer.Write(plan.dependency_count);
+  writer.Write(*plan.op_downstream_map);
+  writer.Write(*plan.op_happens_before);
+  writer.Write(plan.last_live_ops);
+  fout.flush();
+  if (!fout) {
+    LOG(WARNING) << "Failed to save the executor plan to " << path << ".";
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<ExecutorPlan> LoadExecutorPlan(const std::string& path) {
+  std::ifstream fin(path, std::ios::binary);
+  if (!fin) {
+    VLOG(3) << "No executor plan at " << path;
+    return nullptr;
+  }
+  char magic[sizeof(kExecutorPlanMagic) - 1];
+  uint64_t version = 0;
+  PlanReader reader(&fin);
+  if (!fin.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kExecutorPlanMagic, sizeof(magic)) != 0 ||
+      !reader.Read(&version) || version != kExecutorPlanVersion) {
+    LOG(WARNING) << path << " is not an executor plan of version "
+                 << kExecutorPlanVersion << ", it is ignored.";
+    return nullptr;
+  }
+  auto plan = std::make_shared<ExecutorPlan>();
+  if (!reader.Read(&plan->build_fingerprint)) {
+    LOG(WARNING) << "The executor plan " << path << " is truncated.";
+    return nullptr;
+  }
+  if (plan->build_fingerprint != BuildFingerprint()) {
+    LOG(WARNING) << "The executor plan " << path << " was saved by Paddle "
+                 << plan->build_fingerprint << " instead of "
+                 << BuildFingerprint() << ", it is ignored.";
+    return nullptr;
+  }
+  plan->op_downstream_map =
+      std::make_shared<std::map<size_t, std::set<size_t>>>();
+  plan->op_happens_before = std::make_shared<std::vector<std::vector<bool>>>();
+  if (!reader.Read(&plan->program_fingerprint) ||
+      !reader.Read(&plan->trace_execute_order) ||
+      !reader.Read(&plan->dependency_count) ||
+      !reader.Read(plan->op_downstream_map.get()) ||
+      !reader.Read(plan->op_happens_before.get()) ||
+      !reader.Read(&plan->last_live_ops)) {
+    LOG(WARNING) << "The executor plan " << path << " is truncated.";
+    return nullptr;
+  }
+  return plan;
+}
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
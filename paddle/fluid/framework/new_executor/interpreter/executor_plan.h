@@ -0,0 +1,65 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
+
+namespace paddle {
+namespace framework {
+namespace interpreter {
+
+// ExecutorPlan holds the build results of a PirInterpreter which only depend
+// on its instructions: their dependencies, the trace order and the variables
+// each instruction checks for gc. A plan saved with an optimized model lets
+// the predictor loading the model skip the analysis of the same program.
+struct ExecutorPlan {
+  // The Paddle build the plan was made by, see BuildFingerprint.
+  std::string build_fingerprint;
+  // The instructions the plan was made for, see ProgramFingerprint.
+  uint64_t program_fingerprint{0};
+
+  std::vector<size_t> trace_execute_order;
+  std::vector<size_t> dependency_count;
+  std::shared_ptr<std::map<size_t, std::set<size_t>>> op_downstream_map;
+  std::shared_ptr<std::vector<std::vector<bool>>> op_happens_before;
+  // Maps the variable ids to the instructions after which they are freed.
+  std::map<size_t, std::set<size_t>> last_live_ops;
+};
+
+// Identifies the version, commit and compile options of this Paddle build.
+std::string BuildFingerprint();
+
+// Hashes the names, selected kernels and variable ids of the instructions,
+// which decide the build results in the plan.
+uint64_t ProgramFingerprint(
+    const std::vector<std::unique_ptr<InstructionBase>>& instructions);
+
+// Returns false with a warning if the plan could not be written, the plan
+// only saves time and a failure is no reason to fail the run.
+bool SaveExecutorPlan(const ExecutorPlan& plan, const std::string& path);
+
+// Returns nullptr if the file does not hold a plan of this Paddle build.
+std::shared_ptr<ExecutorPlan> LoadExecutorPlan(const std::string& path);
+
+}  // namespace interpreter
+}  // namespace framework
+}  // namespace paddle
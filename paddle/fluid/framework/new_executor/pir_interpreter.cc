@@ -14,16 +14,20 @@
 
 #include "paddle/fluid/framework/new_executor/pir_interpreter.h"
 
+#include <algorithm>
 #include <chrono>
+#include <numeric>
 #include <unordered_set>
 
 #include "paddle/common/flags.h"
 
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/framework/details/share_tensor_buffer_functor.h"
+#include "paddle/fluid/framework/new_executor/interpreter/executor_plan.h"
 #include "paddle/fluid/framework/new_executor/interpreter/interpreter_util.h"
 #include "paddle/fluid/framework/new_executor/interpreter/static_build.h"
 #include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/device/gpu/gpu_info.h"
 #include "paddle/fluid/platform/os_info.h"
 #include "paddle/fluid/platform/profiler/event_tracing.h"
@@ -65,6 +69,7 @@
 #include "paddle/fluid/framework/new_executor/instruction/phi_kernel_instruction.h"
 #include "paddle/fluid/framework/new_executor/instruction/tensorrt_engine_instruction.h"
 #include "paddle/fluid/framework/new_executor/pir_adaptor/pir_adaptor_util.h"
+#include "paddle/fluid/framework/new_executor/shape_plan_cache.h"
 #include "paddle/fluid/pir/dialect/kernel/ir/kernel_attribute.h"
 #include "paddle/fluid/pir/dialect/kernel/ir/kernel_dialect.h"
 #include "paddle/fluid/pir/dialect/kernel/ir/kernel_op.h"
@@ -72,6 +77,7 @@
 #include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/manual_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/manual_pylayer_op.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/tensorrt_op.h"
 #include "paddle/fluid/pir/dialect/operator/utils/utils.h"
 #include "paddle/pir/include/core/builtin_attribute.h"
@@ -770,6 +776,9 @@ void PirInterpreter::AnalyseExecuteOrderForTrace(
 void PirInterpreter::BuildInstruction() {
   VLOG(6) << "Build Instructions for pir ... ";
   vec_instruction_base_.clear();
+  shape_plan_prepared_ = false;
+  run_stats_prepared_ = false;
+  memory_plan_prepared_ = false;
   size_t op_idx = 0;
   for (auto& op : *ir_block_) {
     VLOG(6) << "Build Instruction for op: " << op_idx;
@@ -1271,6 +1280,9 @@ void PirInterpreter::CheckGC(InstructionBase* instr) {
     if (is_ready) {
       VLOG(6) << "Async delete variable with name : "
               << value_exe_info_->GetNameById(static_cast<int>(var_id));
+      if (!planned_var_index_.empty()) {
+        ObserveMemoryPlan(var_id);
+      }
       gc_->Add(refs_[var_id]->Var(), instr);
     }
   }
@@ -1283,6 +1295,43 @@ void PirInterpreter::CheckGC(InstructionBase* instr) {
 
 void PirInterpreter::CalculateLastLiveOps() {
   VLOG(4) << "PirInterpreter(): " << this << " start CalculateLastLiveOps";
+  if (executor_plan_applied_) {
+    RestoreLastLiveOps();
+  } else {
+    AnalyseLastLiveOps();
+  }
+
+  for (auto& dep : *dependency_count_) {
+    deps_.emplace_back(std::make_shared<interpreter::OpDepInfo>(dep));
+  }
+  for (size_t i = 0; i < value_exe_info_->GetVarList().size(); ++i) {
+    refs_.emplace_back(std::make_shared<interpreter::VarRefInfo>(
+        var_ref_count_[i], value_exe_info_->GetVarList()[i]));
+  }
+  VLOG(4) << "done CalculateLastLiveOps";
+}
+
+void PirInterpreter::RestoreLastLiveOps() {
+  last_live_ops_ = execution_config_.executor_plan->last_live_ops;
+  for (const std::string& skip_gc_var : execution_config_.skip_gc_vars) {
+    int var_id = value_exe_info_->GetIdByName(skip_gc_var);
+    if (var_id != -1) {
+      last_live_ops_[var_id].clear();
+      VLOG(8) << "Skip gc for var: " << skip_gc_var;
+    }
+  }
+  // the ids were checked by CheckExecutorPlan
+  var_ref_count_.assign(value_exe_info_->GetVarList().size(), 0);
+  for (auto& pair : last_live_ops_) {
+    for (size_t op_idx : pair.second) {
+      vec_instruction_base_[op_idx]->AddGCCheckVar(pair.first);
+    }
+    var_ref_count_[pair.first] = static_cast<int>(pair.second.size());
+  }
+  VLOG(4) << "restore last_live_ops_ from the executor plan";
+}
+
+void PirInterpreter::AnalyseLastLiveOps() {
   // calculate last_live_ops_
   for (size_t op_idx = 0; op_idx < vec_instruction_base_.size(); ++op_idx) {
     InstructionBase* instr = vec_instruction_base_[op_idx].get();
@@ -1385,15 +1434,6 @@ void PirInterpreter::CalculateLastLiveOps() {
     var_ref_count_[i] = static_cast<int>(last_live_ops_[i].size());
   }
   VLOG(4) << "shrink the last_live_ops list for all vars in skip_gc_vars";
-
-  for (auto& dep : *dependency_count_) {
-    deps_.emplace_back(std::make_shared<interpreter::OpDepInfo>(dep));
-  }
-  for (size_t i = 0; i < value_exe_info_->GetVarList().size(); ++i) {
-    refs_.emplace_back(std::make_shared<interpreter::VarRefInfo>(
-        var_ref_count_[i], value_exe_info_->GetVarList()[i]));
-  }
-  VLOG(4) << "done CalculateLastLiveOps";
 }
 
 void PirInterpreter::ConstructEventForJitInput() {
@@ -1611,7 +1651,20 @@ void PirInterpreter::TraceRunImpl() {
   interpreter::ResetAtomicGuard guard(&deps_, &refs_);
   VLOG(4) << "Tracing Instruction List";
 
+  if (execution_config_.shape_plan_cache) {
+    PrepareShapePlan();
+  }
+  if (execution_config_.run_stats) {
+    PrepareRunStats();
+  }
+  if (execution_config_.memory_offset_plan) {
+    PlaceMemoryPlan();
+  }
   TraceRunInstructionList(vec_instruction_base_);
+  shape_plan_ = nullptr;
+  if (execution_config_.memory_offset_plan) {
+    UpdateMemoryPlan();
+  }
   VLOG(4) << "Done TraceRunInstructionList";
 #ifdef PADDLE_WITH_CUSTOM_DEVICE
   if (phi::is_custom_place(place_)) {
@@ -1620,6 +1673,308 @@ void PirInterpreter::TraceRunImpl() {
 #endif
 }
 
+void PirInterpreter::PrepareRunStats() {
+  auto* run_stats = execution_config_.run_stats;
+  if (!run_stats_prepared_) {
+    // the groups of this program are numbered from 0 for the run
+    std::map<size_t, size_t> group_indices;
+    run_stats_group_ids_.clear();
+    run_stats_instr_groups_.assign(vec_instruction_base_.size(), 0);
+    for (auto& instr : vec_instruction_base_) {
+      size_t group_id = run_stats->GroupId(instr->Name());
+      auto iter = group_indices.find(group_id);
+      if (iter == group_indices.end()) {
+        iter = group_indices.emplace(group_id, group_indices.size()).first;
+        run_stats_group_ids_.push_back(group_id);
+      }
+      run_stats_instr_groups_[instr->Id()] = iter->second;
+    }
+    run_stats_prepared_ = true;
+  }
+  run_stats_group_ns_.assign(run_stats_group_ids_.size(), 0);
+  run_stats_gc_ns_ = 0;
+  // left by the instructions of a multi thread run, which are not recorded
+  instr_gc_ns_.store(0, std::memory_order_relaxed);
+  run_stats_trace_.clear();
+  if (run_stats->SampleTrace()) {
+    run_stats_trace_.reserve(vec_instruction_base_.size());
+  }
+  run_stats_start_ns_ = RunStatsCollector::NowNs();
+}
+
+void PirInterpreter::RecordInstructionStats(InstructionBase* instr,
+                                            uint64_t start_ns) {
+  uint64_t end_ns = RunStatsCollector::NowNs();
+  uint64_t gc_ns = instr_gc_ns_.exchange(0, std::memory_order_relaxed);
+  uint64_t run_ns = end_ns - start_ns - gc_ns;
+  run_stats_group_ns_[run_stats_instr_groups_[instr->Id()]] += run_ns;
+  run_stats_gc_ns_ += gc_ns;
+  if (execution_config_.run_stats->SampleTrace()) {
+    run_stats_trace_.push_back(
+        {instr->Name(), start_ns - run_stats_start_ns_, run_ns, gc_ns});
+  }
+}
+
+void PirInterpreter::FlushRunStats() {
+  auto* run_stats = execution_config_.run_stats;
+  for (size_t i = 0; i < run_stats_group_ids_.size(); ++i) {
+    run_stats->AddGroup(run_stats_group_ids_[i], run_stats_group_ns_[i]);
+  }
+  run_stats->AddPhase(RunStatsCollector::Phase::kGC, run_stats_gc_ns_);
+  if (run_stats->SampleTrace()) {
+    run_stats->AddSampledTrace(std::move(run_stats_trace_));
+    run_stats_trace_.clear();
+  }
+}
+
+void PirInterpreter::PrepareMemoryPlan() {
+  memory_plan_prepared_ = true;
+  planned_vars_.clear();
+  planned_var_index_.clear();
+  memory_replan_ = false;
+  // The lifetimes in the trace order only hold if the instructions run in
+  // that order, which those on another stream than the default one don't.
+  auto* default_ctx = phi::DeviceContextPool::Instance().Get(place_);
+  for (auto& instr : vec_instruction_base_) {
+    if (instr->KernelType() == OpFuncType::kGpuAsync &&
+        &instr->DeviceContext() != default_ctx) {
+      VLOG(3) << "No memory offset plan, " << instr->Name()
+              << " runs on another stream";
+      return;
+    }
+  }
+
+  std::vector<size_t> position(vec_instruction_base_.size(), 0);
+  for (size_t i = 0; i < trace_execute_order_.size(); ++i) {
+    position[trace_execute_order_[i]] = i;
+  }
+  const auto& var_list = value_exe_info_->GetVarList();
+  std::vector<bool> seen(var_list.size(), false);
+  planned_var_index_.assign(var_list.size(), -1);
+  auto touch = [&](int var_id, int pos, bool is_output) {
+    if (var_id < 0 || static_cast<size_t>(var_id) >= var_list.size()) return;
+    int index = planned_var_index_[var_id];
+    if (index >= 0) {
+      planned_vars_[index].lifetime.last_use = pos;
+      return;
+    }
+    if (seen[var_id]) return;
+    seen[var_id] = true;
+    // A tensor read before it is written is fed, or kept between runs. Only
+    // the tensors the gc frees within the run are planned.
+    auto iter = last_live_ops_.find(var_id);
+    if (!is_output || iter == last_live_ops_.end() || iter->second.empty() ||
+        !var_list[var_id]->IsType<phi::DenseTensor>() ||
+        parameter_var_names_.count(value_exe_info_->GetNameById(var_id))) {
+      return;
+    }
+    PlannedVar planned;
+    planned.var_id = var_id;
+    planned.lifetime.name = value_exe_info_->GetNameById(var_id);
+    planned.lifetime.first_use = pos;
+    planned.lifetime.last_use = pos;
+    // the gc after the last instruction of the var to run
+    for (size_t instr_id : iter->second) {
+      planned.lifetime.last_use = std::max(
+          planned.lifetime.last_use, static_cast<int>(position[instr_id]));
+    }
+    planned_var_index_[var_id] = static_cast<int>(planned_vars_.size());
+    planned_vars_.emplace_back(std::move(planned));
+  };
+  for (size_t i = 0; i < trace_execute_order_.size(); ++i) {
+    auto* instr = vec_instruction_base_[trace_execute_order_[i]].get();
+    int pos = static_cast<int>(i);
+    for (auto& pair : instr->Inputs()) {
+      for (int var_id : pair.second) {
+        touch(var_id, pos, false);
+      }
+    }
+    for (auto& pair : instr->Outputs()) {
+      for (int var_id : pair.second) {
+        touch(var_id, pos, true);
+      }
+    }
+  }
+  if (planned_vars_.empty()) {
+    planned_var_index_.clear();
+  }
+  VLOG(3) << "Plan the offsets of " << planned_vars_.size() << " of "
+          << var_list.size() << " variables";
+}
+
+void PirInterpreter::PlaceMemoryPlan() {
+  if (!memory_plan_prepared_) {
+    PrepareMemoryPlan();
+  }
+  for (auto& planned : planned_vars_) {
+    if (planned.excluded || !planned.slot) continue;
+    auto* tensor = value_exe_info_->GetVarList()[planned.var_id]
+                       ->GetMutable<phi::DenseTensor>();
+    auto& holder = tensor->Holder();
+    if (holder == planned.slot) continue;
+    // A buffer set before the run, e.g. by a feed, is not the plan's to
+    // replace.
+    if (holder) {
+      VLOG(3) << "Leave " << planned.lifetime.name << " out of the plan";
+      planned.excluded = true;
+      memory_replan_ = true;
+      continue;
+    }
+    tensor->ResetHolder(planned.slot);
+  }
+}
+
+void PirInterpreter::ObserveMemoryPlan(size_t var_id) {
+  int index = planned_var_index_[var_id];
+  if (index < 0) return;
+  auto& planned = planned_vars_[index];
+  if (planned.excluded) return;
+  auto* var = value_exe_info_->GetVarList()[var_id];
+  if (!var->IsType<phi::DenseTensor>()) return;
+  auto* tensor = var->GetMutable<phi::DenseTensor>();
+  auto& holder = tensor->Holder();
+  if (!holder) return;
+  bool in_slot = holder == planned.slot;
+  // A buffer shared with another tensor lives longer than the lifetime of
+  // the tensor, so the tensor is left to the allocator.
+  bool shared =
+      (planned.slot && planned.slot.use_count() > (in_slot ? 2 : 1)) ||
+      (!in_slot && holder.use_count() > 1);
+  if (shared || !(holder->place() == place_) || tensor->meta().offset != 0) {
+    VLOG(3) << "Leave " << planned.lifetime.name << " out of the plan";
+    planned.excluded = true;
+    memory_replan_ = memory_replan_ || planned.slot != nullptr;
+    return;
+  }
+  planned.lifetime.size =
+      std::max(planned.lifetime.size, tensor->memory_size());
+  // Kernels may allocate more than the dims take, e.g. for padded layouts.
+  if (!in_slot &&
+      (!planned.slot || tensor->memory_size() > planned.slot->size())) {
+    memory_replan_ = true;
+  }
+}
+
+void PirInterpreter::UpdateMemoryPlan() {
+  if (!memory_replan_) return;
+  memory_replan_ = false;
+  std::vector<TensorLifetime> lifetimes;
+  std::vector<PlannedVar*> vars;
+  for (auto& planned : planned_vars_) {
+    planned.slot = nullptr;
+    if (planned.excluded || planned.lifetime.size == 0) continue;
+    lifetimes.push_back(planned.lifetime);
+    vars.push_back(&planned);
+  }
+  size_t alignment = platform::is_cpu_place(place_) ? 64 : 256;
+  auto plan = MakeMemoryOffsetPlan(lifetimes, alignment);
+  memory_plan_arena_size_ = plan.arena_size;
+  if (plan.arena_size == 0) return;
+  // the tensors were freed by the gc, the slots are placed before the run
+  auto arena = memory::AllocShared(place_, plan.arena_size);
+  for (size_t i = 0; i < vars.size(); ++i) {
+    if (plan.sizes[i] == 0) continue;
+    vars[i]->slot =
+        std::make_shared<ArenaSlot>(arena, plan.offsets[i], plan.sizes[i]);
+  }
+  LOG(INFO) << "The " << vars.size() << " temporary tensors of the pir "
+            << "program take "
+            << std::accumulate(plan.sizes.begin(), plan.sizes.end(), size_t{0})
+            << " bytes without reuse and " << plan.arena_size
+            << " bytes packed at offsets, at least "
+            << MemoryLowerBound(lifetimes, alignment) << " bytes";
+}
+
+void PirInterpreter::PrepareShapePlan() {
+  if (!shape_plan_prepared_) {
+    shape_plan_inputs_.clear();
+    for (auto& op : *ir_block_) {
+      std::string op_name = op.name();
+      if (op.attributes().count("op_name")) {
+        op_name = op.attributes()
+                      .at("op_name")
+                      .dyn_cast<::pir::StrAttribute>()
+                      .AsString();
+      }
+      if (op_name == paddle::dialect::FeedOp::name() ||
+          op_name == paddle::dialect::DataOp::name()) {
+        shape_plan_inputs_.push_back(
+            value_exe_info_->GetVarByValue(op.result(0)));
+      }
+    }
+    phi_kernel_instructions_.assign(vec_instruction_base_.size(), nullptr);
+    for (auto& instr : vec_instruction_base_) {
+      phi_kernel_instructions_[instr->Id()] =
+          dynamic_cast<PhiKernelInstruction*>(instr.get());
+    }
+    shape_plan_prepared_ = true;
+  }
+
+  // The shapes of the other variables of the program follow from the feed
+  // variables, so their dtypes, dims and lods make the key of the run.
+  ShapePlanCache::Key key;
+  for (auto* var : shape_plan_inputs_) {
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      key.push_back(-1);
+      continue;
+    }
+    const auto& tensor = var->Get<phi::DenseTensor>();
+    key.push_back(static_cast<int64_t>(tensor.dtype()));
+    key.push_back(tensor.dims().size());
+    for (int i = 0; i < tensor.dims().size(); ++i) {
+      key.push_back(tensor.dims()[i]);
+    }
+    key.push_back(static_cast<int64_t>(tensor.lod().size()));
+    for (auto& level : tensor.lod()) {
+      key.push_back(static_cast<int64_t>(level.size()));
+      key.insert(key.end(), level.begin(), level.end());
+    }
+  }
+  shape_plan_ = execution_config_.shape_plan_cache->Get(
+      key, vec_instruction_base_.size());
+  shape_plan_recording_ = false;
+  if (shape_plan_ && !shape_plan_->recorded.load(std::memory_order_acquire)) {
+    bool expected = false;
+    shape_plan_recording_ =
+        shape_plan_->recording.compare_exchange_strong(expected, true);
+    if (!shape_plan_recording_) {
+      // another interpreter sharing the cache is recording it
+      shape_plan_ = nullptr;
+    }
+  }
+}
+
+// Sets the mode of the phi kernel instruction instr_id for the current
+// shape plan, returns whether the instructions after it may replay their
+// metas.
+bool PirInterpreter::SetInstructionMetaPlan(size_t instr_id, bool replay) {
+  auto* instr = phi_kernel_instructions_[instr_id];
+  if (instr == nullptr) {
+    // legacy kernels, control flow and the like do not record their metas,
+    // their outputs may depend on the values of the inputs
+    auto* instr_node = vec_instruction_base_[instr_id].get();
+    return replay && (instr_node->IsArtificial() ||
+                      dynamic_cast<BuiltinCombineInstruction*>(instr_node));
+  }
+  using MetaPlanMode = PhiKernelInstruction::MetaPlanMode;
+  auto& plan = shape_plan_->instr_plans[instr_id];
+  switch (plan.state) {
+    case InstructionMetaPlan::State::kEmpty:
+      if (!shape_plan_recording_) {
+        // not reached by the run which recorded the plan
+        return false;
+      }
+      instr->SetMetaPlan(&plan, MetaPlanMode::kRecord);
+      return replay;
+    case InstructionMetaPlan::State::kRecorded:
+      instr->SetMetaPlan(&plan,
+                         replay ? MetaPlanMode::kReplay : MetaPlanMode::kNone);
+      return replay;
+    default:
+      return false;
+  }
+}
+
 void PirInterpreter::MultiThreadRunImpl() {
   // lazy initialization of gc, do not create gc is the program only run once
   if (!gc_) {
@@ -1670,13 +2025,31 @@ void PirInterpreter::TraceRunInstructionList(
     }
   }
 
+  // whether the instructions still replay the metas of the shape plan
+  bool replay_meta = shape_plan_ != nullptr;
+  auto* run_stats = execution_config_.run_stats;
   for (size_t idx = 0; idx < trace_execute_order_.size(); idx++) {
     auto instr_id = trace_execute_order_[idx];
     InstructionBase* instr_node = vec_instruction_base_.at(instr_id).get();
 
     VLOG(6) << "Run InstructionBase " << instr_node->Name() << "[" << instr_id
             << "]";
+    if (shape_plan_) {
+      replay_meta = SetInstructionMetaPlan(instr_id, replay_meta);
+    }
+    uint64_t start_ns = run_stats ? RunStatsCollector::NowNs() : 0;
     RunInstructionBase(instr_node);
+    if (run_stats) {
+      RecordInstructionStats(instr_node, start_ns);
+    }
+    if (shape_plan_ && phi_kernel_instructions_[instr_id]) {
+      // the instructions after one which resized its outputs compute their
+      // metas again
+      replay_meta = replay_meta && shape_plan_->instr_plans[instr_id].state !=
+                                       InstructionMetaPlan::State::kUncacheable;
+      phi_kernel_instructions_[instr_id]->SetMetaPlan(
+          nullptr, PhiKernelInstruction::MetaPlanMode::kNone);
+    }
 
     if (UNLIKELY(exception_holder_.IsCaught())) {
       VLOG(4) << "Exception caught";
@@ -1684,6 +2057,11 @@ void PirInterpreter::TraceRunInstructionList(
     }
   }
 
+  if (shape_plan_recording_) {
+    shape_plan_->recorded.store(true, std::memory_order_release);
+    shape_plan_recording_ = false;
+  }
+
   if (UNLIKELY(exception_holder_.IsCaught())) {
     VLOG(1) << "Exception caught " << exception_holder_.Type();
     PADDLE_ENFORCE_EQ(
@@ -1694,6 +2072,9 @@ void PirInterpreter::TraceRunInstructionList(
     VLOG(4) << "clear ok";
     exception_holder_.ReThrow();
   }
+  if (run_stats) {
+    FlushRunStats();
+  }
   VLOG(4) << "Done TraceRunInstructionList";
 }
 
@@ -1920,7 +2301,14 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
               << " runs on " << platform::GetCurrentThreadName() << "\n"
               << "After: " << cur_place << " "
               << instr_node->DebugStringEx(scope_, value_exe_info_.get());
-      CheckGC(instr_node);
+      if (execution_config_.run_stats) {
+        uint64_t gc_start_ns = RunStatsCollector::NowNs();
+        CheckGC(instr_node);
+        instr_gc_ns_.fetch_add(RunStatsCollector::NowNs() - gc_start_ns,
+                               std::memory_order_relaxed);
+      } else {
+        CheckGC(instr_node);
+      }
       VLOG(4) << "done CheckGC";
       memory::LogDeviceMemoryStats(cur_place, instr_node->Name());
     }
@@ -1964,7 +2352,87 @@ void PirInterpreter::RunInstructionBase(InstructionBase* instr_node) {
   }
 }
 
+bool PirInterpreter::ApplyExecutorPlan() {
+  auto& plan = execution_config_.executor_plan;
+  if (plan == nullptr || is_shared_results_build_) {
+    return false;
+  }
+  if (plan->dependency_count.size() != vec_instruction_base_.size() ||
+      plan->program_fingerprint !=
+          interpreter::ProgramFingerprint(vec_instruction_base_)) {
+    LOG(WARNING) << "The executor plan was made for other instructions, "
+                    "analyse the program instead.";
+    return false;
+  }
+  if (!CheckExecutorPlan(*plan)) {
+    LOG(WARNING) << "The executor plan refers to instructions or variables "
+                    "which do not exist, analyse the program instead.";
+    return false;
+  }
+  ir_dependency_builder_.ShareDependency(plan->op_downstream_map,
+                                         plan->op_happens_before);
+  dependency_count_ =
+      std::make_shared<std::vector<size_t>>(plan->dependency_count);
+  is_shared_results_build_ = true;
+  VLOG(4) << "Apply the executor plan of " << vec_instruction_base_.size()
+          << " instructions";
+  return true;
+}
+
+bool PirInterpreter::CheckExecutorPlan(
+    const interpreter::ExecutorPlan& plan) const {
+  size_t instr_num = vec_instruction_base_.size();
+  size_t var_num = value_exe_info_->GetVarList().size();
+  auto valid_instrs = [instr_num](const auto& ids) {
+    return std::all_of(ids.begin(), ids.end(), [instr_num](size_t id) {
+      return id < instr_num;
+    });
+  };
+  if (plan.trace_execute_order.size() != instr_num ||
+      !valid_instrs(plan.trace_execute_order) ||
+      plan.op_downstream_map == nullptr || plan.op_happens_before == nullptr ||
+      plan.op_happens_before->size() != instr_num) {
+    return false;
+  }
+  for (auto& row : *plan.op_happens_before) {
+    if (row.size() != instr_num) {
+      return false;
+    }
+  }
+  for (auto& pair : *plan.op_downstream_map) {
+    if (pair.first >= instr_num || !valid_instrs(pair.second)) {
+      return false;
+    }
+  }
+  for (auto& pair : plan.last_live_ops) {
+    if (pair.first >= var_num || !valid_instrs(pair.second)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::shared_ptr<interpreter::ExecutorPlan> PirInterpreter::ExportExecutorPlan()
+    const {
+  PADDLE_ENFORCE_EQ(is_build_,
+                    true,
+                    platform::errors::PreconditionNotMet(
+                        "The executor plan is exported after the first run."));
+  auto plan = std::make_shared<interpreter::ExecutorPlan>();
+  plan->build_fingerprint = interpreter::BuildFingerprint();
+  plan->program_fingerprint =
+      interpreter::ProgramFingerprint(vec_instruction_base_);
+  plan->trace_execute_order = trace_execute_order_;
+  plan->dependency_count = *dependency_count_;
+  std::tie(plan->op_downstream_map, plan->op_happens_before) =
+      ir_dependency_builder_.GetDependency();
+  plan->last_live_ops = last_live_ops_;
+  return plan;
+}
+
 void PirInterpreter::PreAnalysis() {
+  executor_plan_applied_ = ApplyExecutorPlan();
+
   BuildInstructionDependences();
   VLOG(4) << "Done BuildInstructionDependences";
 
@@ -1987,9 +2455,13 @@ void PirInterpreter::PreAnalysis() {
     }
   }
 
-  AnalyseExecuteOrderForTrace(ir_dependency_builder_.OpDownstreamMap(),
-                              ir_instruction_scheduling_priority_less);
-  VLOG(4) << "Done AnalyseExecuteOrderForTrace";
+  if (executor_plan_applied_) {
+    trace_execute_order_ = execution_config_.executor_plan->trace_execute_order;
+  } else {
+    AnalyseExecuteOrderForTrace(ir_dependency_builder_.OpDownstreamMap(),
+                                ir_instruction_scheduling_priority_less);
+    VLOG(4) << "Done AnalyseExecuteOrderForTrace";
+  }
 
   UpdateSyncOpNum();
   VLOG(4) << "Done UpdateSyncOpNum";
@@ -14,8 +14,10 @@
 
 #pragma once
 #include <memory>
+#include "paddle/fluid/framework/memory_offset_plan.h"
 #include "paddle/fluid/framework/new_executor/instruction/instruction_base.h"
 #include "paddle/fluid/framework/new_executor/interpreter_base_impl.h"
+#include "paddle/fluid/framework/new_executor/run_stats.h"
 #include "paddle/pir/include/core/value.h"
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
@@ -29,6 +31,8 @@ class Block;
 namespace paddle {
 namespace framework {
 class ValueExecutionInfo;
+class PhiKernelInstruction;
+struct ShapePlan;
 class PirInterpreter : public InterpreterBaseImpl {
   using ExecutionConfig = interpreter::ExecutionConfig;
   using InstructionSchedulingPriorityLess = std::function<bool(size_t, size_t)>;
@@ -76,6 +80,16 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   bool IsSharedResultsBuild() const override;
 
+  // The build results to save with the program, see ExecutionConfig::
+  // executor_plan. Only valid after the first run.
+  std::shared_ptr<interpreter::ExecutorPlan> ExportExecutorPlan() const;
+
+  bool ExecutorPlanApplied() const { return executor_plan_applied_; }
+
+  // The size of the arena of the memory offset plan, see ExecutionConfig::
+  // memory_offset_plan, 0 before it is made.
+  size_t MemoryPlanArenaSize() const { return memory_plan_arena_size_; }
+
   void SetCopyProgram(std::shared_ptr<ProgramDesc> prog) override;
 
   std::shared_ptr<ProgramDesc> GetMutableCopyProgram() override;
@@ -134,6 +148,13 @@ class PirInterpreter : public InterpreterBaseImpl {
       InstructionSchedulingPriorityLess compare);
   void ConstructEventForJitInput();
   void CalculateLastLiveOps();
+  void AnalyseLastLiveOps();
+  void RestoreLastLiveOps();
+  // Uses the build results in execution_config_.executor_plan if it was made
+  // for the instructions built, returns whether it was applied.
+  bool ApplyExecutorPlan();
+  // Whether all instruction and variable ids in the plan are in range.
+  bool CheckExecutorPlan(const interpreter::ExecutorPlan& plan) const;
 
   // gc
   void ClearLoDTensorArrayInLocalScope();
@@ -163,6 +184,8 @@ class PirInterpreter : public InterpreterBaseImpl {
   // Note(sonder): share the op dependency and event analysis procedure.
   bool is_shared_results_build_{false};
 
+  bool executor_plan_applied_{false};
+
   const phi::Place place_;
 
   // from variable scope
@@ -243,6 +266,27 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   void RecordMemcpyD2H(InstructionBase* instr_node);
 
+  // shape plan cache
+  void PrepareShapePlan();
+
+  bool SetInstructionMetaPlan(size_t instr_id, bool replay);
+
+  // run stats
+  void PrepareRunStats();
+
+  void RecordInstructionStats(InstructionBase* instr, uint64_t start_ns);
+
+  void FlushRunStats();
+
+  // memory offset plan
+  void PrepareMemoryPlan();
+
+  void PlaceMemoryPlan();
+
+  void ObserveMemoryPlan(size_t var_id);
+
+  void UpdateMemoryPlan();
+
   ::pir::Value GetValueByName(const std::string& var_name);
 
   void CheckGC(InstructionBase* instr);
@@ -263,6 +307,46 @@ class PirInterpreter : public InterpreterBaseImpl {
 
   std::vector<std::unique_ptr<InstructionBase>> vec_instruction_base_;
 
+  // Used by the shape plan cache. The plan of the current run, the feed
+  // variables which decide it, and the instructions indexed by id which can
+  // replay their metas, nullptr for the others.
+  ShapePlan* shape_plan_{nullptr};  // not owned
+  // Whether this run records shape_plan_.
+  bool shape_plan_recording_{false};
+  bool shape_plan_prepared_{false};
+  std::vector<Variable*> shape_plan_inputs_;
+  std::vector<PhiKernelInstruction*> phi_kernel_instructions_;
+
+  // Used by the run stats. The ids of the instruction groups in the
+  // collector, the index of the group of each instruction indexed by id, the
+  // time of each group, the gc and the trace of the current run.
+  bool run_stats_prepared_{false};
+  std::vector<size_t> run_stats_group_ids_;
+  std::vector<size_t> run_stats_instr_groups_;
+  std::vector<uint64_t> run_stats_group_ns_;
+  uint64_t run_stats_start_ns_{0};
+  uint64_t run_stats_gc_ns_{0};
+  // The gc time of the instructions run since it was last read, added to
+  // by the threads running them.
+  std::atomic<uint64_t> instr_gc_ns_{0};
+  std::vector<OpTraceRecord> run_stats_trace_;
+
+  // Used by the memory offset plan. The variables freed within the run,
+  // live from the first to the last instruction using them in the trace
+  // order, their index by variable id, -1 for the others, and whether a
+  // tensor outgrew its slot or left the plan in the last run.
+  struct PlannedVar {
+    size_t var_id{0};
+    TensorLifetime lifetime;
+    std::shared_ptr<phi::Allocation> slot;
+    bool excluded{false};
+  };
+  bool memory_plan_prepared_{false};
+  std::vector<PlannedVar> planned_vars_;
+  std::vector<int> planned_var_index_;
+  bool memory_replan_{false};
+  size_t memory_plan_arena_size_{0};
+
   // value execution info
   std::shared_ptr<ValueExecutionInfo> value_exe_info_;
 
@@ -0,0 +1,197 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/run_stats.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+// The histograms have a single writer, a relaxed load and store is enough
+// and avoids the locked instructions of fetch_add.
+inline void Increase(std::atomic<uint64_t>* value, uint64_t delta) {
+  value->store(value->load(std::memory_order_relaxed) + delta,
+               std::memory_order_relaxed);
+}
+
+const char* PhaseName(RunStatsCollector::Phase phase) {
+  switch (phase) {
+    case RunStatsCollector::Phase::kTotal:
+      return "total";
+    case RunStatsCollector::Phase::kFeed:
+      return "feed";
+    case RunStatsCollector::Phase::kExecute:
+      return "execute";
+    case RunStatsCollector::Phase::kGC:
+      return "gc";
+    case RunStatsCollector::Phase::kFetch:
+      return "fetch";
+    default:
+      return "unknown";
+  }
+}
+
+}  // namespace
+
+int LatencyHistogram::BucketIndex(uint64_t ns) {
+  constexpr uint64_t kSubBucketNum = 1 << kSubBucketBits;
+  if (ns < kSubBucketNum) {
+    return static_cast<int>(ns);
+  }
+  int exponent = 0;
+  for (uint64_t rest = ns >> 1; rest != 0; rest >>= 1) {
+    ++exponent;
+  }
+  int sub_bucket = static_cast<int>((ns >> (exponent - kSubBucketBits)) &
+                                    (kSubBucketNum - 1));
+  return ((exponent - kSubBucketBits + 1) << kSubBucketBits) + sub_bucket;
+}
+
+double LatencyHistogram::BucketValue(int index) {
+  constexpr int kSubBucketNum = 1 << kSubBucketBits;
+  if (index < kSubBucketNum) {
+    return index;
+  }
+  int shift = (index >> kSubBucketBits) - 1;
+  double width = static_cast<double>(1ULL << shift);
+  double lower = (kSubBucketNum + (index & (kSubBucketNum - 1))) * width;
+  return lower + width / 2;
+}
+
+void LatencyHistogram::Add(uint64_t ns) {
+  Increase(&buckets_[BucketIndex(ns)], 1);
+  Increase(&sum_ns_, ns);
+  if (ns > max_ns_.load(std::memory_order_relaxed)) {
+    max_ns_.store(ns, std::memory_order_relaxed);
+  }
+}
+
+LatencySummary LatencyHistogram::Summarize() const {
+  std::array<uint64_t, kBucketNum> counts;
+  uint64_t count = 0;
+  for (int i = 0; i < kBucketNum; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    count += counts[i];
+  }
+  LatencySummary summary;
+  if (count == 0) {
+    return summary;
+  }
+  // The sum may be read before or after the buckets of a concurrent Add.
+  summary.count = count;
+  summary.mean_ns =
+      static_cast<double>(sum_ns_.load(std::memory_order_relaxed)) / count;
+  summary.max_ns = static_cast<double>(max_ns_.load(std::memory_order_relaxed));
+
+  std::array<std::pair<double, double*>, 3> percentiles = {
+      std::make_pair(0.5, &summary.p50_ns),
+      std::make_pair(0.9, &summary.p90_ns),
+      std::make_pair(0.99, &summary.p99_ns)};
+  uint64_t seen = 0;
+  size_t next = 0;
+  for (int i = 0; i < kBucketNum && next < percentiles.size(); ++i) {
+    seen += counts[i];
+    while (next < percentiles.size() &&
+           static_cast<double>(seen) >= percentiles[next].first * count) {
+      *percentiles[next].second = std::min(BucketValue(i), summary.max_ns);
+      ++next;
+    }
+  }
+  return summary;
+}
+
+RunStatsCollector::RunTimer::RunTimer(RunStatsCollector* collector)
+    : collector_(collector) {
+  if (collector_) {
+    collector_->BeginRun();
+    start_ns_ = last_ns_ = NowNs();
+  }
+}
+
+void RunStatsCollector::RunTimer::Mark(Phase phase) {
+  if (collector_) {
+    uint64_t now = NowNs();
+    collector_->AddPhase(phase, now - last_ns_);
+    last_ns_ = now;
+  }
+}
+
+void RunStatsCollector::RunTimer::Finish() {
+  if (collector_) {
+    collector_->AddPhase(Phase::kTotal, NowNs() - start_ns_);
+  }
+}
+
+RunStatsCollector::RunStatsCollector(int trace_sample_interval,
+                                     size_t max_sampled_traces)
+    : trace_sample_interval_(trace_sample_interval),
+      max_sampled_traces_(max_sampled_traces) {
+  PADDLE_ENFORCE_GE(trace_sample_interval,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The trace sample interval should not be negative, "
+                        "but got %d.",
+                        trace_sample_interval));
+}
+
+void RunStatsCollector::BeginRun() {
+  sample_trace_ = trace_sample_interval_ > 0 &&
+                  run_num_ % static_cast<uint64_t>(trace_sample_interval_) == 0;
+  ++run_num_;
+}
+
+size_t RunStatsCollector::GroupId(const std::string& name) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = group_ids_.find(name);
+  if (iter != group_ids_.end()) {
+    return iter->second;
+  }
+  groups_.emplace_back(std::make_unique<LatencyHistogram>());
+  group_ids_.emplace(name, groups_.size() - 1);
+  return groups_.size() - 1;
+}
+
+void RunStatsCollector::AddSampledTrace(std::vector<OpTraceRecord>&& trace) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sampled_traces_.emplace_back(std::move(trace));
+  if (sampled_traces_.size() > max_sampled_traces_) {
+    sampled_traces_.pop_front();
+  }
+}
+
+RunStatsSummary RunStatsCollector::Summarize() const {
+  RunStatsSummary summary;
+  for (int i = 0; i < static_cast<int>(Phase::kPhaseNum); ++i) {
+    summary.phases[PhaseName(static_cast<Phase>(i))] = phases_[i].Summarize();
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto& pair : group_ids_) {
+    auto group = groups_[pair.second]->Summarize();
+    if (group.count > 0) {
+      summary.instruction_groups[pair.first] = group;
+    }
+  }
+  summary.sampled_traces.assign(sampled_traces_.begin(),
+                                sampled_traces_.end());
+  return summary;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,156 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/utils/test_macros.h"
+
+namespace paddle {
+namespace framework {
+
+struct LatencySummary {
+  uint64_t count{0};
+  double mean_ns{0.};
+  double p50_ns{0.};
+  double p90_ns{0.};
+  double p99_ns{0.};
+  double max_ns{0.};
+};
+
+// LatencyHistogram counts durations in log-linear buckets, four per power of
+// two, so the percentiles are within 19% of the durations added. Only one
+// thread may add to a histogram, any thread may summarize it, neither takes
+// a lock.
+class LatencyHistogram {
+ public:
+  void Add(uint64_t ns);
+
+  TEST_API LatencySummary Summarize() const;
+
+ private:
+  static constexpr int kSubBucketBits = 2;
+  static constexpr int kBucketNum = 64 << kSubBucketBits;
+
+  static int BucketIndex(uint64_t ns);
+  static double BucketValue(int index);
+
+  std::array<std::atomic<uint64_t>, kBucketNum> buckets_{};
+  std::atomic<uint64_t> sum_ns_{0};
+  std::atomic<uint64_t> max_ns_{0};
+};
+
+// One instruction of a sampled run, the times are relative to the start of
+// the run.
+struct OpTraceRecord {
+  std::string name;
+  uint64_t start_ns{0};
+  uint64_t run_ns{0};
+  uint64_t gc_ns{0};
+};
+
+struct RunStatsSummary {
+  std::map<std::string, LatencySummary> phases;
+  // The time each kind of instruction took per run, keyed by the op name.
+  std::map<std::string, LatencySummary> instruction_groups;
+  std::vector<std::vector<OpTraceRecord>> sampled_traces;
+};
+
+// RunStatsCollector keeps the latency histograms of the runs of a predictor:
+// the phases of a run timed by the predictor, the gc and the instruction
+// groups timed by the interpreter, and the op level traces of every
+// trace_sample_interval-th run. A predictor runs on one thread at a time, so
+// recording takes no lock, except to keep a sampled trace.
+class RunStatsCollector {
+ public:
+  enum class Phase { kTotal, kFeed, kExecute, kGC, kFetch, kPhaseNum };
+
+  static uint64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // Times the phases of one run, it does nothing with a null collector.
+  class RunTimer {
+   public:
+    explicit RunTimer(RunStatsCollector* collector);
+
+    // Adds the time since the last mark to phase.
+    void Mark(Phase phase);
+
+    // Adds the time since the timer was created to Phase::kTotal. A run
+    // which fails before is not counted.
+    void Finish();
+
+   private:
+    RunStatsCollector* collector_;
+    uint64_t start_ns_{0};
+    uint64_t last_ns_{0};
+  };
+
+  // trace_sample_interval 0 samples no traces, max_sampled_traces is how
+  // many of the latest sampled traces are kept.
+  explicit RunStatsCollector(int trace_sample_interval,
+                             size_t max_sampled_traces = 8);
+
+  RunStatsCollector(const RunStatsCollector&) = delete;
+  RunStatsCollector& operator=(const RunStatsCollector&) = delete;
+
+  // Decides whether the run starting traces its instructions.
+  void BeginRun();
+  bool SampleTrace() const { return sample_trace_; }
+
+  void AddPhase(Phase phase, uint64_t ns) {
+    phases_[static_cast<int>(phase)].Add(ns);
+  }
+
+  // Returns the id of the instruction group named name, creating it if it is
+  // new. Called when the instructions are built.
+  size_t GroupId(const std::string& name);
+  void AddGroup(size_t group_id, uint64_t ns) {
+    groups_[group_id]->Add(ns);
+  }
+
+  void AddSampledTrace(std::vector<OpTraceRecord>&& trace);
+
+  TEST_API RunStatsSummary Summarize() const;
+
+ private:
+  const int trace_sample_interval_;
+  const size_t max_sampled_traces_;
+  uint64_t run_num_{0};
+  bool sample_trace_{false};
+
+  std::array<LatencyHistogram, static_cast<int>(Phase::kPhaseNum)> phases_;
+
+  mutable std::mutex mutex_;
+  std::map<std::string, size_t> group_ids_;
+  // unique_ptr, so that the histograms do not move when groups are added
+  std::vector<std::unique_ptr<LatencyHistogram>> groups_;
+  std::deque<std::vector<OpTraceRecord>> sampled_traces_;
+};
+
+}  // namespace framework
+}  // namespace paddle
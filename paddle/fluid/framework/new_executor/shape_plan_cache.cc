@@ -0,0 +1,56 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/new_executor/shape_plan_cache.h"
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+ShapePlan* ShapePlanCache::Get(const Key& key, size_t instr_num) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = plans_.find(key);
+  if (iter != plans_.end()) {
+    PADDLE_ENFORCE_EQ(iter->second->instr_plans.size(),
+                      instr_num,
+                      platform::errors::PreconditionNotMet(
+                          "The ShapePlanCache is shared by programs with "
+                          "different instruction numbers (%d vs %d).",
+                          iter->second->instr_plans.size(),
+                          instr_num));
+    hit_num_.fetch_add(1, std::memory_order_relaxed);
+    return iter->second.get();
+  }
+  miss_num_.fetch_add(1, std::memory_order_relaxed);
+  if (plans_.size() >= capacity_) {
+    VLOG(6) << "ShapePlanCache is full with " << plans_.size() << " plans";
+    return nullptr;
+  }
+  auto* plan = new ShapePlan(instr_num);
+  plans_.emplace(key, std::unique_ptr<ShapePlan>(plan));
+  return plan;
+}
+
+ShapePlanCacheStats ShapePlanCache::GetStats() const {
+  ShapePlanCacheStats stats;
+  stats.hit_num = hit_num_.load(std::memory_order_relaxed);
+  stats.miss_num = miss_num_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.plan_num = plans_.size();
+  return stats;
+}
+
+}  // namespace framework
+}  // namespace paddle
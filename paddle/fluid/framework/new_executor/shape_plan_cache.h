@@ -0,0 +1,98 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/utils/test_macros.h"
+
+namespace paddle {
+namespace framework {
+
+// The output metas one instruction computed for one set of input shapes.
+struct InstructionMetaPlan {
+  enum class State {
+    kEmpty,
+    kRecorded,
+    // The output metas depend on more than the input shapes, e.g. on the
+    // values of the inputs, or are not all dense tensors.
+    kUncacheable,
+  };
+
+  // Only the run recording the plan writes kRecorded, concurrent runs
+  // replaying the plan may still set kUncacheable.
+  std::atomic<State> state{State::kEmpty};
+  // Indexed like the outputs of the kernel context, a null output has no
+  // meta.
+  std::vector<std::unique_ptr<phi::DenseTensorMeta>> output_metas;
+};
+
+// The metas of all instructions of a program for one set of input shapes,
+// indexed by instruction id.
+struct ShapePlan {
+  explicit ShapePlan(size_t instr_num) : instr_plans(instr_num) {}
+
+  std::vector<InstructionMetaPlan> instr_plans;
+  // The first run of a plan records it, the runs of other interpreters
+  // sharing the cache do not use it until it is recorded.
+  std::atomic<bool> recording{false};
+  std::atomic<bool> recorded{false};
+};
+
+struct ShapePlanCacheStats {
+  uint64_t hit_num{0};
+  uint64_t miss_num{0};
+  uint64_t plan_num{0};
+};
+
+// ShapePlanCache keeps a ShapePlan per input shape, so that runs with shapes
+// seen before replay the output metas of the kernels instead of running
+// their InferMeta. The kernels are fixed when the program is lowered, and
+// the allocator reuses the chunks of a shape seen before, so the metas are
+// what is left to compute per run. The cache may be shared by the
+// interpreters of the clones of a predictor, which run the same program.
+class ShapePlanCache {
+ public:
+  // The dtypes, dims and lods of the feed variables of a run, see
+  // PirInterpreter::PrepareShapePlan.
+  using Key = std::vector<int64_t>;
+
+  explicit ShapePlanCache(size_t capacity) : capacity_(capacity) {}
+
+  ShapePlanCache(const ShapePlanCache&) = delete;
+  ShapePlanCache& operator=(const ShapePlanCache&) = delete;
+
+  // Returns the plan of key, creating an empty one on a miss. Returns
+  // nullptr on a miss when the cache already holds capacity plans.
+  ShapePlan* Get(const Key& key, size_t instr_num);
+
+  TEST_API ShapePlanCacheStats GetStats() const;
+
+ private:
+  const size_t capacity_;
+  mutable std::mutex mutex_;
+  std::map<Key, std::unique_ptr<ShapePlan>> plans_;
+  std::atomic<uint64_t> hit_num_{0};
+  std::atomic<uint64_t> miss_num_{0};
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <atomic>
 #include <codecvt>
 #include <iostream>
 #include <locale>
@@ -36,17 +37,27 @@ class Vocab : public phi::ExtendedTensor,
  public:
   Vocab() = default;
 
-  Vocab(Vocab&& other) = default;
+  // A moved-from vocab is modified, so it gets a new version.
+  Vocab(Vocab&& other)
+      : data_(std::move(other.data_)), version_(other.version_) {
+    other.version_ = NextVersion();
+  }
 
   Vocab(const Vocab& other) = default;
 
   Vocab& operator=(const Vocab& other) = default;
 
-  Vocab& operator=(Vocab&& other) = default;
+  Vocab& operator=(Vocab&& other) {
+    data_ = std::move(other.data_);
+    version_ = other.version_;
+    other.version_ = NextVersion();
+    return *this;
+  }
 
   Vocab& operator=(
       const std::unordered_map<std::wstring, std::int32_t>& other) {
     this->data_ = other;
+    version_ = NextVersion();
     return *this;
   }
 
@@ -60,44 +71,46 @@ class Vocab : public phi::ExtendedTensor,
 
   size_t size() const { return data_.size(); }
 
-  void clear() { data_.clear(); }
+  void clear() {
+    data_.clear();
+    version_ = NextVersion();
+  }
 
   void emplace(const std::wstring& key, std::int32_t value) {
     data_.emplace(key, value);
+    version_ = NextVersion();
   }
 
+  /// \brief Returns an id that changes whenever the content is modified, it
+  /// lets users cache data derived from the vocab. The content is only
+  /// modified through the methods above, so no mutable iterators are exposed.
+  uint64_t version() const { return version_; }
+
   std::int32_t at(const std::wstring& key) { return data_.at(key); }
 
   std::int32_t at(const std::wstring& key) const { return data_.at(key); }
 
-  std::unordered_map<std::wstring, std::int32_t>::iterator find(
-      const std::wstring& key) {
-    return data_.find(key);
-  }
-
   std::unordered_map<std::wstring, std::int32_t>::const_iterator find(
       const std::wstring& key) const {
     return data_.find(key);
   }
 
-  std::unordered_map<std::wstring, std::int32_t>::iterator begin() {
-    return data_.begin();
-  }
-
   std::unordered_map<std::wstring, std::int32_t>::const_iterator begin() const {
     return data_.begin();
   }
 
-  std::unordered_map<std::wstring, std::int32_t>::iterator end() {
-    return data_.end();
-  }
-
   std::unordered_map<std::wstring, std::int32_t>::const_iterator end() const {
     return data_.end();
   }
 
  private:
+  static uint64_t NextVersion() {
+    static std::atomic<uint64_t> version{0};
+    return ++version;
+  }
+
   std::unordered_map<std::wstring, std::int32_t> data_;
+  uint64_t version_{NextVersion()};
 };
 
 // Note(YuanRisheng): PhiVector is essentially a vector that only used for PHI
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/inference/analysis/passes/memory_optimize_pass.h"
 
+#include <algorithm>
 #include <string>
 #include <unordered_set>
 #include <utility>
@@ -21,6 +22,7 @@
 
 #include "glog/logging.h"
 #include "paddle/fluid/framework/ir/graph_helper.h"
+#include "paddle/fluid/framework/memory_offset_plan.h"
 #include "paddle/fluid/inference/analysis/pass_result_info.h"
 #include "paddle/fluid/platform/enforce.h"
 
@@ -248,6 +250,26 @@ void MakeSimpleReusePlan(
   }
 }
 
+namespace {
+
+constexpr size_t kPlanAlignment = 64;
+
+double ToMB(size_t bytes) { return static_cast<double>(bytes) / (1 << 20); }
+
+void ReportPeaks(const std::string& program,
+                 const std::vector<framework::TensorLifetime>& tensors,
+                 size_t reuse_peak) {
+  auto plan = framework::MakeMemoryOffsetPlan(tensors, kPlanAlignment);
+  LOG(INFO) << "The " << tensors.size() << " temporary tensors of the "
+            << program << " take " << ToMB(reuse_peak) << "MB reusing whole "
+            << "variables and " << ToMB(plan.arena_size)
+            << "MB packed at offsets, at least "
+            << ToMB(framework::MemoryLowerBound(tensors, kPlanAlignment))
+            << "MB, with the unknown dims as 1";
+}
+
+}  // namespace
+
 std::string MemoryOptimizePass::repr() const { return "memory_optimize_pass"; }
 
 void MemoryOptimizePass::RunImpl(Argument* argument) {
@@ -277,6 +299,22 @@ void MemoryOptimizePass::RunImpl(Argument* argument) {
   CollectVarMemorySize(graph, &space_table);
   MakeSimpleReusePlan(lifecycles, space_table, &node2cluster, &cluster_size);
 
+  std::vector<framework::TensorLifetime> tensors;
+  for (auto& pair : lifecycles) {
+    if (!space_table.count(pair.first)) continue;
+    framework::TensorLifetime tensor;
+    tensor.name = pair.first;
+    tensor.size = space_table.at(pair.first);
+    tensor.first_use = pair.second.first;
+    tensor.last_use = pair.second.second;
+    tensors.push_back(tensor);
+  }
+  size_t reuse_peak = 0;
+  for (auto& cluster : cluster_size) {
+    reuse_peak += cluster.second;
+  }
+  ReportPeaks("main graph", tensors, reuse_peak);
+
   auto* pass_res_info = PassResultInfoForRuntime::Instance();
   pass_res_info->Set(
       argument->root_predictor_id(), "memory_optimize_pass", node2cluster);
@@ -40,6 +40,10 @@ namespace analysis {
  * current name of var.
  * 3. Perform reuse plan: Replace all var's name in the model according to the
  * mapping table.
+ * After the first run the executor packs the vars of the plan at offsets of
+ * one arena instead of sharing whole vars, see NaiveExecutor::MakeOffsetPlan,
+ * the peaks of both are logged. The pir program is left to its executor,
+ * which frees the tensors after their last use.
  */
 class MemoryOptimizePass : public AnalysisPass {
  public:
@@ -496,6 +496,18 @@ AnalysisConfig::AnalysisConfig(const AnalysisConfig &other) {
   CP_MEMBER(enable_low_precision_io_);
 
   CP_MEMBER(enable_memory_optim_);
+  CP_MEMBER(enable_mmap_params_);
+  CP_MEMBER(enable_shared_clone_);
+  CP_MEMBER(shared_clone_max_concurrent_runs_);
+  CP_MEMBER(enable_shape_plan_cache_);
+  CP_MEMBER(shape_plan_cache_capacity_);
+  CP_MEMBER(shape_bucket_inputs_);
+  CP_MEMBER(shape_buckets_);
+  CP_MEMBER(shape_bucket_pad_value_);
+  CP_MEMBER(enable_run_stats_);
+  CP_MEMBER(run_stats_trace_sample_interval_);
+  CP_MEMBER(shared_runtime_);
+  CP_MEMBER(shared_runtime_priority_);
   // TensorRT related.
   CP_MEMBER(use_tensorrt_);
   CP_MEMBER(tensorrt_workspace_size_);
@@ -1138,6 +1150,11 @@ std::string AnalysisConfig::SerializeInfoCache() {
   ss << trt_dla_core_;
 
   ss << enable_memory_optim_;
+  ss << enable_mmap_params_;
+  ss << enable_shared_clone_;
+  ss << enable_shape_plan_cache_;
+  for (auto &input : shape_bucket_inputs_) ss << input;
+  for (auto bucket : shape_buckets_) ss << bucket;
   ss << trt_engine_memory_sharing_;
 
   ss << use_mkldnn_;
@@ -1249,6 +1266,76 @@ bool AnalysisConfig::enable_memory_optim() const {
   return enable_memory_optim_;
 }
 
+void AnalysisConfig::EnableMmapParams(bool x) { enable_mmap_params_ = x; }
+
+void AnalysisConfig::EnableSharedClone(bool x, int max_concurrent_runs) {
+  PADDLE_ENFORCE_GE(max_concurrent_runs,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The max_concurrent_runs should be non-negative, but "
+                        "got %d.",
+                        max_concurrent_runs));
+  enable_shared_clone_ = x;
+  shared_clone_max_concurrent_runs_ = max_concurrent_runs;
+}
+
+void AnalysisConfig::EnableShapePlanCache(int capacity) {
+  PADDLE_ENFORCE_GT(capacity,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The capacity of the shape plan cache should be "
+                        "positive, but got %d.",
+                        capacity));
+  enable_shape_plan_cache_ = true;
+  shape_plan_cache_capacity_ = capacity;
+}
+
+void AnalysisConfig::SetShapeBuckets(
+    const std::vector<std::string> &padded_inputs,
+    const std::vector<int> &seq_len_buckets,
+    double pad_value) {
+  for (size_t i = 0; i < seq_len_buckets.size(); ++i) {
+    PADDLE_ENFORCE_GT(
+        seq_len_buckets[i],
+        i == 0 ? 0 : seq_len_buckets[i - 1],
+        platform::errors::InvalidArgument(
+            "The shape buckets should be positive and ascending, but got "
+            "%d at %d.",
+            seq_len_buckets[i],
+            i));
+  }
+  shape_bucket_inputs_ = padded_inputs;
+  shape_buckets_ = seq_len_buckets;
+  shape_bucket_pad_value_ = pad_value;
+}
+
+void AnalysisConfig::EnableRunStats(int trace_sample_interval) {
+  PADDLE_ENFORCE_GE(trace_sample_interval,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The trace sample interval should not be negative, "
+                        "but got %d.",
+                        trace_sample_interval));
+  enable_run_stats_ = true;
+  run_stats_trace_sample_interval_ = trace_sample_interval;
+}
+
+void AnalysisConfig::SetSharedRuntime(
+    std::shared_ptr<paddle_infer::services::SharedRuntime> runtime,
+    int priority) {
+  PADDLE_ENFORCE_NOT_NULL(runtime,
+                          platform::errors::InvalidArgument(
+                              "The shared runtime should not be null."));
+  PADDLE_ENFORCE_GT(priority,
+                    0,
+                    platform::errors::InvalidArgument(
+                        "The priority of a model should be positive, but got "
+                        "%d.",
+                        priority));
+  shared_runtime_ = std::move(runtime);
+  shared_runtime_priority_ = priority;
+}
+
 bool AnalysisConfig::trt_engine_memory_sharing() const {
   return trt_engine_memory_sharing_;
 }
@@ -1459,6 +1546,17 @@ std::string AnalysisConfig::Summary() {
   os.InsertRow(
       {"use_optimized_model", use_optimized_model_ ? "true" : "false"});
   os.InsertRow({"memory_optim", enable_memory_optim_ ? "true" : "false"});
+  os.InsertRow({"mmap_params", enable_mmap_params_ ? "true" : "false"});
+  os.InsertRow({"shared_clone", enable_shared_clone_ ? "true" : "false"});
+  os.InsertRow({"shape_plan_cache",
+                enable_shape_plan_cache_
+                    ? std::to_string(shape_plan_cache_capacity_)
+                    : "false"});
+  os.InsertRow({"run_stats", enable_run_stats_ ? "true" : "false"});
+  os.InsertRow({"shared_runtime",
+                shared_runtime_
+                    ? "priority " + std::to_string(shared_runtime_priority_)
+                    : "false"});
   os.InsertRow({"enable_profile", with_profile_ ? "true" : "false"});
   os.InsertRow({"enable_log", with_glog_info_ ? "true" : "false"});
   os.InsertRow({"collect_shape_range_info",
@@ -17,6 +17,8 @@
 #include <glog/logging.h>
 
 #include <algorithm>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
 #include <cstdlib>
 #include <fstream>
 #include <memory>
@@ -24,6 +26,9 @@
 #include <string>
 #include <utility>
 #include <vector>
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 #include "paddle/common/enforce.h"
 #include "paddle/fluid//platform/device/gpu/gpu_types.h"
@@ -32,11 +37,15 @@
 #include "paddle/fluid/framework/feed_hook.h"
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 #include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/mapped_params.h"
 #include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/new_executor/interpreter/executor_plan.h"
 #include "paddle/fluid/framework/new_executor/pir_adaptor/pir_adaptor_util.h"
+#include "paddle/fluid/framework/new_executor/workqueue/workqueue.h"
 #include "paddle/fluid/framework/op_proto_maker.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/framework/transfer_scope_cache.h"
 #include "paddle/fluid/framework/var_type_traits.h"
 #include "paddle/fluid/framework/version.h"
@@ -49,6 +58,7 @@
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/inference/api/paddle_inference_pass.h"
+#include "paddle/fluid/inference/api/paddle_shared_runtime.h"
 #include "paddle/fluid/inference/api/resource_manager.h"
 #include "paddle/fluid/inference/utils/io_utils.h"
 #include "paddle/fluid/inference/utils/model_utils.h"
@@ -134,10 +144,12 @@
 #include "paddle/pir/include/core/builtin_attribute.h"
 #include "paddle/pir/include/core/program.h"
 #include "paddle/pir/include/dialect/shape/transforms/shape_optimization_pass.h"
+#include "paddle/pir/include/pass/pass.h"
 #include "paddle/pir/include/pass/pass_manager.h"
 #include "paddle/pir/include/pass/pass_registry.h"
 
 COMMON_DECLARE_bool(pir_apply_inplace_pass);
+COMMON_DECLARE_bool(pir_combine_pattern_passes);
 COMMON_DECLARE_bool(enable_pir_api);
 
 namespace paddle {
@@ -216,6 +228,108 @@ bool IsPersistable(const framework::VarDesc *var) {
   return false;
 }
 
+// Adds the passes to pm, the runs of kPirCombinablePasses in them as one
+// CombinedPatternRewritePass each if combine is set.
+void AddPirPasses(::pir::PassManager *pm,
+                  std::vector<std::unique_ptr<::pir::Pass>> passes,
+                  bool combine) {
+  auto combinable = [&](const std::unique_ptr<::pir::Pass> &pass) {
+    return combine && std::find(kPirCombinablePasses.begin(),
+                                kPirCombinablePasses.end(),
+                                pass->name()) != kPirCombinablePasses.end();
+  };
+  for (size_t i = 0; i < passes.size();) {
+    size_t end = i;
+    while (end < passes.size() && combinable(passes[end])) ++end;
+    if (end - i < 2) {
+      pm->AddPass(std::move(passes[i++]));
+      continue;
+    }
+    std::vector<std::unique_ptr<::pir::Pass>> combined(
+        std::make_move_iterator(passes.begin() + i),
+        std::make_move_iterator(passes.begin() + end));
+    pm->AddPass(std::make_unique<::pir::CombinedPatternRewritePass>(
+        std::move(combined)));
+    i = end;
+  }
+}
+
+// Resident set size of the process in bytes, 0 if unknown.
+size_t GetProcessRSS() {
+#ifdef __linux__
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  if (statm >> pages >> resident) {
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  }
+#endif
+  return 0;
+}
+
+void LoadMappedParams(const std::string &params_file,
+                      const std::vector<phi::DenseTensor *> &tensors,
+                      const phi::Place &place) {
+  size_t rss_before = GetProcessRSS();
+  auto start = std::chrono::steady_clock::now();
+  auto stats =
+      framework::LoadCombinedParamsFromMappedFile(params_file, tensors, place);
+  double load_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  size_t rss_after = GetProcessRSS();
+  LOG(INFO) << "Load params from " << params_file << " with mmap in "
+            << load_ms << " ms, " << stats.mapped_num << "/"
+            << stats.tensor_num << " tensors (" << (stats.mapped_bytes >> 20)
+            << " MB) mapped, " << (stats.copied_bytes >> 20)
+            << " MB copied, process RSS " << (rss_before >> 20) << " MB -> "
+            << (rss_after >> 20) << " MB";
+}
+
+// Copies src of shape [N, L, ...] into the front of dst of shape
+// [N, len, ...], filling the rest with value.
+template <typename T>
+void PadAlongDim1(const phi::DenseTensor &src,
+                  int64_t len,
+                  double value,
+                  phi::DenseTensor *dst) {
+  auto dims = src.dims();
+  int64_t rows = dims[0];
+  int64_t src_len = dims[1];
+  int64_t inner = rows * src_len == 0 ? 0 : src.numel() / (rows * src_len);
+  dims[1] = len;
+  dst->Resize(dims);
+  const T *src_data = src.data<T>();
+  T *dst_data = dst->mutable_data<T>(phi::CPUPlace());
+  std::fill(dst_data, dst_data + dst->numel(), static_cast<T>(value));
+  for (int64_t i = 0; i < rows; ++i) {
+    std::copy(src_data + i * src_len * inner,
+              src_data + (i + 1) * src_len * inner,
+              dst_data + i * len * inner);
+  }
+}
+
+// Copies the front of src of shape [N, L, ...] along dim 1 into dst of shape
+// [N, len, ...] on the place of src.
+void SliceAlongDim1(const phi::DenseTensor &src,
+                    int64_t len,
+                    phi::DenseTensor *dst) {
+  auto dims = src.dims();
+  int64_t rows = dims[0];
+  int64_t src_len = dims[1];
+  int64_t inner = rows * src_len == 0 ? 0 : src.numel() / (rows * src_len);
+  dims[1] = len;
+  dst->Resize(dims);
+  dst->mutable_data(src.place(), src.dtype());
+  for (int64_t i = 0; i < rows; ++i) {
+    phi::DenseTensor src_row = src.Slice(i, i + 1);
+    src_row.Resize(common::make_ddim({src_len, inner}));
+    phi::DenseTensor dst_row = dst->Slice(i, i + 1);
+    dst_row.Resize(common::make_ddim({len, inner}));
+    phi::DenseTensor dst_part = dst_row.Slice(0, len);
+    framework::TensorCopySync(src_row.Slice(0, len), src.place(), &dst_part);
+  }
+}
+
 phi::DataType ConvertPrecision(AnalysisConfig::Precision precision) {
   switch (precision) {
     case AnalysisConfig::Precision::kFloat32:
@@ -371,6 +485,161 @@ bool PaddleTensorToDenseTensor(const PaddleTensor &pt,
 }
 }  // namespace
 
+struct SharedRuntimeModel {
+  SharedRuntimeModel(
+      std::shared_ptr<paddle_infer::services::SharedRuntime> shared_runtime,
+      int priority)
+      : runtime(std::move(shared_runtime)), id(runtime->Attach(priority)) {}
+
+  // The last of the predictor and its clones detaches the model.
+  ~SharedRuntimeModel() { runtime->Detach(id); }
+
+  std::shared_ptr<paddle_infer::services::SharedRuntime> runtime;
+  const int id;
+};
+
+struct SharedCloneState {
+  // The optimized and kernel lowered program run by every predictor.
+  std::shared_ptr<pir::Program> program;
+  // The sub scope of the first predictor, which holds the persistables. The
+  // sub scopes of the clones are its kids, so the clones look the
+  // persistables up in it and create their own variables locally.
+  framework::Scope *param_scope{nullptr};
+  // The instructions are built from the shared program by one predictor at a
+  // time.
+  std::mutex build_mutex;
+  // The runs in flight, at most max_running unless it is 0.
+  std::mutex run_mutex;
+  std::condition_variable run_cv;
+  int running{0};
+  int max_running{0};
+};
+
+namespace {
+// Admits a run of a predictor which shares its program with clones. The
+// first run of a predictor also builds its instructions, under the build lock.
+class SharedCloneRunGuard {
+ public:
+  SharedCloneRunGuard(SharedCloneState *state, bool *built)
+      : state_(state), built_(built) {
+    if (state_ == nullptr) {
+      return;
+    }
+    if (state_->max_running > 0) {
+      std::unique_lock<std::mutex> lock(state_->run_mutex);
+      state_->run_cv.wait(
+          lock, [this] { return state_->running < state_->max_running; });
+      ++state_->running;
+      admitted_ = true;
+    }
+    if (!*built_) {
+      build_lock_ = std::unique_lock<std::mutex>(state_->build_mutex);
+    }
+  }
+
+  ~SharedCloneRunGuard() {
+    if (build_lock_.owns_lock()) {
+      *built_ = true;
+      build_lock_.unlock();
+    }
+    if (admitted_) {
+      {
+        std::lock_guard<std::mutex> lock(state_->run_mutex);
+        --state_->running;
+      }
+      state_->run_cv.notify_one();
+    }
+  }
+
+ private:
+  SharedCloneState *state_;
+  bool *built_;
+  bool admitted_{false};
+  std::unique_lock<std::mutex> build_lock_;
+};
+
+// Sets the math library threads of a run. A predictor attached to a shared
+// runtime waits until the run is admitted and runs with the cores granted.
+// The grant is set on the thread of the run only, so that the concurrent
+// runs keep their own partitions. This holds for the MKL and OpenMP (and so
+// oneDNN) kernels of an MKLML build; the OpenBLAS thread number is global,
+// and the last run admitted sets it for all.
+class SharedRuntimeAdmission {
+ public:
+  SharedRuntimeAdmission(const SharedRuntimeModel *model, int num_threads)
+      : model_(model) {
+    if (model_ != nullptr) {
+      granted_ = model_->runtime->Acquire(model_->id, num_threads);
+      paddle::platform::SetNumThreadsLocal(granted_);
+    } else {
+      paddle::platform::SetNumThreads(num_threads);
+    }
+  }
+
+  ~SharedRuntimeAdmission() {
+    if (granted_ > 0) {
+      // the thread may run a predictor without a shared runtime next
+      paddle::platform::SetNumThreadsLocal(0);
+      model_->runtime->Release(model_->id, granted_);
+    }
+  }
+
+ private:
+  const SharedRuntimeModel *model_;
+  int granted_{0};
+};
+}  // namespace
+
+struct AsyncRunState {
+  // The inputs of the run executing and of the next one, the outputs of the
+  // run whose callback is called and of the next one.
+  static constexpr int kSlotNum = 2;
+  struct Slot {
+    framework::Scope scope;
+    bool busy{false};
+  };
+
+  // Slots are taken in turn, as the runs and the callbacks go in order.
+  int AcquireSlot(Slot *slots, int *next) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return !slots[*next].busy; });
+    int id = *next;
+    slots[id].busy = true;
+    *next = (id + 1) % kSlotNum;
+    return id;
+  }
+
+  void ReleaseSlot(Slot *slots, int id) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      slots[id].busy = false;
+    }
+    cv.notify_all();
+  }
+
+  void WaitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this] { return running == 0; });
+  }
+
+  std::unique_ptr<PaddlePredictor> runner;
+  std::vector<std::string> input_names;
+  std::vector<std::string> output_names;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  Slot input_slots[kSlotNum];
+  Slot output_slots[kSlotNum];
+  int next_input_slot{0};
+  int next_output_slot{0};
+  // The runs queued, until their callbacks return.
+  int running{0};
+
+  // Destroyed before the runner, after the tasks queued are done.
+  std::unique_ptr<framework::WorkQueue> run_queue;
+  std::unique_ptr<framework::WorkQueue> callback_queue;
+};
+
 AnalysisPredictor::AnalysisPredictor(const AnalysisConfig &config)
     : config_(config),
       fusion_statis_(),
@@ -487,6 +756,17 @@ bool AnalysisPredictor::Init(
     return false;
   }
   InitPlace();
+  // the clones share the model of the predictor they are cloned from
+  if (config_.shared_runtime() && !shared_runtime_model_) {
+    if (phi::is_cpu_place(place_)) {
+      shared_runtime_model_ = std::make_shared<SharedRuntimeModel>(
+          config_.shared_runtime(), config_.shared_runtime_priority());
+    } else {
+      LOG(WARNING) << "Only the predictors on cpu share the cores of a "
+                      "runtime, the predictor on "
+                   << place_ << " runs on its own.";
+    }
+  }
 
   if (!CreateExecutor()) {
     return false;
@@ -506,6 +786,14 @@ bool AnalysisPredictor::Init(
 
   PrepareFeedFetch();
 
+  if (!status_is_cloned_ && UseSharedClone()) {
+    shared_clone_state_ = std::make_shared<SharedCloneState>();
+    shared_clone_state_->program = pir_program_;
+    shared_clone_state_->param_scope = sub_scope_;
+    shared_clone_state_->max_running =
+        config_.shared_clone_max_concurrent_runs();
+  }
+
   // Prepare executor, create local variables.
   if (!PrepareExecutor()) {
     return true;
@@ -799,7 +1087,11 @@ bool AnalysisPredictor::PrepareScope(
     scope_ = std::make_unique<paddle::framework::Scope>();
     status_is_cloned_ = false;
   }
-  sub_scope_ = &scope_->NewScope();
+  if (status_is_cloned_ && shared_clone_state_) {
+    sub_scope_ = &shared_clone_state_->param_scope->NewScope();
+  } else {
+    sub_scope_ = &scope_->NewScope();
+  }
   return true;
 }
 
@@ -851,9 +1143,10 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
     // Apply some optimization passes required by the inference
     ::pir::PassManager pass_pm(::pir::IrContext::Instance(),
                                config_.pm_opt_level_);
+    std::vector<std::unique_ptr<::pir::Pass>> passes;
     if (!config_.custom_passes_.empty()) {
       for (const auto &custom_pass : config_.custom_passes_) {
-        pass_pm.AddPass(pir::PassRegistry::Instance().Get(custom_pass));
+        passes.push_back(pir::PassRegistry::Instance().Get(custom_pass));
       }
     }
     if (config_.use_gpu()) {
@@ -863,7 +1156,7 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
           if (std::find(config_.deleted_passes_.begin(),
                         config_.deleted_passes_.end(),
                         gpu_pass) == config_.deleted_passes_.end()) {
-            pass_pm.AddPass(pir::PassRegistry::Instance().Get(gpu_pass));
+            passes.push_back(pir::PassRegistry::Instance().Get(gpu_pass));
           }
         }
       }
@@ -876,8 +1169,7 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
           if (std::find(config_.deleted_passes_.begin(),
                         config_.deleted_passes_.end(),
                         xpu_pass) == config_.deleted_passes_.end()) {
-            pass_pm.AddPass(
-                std::move(pir::PassRegistry::Instance().Get(xpu_pass)));
+            passes.push_back(pir::PassRegistry::Instance().Get(xpu_pass));
           }
         }
       }
@@ -891,7 +1183,7 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
           if (std::find(config_.deleted_passes_.begin(),
                         config_.deleted_passes_.end(),
                         mkldnn_pass) == config_.deleted_passes_.end()) {
-            pass_pm.AddPass(pir::PassRegistry::Instance().Get(mkldnn_pass));
+            passes.push_back(pir::PassRegistry::Instance().Get(mkldnn_pass));
           }
         }
       }
@@ -903,14 +1195,14 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
           if (std::find(config_.deleted_passes_.begin(),
                         config_.deleted_passes_.end(),
                         cpu_pass) == config_.deleted_passes_.end()) {
-            pass_pm.AddPass(pir::PassRegistry::Instance().Get(cpu_pass));
+            passes.push_back(pir::PassRegistry::Instance().Get(cpu_pass));
           }
         }
       }
     }
 
     // set attr
-    for (const auto &pass : pass_pm.passes()) {
+    for (const auto &pass : passes) {
       pass->SetNotOwned(pir::Pass::kParamScopeAttr, sub_scope_);
       if (pass->name() == "matmul_add_act_fuse_pass" ||
           pass->name() == "conv2d_add_act_fuse_pass" ||
@@ -918,6 +1210,10 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
         pass->Set("use_cutlass", new bool(config_.use_cutlass_));
       }
     }
+    // The passes are printed by name when debugging, so they stay apart.
+    AddPirPasses(&pass_pm,
+                 std::move(passes),
+                 FLAGS_pir_combine_pattern_passes && !config_.ir_debug_);
 
     if (!config_.glog_info_disabled()) {
       pass_pm.EnablePrintStatistics();
@@ -991,6 +1287,17 @@ void AnalysisPredictor::OptimizeInferencePirProgram() {
   basic_pass_pm.Run(pir_program_.get());
   //----------------------------------------------------------------------------------------------//
 
+#ifdef PADDLE_WITH_DNNL
+  // The scales are calibrated on the program with the parameters folded, the
+  // int8 ops are placed before the kernels are chosen.
+  if (config_.mkldnn_quantizer_enabled()) {
+    if (!mkldnn_quantizer_)
+      mkldnn_quantizer_ = new AnalysisPredictor::MkldnnQuantizer(
+          *this, config_.mkldnn_quantizer_config());
+    mkldnn_quantizer_->QuantizePir();
+  }
+#endif
+
   pir_program_ =
       paddle::dialect::PdOpLowerToKernelPass(pir_program_.get(), place_);
 
@@ -1075,12 +1382,15 @@ bool AnalysisPredictor::SaveOrLoadPirParameters(bool for_save) {
         var = sub_scope_->Var(param_names[i]);
         auto *tensor_temp = var->GetMutable<phi::DenseTensor>();
         tensor_temp->Resize(common::make_ddim(pir::GetShapeFromValue(value)));
-        phi::DeviceContextPool &pool = phi::DeviceContextPool::Instance();
-        const phi::DeviceContext *dev_ctx = nullptr;
-        dev_ctx = pool.Get(place_);
-        pir::Type type_ = pir::GetDataTypeFromValue(value);
-        phi::DataType type_data = paddle::dialect::TransToPhiDataType(type_);
-        dev_ctx->Alloc(tensor_temp, type_data);
+        // with mmap the holder is set by the mapped file
+        if (for_save || !UseMmapParams()) {
+          phi::DeviceContextPool &pool = phi::DeviceContextPool::Instance();
+          const phi::DeviceContext *dev_ctx = nullptr;
+          dev_ctx = pool.Get(place_);
+          pir::Type type_ = pir::GetDataTypeFromValue(value);
+          phi::DataType type_data = paddle::dialect::TransToPhiDataType(type_);
+          dev_ctx->Alloc(tensor_temp, type_data);
+        }
       } else {
         PADDLE_THROW(platform::errors::Unavailable(
             "Only support parameter data of type DenseTensor."));
@@ -1098,6 +1408,8 @@ bool AnalysisPredictor::SaveOrLoadPirParameters(bool for_save) {
     pir::SaveCombineFunction(
         const_tensor_out, param_names, optimized_params, true, false, true);
     LOG(INFO) << "Optimized params saved to " << optimized_params;
+  } else if (UseMmapParams()) {
+    LoadMappedParams(config_.params_file(), tensor_out, place_);
   } else {
     pir::LoadCombineFunction(
         config_.params_file(), param_names, &tensor_out, false, place_);
@@ -1114,6 +1426,12 @@ bool AnalysisPredictor::PreparePirProgram() {
       nullptr,
       platform::errors::Fatal("Here, pir_program must be a nullptr!"));
 
+  if (status_is_cloned_ && shared_clone_state_) {
+    // the feeds, fetches and parameters come with the predictor cloned from
+    pir_program_ = shared_clone_state_->program;
+    return true;
+  }
+
   pir_program_ = std::make_shared<pir::Program>(pir::IrContext::Instance());
   pir::ReadModule(config_.prog_file(), pir_program_.get(), 1 /*pir_version*/);
   if (!SaveOrLoadPirParameters(false)) {
@@ -1178,8 +1496,13 @@ bool AnalysisPredictor::PrepareProgram(
         pir_program_,
         nullptr,
         platform::errors::Fatal("Here, pir_program must be a nullptr!"));
-    pir_program_ = paddle::TranslateLegacyProgramToProgram(*inference_program_);
-    OptimizeInferencePirProgram();
+    if (status_is_cloned_ && shared_clone_state_) {
+      pir_program_ = shared_clone_state_->program;
+    } else {
+      pir_program_ =
+          paddle::TranslateLegacyProgramToProgram(*inference_program_);
+      OptimizeInferencePirProgram();
+    }
   }
   return true;
 }
@@ -1251,10 +1574,20 @@ bool AnalysisPredictor::PrepareExecutor() {
     executor_->Prepare(sub_scope_, *inference_program_, 0);
   }
 
+  if (config_.run_stats_enabled()) {
+    run_stats_ = std::make_unique<framework::RunStatsCollector>(
+        config_.run_stats_trace_sample_interval());
+  }
+
   if (config_.new_executor_enabled()) {
     framework::interpreter::ExecutionConfig execution_config;
     execution_config.create_local_scope = false;
     execution_config.used_for_inference = true;
+    execution_config.run_stats = run_stats_.get();
+    // the pir program packs the tensors it frees at offsets of an arena,
+    // the legacy one those of the reuse table, see MakeOffsetPlan
+    execution_config.memory_offset_plan =
+        config_.new_ir_enabled() && config_.enable_memory_optim_;
 
     auto input_names = GetInputNames();
 
@@ -1265,7 +1598,33 @@ bool AnalysisPredictor::PrepareExecutor() {
     execution_config.skip_gc_vars.insert(output_names.begin(),
                                          output_names.end());
 
-    if (config_.new_ir_enabled()) {
+    if (config_.new_ir_enabled() && config_.shape_plan_cache_enabled()) {
+      // the clones run the same program and share the cache of the root
+      if (!shape_plan_cache_) {
+        shape_plan_cache_ = std::make_shared<framework::ShapePlanCache>(
+            config_.shape_plan_cache_capacity());
+      }
+      execution_config.shape_plan_cache = shape_plan_cache_.get();
+    }
+
+    if (config_.new_ir_enabled() && config_.use_optimized_model_) {
+      execution_config.executor_plan = framework::interpreter::LoadExecutorPlan(
+          GetOptimizedModelPath() + "/" + "_optimized.plan");
+    }
+
+    if (config_.new_ir_enabled() && status_is_cloned_ && shared_clone_state_) {
+      // The feed and fetch variables of the clone should not resolve to the
+      // ones of the predictor cloned from, which live in the parent scope.
+      for (auto &name : input_names) {
+        sub_scope_->Var(name);
+      }
+      for (auto &name : output_names) {
+        sub_scope_->Var(name);
+      }
+      std::lock_guard<std::mutex> lock(shared_clone_state_->build_mutex);
+      executor_->PrepareInterpreterCore(
+          sub_scope_, *pir_program_, execution_config);
+    } else if (config_.new_ir_enabled()) {
       executor_->PrepareInterpreterCore(
           sub_scope_, *pir_program_, execution_config);
     } else {
@@ -1280,7 +1639,14 @@ bool AnalysisPredictor::PrepareExecutor() {
     auto reuse_table =
         pass_res_info->Get<std::unordered_map<std::string, std::string>>(
             root_predictor_id_, "memory_optimize_pass");
+    // the first run shares whole vars, the later ones pack them at offsets
     executor_->MakeReusePlan(reuse_table);
+    std::vector<std::string> reuse_vars;
+    reuse_vars.reserve(reuse_table.size());
+    for (auto &pair : reuse_table) {
+      reuse_vars.push_back(pair.first);
+    }
+    executor_->MakeOffsetPlan(reuse_vars);
   }
   return true;
 }
@@ -1644,11 +2010,13 @@ void AnalysisPredictor::MkldnnPostReset() {
 bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
                             std::vector<PaddleTensor> *output_data,
                             int batch_size) {
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  SharedRuntimeAdmission admission(shared_runtime_model_.get(),
+                                   config_.cpu_math_library_num_threads());
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
   VLOG(3) << "Predictor::predict";
+  framework::RunStatsCollector::RunTimer run_timer(run_stats_.get());
   // set feed variable
   framework::Scope *scope = sub_scope_ ? sub_scope_ : scope_.get();
   PADDLE_ENFORCE_NOT_NULL(
@@ -1674,19 +2042,31 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
     HookCollectShapeRangeInfo();
   }
 
+  if (!config_.shape_buckets().empty()) {
+    PadInputsToShapeBuckets();
+  }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kFeed);
+
   if (config_.new_executor_enabled()) {  // NOLINT
+    SharedCloneRunGuard guard(shared_clone_state_.get(), &shared_clone_built_);
     executor_->RunInterpreterCore();
+    SaveExecutorPlanOnce();
   } else {
     // Run the inference program
     // if share variables, we need not create variables
     executor_->Run();
   }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kExecute);
+  if (!config_.shape_buckets().empty()) {
+    UnpadShapeBucketOutputs();
+  }
 
   // get fetch variable
   if (!GetFetch(output_data, scope)) {
     LOG(ERROR) << "fail to get fetches";
     return false;
   }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kFetch);
 
   // All the containers in the scope will be hold in inference, but the
   // operators assume that the container will be reset after each batch.
@@ -1694,7 +2074,8 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   // bool; the next time, the operator will call MutableData and construct a new
   // container again, so that the container will be empty for each batch.
   if (sub_scope_) {
-    tensor_array_batch_cleaner_.CollectNoTensorVars(sub_scope_);
+    tensor_array_batch_cleaner_.CollectNoTensorVars(sub_scope_,
+                                                   !shared_clone_state_);
   }
   tensor_array_batch_cleaner_.ResetNoTensorVars();
 
@@ -1710,6 +2091,7 @@ bool AnalysisPredictor::Run(const std::vector<PaddleTensor> &inputs,
   // https://software.intel.com/en-us/mkl-developer-reference-c-mkl-free-buffers
   phi::dynload::MKL_Free_Buffers();
 #endif
+  run_timer.Finish();
   return true;
 }
 
@@ -1721,11 +2103,13 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
     auto &pool = paddle::experimental::DeviceContextPool::Instance();
     pool.SyncDeviceContext(place_);
   }
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  SharedRuntimeAdmission admission(shared_runtime_model_.get(),
+                                   config_.cpu_math_library_num_threads());
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) MkldnnPreSet(inputs);
 #endif
   VLOG(3) << "predict start";
+  framework::RunStatsCollector::RunTimer run_timer(run_stats_.get());
   // set feed variable
   framework::Scope *scope = sub_scope_ ? sub_scope_ : scope_.get();
   PADDLE_ENFORCE_NOT_NULL(
@@ -1775,13 +2159,24 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
   }
 #endif
 
+  if (!config_.shape_buckets().empty()) {
+    PadInputsToShapeBuckets();
+  }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kFeed);
+
   if (config_.new_executor_enabled()) {  // NOLINT
+    SharedCloneRunGuard guard(shared_clone_state_.get(), &shared_clone_built_);
     executor_->RunInterpreterCore();
+    SaveExecutorPlanOnce();
   } else {
     // Run the inference program
     // if share variables, we need not create variables
     executor_->Run();
   }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kExecute);
+  if (!config_.shape_buckets().empty()) {
+    UnpadShapeBucketOutputs();
+  }
 
   inference::DisplayMemoryInfo(place_, "after run");
 #ifdef PADDLE_WITH_XPU
@@ -1794,9 +2189,11 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
     LOG(ERROR) << "fail to get fetches";
     return false;
   }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kFetch);
 
   // Fix TensorArray reuse not cleaned bug.
-  tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
+  tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_,
+                                                  !shared_clone_state_);
   tensor_array_batch_cleaner_.ResetTensorArray();
 
   // recover the cpu_math_library_num_threads to 1, in order to avoid thread
@@ -1814,6 +2211,7 @@ bool AnalysisPredictor::Run(const std::vector<paddle::Tensor> &inputs,
   // https://software.intel.com/en-us/mkl-developer-reference-c-mkl-free-buffers
   phi::dynload::MKL_Free_Buffers();
 #endif
+  run_timer.Finish();
   return true;
 }
 
@@ -2416,7 +2814,9 @@ CreatePaddlePredictor<AnalysisConfig, PaddleEngineKind::kAnalysis>(
     return nullptr;
   }
 
-  if (config.mkldnn_quantizer_enabled() && !predictor_p->MkldnnQuantize()) {
+  // The pir program is quantized while it is optimized.
+  if (config.mkldnn_quantizer_enabled() && !config.new_ir_enabled() &&
+      !predictor_p->MkldnnQuantize()) {
     return nullptr;
   }
 
@@ -2646,6 +3046,11 @@ std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::GetOutputTensor(
       platform::errors::PreconditionNotMet(
           "The variable named %s is not found in the scope of the executor.",
           name));
+  return CreateOutputHandle(scope, name);
+}
+
+std::unique_ptr<ZeroCopyTensor> AnalysisPredictor::CreateOutputHandle(
+    framework::Scope *scope, const std::string &name) {
   std::unique_ptr<ZeroCopyTensor> res(new ZeroCopyTensor(
       static_cast<void *>(scope), this->GetDeviceContexts()));
   res->input_or_output_ = false;
@@ -2680,12 +3085,14 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
     return true;
   }
 #endif
+  framework::RunStatsCollector::RunTimer run_timer(run_stats_.get());
   if (private_context_) {
     phi::DeviceContextPool::SetDeviceContexts(&device_contexts_);
     auto &pool = paddle::experimental::DeviceContextPool::Instance();
     pool.SyncDeviceContext(place_);
   }
-  paddle::platform::SetNumThreads(config_.cpu_math_library_num_threads());
+  SharedRuntimeAdmission admission(shared_runtime_model_.get(),
+                                   config_.cpu_math_library_num_threads());
 #ifdef PADDLE_WITH_DNNL
   if (config_.use_mkldnn_) {
     std::vector<std::vector<int>> shape_vector;
@@ -2741,11 +3148,22 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
   }
 #endif
 
+  if (!config_.shape_buckets().empty()) {
+    PadInputsToShapeBuckets();
+  }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kFeed);
+
   if (config_.new_executor_enabled()) {  // NOLINT
+    SharedCloneRunGuard guard(shared_clone_state_.get(), &shared_clone_built_);
     executor_->RunInterpreterCore({}, false, switch_stream);
+    SaveExecutorPlanOnce();
   } else {
     executor_->Run();
   }
+  run_timer.Mark(framework::RunStatsCollector::Phase::kExecute);
+  if (!config_.shape_buckets().empty()) {
+    UnpadShapeBucketOutputs();
+  }
   inference::DisplayMemoryInfo(place_, "after run");
 
 #ifdef PADDLE_WITH_XPU
@@ -2755,7 +3173,8 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
 #endif
 
   // Fix TensorArray reuse not cleaned bug.
-  tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
+  tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_,
+                                                  !shared_clone_state_);
   tensor_array_batch_cleaner_.ResetTensorArray();
 
   // recover the cpu_math_library_num_threads to 1, in order to avoid thread
@@ -2773,9 +3192,112 @@ bool AnalysisPredictor::ZeroCopyRun(bool switch_stream) {
   // https://software.intel.com/en-us/mkl-developer-reference-c-mkl-free-buffers
   phi::dynload::MKL_Free_Buffers();
 #endif
+  run_timer.Mark(framework::RunStatsCollector::Phase::kFetch);
+  run_timer.Finish();
   return true;
 }
 
+void AnalysisPredictor::RunAsync(paddle_infer::AsyncRunCallback callback) {
+  std::call_once(async_run_flag_, [this] {
+    auto state = std::make_unique<AsyncRunState>();
+    state->runner = Clone();
+    state->input_names = GetInputNames();
+    state->output_names = GetOutputNames();
+    state->run_queue = framework::CreateSingleThreadedWorkQueue(
+        framework::WorkQueueOptions("AsyncRun",
+                                    /*num_threads*/ 1,
+                                    /*allow_spinning*/ false,
+                                    /*track_task*/ false));
+    state->callback_queue = framework::CreateSingleThreadedWorkQueue(
+        framework::WorkQueueOptions("AsyncRunCallback",
+                                    /*num_threads*/ 1,
+                                    /*allow_spinning*/ false,
+                                    /*track_task*/ false));
+    async_run_state_ = std::move(state);
+  });
+  AsyncRunState *state = async_run_state_.get();
+
+  // Swap the feeds into the slot, the handles refill the tensors of the slot
+  // two runs ago, which that run no longer reads.
+  framework::Scope *scope = executor_->GetScope();
+  int input_slot =
+      state->AcquireSlot(state->input_slots, &state->next_input_slot);
+  framework::Scope &inputs = state->input_slots[input_slot].scope;
+  for (auto &name : state->input_names) {
+    auto *var = scope->FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var,
+        platform::errors::PreconditionNotMet(
+            "The input %s is not found in the scope of the predictor.", name));
+    auto *feed = var->GetMutable<phi::DenseTensor>();
+    auto *staged = inputs.Var(name)->GetMutable<phi::DenseTensor>();
+    phi::DenseTensor tmp = *staged;
+    *staged = *feed;
+    *feed = tmp;
+  }
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    ++state->running;
+  }
+
+  state->run_queue->AddTask([state, input_slot, callback]() {
+    auto *runner = static_cast<AnalysisPredictor *>(state->runner.get());
+    framework::Scope *run_scope = runner->executor_->GetScope();
+    framework::Scope &inputs = state->input_slots[input_slot].scope;
+    bool success = false;
+    int output_slot = -1;
+    try {
+      for (auto &name : state->input_names) {
+        auto &staged = inputs.FindVar(name)->Get<phi::DenseTensor>();
+        auto *feed = run_scope->FindVar(name)->GetMutable<phi::DenseTensor>();
+        feed->ShareDataWith(staged);
+        feed->set_lod(staged.lod());
+      }
+      success = runner->ZeroCopyRun();
+      if (success) {
+        // The next run reuses the fetch tensors of the runner.
+        output_slot =
+            state->AcquireSlot(state->output_slots, &state->next_output_slot);
+        framework::Scope &outputs = state->output_slots[output_slot].scope;
+        for (auto &name : state->output_names) {
+          auto &fetch = run_scope->FindVar(name)->Get<phi::DenseTensor>();
+          auto *out = outputs.Var(name)->GetMutable<phi::DenseTensor>();
+          framework::TensorCopySync(fetch, fetch.place(), out);
+          out->set_lod(fetch.lod());
+        }
+      }
+    } catch (const std::exception &e) {
+      LOG(ERROR) << "The async run failed: " << e.what();
+      success = false;
+    }
+    state->ReleaseSlot(state->input_slots, input_slot);
+
+    state->callback_queue->AddTask([state, output_slot, success, callback]() {
+      auto *runner = static_cast<AnalysisPredictor *>(state->runner.get());
+      std::vector<std::unique_ptr<paddle_infer::Tensor>> outputs;
+      if (output_slot >= 0) {
+        for (auto &name : state->output_names) {
+          outputs.emplace_back(runner->CreateOutputHandle(
+              &state->output_slots[output_slot].scope, name));
+        }
+      }
+      try {
+        callback(success, std::move(outputs));
+      } catch (const std::exception &e) {
+        LOG(ERROR) << "The callback of the async run failed: " << e.what();
+      }
+      if (output_slot >= 0) {
+        state->ReleaseSlot(state->output_slots, output_slot);
+      }
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        --state->running;
+      }
+      state->cv.notify_all();
+    });
+  });
+}
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 bool AnalysisPredictor::ExpRunWithExternalStream(const gpuStream_t stream) {
   if (!private_context_) {
@@ -3050,6 +3572,17 @@ bool AnalysisPredictor::LoadProgramDesc() {
   return true;
 }
 
+bool AnalysisPredictor::UseMmapParams() const {
+  return config_.mmap_params_enabled() && !config_.params_file().empty() &&
+         !config_.model_from_memory() && framework::IsMappedParamsSupported();
+}
+
+bool AnalysisPredictor::UseSharedClone() const {
+  return config_.shared_clone_enabled() && config_.new_ir_enabled() &&
+         config_.new_executor_enabled() &&
+         !config_.dist_config().use_dist_model();
+}
+
 bool AnalysisPredictor::LoadParameters() {
   PADDLE_ENFORCE_NOT_NULL(inference_program_.get(),
                           platform::errors::PreconditionNotMet(
@@ -3091,6 +3624,24 @@ bool AnalysisPredictor::LoadParameters() {
   if (!config_.params_file().empty()) {
     // sort paramlist to have consistent ordering
     std::sort(params.begin(), params.end());
+    if (UseMmapParams()) {
+      std::vector<phi::DenseTensor *> tensors;
+      bool all_dense = true;
+      for (auto &name : params) {
+        auto *var = load_block->FindVar(name);
+        if (var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+          all_dense = false;
+          break;
+        }
+        tensors.push_back(scope_->Var(name)->GetMutable<phi::DenseTensor>());
+      }
+      if (all_dense) {
+        LoadMappedParams(config_.params_file(), tensors, place_);
+        return true;
+      }
+      LOG(WARNING) << "Only DenseTensor params can be loaded with mmap, "
+                      "fall back to load_combine.";
+    }
     // append just the load_combine op
     framework::OpDesc *op = load_block->AppendOp();
     op->SetType("load_combine");
@@ -3108,6 +3659,154 @@ bool AnalysisPredictor::LoadParameters() {
   return true;
 }
 
+ShapePlanCacheStats AnalysisPredictor::GetShapePlanCacheStats() const {
+  ShapePlanCacheStats stats;
+  if (shape_plan_cache_) {
+    auto cache_stats = shape_plan_cache_->GetStats();
+    stats.hit_num = cache_stats.hit_num;
+    stats.miss_num = cache_stats.miss_num;
+    stats.plan_num = cache_stats.plan_num;
+  }
+  return stats;
+}
+
+RunStats AnalysisPredictor::GetRunStats() const {
+  RunStats stats;
+  if (!run_stats_) {
+    return stats;
+  }
+  auto ToLatencyStats = [](const framework::LatencySummary &summary) {
+    LatencyStats latency;
+    latency.count = summary.count;
+    latency.mean_us = summary.mean_ns / 1000.;
+    latency.p50_us = summary.p50_ns / 1000.;
+    latency.p90_us = summary.p90_ns / 1000.;
+    latency.p99_us = summary.p99_ns / 1000.;
+    latency.max_us = summary.max_ns / 1000.;
+    return latency;
+  };
+  auto summary = run_stats_->Summarize();
+  stats.total = ToLatencyStats(summary.phases["total"]);
+  stats.feed = ToLatencyStats(summary.phases["feed"]);
+  stats.execute = ToLatencyStats(summary.phases["execute"]);
+  stats.gc = ToLatencyStats(summary.phases["gc"]);
+  stats.fetch = ToLatencyStats(summary.phases["fetch"]);
+  for (auto &pair : summary.instruction_groups) {
+    stats.instruction_groups[pair.first] = ToLatencyStats(pair.second);
+  }
+  for (auto &trace : summary.sampled_traces) {
+    std::vector<OpTraceEvent> events;
+    events.reserve(trace.size());
+    for (auto &record : trace) {
+      OpTraceEvent event;
+      event.name = record.name;
+      event.start_us = record.start_ns / 1000.;
+      event.run_us = record.run_ns / 1000.;
+      event.gc_us = record.gc_ns / 1000.;
+      events.push_back(std::move(event));
+    }
+    stats.sampled_traces.push_back(std::move(events));
+  }
+  return stats;
+}
+
+void AnalysisPredictor::PadInputsToShapeBuckets() {
+  // a run which threw left the padded inputs in the scope
+  RestoreShapeBucketInputs();
+  const auto &buckets = config_.shape_buckets();
+  for (auto &name : config_.shape_bucket_inputs()) {
+    auto *var = sub_scope_->FindVar(name);
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      continue;
+    }
+    auto *tensor = var->GetMutable<phi::DenseTensor>();
+    if (!tensor->initialized() || tensor->dims().size() < 2 ||
+        !phi::is_cpu_place(tensor->place())) {
+      continue;
+    }
+    int64_t len = tensor->dims()[1];
+    auto bucket = std::lower_bound(buckets.begin(), buckets.end(), len);
+    if (bucket == buckets.end() || *bucket == len) {
+      continue;
+    }
+    phi::DenseTensor padded;
+    double value = config_.shape_bucket_pad_value();
+    switch (tensor->dtype()) {
+      case phi::DataType::FLOAT32:
+        PadAlongDim1<float>(*tensor, *bucket, value, &padded);
+        break;
+      case phi::DataType::FLOAT64:
+        PadAlongDim1<double>(*tensor, *bucket, value, &padded);
+        break;
+      case phi::DataType::INT32:
+        PadAlongDim1<int32_t>(*tensor, *bucket, value, &padded);
+        break;
+      case phi::DataType::INT64:
+        PadAlongDim1<int64_t>(*tensor, *bucket, value, &padded);
+        break;
+      default:
+        PADDLE_THROW(platform::errors::Unimplemented(
+            "The input %s of data type %s can not be padded to the shape "
+            "buckets.",
+            name,
+            phi::DataTypeToString(tensor->dtype())));
+    }
+    VLOG(4) << "Pad input " << name << " from length " << len << " to "
+            << *bucket;
+    if (shape_bucket_padded_.empty()) {
+      shape_bucket_len_ = len;
+      shape_bucket_padded_len_ = *bucket;
+    }
+    phi::DenseTensor fed;
+    fed.ShareDataWith(*tensor);
+    shape_bucket_padded_.emplace_back(tensor, std::move(fed));
+    tensor->ShareDataWith(padded);
+  }
+}
+
+void AnalysisPredictor::RestoreShapeBucketInputs() {
+  for (auto &item : shape_bucket_padded_) {
+    item.first->ShareDataWith(item.second);
+  }
+  shape_bucket_padded_.clear();
+}
+
+void AnalysisPredictor::UnpadShapeBucketOutputs() {
+  if (shape_bucket_padded_.empty()) {
+    return;
+  }
+  RestoreShapeBucketInputs();
+  for (auto &item : idx2fetches_) {
+    auto *var = sub_scope_->FindVar(item.second);
+    if (var == nullptr || !var->IsType<phi::DenseTensor>()) {
+      continue;
+    }
+    auto *tensor = var->GetMutable<phi::DenseTensor>();
+    if (!tensor->initialized() || tensor->dims().size() < 2 ||
+        tensor->dims()[1] != shape_bucket_padded_len_) {
+      continue;
+    }
+    VLOG(4) << "Slice output " << item.second << " from length "
+            << shape_bucket_padded_len_ << " to " << shape_bucket_len_;
+    phi::DenseTensor sliced;
+    SliceAlongDim1(*tensor, shape_bucket_len_, &sliced);
+    tensor->ShareDataWith(sliced);
+  }
+}
+
+void AnalysisPredictor::SaveExecutorPlanOnce() {
+  if (executor_plan_saved_ || !config_.save_optimized_model_ ||
+      !config_.new_ir_enabled() || status_is_cloned_) {
+    return;
+  }
+  std::string plan_path = GetOptimizedModelPath() + "/" + "_optimized.plan";
+  // a plan which failed to save is not tried again on every run
+  executor_plan_saved_ = true;
+  if (executor_->SaveExecutorPlan(plan_path)) {
+    LOG(INFO) << "Executor plan saved to " << plan_path;
+  }
+}
+
 uint64_t AnalysisPredictor::TryShrinkMemory() {
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   if (config_.use_gpu()) {
@@ -3193,6 +3892,10 @@ bool AnalysisPredictor::SaveTrtCalibToDisk() {
 #endif
 
 AnalysisPredictor::~AnalysisPredictor() {  // NOLINT
+  if (async_run_state_) {
+    async_run_state_->WaitIdle();
+    async_run_state_.reset();
+  }
 #ifdef PADDLE_WITH_TENSORRT
   if (config_.tensorrt_engine_enabled() &&
       config_.tensorrt_precision_mode_ == AnalysisConfig::Precision::kInt8 &&
@@ -3215,7 +3918,12 @@ AnalysisPredictor::~AnalysisPredictor() {  // NOLINT
       }
       framework::global_transfer_scope_key().erase(sub_scope_);
     }
-    scope_->DeleteScope(sub_scope_);
+    // The persistables may still be used by the clones, the sub scope holding
+    // them is deleted with the scope once the last clone is gone.
+    if (!shared_clone_state_ ||
+        shared_clone_state_->param_scope != sub_scope_) {
+      sub_scope_->parent()->DeleteScope(sub_scope_);
+    }
   }
 
 #if PADDLE_WITH_DNNL
@@ -3264,10 +3972,40 @@ std::unique_ptr<PaddlePredictor> AnalysisPredictor::Clone(void *stream) {
         "function has received a stream parameter."));
   }
   x->predictor_stream_ = stream;
+  x->shape_plan_cache_ = shape_plan_cache_;
+  x->shared_runtime_model_ = shared_runtime_model_;
+  bool shared = shared_clone_state_ != nullptr;
+  size_t rss_before = 0;
+  auto start = std::chrono::steady_clock::now();
+  if (shared) {
+    rss_before = GetProcessRSS();
+    x->shared_clone_state_ = shared_clone_state_;
+    if (load_pir_model_) {
+      x->pir_feeds_ = pir_feeds_;
+      x->pir_fetches_ = pir_fetches_;
+      x->feed_names_ = feed_names_;
+      x->idx2feeds_ = idx2feeds_;
+      x->idx2fetches_ = idx2fetches_;
+    }
+  }
   x->Init(scope_, inference_program_);
 #ifdef PADDLE_WITH_TENSORRT
   x->executor_->ResetTrtOps(++AnalysisPredictor::clone_num_);
 #endif
+  if (shared) {
+    // the dependency analysis is shared if this predictor has run
+    if (!private_context_ && !x->private_context_) {
+      x->executor_->ShareBuildResultsFrom(*executor_);
+    }
+    double clone_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    size_t rss_after = GetProcessRSS();
+    LOG(INFO) << "Clone predictor sharing the program in " << clone_ms
+              << " ms, process RSS "
+              << (rss_after > rss_before ? (rss_after - rss_before) >> 10 : 0)
+              << " KB more";
+  }
   return std::unique_ptr<PaddlePredictor>(x);
 }
 
@@ -3692,6 +4430,19 @@ bool Predictor::Run(const std::vector<paddle::Tensor> &inputs,
   return predictor_->Run(inputs, outputs);
 }
 
+void Predictor::RunAsync(AsyncRunCallback callback) {
+  auto *pred = dynamic_cast<paddle::AnalysisPredictor *>(predictor_.get());
+  PADDLE_ENFORCE_NOT_NULL(
+      pred,
+      platform::errors::PreconditionNotMet(
+          "The async runs are only supported by the AnalysisPredictor."));
+  PADDLE_ENFORCE_EQ(static_cast<bool>(callback),
+                    true,
+                    platform::errors::InvalidArgument(
+                        "The callback of the async run should be set."));
+  pred->RunAsync(std::move(callback));
+}
+
 std::unique_ptr<Predictor> Predictor::Clone(void *stream) {
   auto analysis_pred = predictor_->Clone(stream);
   std::unique_ptr<Predictor> pred(new Predictor(std::move(analysis_pred)));
@@ -3713,6 +4464,24 @@ void Predictor::RegisterInputHook(const InputTensorHookFunc &hookfunc) {
 
 void *Predictor::GetExecStream() const { return predictor_->GetExecStream(); }
 
+RunStats Predictor::GetRunStats() const {
+  auto *pred = dynamic_cast<paddle::AnalysisPredictor *>(predictor_.get());
+  PADDLE_ENFORCE_NOT_NULL(
+      pred,
+      platform::errors::PreconditionNotMet(
+          "The run stats are only collected by the AnalysisPredictor."));
+  return pred->GetRunStats();
+}
+
+ShapePlanCacheStats Predictor::GetShapePlanCacheStats() const {
+  auto *pred = dynamic_cast<paddle::AnalysisPredictor *>(predictor_.get());
+  PADDLE_ENFORCE_NOT_NULL(
+      pred,
+      platform::errors::PreconditionNotMet(
+          "The shape plan cache is only used by the AnalysisPredictor."));
+  return pred->GetShapePlanCacheStats();
+}
+
 int GetNumBytesOfDataType(DataType dtype) {
   switch (dtype) {
     case DataType::FLOAT32:
@@ -3773,6 +4542,11 @@ void ConvertToMixedPrecision(const std::string &model_file,
                                                        white_list);
 }
 
+void AlignParamsForMmap(const std::string &params_file,
+                        const std::string &aligned_params_file) {
+  paddle::framework::AlignCombinedParamsFile(params_file, aligned_params_file);
+}
+
 }  // namespace paddle_infer
 
 namespace paddle_infer {
@@ -3878,6 +4652,11 @@ void InternalUtils::SyncStream(paddle_infer::Predictor *p) {
   paddle::gpuStreamSynchronize(dev_ctx->stream());
 #endif
 }
+bool InternalUtils::ExecutorPlanApplied(paddle_infer::Predictor *p) {
+  auto *pred = dynamic_cast<paddle::AnalysisPredictor *>(p->predictor_.get());
+  return pred != nullptr && pred->executor_->ExecutorPlanApplied();
+}
+
 void InternalUtils::SyncStream(cudaStream_t stream) {
 #ifdef PADDLE_WITH_CUDA
   cudaStreamSynchronize(stream);
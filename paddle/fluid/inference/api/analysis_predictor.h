@@ -21,6 +21,8 @@
 #include <vector>
 
 #include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/new_executor/run_stats.h"
+#include "paddle/fluid/framework/new_executor/shape_plan_cache.h"
 #include "paddle/fluid/framework/op_compatible_info.h"
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
@@ -72,6 +74,14 @@ using framework::proto::ProgramDesc;
 using inference::analysis::Analyzer;
 using inference::analysis::Argument;
 
+// The program, persistables and run admission shared by a predictor and its
+// clones, see AnalysisConfig::EnableSharedClone.
+struct SharedCloneState;
+// The clone, the queues and the input and output slots of RunAsync.
+struct AsyncRunState;
+// The model a predictor and its clones attached to a shared runtime.
+struct SharedRuntimeModel;
+
 ///
 /// \class AnalysisPredictor
 ///
@@ -214,6 +224,14 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   bool ZeroCopyRun(bool switch_stream = false) override;
 
+  ///
+  /// \brief Run the prediction engine on a clone without waiting for it, see
+  /// paddle_infer::Predictor::RunAsync.
+  ///
+  /// \param callback Called with the outputs when the run is done
+  ///
+  void RunAsync(paddle_infer::AsyncRunCallback callback);
+
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   // Note: Can only be used under thread_local semantics.
   bool ExpRunWithExternalStream(const gpuStream_t stream);
@@ -277,6 +295,22 @@ class AnalysisPredictor : public PaddlePredictor {
   ///
   uint64_t TryShrinkMemory() override;
 
+  ///
+  /// \brief Get the statistics of the shape plan cache shared with the
+  /// clones, all zero if it is not enabled.
+  ///
+  /// \return The hits and misses of the shape plan cache
+  ///
+  ShapePlanCacheStats GetShapePlanCacheStats() const;
+
+  ///
+  /// \brief Get the latency breakdown of the runs so far, all empty if it is
+  /// not enabled.
+  ///
+  /// \return The latency of the phases and instructions of the runs
+  ///
+  RunStats GetRunStats() const;
+
   ///
   /// \brief Get the argument used by predictor
   ///
@@ -391,6 +425,38 @@ class AnalysisPredictor : public PaddlePredictor {
   /// \return Whether the function executed successfully
   ///
   bool LoadParameters();
+  ///
+  /// \brief Whether the combined params file is loaded with mmap.
+  ///
+  /// \return Whether to load params with mmap
+  ///
+  bool UseMmapParams() const;
+  ///
+  /// \brief Whether the clones share the program of this predictor.
+  ///
+  /// \return Whether to share the program with the clones
+  ///
+  bool UseSharedClone() const;
+  ///
+  /// \brief Pad the inputs of AnalysisConfig::SetShapeBuckets to the
+  /// smallest bucket not shorter than them.
+  ///
+  void PadInputsToShapeBuckets();
+  ///
+  /// \brief Give the caller back the inputs it fed before they were padded.
+  ///
+  void RestoreShapeBucketInputs();
+  ///
+  /// \brief Restore the padded inputs and slice the outputs padded along
+  /// dim 1 back to the length of the inputs.
+  ///
+  void UnpadShapeBucketOutputs();
+  ///
+  /// \brief Save the executor plan next to the optimized model after the
+  /// first run, so that the predictors using the optimized model skip the
+  /// analysis of the program.
+  ///
+  void SaveExecutorPlanOnce();
 
   ///
   /// \brief Save or Load pir model parameters.
@@ -519,6 +585,8 @@ class AnalysisPredictor : public PaddlePredictor {
   void InitResourceManager(void *stream);
   std::string GetOptimizedModelPath();
   void ClearExtraParams();
+  std::unique_ptr<ZeroCopyTensor> CreateOutputHandle(framework::Scope *scope,
+                                                     const std::string &name);
 
 #if defined(PADDLE_WITH_DISTRIBUTE) && defined(PADDLE_WITH_PSCORE)
   // fleet exe related
@@ -619,6 +687,26 @@ class AnalysisPredictor : public PaddlePredictor {
   std::vector<InputTensorHookFunc> input_hookfuncs_;
   // Some status here that help to determine the status inside the predictor.
   bool status_is_cloned_{false};
+  // Set when the predictor shares its program with clones.
+  std::shared_ptr<SharedCloneState> shared_clone_state_;
+  bool shared_clone_built_{false};
+  // Set when the output metas are cached per input shape, shared with the
+  // clones.
+  std::shared_ptr<framework::ShapePlanCache> shape_plan_cache_;
+  // The inputs padded to the shape buckets with the tensors fed by the
+  // caller, and the length of the first one before and after the padding.
+  std::vector<std::pair<phi::DenseTensor *, phi::DenseTensor>>
+      shape_bucket_padded_;
+  int64_t shape_bucket_len_{0};
+  int64_t shape_bucket_padded_len_{0};
+  bool executor_plan_saved_{false};
+  // Set when the latency of the runs is collected.
+  std::unique_ptr<framework::RunStatsCollector> run_stats_;
+  // Set when attached to a shared runtime, shared with the clones.
+  std::shared_ptr<SharedRuntimeModel> shared_runtime_model_;
+  // Created by the first RunAsync.
+  std::once_flag async_run_flag_;
+  std::unique_ptr<AsyncRunState> async_run_state_;
 
   std::map<std::string, std::vector<std::vector<int32_t>>> shape_info_;
   std::map<std::string, std::vector<std::vector<int32_t>>> shape_tensor_value_;
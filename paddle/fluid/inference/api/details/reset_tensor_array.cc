@@ -26,7 +26,8 @@ namespace paddle {
 namespace details {
 
 // Should be called after the parameters are loaded.
-void TensorArrayBatchCleaner::CollectTensorArrays(framework::Scope *scope) {
+void TensorArrayBatchCleaner::CollectTensorArrays(framework::Scope *scope,
+                                                  bool with_kids) {
   if (flag_) {
     for (auto &var_name : scope->LocalVarNames()) {
       auto *var = scope->FindVar(var_name);
@@ -38,8 +39,10 @@ void TensorArrayBatchCleaner::CollectTensorArrays(framework::Scope *scope) {
         arrays_.push_back(var->GetMutable<framework::LoDTensorArray>());
       }
     }
-    for (auto *kid : scope->kids()) {
-      CollectTensorArrays(kid);
+    if (with_kids) {
+      for (auto *kid : scope->kids()) {
+        CollectTensorArrays(kid);
+      }
     }
 
     VLOG(3) << "Collect " << arrays_.size() << " arrays";
@@ -54,7 +57,8 @@ void TensorArrayBatchCleaner::ResetTensorArray() {
   }
 }
 
-void TensorArrayBatchCleaner::CollectNoTensorVars(framework::Scope *scope) {
+void TensorArrayBatchCleaner::CollectNoTensorVars(framework::Scope *scope,
+                                                  bool with_kids) {
   if (no_tensor_flag_) {
     for (auto &var_name : scope->LocalVarNames()) {
       auto *var = scope->FindVar(var_name);
@@ -64,8 +68,10 @@ void TensorArrayBatchCleaner::CollectNoTensorVars(framework::Scope *scope) {
       }
     }
 
-    for (auto *kid : scope->kids()) {
-      CollectTensorArrays(kid);
+    if (with_kids) {
+      for (auto *kid : scope->kids()) {
+        CollectTensorArrays(kid);
+      }
     }
     no_tensor_flag_ = false;  // Only collect one time.
   }
@@ -55,11 +55,13 @@ struct TensorArrayBatchCleaner {
   // bool(trick), because some of them are containers, and some operators just
   // keep inserting new items without clearing the containers first; So the
   // memory grow larger and larger in inference service deployed online.
-  void CollectNoTensorVars(framework::Scope *scope);
+  // The kid scopes are skipped if with_kids is false, e.g. when they belong to
+  // other predictors.
+  void CollectNoTensorVars(framework::Scope *scope, bool with_kids = true);
   void ResetNoTensorVars();
 
   // Fix the tensor array not clear in the inference scenarios.
-  void CollectTensorArrays(framework::Scope *scope);
+  void CollectTensorArrays(framework::Scope *scope, bool with_kids = true);
   void ResetTensorArray();
 
  private:
@@ -0,0 +1,513 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <utility>
+
+#include "paddle/fluid/inference/api/paddle_dynamic_batcher.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/phi/common/bfloat16.h"
+#include "paddle/phi/common/float16.h"
+
+namespace paddle_infer {
+namespace services {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Tensors = DynamicBatcher::Tensors;
+
+template <typename Visitor>
+void VisitDataType(DataType dtype, Visitor&& visitor) {
+  switch (dtype) {
+    case DataType::FLOAT32:
+      visitor(float());
+      break;
+    case DataType::FLOAT64:
+      visitor(double());
+      break;
+    case DataType::INT64:
+      visitor(int64_t());
+      break;
+    case DataType::INT32:
+      visitor(int32_t());
+      break;
+    case DataType::UINT8:
+      visitor(uint8_t());
+      break;
+    case DataType::INT8:
+      visitor(int8_t());
+      break;
+    case DataType::BOOL:
+      visitor(bool());
+      break;
+    case DataType::FLOAT16:
+      visitor(phi::dtype::float16());
+      break;
+    case DataType::BFLOAT16:
+      visitor(phi::dtype::bfloat16());
+      break;
+    default:
+      PADDLE_THROW(phi::errors::Unimplemented(
+          "Unsupported data type %d in DynamicBatcher.",
+          static_cast<int>(dtype)));
+  }
+}
+
+int64_t Numel(const std::vector<int>& shape, size_t begin = 0) {
+  int64_t numel = 1;
+  for (size_t i = begin; i < shape.size(); ++i) {
+    numel *= shape[i];
+  }
+  return numel;
+}
+
+// Runs a batch with a predictor of the pool, the predictor is only used by
+// one worker.
+DynamicBatcher::BatchRunFunc MakePredictorRunFunc(Predictor* predictor) {
+  return [predictor](const Tensors& inputs, Tensors* outputs) {
+    for (auto& input : inputs) {
+      auto handle = predictor->GetInputHandle(input.name);
+      handle->Reshape(input.shape);
+      VisitDataType(input.dtype, [&](auto type) {
+        using T = decltype(type);
+        handle->CopyFromCpu(static_cast<const T*>(input.data.data()));
+      });
+    }
+    PADDLE_ENFORCE_EQ(
+        predictor->Run(),
+        true,
+        phi::errors::Fatal("Failed to run the predictor of DynamicBatcher."));
+    auto output_names = predictor->GetOutputNames();
+    outputs->resize(output_names.size());
+    for (size_t i = 0; i < output_names.size(); ++i) {
+      auto handle = predictor->GetOutputHandle(output_names[i]);
+      auto& output = (*outputs)[i];
+      output.name = output_names[i];
+      output.shape = handle->shape();
+      output.dtype = handle->type();
+      output.data.Resize(Numel(output.shape) *
+                         GetNumBytesOfDataType(output.dtype));
+      VisitDataType(output.dtype, [&](auto type) {
+        using T = decltype(type);
+        handle->CopyToCpu(static_cast<T*>(output.data.data()));
+      });
+    }
+  };
+}
+
+}  // namespace
+
+struct DynamicBatcher::Impl {
+  struct Request {
+    Tensors inputs;
+    int batch_size{0};
+    // length of the padded inputs after padding, 0 to pad to the batch
+    int padded_len{0};
+    Clock::time_point enqueue_time;
+    std::promise<Tensors> promise;
+  };
+
+  // requests which can be batched together
+  struct Queue {
+    std::deque<std::unique_ptr<Request>> requests;
+    int row_num{0};
+  };
+
+  Impl(std::vector<BatchRunFunc> run_funcs, const DynamicBatcherConfig& config)
+      : config_(config),
+        padded_inputs_(config.padded_inputs.begin(),
+                       config.padded_inputs.end()),
+        run_funcs_(std::move(run_funcs)) {
+    PADDLE_ENFORCE_GT(config_.max_batch_size,
+                      0,
+                      phi::errors::InvalidArgument(
+                          "The max_batch_size of DynamicBatcher should be "
+                          "greater than 0, but got %d.",
+                          config_.max_batch_size));
+    PADDLE_ENFORCE_EQ(
+        std::is_sorted(config_.seq_len_buckets.begin(),
+                       config_.seq_len_buckets.end()),
+        true,
+        phi::errors::InvalidArgument(
+            "The seq_len_buckets of DynamicBatcher should be ascending."));
+    for (size_t i = 0; i < run_funcs_.size(); ++i) {
+      workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  ~Impl() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  std::future<Tensors> Submit(Tensors inputs) {
+    PADDLE_ENFORCE_EQ(
+        inputs.empty(),
+        false,
+        phi::errors::InvalidArgument("The request has no inputs."));
+    auto request = std::make_unique<Request>();
+    request->batch_size = inputs[0].shape.empty() ? 0 : inputs[0].shape[0];
+    // requests are batched with the ones of the same key: the same inputs
+    // with the same dims except dim 0 and the padded dim
+    std::ostringstream key;
+    for (auto& input : inputs) {
+      PADDLE_ENFORCE_EQ(
+          !input.shape.empty() && input.shape[0] == request->batch_size,
+          true,
+          phi::errors::InvalidArgument(
+              "All inputs of a request should have the same dim 0."));
+      PADDLE_ENFORCE_EQ(
+          input.data.length(),
+          Numel(input.shape) * GetNumBytesOfDataType(input.dtype),
+          phi::errors::InvalidArgument(
+              "The data size of input %s does not match its shape.",
+              input.name));
+      bool padded = padded_inputs_.count(input.name) > 0;
+      if (padded) {
+        PADDLE_ENFORCE_GE(input.shape.size(),
+                          2UL,
+                          phi::errors::InvalidArgument(
+                              "The padded input %s should have at least 2 "
+                              "dims.",
+                              input.name));
+        request->padded_len = std::max(request->padded_len, input.shape[1]);
+      }
+      key << input.name << ':' << static_cast<int>(input.dtype);
+      for (size_t i = padded ? 2 : 1; i < input.shape.size(); ++i) {
+        key << ',' << input.shape[i];
+      }
+      key << ';';
+    }
+    if (request->padded_len > 0) {
+      auto& buckets = config_.seq_len_buckets;
+      auto bucket =
+          std::lower_bound(buckets.begin(), buckets.end(), request->padded_len);
+      if (bucket != buckets.end()) {
+        request->padded_len = *bucket;
+      } else if (buckets.empty()) {
+        request->padded_len = 0;
+      }
+      key << "len:" << request->padded_len;
+    }
+    request->inputs = std::move(inputs);
+    request->enqueue_time = Clock::now();
+    auto future = request->promise.get_future();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      PADDLE_ENFORCE_EQ(stopped_,
+                        false,
+                        phi::errors::PreconditionNotMet(
+                            "The DynamicBatcher has been stopped."));
+      auto& queue = queues_[key.str()];
+      queue.row_num += request->batch_size;
+      queue.requests.emplace_back(std::move(request));
+    }
+    cv_.notify_all();
+    ++request_num_;
+    return future;
+  }
+
+  // Waits for a batch, returns false when the batcher is stopped and there
+  // are no queued requests. A full queue is run at once, otherwise the
+  // oldest queue is run at its deadline.
+  bool NextBatch(std::vector<std::unique_ptr<Request>>* batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto older = [](const Queue& a, const Queue& b) {
+      return a.requests.front()->enqueue_time <
+             b.requests.front()->enqueue_time;
+    };
+    while (true) {
+      auto oldest = queues_.end();
+      auto oldest_full = queues_.end();
+      for (auto it = queues_.begin(); it != queues_.end(); ++it) {
+        if (oldest == queues_.end() || older(it->second, oldest->second)) {
+          oldest = it;
+        }
+        if (it->second.row_num >= config_.max_batch_size &&
+            (oldest_full == queues_.end() ||
+             older(it->second, oldest_full->second))) {
+          oldest_full = it;
+        }
+      }
+      if (oldest == queues_.end()) {
+        if (stopped_) {
+          return false;
+        }
+        cv_.wait(lock);
+        continue;
+      }
+      if (oldest_full == queues_.end()) {
+        auto deadline = oldest->second.requests.front()->enqueue_time +
+                        std::chrono::microseconds(config_.max_queue_delay_us);
+        if (Clock::now() < deadline && !stopped_) {
+          cv_.wait_until(lock, deadline);
+          continue;
+        }
+      } else {
+        oldest = oldest_full;
+      }
+      auto& queue = oldest->second;
+      int row_num = 0;
+      while (!queue.requests.empty()) {
+        int batch_size = queue.requests.front()->batch_size;
+        if (!batch->empty() && row_num + batch_size > config_.max_batch_size) {
+          break;
+        }
+        row_num += batch_size;
+        batch->emplace_back(std::move(queue.requests.front()));
+        queue.requests.pop_front();
+      }
+      queue.row_num -= row_num;
+      if (queue.requests.empty()) {
+        queues_.erase(oldest);
+      }
+      return true;
+    }
+  }
+
+  // Concatenates the inputs of the batch along dim 0, padding dim 1 of the
+  // padded inputs.
+  Tensors MergeInputs(const std::vector<std::unique_ptr<Request>>& batch) {
+    const Tensors& first = batch.front()->inputs;
+    int padded_len = batch.front()->padded_len;
+    if (padded_len == 0) {
+      for (auto& request : batch) {
+        for (auto& input : request->inputs) {
+          if (padded_inputs_.count(input.name)) {
+            padded_len = std::max(padded_len, input.shape[1]);
+          }
+        }
+      }
+    }
+
+    int row_num = 0;
+    for (auto& request : batch) {
+      row_num += request->batch_size;
+    }
+    Tensors merged(first.size());
+    for (size_t i = 0; i < first.size(); ++i) {
+      auto& input = merged[i];
+      input.name = first[i].name;
+      input.dtype = first[i].dtype;
+      input.shape = first[i].shape;
+      input.shape[0] = row_num;
+      bool padded = padded_inputs_.count(input.name) > 0;
+      if (padded) {
+        input.shape[1] = padded_len;
+      }
+      size_t elem_size = GetNumBytesOfDataType(input.dtype);
+      input.data.Resize(Numel(input.shape) * elem_size);
+      if (padded) {
+        VisitDataType(input.dtype, [&](auto type) {
+          using T = decltype(type);
+          std::fill_n(static_cast<T*>(input.data.data()),
+                      Numel(input.shape),
+                      static_cast<T>(static_cast<float>(config_.pad_value)));
+        });
+      }
+
+      // bytes of one step along the padded dim, or of one row
+      size_t step_bytes = Numel(input.shape, padded ? 2 : 1) * elem_size;
+      size_t dst_row_bytes = padded ? padded_len * step_bytes : step_bytes;
+      char* dst = static_cast<char*>(input.data.data());
+      for (auto& request : batch) {
+        auto& src = request->inputs[i];
+        size_t src_row_bytes = padded ? src.shape[1] * step_bytes : step_bytes;
+        const char* src_data = static_cast<const char*>(src.data.data());
+        if (src_row_bytes == dst_row_bytes) {
+          std::memcpy(dst, src_data, src_row_bytes * request->batch_size);
+        } else {
+          for (int row = 0; row < request->batch_size; ++row) {
+            std::memcpy(dst + row * dst_row_bytes,
+                        src_data + row * src_row_bytes,
+                        src_row_bytes);
+          }
+          padding_num_ += (dst_row_bytes - src_row_bytes) / elem_size *
+                          request->batch_size;
+        }
+        dst += dst_row_bytes * request->batch_size;
+      }
+    }
+    return merged;
+  }
+
+  // Splits the outputs of the batch along dim 0 and sets the results. An
+  // output with LoD is split by the sequences of its top level, each request
+  // gets its sequences with the LoD rebased to them.
+  void ScatterOutputs(const Tensors& outputs,
+                      std::vector<std::unique_ptr<Request>>* batch) {
+    int row_num = 0;
+    for (auto& request : *batch) {
+      row_num += request->batch_size;
+    }
+    std::vector<Tensors> results(batch->size(), Tensors(outputs.size()));
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      auto& output = outputs[i];
+      bool split = row_num > 0 && !output.shape.empty() && output.shape[0] > 0;
+      if (split && output.lod.empty()) {
+        split = output.shape[0] == row_num;
+      } else if (split) {
+        // the top level has a sequence for every row of the batch, and the
+        // last level covers the rows of the output
+        auto& last = output.lod.back();
+        split = output.lod[0].size() == static_cast<size_t>(row_num) + 1 &&
+                !last.empty() &&
+                last.back() == static_cast<size_t>(output.shape[0]);
+      }
+      size_t row_bytes = split ? output.data.length() / output.shape[0] : 0;
+      const char* src = static_cast<const char*>(output.data.data());
+      size_t seq_begin = 0;
+      for (size_t j = 0; j < batch->size(); ++j) {
+        auto& result = results[j][i];
+        result.name = output.name;
+        result.dtype = output.dtype;
+        result.lod = output.lod;
+        result.shape = output.shape;
+        if (split) {
+          size_t seq_end = seq_begin + (*batch)[j]->batch_size;
+          // the rows of the sequences [seq_begin, seq_end) at every level
+          size_t row_begin = seq_begin, row_end = seq_end;
+          for (size_t level = 0; level < output.lod.size(); ++level) {
+            auto& offsets = output.lod[level];
+            size_t base = offsets[row_begin];
+            result.lod[level].assign(offsets.begin() + row_begin,
+                                     offsets.begin() + row_end + 1);
+            for (auto& offset : result.lod[level]) {
+              offset -= base;
+            }
+            row_begin = base;
+            row_end = offsets[row_end];
+          }
+          result.shape[0] = static_cast<int>(row_end - row_begin);
+          result.data.Resize(row_bytes * (row_end - row_begin));
+          std::memcpy(result.data.data(),
+                      src + row_bytes * row_begin,
+                      row_bytes * (row_end - row_begin));
+          seq_begin = seq_end;
+        } else {
+          result.data = output.data;
+        }
+      }
+    }
+    for (size_t j = 0; j < batch->size(); ++j) {
+      (*batch)[j]->promise.set_value(std::move(results[j]));
+    }
+  }
+
+  void WorkerLoop(size_t worker_id) {
+    std::vector<std::unique_ptr<Request>> batch;
+    while (NextBatch(&batch)) {
+      auto start = Clock::now();
+      int64_t wait_ns = 0;
+      int row_num = 0;
+      for (auto& request : batch) {
+        wait_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       start - request->enqueue_time)
+                       .count();
+        row_num += request->batch_size;
+      }
+      // counted before the results are set, so they are visible to callers
+      ++batch_num_;
+      row_num_ += row_num;
+      queue_wait_ns_ += wait_ns;
+      try {
+        Tensors outputs;
+        run_funcs_[worker_id](MergeInputs(batch), &outputs);
+        ScatterOutputs(outputs, &batch);
+      } catch (...) {
+        for (auto& request : batch) {
+          request->promise.set_exception(std::current_exception());
+        }
+      }
+      VLOG(4) << "DynamicBatcher worker " << worker_id << " ran "
+              << batch.size() << " requests of " << row_num << " rows";
+      batch.clear();
+    }
+  }
+
+  DynamicBatcherConfig config_;
+  std::unordered_set<std::string> padded_inputs_;
+  std::vector<BatchRunFunc> run_funcs_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::map<std::string, Queue> queues_;
+  bool stopped_{false};
+  std::vector<std::thread> workers_;
+
+  std::atomic<uint64_t> request_num_{0};
+  std::atomic<uint64_t> batch_num_{0};
+  std::atomic<uint64_t> row_num_{0};
+  std::atomic<uint64_t> padding_num_{0};
+  std::atomic<int64_t> queue_wait_ns_{0};
+};
+
+DynamicBatcher::DynamicBatcher(const Config& config,
+                               const DynamicBatcherConfig& batcher_config)
+    : pool_(std::make_unique<PredictorPool>(
+          config, std::max<size_t>(batcher_config.num_workers, 1))) {
+  std::vector<BatchRunFunc> run_funcs;
+  for (size_t i = 0; i < std::max<size_t>(batcher_config.num_workers, 1);
+       ++i) {
+    run_funcs.emplace_back(MakePredictorRunFunc(pool_->Retrieve(i)));
+  }
+  impl_ = std::make_unique<Impl>(std::move(run_funcs), batcher_config);
+}
+
+DynamicBatcher::DynamicBatcher(std::vector<BatchRunFunc> run_funcs,
+                               const DynamicBatcherConfig& batcher_config) {
+  PADDLE_ENFORCE_GT(run_funcs.size(),
+                    0UL,
+                    phi::errors::InvalidArgument(
+                        "DynamicBatcher needs at least one run function."));
+  impl_ = std::make_unique<Impl>(std::move(run_funcs), batcher_config);
+}
+
+DynamicBatcher::~DynamicBatcher() = default;
+
+std::future<DynamicBatcher::Tensors> DynamicBatcher::Submit(Tensors inputs) {
+  return impl_->Submit(std::move(inputs));
+}
+
+DynamicBatcherStats DynamicBatcher::GetStats() const {
+  DynamicBatcherStats stats;
+  stats.request_num = impl_->request_num_;
+  stats.batch_num = impl_->batch_num_;
+  stats.row_num = impl_->row_num_;
+  stats.padding_num = impl_->padding_num_;
+  stats.queue_wait_ms = static_cast<double>(impl_->queue_wait_ns_) / 1e6;
+  return stats;
+}
+
+}  // namespace services
+}  // namespace paddle_infer
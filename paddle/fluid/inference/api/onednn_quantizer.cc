@@ -15,6 +15,7 @@
 #include "paddle/fluid/inference/api/onednn_quantizer.h"
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 #include <map>
 #include <numeric>
@@ -25,12 +26,22 @@
 #include "paddle/fluid/framework/ir/fuse_pass_base.h"
 #include "paddle/fluid/framework/ir/graph.h"
 #include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/naive_executor.h"
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/type_defs.h"
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/analysis_predictor.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/transforms/onednn/onednn_quantize_pass.h"
+#include "paddle/fluid/pir/transforms/pd_op_to_kernel_pass.h"
 #include "paddle/fluid/platform/onednn_helper.h"
 #include "paddle/phi/common/place.h"
+#include "paddle/pir/include/core/builder.h"
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/builtin_op.h"
+#include "paddle/pir/include/core/ir_mapping.h"
+#include "paddle/pir/include/core/program.h"
+#include "paddle/pir/include/pass/pass_manager.h"
 #include "paddle/utils/string/pretty_log.h"
 
 namespace paddle {
@@ -65,6 +76,28 @@ static void check_tensor(const phi::DenseTensor& tensor) {
       platform::errors::InvalidArgument("Tensor dimension is empty."));
 }
 
+// The variable keeping the input of the i-th quantized op of a pir program.
+static std::string PirCalibVarName(size_t i) {
+  return "@calib_in_" + std::to_string(i);
+}
+
+template <typename T>
+static void CopyWarmupInput(const PaddleTensor& input,
+                            phi::DenseTensor* tensor) {
+  tensor->Resize(common::make_ddim(input.shape));
+  PADDLE_ENFORCE_EQ(
+      input.data.length(),
+      tensor->numel() * sizeof(T),
+      platform::errors::InvalidArgument(
+          "The warmup data %s has %d bytes, but its shape needs %d.",
+          input.name,
+          input.data.length(),
+          tensor->numel() * sizeof(T)));
+  std::memcpy(tensor->mutable_data<T>(phi::CPUPlace()),
+              input.data.data(),
+              input.data.length());
+}
+
 void AnalysisPredictor::MkldnnQuantizer::CalculateScalesForRNNWeights(
     const paddle::framework::OpDesc* op, bool gru) {
   const auto& wx_names = op->Input("WeightX");
@@ -228,6 +261,9 @@ void AnalysisPredictor::MkldnnQuantizer::CalculateSingleScale(
                                                 is_unsigned,
                                                 /*is_transposed*/ true);
       break;
+    case ScaleAlgo::PERCENTILE:
+      scales_[var_name] = GetPercentileScalingFactor(var_tensor, is_unsigned);
+      break;
     default:
       throw std::runtime_error(
           "MkldnnQuantizer: Unexpected ScaleAlgo specified.");
@@ -406,6 +442,39 @@ AnalysisPredictor::MkldnnQuantizer::GetMaxScalingFactor(
   return std::make_pair(is_unsigned, scale_tensor);
 }
 
+std::pair<bool, phi::DenseTensor>
+AnalysisPredictor::MkldnnQuantizer::GetPercentileScalingFactor(
+    const phi::DenseTensor& var_tensor, bool is_unsigned) const {
+  check_tensor(var_tensor);
+
+  ConstEigenVectorArrayMap eigen_tensor{
+      var_tensor.data<float>(), var_tensor.numel(), 1};
+  float min_val = eigen_tensor.minCoeff();
+  if (is_unsigned)
+    PADDLE_ENFORCE_GE(
+        min_val,
+        0.0f,
+        platform::errors::InvalidArgument(
+            "Tensor is claimed to be unsigned, but its min value (%f) is < 0.0",
+            min_val));
+
+  std::vector<float> abs_values(eigen_tensor.size());
+  for (int i = 0; i < eigen_tensor.size(); i++) {
+    abs_values[i] = std::abs(eigen_tensor[i]);
+  }
+  auto nth = abs_values.begin() +
+             std::min(abs_values.size() - 1,
+                      static_cast<size_t>(abs_values.size() * 0.9999));
+  std::nth_element(abs_values.begin(), nth, abs_values.end());
+  float threshold = *nth;
+  if (threshold <= 0.0f) threshold = eigen_tensor.abs().maxCoeff();
+
+  phi::DenseTensor scale_tensor = CreateScaleTensor();
+  scale_tensor.data<double>()[0] = 1.0 / threshold;
+
+  return std::make_pair(is_unsigned, scale_tensor);
+}
+
 std::pair<bool, phi::DenseTensor>
 AnalysisPredictor::MkldnnQuantizer::GetMaxChScalingFactor(
     const phi::DenseTensor& var_tensor,
@@ -619,6 +688,124 @@ bool AnalysisPredictor::MkldnnQuantizer::Quantize() {
   return true;
 }
 
+bool AnalysisPredictor::MkldnnQuantizer::QuantizePir() {
+  auto scales = CalculatePirScales();
+  ClearDeviceContext();
+
+  PrettyLogH1("--- Running quantize pass on the pir program");
+  ::pir::PassManager quantize_pm(::pir::IrContext::Instance(),
+                                 predictor_.config_.pm_opt_level_);
+  auto quantize_pass = ::pir::CreateOneDNNQuantizePass();
+  quantize_pass->Set(
+      "quantize_scales",
+      new std::vector<std::pair<bool, float>>(std::move(scales)));
+  quantize_pass->SetNotOwned(::pir::Pass::kParamScopeAttr,
+                             predictor_.sub_scope_);
+  quantize_pm.AddPass(std::move(quantize_pass));
+  if (!predictor_.config_.glog_info_disabled()) {
+    quantize_pm.EnablePrintStatistics();
+  }
+  quantize_pm.Run(predictor_.pir_program_.get());
+  return true;
+}
+
+std::vector<std::pair<bool, float>>
+AnalysisPredictor::MkldnnQuantizer::CalculatePirScales() const {
+  auto warmup_data = qconfig_->warmup_data();
+  PADDLE_ENFORCE_NOT_NULL(warmup_data,
+                          platform::errors::PreconditionNotMet(
+                              "Warmup data cannot be NULL in the config."));
+  PrettyLogH1("--- Running warmup iteration for quantization");
+
+  // A copy of the program keeps the input of every quantized op in a
+  // variable of its own.
+  ::pir::IrMapping mapping;
+  auto program = predictor_.pir_program_->Clone(mapping);
+  auto ops = ::pir::GetOneDNNQuantizableOps(program->block());
+  std::vector<ScaleAlgo> algos;
+  ::pir::Builder builder(::pir::IrContext::Instance(), program->block());
+  for (size_t i = 0; i < ops.size(); ++i) {
+    // The rules of onednn_op.fused_conv2d are the ones of fused_conv2d.
+    std::string op_type = ops[i]->name().substr(ops[i]->name().find('.') + 1);
+    algos.push_back(qconfig_->scale_algo(op_type, "Input"));
+    if (algos.back() == ScaleAlgo::NONE) continue;
+    builder.set_insertion_point(ops[i]);
+    builder.Build<::pir::ShadowOutputOp>(ops[i]->operand_source(0),
+                                         PirCalibVarName(i));
+  }
+  std::vector<std::string> feed_names;
+  for (auto& op : *program->block()) {
+    if (op.isa<paddle::dialect::DataOp>()) {
+      feed_names.push_back(
+          op.attribute<::pir::StrAttribute>("name").AsString());
+    }
+  }
+  PADDLE_ENFORCE_EQ(warmup_data->size(),
+                    feed_names.size(),
+                    platform::errors::InvalidArgument(
+                        "The warmup data has %d inputs, but the program "
+                        "needs %d.",
+                        warmup_data->size(),
+                        feed_names.size()));
+  auto kernel_program =
+      paddle::dialect::PdOpLowerToKernelPass(program.get(), predictor_.place_);
+
+  auto* scope = &predictor_.sub_scope_->NewScope();
+  for (size_t i = 0; i < feed_names.size(); ++i) {
+    const auto& input = (*warmup_data)[i];
+    bool named = std::find(feed_names.begin(), feed_names.end(), input.name) !=
+                 feed_names.end();
+    auto* tensor = scope->Var(named ? input.name : feed_names[i])
+                       ->GetMutable<phi::DenseTensor>();
+    if (input.dtype == PaddleDType::FLOAT32) {
+      CopyWarmupInput<float>(input, tensor);
+    } else if (input.dtype == PaddleDType::INT64) {
+      CopyWarmupInput<int64_t>(input, tensor);
+    } else if (input.dtype == PaddleDType::INT32) {
+      CopyWarmupInput<int32_t>(input, tensor);
+    } else {
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "MkldnnQuantizer: The warmup data of the pir program only supports "
+          "float32, int64 and int32."));
+    }
+  }
+  framework::NaiveExecutor executor(predictor_.place_);
+  framework::interpreter::ExecutionConfig execution_config;
+  execution_config.create_local_scope = false;
+  execution_config.used_for_inference = true;
+  executor.PrepareInterpreterCore(scope, *kernel_program, execution_config);
+  executor.RunInterpreterCore();
+
+  PrettyLogH1("--- Calculating scales for quantization");
+  std::vector<std::pair<bool, float>> scales(ops.size(), {false, 0.0f});
+  for (size_t i = 0; i < ops.size(); ++i) {
+    if (algos[i] == ScaleAlgo::NONE) continue;
+    auto* var = scope->FindVar(PirCalibVarName(i));
+    check_var(var, PirCalibVarName(i));
+    const auto& var_tensor = var->Get<phi::DenseTensor>();
+    check_tensor(var_tensor);
+    ConstEigenVectorArrayMap eigen_tensor{
+        var_tensor.data<float>(), var_tensor.numel(), 1};
+    bool is_unsigned = eigen_tensor.minCoeff() >= 0.0f;
+    std::pair<bool, phi::DenseTensor> scale;
+    switch (algos[i]) {
+      case ScaleAlgo::KL:
+        scale = GetKLScalingFactor(var_tensor, is_unsigned);
+        break;
+      case ScaleAlgo::PERCENTILE:
+        scale = GetPercentileScalingFactor(var_tensor, is_unsigned);
+        break;
+      default:
+        scale = GetMaxScalingFactor(var_tensor, is_unsigned);
+        break;
+    }
+    scales[i] = {scale.first,
+                 static_cast<float>(scale.second.data<double>()[0])};
+  }
+  predictor_.sub_scope_->DeleteScope(scope);
+  return scales;
+}
+
 bool AnalysisPredictor::MkldnnQuantizer::RunQuantizePasses() const {
   predictor_.executor_->CreateVariables(
       *predictor_.inference_program_, 0, true, predictor_.sub_scope_);
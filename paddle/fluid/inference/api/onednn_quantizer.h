@@ -52,6 +52,9 @@ class AnalysisPredictor::MkldnnQuantizer {
 
   // Execute full quantization procedure.
   bool Quantize();
+  // Quantize the ops of the pir program before it is lowered, with the scales
+  // calibrated on the warmup data.
+  bool QuantizePir();
 
 #ifdef PADDLE_WITH_TESTING
   friend class MkldnnQuantizerTest;
@@ -77,6 +80,9 @@ class AnalysisPredictor::MkldnnQuantizer {
   void PrepareArgument() const;
   void ClearDeviceContext() const;
   bool RunQuantizePasses() const;
+  // Run the warmup data through a copy of the pir program which keeps the
+  // inputs of the quantized ops, and calculate the scales of them.
+  std::vector<std::pair<bool, float>> CalculatePirScales() const;
 
   std::vector<int> ExpandQuantizedBins(std::vector<int> quantized_bins,
                                        std::vector<int> reference_bins) const;
@@ -101,6 +107,10 @@ class AnalysisPredictor::MkldnnQuantizer {
   TEST_API std::pair<bool, phi::DenseTensor> GetMaxScalingFactor(
       const phi::DenseTensor& var_tensor, bool is_unsigned) const;
 
+  // Clip the outliers beyond the 99.99th percentile of the absolute values.
+  TEST_API std::pair<bool, phi::DenseTensor> GetPercentileScalingFactor(
+      const phi::DenseTensor& var_tensor, bool is_unsigned) const;
+
   // Returns histogram and bin width
   TEST_API std::pair<std::vector<int>, float> Histogram(
       const phi::DenseTensor& var_tensor,
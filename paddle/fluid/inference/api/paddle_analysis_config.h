@@ -25,6 +25,7 @@
 #pragma once
 
 #include <cassert>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <string>
@@ -42,6 +43,12 @@
 #include "paddle_onednn_quantizer_config.h"  // NOLINT
 #endif
 
+namespace paddle_infer {
+namespace services {
+class SharedRuntime;
+}  // namespace services
+}  // namespace paddle_infer
+
 namespace paddle {
 
 class AnalysisPredictor;
@@ -124,6 +131,79 @@ struct PD_INFER_DECL XpuConfig {
   std::map<std::string, int> quant_post_dynamic_weight_methods;
 };
 
+///
+/// \brief Statistics of the shape plan cache of a predictor, see
+/// AnalysisConfig::EnableShapePlanCache.
+///
+struct PD_INFER_DECL ShapePlanCacheStats {
+  /// Runs whose input shapes had a plan.
+  uint64_t hit_num{0};
+  /// Runs whose input shapes were seen the first time, or did not fit into
+  /// the cache.
+  uint64_t miss_num{0};
+  /// Input shapes with a plan.
+  uint64_t plan_num{0};
+
+  double hit_rate() const {
+    return hit_num + miss_num == 0
+               ? 0.
+               : static_cast<double>(hit_num) / (hit_num + miss_num);
+  }
+};
+
+///
+/// \brief The latency of one phase of the runs of a predictor, see
+/// AnalysisConfig::EnableRunStats. The percentiles are within 19% of the
+/// measured latencies.
+///
+struct PD_INFER_DECL LatencyStats {
+  /// Runs measured.
+  uint64_t count{0};
+  double mean_us{0.};
+  double p50_us{0.};
+  double p90_us{0.};
+  double p99_us{0.};
+  double max_us{0.};
+};
+
+///
+/// \brief One instruction of a sampled run.
+///
+struct PD_INFER_DECL OpTraceEvent {
+  /// The op name, e.g. pd_op.conv2d.
+  std::string name;
+  /// Since the interpreter started the run.
+  double start_us{0.};
+  /// Running the kernel, without the gc after it.
+  double run_us{0.};
+  /// Releasing the variables the instruction used last.
+  double gc_us{0.};
+};
+
+///
+/// \brief The latency breakdown of the runs of a predictor, see
+/// AnalysisConfig::EnableRunStats.
+///
+struct PD_INFER_DECL RunStats {
+  /// The whole Run or ZeroCopyRun call.
+  LatencyStats total;
+  /// Copying the inputs in Run and preparing them, e.g. padding them to the
+  /// shape buckets.
+  LatencyStats feed;
+  /// Running the program, including the gc.
+  LatencyStats execute;
+  /// Releasing the intermediate variables while running the program.
+  LatencyStats gc;
+  /// Copying the outputs in Run. ZeroCopyRun copies none, it counts
+  /// preparing the outputs in place, e.g. slicing them back from the shape
+  /// buckets, and cleaning up after the run.
+  LatencyStats fetch;
+  /// The time the instructions of each op took per run, keyed by op name.
+  std::map<std::string, LatencyStats> instruction_groups;
+  /// The instructions of the latest sampled runs, oldest first.
+  std::vector<std::vector<OpTraceEvent>> sampled_traces;
+};
+
 struct DistConfig {
   bool use_dist_model() const { return use_dist_model_; }
   void EnableDistModel(bool use_dist_model) {
@@ -1073,6 +1153,171 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Load the combined params file through a private memory mapping.
+  /// On CPU, the tensors whose data is aligned in the file use the mapped
+  /// pages directly, so processes loading the same file share the weights
+  /// through the page cache. Use paddle_infer::AlignParamsForMmap to convert
+  /// a params file, unaligned tensors are copied out of the mapping.
+  ///
+  /// \param x Whether to load params with mmap.
+  ///
+  void EnableMmapParams(bool x = true);
+  ///
+  /// \brief A boolean state telling whether params are loaded with mmap.
+  ///
+  /// \return bool Whether params are loaded with mmap.
+  ///
+  bool mmap_params_enabled() const { return enable_mmap_params_; }
+
+  ///
+  /// \brief Let the predictors created by Clone share the optimized and
+  /// kernel lowered program, the dependency analysis of its instructions and
+  /// the persistables with this predictor, instead of optimizing the program
+  /// again. A clone only builds its own instructions and holds its own
+  /// activations. Only works with PIR and the new executor.
+  ///
+  /// \param x Whether to share the program with the clones.
+  /// \param max_concurrent_runs How many of the predictor and its clones run
+  /// at the same time, which bounds the memory taken by the activations. 0
+  /// means no limit.
+  ///
+  void EnableSharedClone(bool x = true, int max_concurrent_runs = 0);
+  ///
+  /// \brief A boolean state telling whether the clones share the program.
+  ///
+  /// \return bool Whether the clones share the program.
+  ///
+  bool shared_clone_enabled() const { return enable_shared_clone_; }
+  ///
+  /// \brief Get the limit of the concurrent runs of the predictor and its
+  /// clones, 0 means no limit.
+  ///
+  /// \return int The limit of the concurrent runs.
+  ///
+  int shared_clone_max_concurrent_runs() const {
+    return shared_clone_max_concurrent_runs_;
+  }
+
+  ///
+  /// \brief Cache the output shapes computed by the kernels of a run, keyed
+  /// by the shapes of the inputs. A later run with the same input shapes
+  /// sets them instead of inferring them again. Kernels whose output shapes
+  /// depend on the values of the inputs are detected and always infer
+  /// theirs. The clones of the predictor share its cache. Only works with
+  /// PIR and the new executor.
+  ///
+  /// \param capacity How many input shapes are cached, the runs with other
+  /// input shapes infer the output shapes as usual.
+  ///
+  void EnableShapePlanCache(int capacity = 64);
+  ///
+  /// \brief A boolean state telling whether the shape plan cache is used.
+  ///
+  /// \return bool Whether the shape plan cache is used.
+  ///
+  bool shape_plan_cache_enabled() const { return enable_shape_plan_cache_; }
+  ///
+  /// \brief Get the number of input shapes the shape plan cache holds.
+  ///
+  /// \return int The capacity of the shape plan cache.
+  ///
+  int shape_plan_cache_capacity() const { return shape_plan_cache_capacity_; }
+
+  ///
+  /// \brief Pad CPU inputs of variable length along dim 1, e.g. token ids,
+  /// to the smallest of the given lengths not shorter than them, so that
+  /// fewer input shapes reach the shape plan cache and the allocator. After
+  /// the run the caller gets its inputs back, and the outputs of the padded
+  /// length along dim 1 are sliced back to the length of the inputs. Only
+  /// fits models which ignore the padding, e.g. through an attention mask
+  /// padded as well.
+  ///
+  /// \param padded_inputs The names of the inputs to pad.
+  /// \param seq_len_buckets Ascending lengths. Inputs longer than the last
+  /// one are not padded.
+  /// \param pad_value The value of the padding.
+  ///
+  void SetShapeBuckets(const std::vector<std::string>& padded_inputs,
+                       const std::vector<int>& seq_len_buckets,
+                       double pad_value = 0.);
+  ///
+  /// \brief Get the names of the inputs padded to the shape buckets.
+  ///
+  /// \return const std::vector<std::string>& The padded inputs.
+  ///
+  const std::vector<std::string>& shape_bucket_inputs() const {
+    return shape_bucket_inputs_;
+  }
+  ///
+  /// \brief Get the lengths the inputs are padded to.
+  ///
+  /// \return const std::vector<int>& The ascending shape buckets.
+  ///
+  const std::vector<int>& shape_buckets() const { return shape_buckets_; }
+  ///
+  /// \brief Get the value the inputs are padded with.
+  ///
+  /// \return double The pad value.
+  ///
+  double shape_bucket_pad_value() const { return shape_bucket_pad_value_; }
+
+  ///
+  /// \brief Collect the latency of the runs of the predictor: the feed,
+  /// execute, gc and fetch phases, and the time the instructions of each op
+  /// take. The histograms are always on and cheap, the instructions are timed
+  /// only with PIR and the new executor.
+  ///
+  /// \param trace_sample_interval Every how many runs the time of each
+  /// instruction is kept as a trace, 0 keeps none.
+  ///
+  void EnableRunStats(int trace_sample_interval = 0);
+  ///
+  /// \brief A boolean state telling whether the run stats are collected.
+  ///
+  /// \return bool Whether the run stats are collected.
+  ///
+  bool run_stats_enabled() const { return enable_run_stats_; }
+  ///
+  /// \brief Get every how many runs a trace is sampled.
+  ///
+  /// \return int The trace sample interval, 0 if no trace is sampled.
+  ///
+  int run_stats_trace_sample_interval() const {
+    return run_stats_trace_sample_interval_;
+  }
+
+  ///
+  /// \brief Run on the cores of a runtime shared with the predictors of
+  /// other models, see paddle_infer::services::SharedRuntime. The runs take
+  /// at most cpu_math_library_num_threads of its cores. Only the predictors
+  /// on cpu are attached, every clone with the same priority. The cores
+  /// granted bound the MKL and OpenMP threads of a run; with OpenBLAS the
+  /// thread number is process-wide and the partition does not hold.
+  ///
+  /// \param runtime The shared runtime.
+  /// \param priority The share of the cores of the model, relative to the
+  /// other models attached, positive.
+  ///
+  void SetSharedRuntime(
+      std::shared_ptr<paddle_infer::services::SharedRuntime> runtime,
+      int priority = 1);
+  ///
+  /// \brief Get the runtime the predictor shares the cores of.
+  ///
+  /// \return The shared runtime, nullptr if none.
+  ///
+  const std::shared_ptr<paddle_infer::services::SharedRuntime>&
+  shared_runtime() const {
+    return shared_runtime_;
+  }
+  ///
+  /// \brief Get the priority of the model in the shared runtime.
+  ///
+  /// \return int The priority.
+  ///
+  int shared_runtime_priority() const { return shared_runtime_priority_; }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -1293,6 +1538,18 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool enable_mmap_params_{false};
+  bool enable_shared_clone_{false};
+  int shared_clone_max_concurrent_runs_{0};
+  bool enable_shape_plan_cache_{false};
+  int shape_plan_cache_capacity_{64};
+  std::vector<std::string> shape_bucket_inputs_;
+  std::vector<int> shape_buckets_;
+  double shape_bucket_pad_value_{0.};
+  bool enable_run_stats_{false};
+  int run_stats_trace_sample_interval_{0};
+  std::shared_ptr<paddle_infer::services::SharedRuntime> shared_runtime_;
+  int shared_runtime_priority_{1};
   bool trt_engine_memory_sharing_{true};
   int trt_engine_memory_sharing_identifier_{0};
 
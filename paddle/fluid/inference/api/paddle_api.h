@@ -524,6 +524,11 @@ class PD_INFER_DECL InternalUtils {
   static void SyncStream(paddle_infer::Predictor* pred);
   static void SyncStream(cudaStream_t stream);
   static void SyncStream(hipStream_t stream);
+
+  // Whether the predictor used the executor plan saved with its optimized
+  // model instead of analysing the program.
+  static bool ExecutorPlanApplied(paddle_infer::Predictor* pred);
+
   template <typename T>
   static void CopyFromCpuWithIoStream(paddle_infer::Tensor* t,
                                       const T* data,
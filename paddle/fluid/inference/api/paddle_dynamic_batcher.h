@@ -0,0 +1,119 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle_inference_api.h"  // NOLINT
+
+///
+/// \file paddle_dynamic_batcher.h
+///
+/// \brief Server side batching of small inference requests.
+///
+
+namespace paddle_infer {
+namespace services {
+
+struct PD_INFER_DECL DynamicBatcherConfig {
+  /// The largest number of rows (dim 0 of the inputs) run in one batch.
+  int max_batch_size{32};
+  /// How long the oldest request of a batch waits for more requests before
+  /// the batch is run anyway, in microseconds.
+  int64_t max_queue_delay_us{1000};
+  /// Number of predictors, each one runs a batch at a time.
+  size_t num_workers{1};
+  /// Inputs of variable length along dim 1, e.g. token ids. They are padded
+  /// with pad_value to the longest request of the batch, or to the bucket
+  /// of the request if seq_len_buckets is set.
+  std::vector<std::string> padded_inputs;
+  double pad_value{0.};
+  /// Ascending sequence lengths. A request is only batched with requests in
+  /// the same bucket, the smallest one not shorter than its padded inputs,
+  /// which bounds the padding. Longer requests are batched by exact length.
+  std::vector<int> seq_len_buckets;
+};
+
+struct PD_INFER_DECL DynamicBatcherStats {
+  uint64_t request_num{0};
+  uint64_t batch_num{0};
+  /// Sum of the sizes of the batches run.
+  uint64_t row_num{0};
+  /// Elements added to the padded inputs.
+  uint64_t padding_num{0};
+  /// Time the requests waited in the queue, summed over all requests.
+  double queue_wait_ms{0.};
+};
+
+///
+/// \class DynamicBatcher
+///
+/// \brief DynamicBatcher queues requests from many threads, coalesces the
+/// compatible ones along the batch dim and runs every batch once on one of
+/// the predictors of a PredictorPool. Each request gets the rows of the
+/// outputs which belong to it through a future. Outputs whose dim 0 is not
+/// the batch size are returned whole to every request of the batch.
+///
+/// \code{cpp}
+///   DynamicBatcherConfig batcher_config;
+///   batcher_config.max_batch_size = 16;
+///   batcher_config.num_workers = 2;
+///   DynamicBatcher batcher(config, batcher_config);
+///   auto outputs = batcher.Submit(std::move(inputs)).get();
+/// \endcode
+///
+class PD_INFER_DECL DynamicBatcher {
+ public:
+  using Tensors = std::vector<paddle::PaddleTensor>;
+  /// Runs a batch, called concurrently from different workers with different
+  /// functions.
+  using BatchRunFunc = std::function<void(const Tensors& inputs,
+                                          Tensors* outputs)>;
+
+  DynamicBatcher(const DynamicBatcher&) = delete;
+  DynamicBatcher& operator=(const DynamicBatcher&) = delete;
+
+  /// \brief Run the batches on a PredictorPool of
+  /// batcher_config.num_workers predictors created from \param config.
+  DynamicBatcher(const Config& config,
+                 const DynamicBatcherConfig& batcher_config);
+
+  /// \brief Run the batches with \param run_funcs, one worker each.
+  DynamicBatcher(std::vector<BatchRunFunc> run_funcs,
+                 const DynamicBatcherConfig& batcher_config);
+
+  /// \brief Runs the queued requests and stops the workers.
+  ~DynamicBatcher();
+
+  /// \brief Queue a request. All inputs of the request have the same dim 0,
+  /// usually 1. The future holds the outputs of the request, or the error
+  /// of its batch.
+  std::future<Tensors> Submit(Tensors inputs);
+
+  DynamicBatcherStats GetStats() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<PredictorPool> pool_;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -22,6 +22,7 @@ limitations under the License. */
 #pragma once
 
 #include <cassert>
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
@@ -48,6 +49,16 @@ using PrecisionType = paddle::AnalysisConfig::Precision;
 using Config = paddle::AnalysisConfig;
 using DistConfig = paddle::DistConfig;
 using XpuConfig = paddle::XpuConfig;
+using ShapePlanCacheStats = paddle::ShapePlanCacheStats;
+using RunStats = paddle::RunStats;
+
+///
+/// \brief Called when a run of Predictor::RunAsync is done, with whether it
+/// succeeded and the output handles in the order of GetOutputNames. The
+/// handles are valid until it returns.
+///
+using AsyncRunCallback = std::function<void(
+    bool success, std::vector<std::unique_ptr<Tensor>> outputs)>;
 
 ///
 /// \class Predictor
@@ -140,6 +151,18 @@ class PD_INFER_DECL Predictor {
   bool Run(const std::vector<paddle::Tensor>& inputs,
            std::vector<paddle::Tensor>* outputs);
 
+  ///
+  /// \brief Run the prediction engine without waiting for it. The inputs set
+  /// by the input handles are moved into the run, so the handles can be
+  /// filled for the next run as soon as it returns, while this one executes.
+  /// The runs execute in order on a clone of the predictor, and their outputs
+  /// are handed to the callbacks on another thread. It waits while two runs
+  /// are already queued. Don't call Run meanwhile.
+  ///
+  /// \param[in] callback Called when the run is done
+  ///
+  void RunAsync(AsyncRunCallback callback);
+
   ///
   /// \brief Get the output names
   ///
@@ -190,6 +213,22 @@ class PD_INFER_DECL Predictor {
   ///
   uint64_t TryShrinkMemory();
 
+  ///
+  /// \brief Get the statistics of the shape plan cache, see
+  /// Config::EnableShapePlanCache.
+  ///
+  /// \return The hits and misses of the shape plan cache.
+  ///
+  ShapePlanCacheStats GetShapePlanCacheStats() const;
+
+  ///
+  /// \brief Get the latency breakdown of the runs so far, see
+  /// Config::EnableRunStats.
+  ///
+  /// \return The latency of the phases and instructions of the runs.
+  ///
+  RunStats GetRunStats() const;
+
   ///
   /// \brief Register a output hook function to operate the intermediate tensor
   /// of op output. when using this function, memory reuse should be turned off.
@@ -248,6 +287,14 @@ PD_INFER_DECL void ConvertToMixedPrecision(
     std::unordered_set<std::string> black_list = {},
     std::unordered_set<std::string> white_list = {});
 
+///
+/// \brief Rewrite a combined params file so that the data of every tensor is
+/// aligned, which lets Config::EnableMmapParams use it without copying. The
+/// result is still loadable without mmap.
+///
+PD_INFER_DECL void AlignParamsForMmap(const std::string& params_file,
+                                      const std::string& aligned_params_file);
+
 namespace services {
 ///
 /// \class PredictorPool
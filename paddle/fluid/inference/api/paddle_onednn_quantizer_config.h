@@ -48,6 +48,8 @@ enum class ScaleAlgo {
   MAX_CH_GRU,  ///< Find scale based on the max absolute value per output
                /// channel for fusion_gru/multi_gru operators
   KL,          ///< Find scale based on KL Divergence
+  PERCENTILE,  ///< Find scale based on the 99.99th percentile of the absolute
+               ///< values
 };
 
 ///
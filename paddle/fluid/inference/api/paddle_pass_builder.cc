@@ -675,4 +675,11 @@ const std::vector<std::string> kPirCpuPasses{
     "delete_quant_dequant_linear_op_pass",
     "delete_weight_dequant_linear_op_pass"};
 
+const std::vector<std::string> kPirCombinablePasses{
+    "delete_quant_dequant_linear_op_pass",
+    "delete_weight_dequant_linear_op_pass",
+    "map_op_to_another_pass",
+    "identity_op_clean_pass",
+    "silu_fuse_pass"};
+
 }  // namespace paddle
@@ -351,5 +351,8 @@ PD_INFER_DECL extern const std::vector<std::string> kPirGpuPasses;
 PD_INFER_DECL extern const std::vector<std::string> kPirCpuPasses;
 PD_INFER_DECL extern const std::vector<std::string> kPirXpuPasses;
 PD_INFER_DECL extern const std::vector<std::string> kPirMkldnnPasses;
+/// The passes of the lists above whose patterns match disjoint ops. The ones
+/// next to each other in a list run as one CombinedPatternRewritePass.
+PD_INFER_DECL extern const std::vector<std::string> kPirCombinablePasses;
 
 }  // namespace paddle
@@ -0,0 +1,115 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+
+#include "paddle_infer_declare.h"  // NOLINT
+
+///
+/// \file paddle_shared_runtime.h
+///
+/// \brief The cores of a machine shared by the predictors of many models.
+///
+
+namespace paddle_infer {
+namespace services {
+
+struct PD_INFER_DECL SharedRuntimeConfig {
+  /// The cores the runs of the attached predictors share, 0 for all the
+  /// cores of the machine.
+  int num_cores{0};
+};
+
+struct PD_INFER_DECL SharedRuntimeStats {
+  int num_cores{0};
+  /// The cores granted to the runs in progress.
+  int busy_cores{0};
+  uint64_t run_num{0};
+  /// The runs which waited for cores, and how long they waited in total.
+  uint64_t waited_run_num{0};
+  double wait_ms{0.};
+  /// The cores a run of each attached model gets when other runs wait,
+  /// keyed by the model id.
+  std::map<int, int> model_quotas;
+};
+
+///
+/// \class SharedRuntime
+///
+/// \brief SharedRuntime lets the predictors of the models served by one
+/// process share the cores instead of each one running as many math library
+/// threads as its config asks for. A predictor attached by
+/// Config::SetSharedRuntime is admitted to run only when a core is free and
+/// runs with the cores it is granted, so the runs never take more cores
+/// than the runtime has. The waiting runs of the models of a higher
+/// priority are admitted first. Every model gets a quota of the cores in
+/// proportion to its priority, which a run does not exceed while other runs
+/// wait, and which it may exceed while the cores are idle.
+///
+/// \code{cpp}
+///   auto runtime = std::make_shared<SharedRuntime>();
+///   Config detection_config, ocr_config;
+///   detection_config.SetSharedRuntime(runtime, 2);
+///   ocr_config.SetSharedRuntime(runtime, 1);
+/// \endcode
+///
+class PD_INFER_DECL SharedRuntime {
+ public:
+  explicit SharedRuntime(const SharedRuntimeConfig& config = {});
+  ~SharedRuntime();
+
+  SharedRuntime(const SharedRuntime&) = delete;
+  SharedRuntime& operator=(const SharedRuntime&) = delete;
+
+  ///
+  /// \brief Attach a model, its quota is in proportion to \param priority,
+  /// which is positive. The predictors attach themselves.
+  ///
+  /// \return int The id of the model.
+  ///
+  int Attach(int priority);
+  ///
+  /// \brief Detach a model attached before, called once the predictor and
+  /// its clones are destroyed. It never throws.
+  ///
+  void Detach(int model_id) noexcept;
+
+  ///
+  /// \brief Wait until a run of the model is admitted.
+  ///
+  /// \param num_threads The threads the run asks for.
+  /// \return int The cores granted, between 1 and num_threads.
+  ///
+  int Acquire(int model_id, int num_threads);
+  ///
+  /// \brief Give back the cores granted to a run. It never throws, so it
+  /// can be called when a run unwinds.
+  ///
+  void Release(int model_id, int num_cores) noexcept;
+
+  int num_cores() const;
+
+  SharedRuntimeStats GetStats() const;
+
+ private:
+  struct Impl;
+  std::unique_ptr<Impl> impl_;
+};
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -0,0 +1,178 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <set>
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "paddle/fluid/inference/api/paddle_shared_runtime.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle_infer {
+namespace services {
+
+struct SharedRuntime::Impl {
+  struct Model {
+    int priority{1};
+    int quota{1};
+  };
+
+  // The cores of the model when other runs wait.
+  void UpdateQuotas() {
+    int64_t priority_sum = 0;
+    for (auto& pair : models) {
+      priority_sum += pair.second.priority;
+    }
+    for (auto& pair : models) {
+      pair.second.quota = std::max<int>(
+          1,
+          static_cast<int>(static_cast<int64_t>(num_cores) *
+                           pair.second.priority / priority_sum));
+    }
+  }
+
+  Model& GetModel(int model_id) {
+    auto iter = models.find(model_id);
+    PADDLE_ENFORCE_NE(
+        iter,
+        models.end(),
+        paddle::platform::errors::NotFound(
+            "No model %d is attached to the runtime.", model_id));
+    return iter->second;
+  }
+
+  int num_cores{1};
+
+  mutable std::mutex mutex;
+  std::condition_variable cv;
+  int busy_cores{0};
+  std::map<int, Model> models;
+  int next_model_id{0};
+  // The waiting runs, the higher priority first, then the earlier.
+  std::set<std::pair<int, uint64_t>> waiting;
+  uint64_t next_ticket{0};
+
+  uint64_t run_num{0};
+  uint64_t waited_run_num{0};
+  double wait_ms{0.};
+};
+
+SharedRuntime::SharedRuntime(const SharedRuntimeConfig& config)
+    : impl_(new Impl) {
+  PADDLE_ENFORCE_GE(config.num_cores,
+                    0,
+                    paddle::platform::errors::InvalidArgument(
+                        "The cores of the runtime should not be negative, but "
+                        "got %d.",
+                        config.num_cores));
+  impl_->num_cores =
+      config.num_cores > 0
+          ? config.num_cores
+          : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+SharedRuntime::~SharedRuntime() = default;
+
+int SharedRuntime::Attach(int priority) {
+  PADDLE_ENFORCE_GT(priority,
+                    0,
+                    paddle::platform::errors::InvalidArgument(
+                        "The priority of a model should be positive, but got "
+                        "%d.",
+                        priority));
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  int model_id = impl_->next_model_id++;
+  impl_->models[model_id].priority = priority;
+  impl_->UpdateQuotas();
+  return model_id;
+}
+
+void SharedRuntime::Detach(int model_id) noexcept {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  if (impl_->models.erase(model_id) == 0) {
+    LOG(WARNING) << "Detach model " << model_id
+                 << ", which is not attached to the runtime.";
+    return;
+  }
+  impl_->UpdateQuotas();
+  // The quotas of the waiting runs may have grown.
+  impl_->cv.notify_all();
+}
+
+int SharedRuntime::Acquire(int model_id, int num_threads) {
+  std::unique_lock<std::mutex> lock(impl_->mutex);
+  auto key = std::make_pair(-impl_->GetModel(model_id).priority,
+                            impl_->next_ticket++);
+  impl_->waiting.insert(key);
+  auto admitted = [&] {
+    return impl_->busy_cores < impl_->num_cores &&
+           *impl_->waiting.begin() == key;
+  };
+  if (!admitted()) {
+    auto start = std::chrono::steady_clock::now();
+    impl_->cv.wait(lock, admitted);
+    ++impl_->waited_run_num;
+    impl_->wait_ms += std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  }
+  impl_->waiting.erase(key);
+  // The next waiting run may be admitted as well.
+  impl_->cv.notify_all();
+
+  int granted = std::min(std::max(num_threads, 1),
+                         impl_->num_cores - impl_->busy_cores);
+  // Leave the cores above the quota to the runs waiting.
+  if (!impl_->waiting.empty()) {
+    granted = std::min(granted, impl_->GetModel(model_id).quota);
+  }
+  impl_->busy_cores += granted;
+  ++impl_->run_num;
+  return granted;
+}
+
+void SharedRuntime::Release(int model_id, int num_cores) noexcept {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  if (num_cores > impl_->busy_cores) {
+    LOG(ERROR) << "Model " << model_id << " releases " << num_cores
+               << " cores, but only " << impl_->busy_cores
+               << " are granted.";
+    num_cores = impl_->busy_cores;
+  }
+  impl_->busy_cores -= num_cores;
+  impl_->cv.notify_all();
+}
+
+int SharedRuntime::num_cores() const { return impl_->num_cores; }
+
+SharedRuntimeStats SharedRuntime::GetStats() const {
+  std::lock_guard<std::mutex> lock(impl_->mutex);
+  SharedRuntimeStats stats;
+  stats.num_cores = impl_->num_cores;
+  stats.busy_cores = impl_->busy_cores;
+  stats.run_num = impl_->run_num;
+  stats.waited_run_num = impl_->waited_run_num;
+  stats.wait_ms = impl_->wait_ms;
+  for (auto& pair : impl_->models) {
+    stats.model_quotas[pair.first] = pair.second.quota;
+  }
+  return stats;
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -143,6 +143,31 @@ PD_Bool PD_PredictorRun(__pd_keep PD_Predictor* pd_predictor) {
   return predictor->Run();  // NOLINT
 }
 
+void PD_PredictorRunAsync(__pd_keep PD_Predictor* pd_predictor,
+                          PD_PredictorRunCallback callback,
+                          void* user_data) {
+  CHECK_AND_CONVERT_PD_PREDICTOR;
+  PADDLE_ENFORCE_NOT_NULL(
+      callback,
+      phi::errors::InvalidArgument(
+          "The callback of the async run shouldn't be nullptr"));
+  predictor->RunAsync(
+      [callback, user_data](
+          bool success,
+          std::vector<std::unique_ptr<paddle_infer::Tensor>> outputs) {
+        std::vector<PD_Tensor> pd_tensors(outputs.size());
+        std::vector<PD_Tensor*> pd_outputs(outputs.size());
+        for (size_t i = 0; i < outputs.size(); ++i) {
+          pd_tensors[i].tensor = std::move(outputs[i]);
+          pd_outputs[i] = &pd_tensors[i];
+        }
+        callback(user_data,
+                 success,
+                 pd_outputs.empty() ? nullptr : pd_outputs.data(),
+                 pd_outputs.size());
+      });
+}
+
 void PD_PredictorClearIntermediateTensor(__pd_keep PD_Predictor* pd_predictor) {
   CHECK_AND_CONVERT_PD_PREDICTOR;
   predictor->ClearIntermediateTensor();
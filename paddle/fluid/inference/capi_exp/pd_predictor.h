@@ -32,6 +32,20 @@ typedef struct PD_Tensor PD_Tensor;
 typedef struct PD_OneDimArrayCstr PD_OneDimArrayCstr;
 typedef struct PD_IOInfos PD_IOInfos;
 
+///
+/// \brief Called when a run of PD_PredictorRunAsync is done
+///
+/// \param[in] user_data the user data passed to PD_PredictorRunAsync
+/// \param[in] success Whether the run succeeded
+/// \param[in] outputs the output tensors in the order of the output names,
+/// valid until it returns
+/// \param[in] output_num the number of the outputs
+///
+typedef void (*PD_PredictorRunCallback)(void* user_data,
+                                        PD_Bool success,
+                                        PD_Tensor** outputs,
+                                        size_t output_num);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -131,6 +145,20 @@ PADDLE_CAPI_EXPORT extern __pd_give PD_Tensor* PD_PredictorGetOutputHandle(
 PADDLE_CAPI_EXPORT extern PD_Bool PD_PredictorRun(
     __pd_keep PD_Predictor* pd_predictor);
 
+///
+/// \brief Run the prediction engine without waiting for it. The inputs set
+/// by the input tensors are moved into the run, so they can be filled for
+/// the next run as soon as it returns, see Predictor::RunAsync.
+///
+/// \param[in] pd_predictor predictor
+/// \param[in] callback called on another thread when the run is done
+/// \param[in] user_data passed to the callback
+///
+PADDLE_CAPI_EXPORT extern void PD_PredictorRunAsync(
+    __pd_keep PD_Predictor* pd_predictor,
+    PD_PredictorRunCallback callback,
+    void* user_data);
+
 /// \brief Clear the intermediate tensors of the predictor
 ///
 /// \param[in] pd_predictor predictor
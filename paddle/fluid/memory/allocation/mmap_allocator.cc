@@ -18,17 +18,22 @@
 
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <cstdlib>
 
 #include <atomic>
+#include <chrono>
 #include <random>
 #include <string>
+#include <unordered_map>
 
 #include "glog/logging.h"
 #include "paddle/common/flags.h"
 #include "paddle/fluid/platform/enforce.h"
 
 COMMON_DECLARE_bool(use_shm_cache);
+COMMON_DECLARE_int64(dataloader_shm_ring_arena_size);
+COMMON_DECLARE_int64(dataloader_shm_ring_block_timeout);
 
 namespace paddle {
 namespace memory {
@@ -421,6 +426,383 @@ void MemoryMapAllocationPool::Clear() {
 
 MemoryMapAllocationPool::~MemoryMapAllocationPool() { Clear(); }  // NOLINT
 
+namespace {
+
+constexpr uint64_t kRingArenaMagic = 0x50444c52494e4731;  // "PDLRING1"
+
+// Both headers are padded to mmap_alignment so that payloads stay aligned.
+struct RingArenaHeader {
+  uint64_t magic;
+  uint64_t capacity;
+  // logical offsets, the physical offset is `offset % capacity`
+  std::atomic<uint64_t> head;
+  std::atomic<uint64_t> tail;
+};
+
+struct RingBlockHeader {
+  std::atomic<int32_t> refcount;
+  // the references in refcount not adopted by a consumer yet, or
+  // kRingBlockRevoked once they have expired
+  std::atomic<int32_t> pending;
+  // the steady clock time in ns the pending references expire at
+  std::atomic<int64_t> deadline;
+  // the logical position of the block
+  std::atomic<uint64_t> position;
+  // bytes of the block, including this header
+  uint64_t size;
+};
+
+constexpr int32_t kRingBlockRevoked = -1;
+
+static_assert(sizeof(RingArenaHeader) <= mmap_alignment,
+              "RingArenaHeader should fit in mmap_alignment");
+static_assert(sizeof(RingBlockHeader) <= mmap_alignment,
+              "RingBlockHeader should fit in mmap_alignment");
+
+inline RingArenaHeader *GetRingHeader(void *map_ptr) {
+  return reinterpret_cast<RingArenaHeader *>(map_ptr);
+}
+
+inline RingBlockHeader *GetRingBlock(void *map_ptr, uint64_t offset) {
+  return reinterpret_cast<RingBlockHeader *>(static_cast<char *>(map_ptr) +
+                                             mmap_alignment + offset);
+}
+
+inline uint64_t AlignRingSize(uint64_t size) {
+  return (size + mmap_alignment - 1) / mmap_alignment * mmap_alignment;
+}
+
+inline void InitRingBlock(RingBlockHeader *block,
+                          int32_t refcount,
+                          uint64_t position,
+                          uint64_t size) {
+  new (&block->refcount) std::atomic<int32_t>(refcount);
+  new (&block->pending) std::atomic<int32_t>(0);
+  new (&block->deadline) std::atomic<int64_t>(0);
+  block->size = size;
+  // published last, a consumer checking the position of a reused block sees
+  // either the old position or no pending reference
+  block->position.store(position, std::memory_order_release);
+}
+
+// CLOCK_MONOTONIC, which is shared by the processes on the host
+inline int64_t SteadyNowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+RingArenaAllocation::RingArenaAllocation(
+    void *ptr,
+    size_t size,
+    uint64_t position,
+    std::shared_ptr<SharedMemoryRingArena> arena)
+    : Allocation(ptr, size, phi::CPUPlace()),
+      position_(position),
+      arena_(std::move(arena)) {}
+
+void RingArenaAllocation::incref() { arena_->IncRef(position_); }
+
+const std::string &RingArenaAllocation::ipc_name() const {
+  return arena_->ipc_name();
+}
+
+RingArenaAllocation::~RingArenaAllocation() { arena_->DecRef(position_); }
+
+SharedMemoryRingArena::SharedMemoryRingArena(std::string ipc_name,
+                                             void *map_ptr,
+                                             size_t map_size,
+                                             bool is_owner)
+    : ipc_name_(std::move(ipc_name)),
+      map_ptr_(map_ptr),
+      map_size_(map_size),
+      is_owner_(is_owner),
+      owner_pid_(is_owner ? getpid() : -1) {}
+
+std::shared_ptr<SharedMemoryRingArena> SharedMemoryRingArena::Create(
+    size_t capacity) {
+  capacity = AlignRingSize(capacity);
+  PADDLE_ENFORCE_GT(capacity,
+                    static_cast<size_t>(mmap_alignment),
+                    platform::errors::InvalidArgument(
+                        "The capacity of shared memory ring arena is too "
+                        "small, received %d.",
+                        capacity));
+  std::string ipc_name = GetIPCName() + "_ring";
+  size_t map_size = capacity + mmap_alignment;
+  int fd = -1;
+  void *map_ptr = nullptr;
+  AllocateMemoryMap(ipc_name,
+                    &fd,
+                    MAPPED_SHAREDMEM | MAPPED_EXCLUSIVE,
+                    map_size,
+                    &map_ptr);
+  auto *header = GetRingHeader(map_ptr);
+  header->magic = kRingArenaMagic;
+  header->capacity = capacity;
+  new (&header->head) std::atomic<uint64_t>(0);
+  new (&header->tail) std::atomic<uint64_t>(0);
+  VLOG(4) << "Create shared memory ring arena " << ipc_name << ", capacity "
+          << capacity;
+  return std::shared_ptr<SharedMemoryRingArena>(
+      new SharedMemoryRingArena(ipc_name, map_ptr, map_size, true));
+}
+
+std::shared_ptr<SharedMemoryRingArena> SharedMemoryRingArena::Open(
+    const std::string &ipc_name) {
+  int fd = shm_open(ipc_name.c_str(), O_RDWR, (mode_t)0600);
+  PADDLE_ENFORCE_NE(fd,
+                    -1,
+                    platform::errors::Unavailable(
+                        "File descriptor %s open failed", ipc_name.c_str()));
+  struct stat file_stat;
+  PADDLE_ENFORCE_NE(
+      fstat(fd, &file_stat),
+      -1,
+      platform::errors::Unavailable("Stat of %s failed", ipc_name.c_str()));
+  size_t map_size = static_cast<size_t>(file_stat.st_size);
+  void *map_ptr =
+      mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  PADDLE_ENFORCE_NE(map_ptr,
+                    MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Memory map failed when open shared memory ring "
+                        "arena %s.",
+                        ipc_name.c_str()));
+  PADDLE_ENFORCE_EQ(GetRingHeader(map_ptr)->magic,
+                    kRingArenaMagic,
+                    platform::errors::InvalidArgument(
+                        "%s is not a shared memory ring arena.",
+                        ipc_name.c_str()));
+  VLOG(4) << "Open shared memory ring arena " << ipc_name;
+  return std::shared_ptr<SharedMemoryRingArena>(
+      new SharedMemoryRingArena(ipc_name, map_ptr, map_size, false));
+}
+
+size_t SharedMemoryRingArena::capacity() const {
+  return GetRingHeader(map_ptr_)->capacity;
+}
+
+size_t SharedMemoryRingArena::used() const {
+  auto *header = GetRingHeader(map_ptr_);
+  return header->head.load() - header->tail.load();
+}
+
+void SharedMemoryRingArena::Reclaim() {
+  auto *header = GetRingHeader(map_ptr_);
+  uint64_t head = header->head.load(std::memory_order_acquire);
+  uint64_t tail = header->tail.load(std::memory_order_relaxed);
+  while (tail < head) {
+    auto *block = GetRingBlock(map_ptr_, tail % header->capacity);
+    int32_t refcount = block->refcount.load(std::memory_order_acquire);
+    if (refcount != 0) {
+      // Only expired pending references are left, revoke them. A consumer
+      // adopting one concurrently changes pending and fails the exchange.
+      int32_t pending = block->pending.load(std::memory_order_acquire);
+      if (pending <= 0 || pending != refcount ||
+          SteadyNowNs() < block->deadline.load(std::memory_order_relaxed) ||
+          !block->pending.compare_exchange_strong(pending,
+                                                  kRingBlockRevoked)) {
+        break;
+      }
+      block->refcount.fetch_sub(pending);
+      VLOG(4) << "Revoke " << pending << " expired references of the block "
+              << "at " << tail << " of shared memory ring arena " << ipc_name_;
+    }
+    tail += block->size;
+  }
+  header->tail.store(tail, std::memory_order_release);
+}
+
+std::shared_ptr<RingArenaAllocation> SharedMemoryRingArena::Allocate(
+    size_t size) {
+  PADDLE_ENFORCE_EQ(is_owner_ && owner_pid_ == getpid(),
+                    true,
+                    platform::errors::PermissionDenied(
+                        "Only the process creating shared memory ring arena "
+                        "%s can allocate from it.",
+                        ipc_name_));
+  auto *header = GetRingHeader(map_ptr_);
+  const uint64_t capacity = header->capacity;
+  const uint64_t block_size = AlignRingSize(size) + mmap_alignment;
+  if (block_size > capacity) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(mtx_);
+  Reclaim();
+  uint64_t head = header->head.load(std::memory_order_relaxed);
+  uint64_t tail = header->tail.load(std::memory_order_relaxed);
+  uint64_t pad = 0;
+  if (head % capacity + block_size > capacity) {
+    // the block does not fit before the end of the ring, skip to the start
+    pad = capacity - head % capacity;
+  }
+  if (head + pad + block_size - tail > capacity) {
+    VLOG(6) << "Shared memory ring arena " << ipc_name_ << " is full";
+    return nullptr;
+  }
+  if (pad > 0) {
+    InitRingBlock(GetRingBlock(map_ptr_, head % capacity), 0, head, pad);
+    head += pad;
+  }
+  auto *block = GetRingBlock(map_ptr_, head % capacity);
+  InitRingBlock(block, 1, head, block_size);
+  header->head.store(head + block_size, std::memory_order_release);
+  void *ptr = reinterpret_cast<char *>(block) + mmap_alignment;
+  return std::make_shared<RingArenaAllocation>(
+      ptr, size, head, shared_from_this());
+}
+
+std::shared_ptr<RingArenaAllocation> SharedMemoryRingArena::Rebuild(
+    uint64_t position, size_t size) {
+  uint64_t offset = position % capacity();
+  PADDLE_ENFORCE_LE(offset + AlignRingSize(size) + mmap_alignment,
+                    capacity(),
+                    platform::errors::OutOfRange(
+                        "The block (position %d, size %d) is out of the "
+                        "shared memory ring arena %s.",
+                        position,
+                        size,
+                        ipc_name_));
+  auto *block = GetRingBlock(map_ptr_, offset);
+  // Adopt a pending reference of the block, the block is checked again
+  // after that in case it was revoked and reused in between.
+  bool adopted = false;
+  if (block->position.load(std::memory_order_acquire) == position) {
+    int32_t pending = block->pending.load(std::memory_order_acquire);
+    while (pending > 0 && !block->pending.compare_exchange_weak(
+                              pending, pending - 1)) {
+    }
+    adopted = pending > 0;
+    if (adopted &&
+        block->position.load(std::memory_order_acquire) != position) {
+      block->pending.fetch_add(1);
+      adopted = false;
+    }
+  }
+  PADDLE_ENFORCE_EQ(
+      adopted,
+      true,
+      platform::errors::Unavailable(
+          "The block at position %d of shared memory ring arena %s has "
+          "expired, the tensor was not unpickled within "
+          "FLAGS_dataloader_shm_ring_block_timeout seconds.",
+          position,
+          ipc_name_));
+  void *ptr = reinterpret_cast<char *>(block) + mmap_alignment;
+  return std::make_shared<RingArenaAllocation>(
+      ptr, size, position, shared_from_this());
+}
+
+void SharedMemoryRingArena::IncRef(uint64_t position) {
+  auto *block = GetRingBlock(map_ptr_, position % capacity());
+  block->refcount.fetch_add(1);
+  block->pending.fetch_add(1);
+  int64_t deadline =
+      SteadyNowNs() + FLAGS_dataloader_shm_ring_block_timeout * 1000000000LL;
+  int64_t old = block->deadline.load(std::memory_order_relaxed);
+  while (old < deadline &&
+         !block->deadline.compare_exchange_weak(old, deadline)) {
+  }
+}
+
+void SharedMemoryRingArena::DecRef(uint64_t position) {
+  GetRingBlock(map_ptr_, position % capacity())->refcount.fetch_sub(1);
+}
+
+SharedMemoryRingArena::~SharedMemoryRingArena() {
+  // NOTE: the name is left in MemoryMapFdSet, it may already be destructed
+  // when the arena of the process is released at exit. A forked child
+  // inherits the arena of its parent but doesn't own it.
+  if (is_owner_ && owner_pid_ == getpid()) {
+    shm_unlink(ipc_name_.c_str());
+  }
+  if (munmap(map_ptr_, map_size_) == -1) {
+    VLOG(3) << "could not unmap the shared memory ring arena " << ipc_name_;
+  }
+  VLOG(4) << "~SharedMemoryRingArena: " << ipc_name_;
+}
+
+std::shared_ptr<SharedMemoryRingArena> GetLocalSharedMemoryRingArena() {
+  static std::mutex mtx;
+  static std::shared_ptr<SharedMemoryRingArena> arena = nullptr;
+  static pid_t owner_pid = -1;
+  if (FLAGS_dataloader_shm_ring_arena_size <= 0) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(mtx);
+  // A forked child must not allocate from the arena of its parent.
+  if (arena == nullptr || owner_pid != getpid()) {
+    arena = SharedMemoryRingArena::Create(
+        static_cast<size_t>(FLAGS_dataloader_shm_ring_arena_size));
+    owner_pid = getpid();
+  }
+  return arena;
+}
+
+std::shared_ptr<SharedMemoryRingArena> OpenSharedMemoryRingArena(
+    const std::string &ipc_name) {
+  static std::mutex mtx;
+  static std::unordered_map<std::string, std::shared_ptr<SharedMemoryRingArena>>
+      arenas;
+  std::lock_guard<std::mutex> guard(mtx);
+  auto iter = arenas.find(ipc_name);
+  if (iter != arenas.end()) {
+    return iter->second;
+  }
+  auto arena = SharedMemoryRingArena::Open(ipc_name);
+  arenas.emplace(ipc_name, arena);
+  return arena;
+}
+
+std::shared_ptr<MappedFile> MappedFile::Open(const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(
+      fd,
+      -1,
+      platform::errors::Unavailable(
+          "Open file %s failed, reason: %s.", path, strerror(errno)));
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == -1) {
+    close(fd);
+    PADDLE_THROW(platform::errors::Unavailable(
+        "Fstat file %s failed, reason: %s.", path, strerror(errno)));
+  }
+  auto size = static_cast<size_t>(file_stat.st_size);
+  void *ptr = nullptr;
+  if (size > 0) {
+    // writable but private, written pages are copied instead of failing
+    ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  PADDLE_ENFORCE_NE(ptr,
+                    MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Memory map file %s failed, reason: %s.",
+                        path,
+                        strerror(errno)));
+  VLOG(4) << "Map file " << path << " of " << size << " bytes";
+  return std::shared_ptr<MappedFile>(new MappedFile(path, ptr, size));
+}
+
+MappedFile::~MappedFile() {
+  if (map_ptr_ != nullptr && munmap(map_ptr_, map_size_) == -1) {
+    LOG(WARNING) << "munmap " << path_ << " failed: " << strerror(errno);
+  }
+}
+
+MappedFileAllocation::MappedFileAllocation(std::shared_ptr<MappedFile> file,
+                                           size_t offset,
+                                           size_t size)
+    : Allocation(const_cast<char *>(file->data()) + offset,
+                 size,
+                 phi::CPUPlace()),
+      file_(std::move(file)),
+      offset_(offset) {}
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
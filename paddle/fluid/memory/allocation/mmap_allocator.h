@@ -16,10 +16,13 @@
 
 #ifndef _WIN32
 
+#include <sys/types.h>
+
 #include <atomic>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
@@ -235,6 +238,145 @@ class MemoryMapAllocationPool {
   std::mutex mtx_;
 };
 
+class SharedMemoryRingArena;
+
+// An allocation sub-allocated from a SharedMemoryRingArena. Every process
+// holding the block owns one reference, the block is reclaimed by the
+// producer once the last reference is dropped.
+class RingArenaAllocation : public Allocation {
+ public:
+  RingArenaAllocation(void *ptr,
+                      size_t size,
+                      uint64_t position,
+                      std::shared_ptr<SharedMemoryRingArena> arena);
+
+  // add a pending reference for a consumer process, which adopts it in
+  // SharedMemoryRingArena::Rebuild
+  void incref();
+  // the logical position of the block, which is never reused by another
+  // block of the arena
+  inline uint64_t position() const { return position_; }
+  const std::string &ipc_name() const;
+
+  ~RingArenaAllocation() override;
+
+ private:
+  uint64_t position_;
+  std::shared_ptr<SharedMemoryRingArena> arena_;
+};
+
+/* Note:
+SharedMemoryRingArena is a persistent shared memory file used by a
+DataLoader worker to pass tensors to the trainer. It is created once per
+producer process and sub-allocated as a ring buffer, so a batch is passed as
+(ipc_name, offset, size) and no shm_open/mmap/munmap is issued per batch.
+Blocks carry an atomic refcount in the shared memory, the producer reclaims
+blocks from the tail of the ring once their refcount drops to zero. The
+consumer maps each arena only once and caches the mapping.
+A reference added for a pickled tensor is pending until the consumer adopts
+it. Pending references that are never adopted, e.g. of a pickled tensor that
+is never unpickled, expire after FLAGS_dataloader_shm_ring_block_timeout
+seconds, so that they don't block the ring forever.
+Only the process that created the arena, not its forked children, allocates
+from it and unlinks it.
+*/
+class SharedMemoryRingArena
+    : public std::enable_shared_from_this<SharedMemoryRingArena> {
+ public:
+  static std::shared_ptr<SharedMemoryRingArena> Create(size_t capacity);
+
+  static std::shared_ptr<SharedMemoryRingArena> Open(
+      const std::string &ipc_name);
+
+  // Returns nullptr if the ring has no room for `size` bytes, callers should
+  // fall back to a standalone shared memory file.
+  std::shared_ptr<RingArenaAllocation> Allocate(size_t size);
+
+  // Adopts a pending reference of the block at `position`, throws if it has
+  // expired.
+  std::shared_ptr<RingArenaAllocation> Rebuild(uint64_t position,
+                                               size_t size);
+
+  // Adds a pending reference of the block at `position`.
+  void IncRef(uint64_t position);
+
+  void DecRef(uint64_t position);
+
+  inline const std::string &ipc_name() const { return ipc_name_; }
+
+  size_t capacity() const;
+
+  // bytes between the tail and the head of the ring
+  size_t used() const;
+
+  ~SharedMemoryRingArena();
+
+ private:
+  SharedMemoryRingArena(std::string ipc_name,
+                        void *map_ptr,
+                        size_t map_size,
+                        bool is_owner);
+
+  void Reclaim();
+
+  std::string ipc_name_;
+  void *map_ptr_ = nullptr;
+  size_t map_size_ = 0;
+  bool is_owner_ = false;
+  pid_t owner_pid_ = -1;
+  std::mutex mtx_;
+};
+
+// The ring arena of the current process, created on first use with
+// FLAGS_dataloader_shm_ring_arena_size bytes. Returns nullptr if disabled.
+std::shared_ptr<SharedMemoryRingArena> GetLocalSharedMemoryRingArena();
+
+// Open (or get the cached mapping of) the ring arena of another process.
+std::shared_ptr<SharedMemoryRingArena> OpenSharedMemoryRingArena(
+    const std::string &ipc_name);
+
+/* Note:
+MappedFile is a private, writable mapping of a whole file opened read-only.
+Pages stay in the page cache and are shared by every process mapping the
+same file, a page is only copied into the process if it is written
+(copy-on-write), so weights loaded through it cost no private memory until
+modified. Writes never reach the file. The mapping is writable because the
+tensors sharing it may be updated in place by kernels.
+*/
+class MappedFile {
+ public:
+  static std::shared_ptr<MappedFile> Open(const std::string &path);
+
+  inline const char *data() const { return static_cast<char *>(map_ptr_); }
+  inline size_t size() const { return map_size_; }
+  inline const std::string &path() const { return path_; }
+
+  ~MappedFile();
+
+ private:
+  MappedFile(std::string path, void *map_ptr, size_t map_size)
+      : path_(std::move(path)), map_ptr_(map_ptr), map_size_(map_size) {}
+
+  std::string path_;
+  void *map_ptr_ = nullptr;
+  size_t map_size_ = 0;
+};
+
+// An allocation aliasing [offset, offset + size) of a MappedFile, which is
+// kept mapped until the last allocation aliasing it is released.
+class MappedFileAllocation : public Allocation {
+ public:
+  MappedFileAllocation(std::shared_ptr<MappedFile> file,
+                       size_t offset,
+                       size_t size);
+
+  inline size_t offset() const { return offset_; }
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+  size_t offset_;
+};
+
 }  // namespace allocation
 }  // namespace memory
 }  // namespace paddle
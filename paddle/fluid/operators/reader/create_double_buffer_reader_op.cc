@@ -12,9 +12,13 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include "paddle/common/flags.h"
 #include "paddle/fluid/operators/reader/buffered_reader.h"
+#include "paddle/fluid/operators/reader/pipelined_reader.h"
 #include "paddle/fluid/operators/reader/reader_op_registry.h"
 
+COMMON_DECLARE_int32(reader_pipeline_num_workers);
+
 namespace paddle::operators::reader {
 class CreateDoubleBufferReaderOp : public framework::OperatorBase {
  public:
@@ -56,9 +60,16 @@ class CreateDoubleBufferReaderOp : public framework::OperatorBase {
       place = phi::GPUPlace(static_cast<int>(num));
     }
 
-    VLOG(10) << "Create new double buffer reader on " << place;
-
     out->Clear();
+    if (phi::is_cpu_place(place) && FLAGS_reader_pipeline_num_workers > 0) {
+      VLOG(10) << "Create new pipelined reader with "
+               << FLAGS_reader_pipeline_num_workers << " workers";
+      out->Reset(framework::MakeDecoratedReader<PipelinedReader>(
+          underlying_reader, FLAGS_reader_pipeline_num_workers, 2));
+      return;
+    }
+
+    VLOG(10) << "Create new double buffer reader on " << place;
     out->Reset(framework::MakeDecoratedReader<BufferedReader>(
         underlying_reader, place, 2));
   }
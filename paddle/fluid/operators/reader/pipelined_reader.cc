@@ -0,0 +1,268 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/reader/pipelined_reader.h"
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "paddle/fluid/framework/tensor_util.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+namespace {
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void CopyDecode(const framework::LoDTensorArray &in,
+                framework::LoDTensorArray *out) {
+  out->resize(in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    framework::TensorCopySync(in[i], phi::CPUPlace(), &(*out)[i]);
+    (*out)[i].set_lod(in[i].lod());
+  }
+}
+
+}  // namespace
+
+PipelinedReader::PipelinedReader(
+    const std::shared_ptr<framework::ReaderBase> &reader,
+    size_t num_workers,
+    size_t buffer_size,
+    DecodeFunc decode_fn)
+    : framework::DecoratedReader(reader),
+      num_workers_(num_workers),
+      buffer_size_(buffer_size),
+      decode_fn_(decode_fn ? std::move(decode_fn) : DecodeFunc(CopyDecode)),
+      slots_(buffer_size + num_workers),
+      free_slots_(buffer_size + num_workers),
+      work_queue_(buffer_size + num_workers),
+      out_queue_(buffer_size),
+      ready_slots_(buffer_size + num_workers, -1) {
+  PADDLE_ENFORCE_GT(
+      num_workers_,
+      static_cast<size_t>(0),
+      phi::errors::InvalidArgument(
+          "The worker number of PipelinedReader must be greater than 0."));
+  PADDLE_ENFORCE_GT(
+      buffer_size_,
+      static_cast<size_t>(0),
+      phi::errors::InvalidArgument(
+          "The buffer size of PipelinedReader must be greater than 0."));
+  VLOG(1) << "PipelinedReader with " << num_workers_ << " workers, "
+          << buffer_size_ << " buffers";
+  Launch();
+}
+
+PipelinedReader::~PipelinedReader() {
+  VLOG(1) << "~PipelinedReader";
+  reader_->Shutdown();
+  Stop();
+}
+
+void PipelinedReader::Launch() {
+  free_slots_.ReOpen();
+  work_queue_.ReOpen();
+  out_queue_.ReOpen();
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    free_slots_.Send(i);
+  }
+  {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    std::fill(ready_slots_.begin(), ready_slots_.end(), -1);
+    total_num_ = 0;
+    fetch_done_ = false;
+    stopped_ = false;
+    exception_ = nullptr;
+  }
+  fetch_thread_ = std::thread([this] { FetchLoop(); });
+  for (size_t i = 0; i < num_workers_; ++i) {
+    decode_threads_.emplace_back([this] { DecodeLoop(); });
+  }
+  emit_thread_ = std::thread([this] { EmitLoop(); });
+}
+
+void PipelinedReader::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    stopped_ = true;
+  }
+  reorder_cv_.notify_all();
+  free_slots_.Close();
+  work_queue_.Close();
+  out_queue_.Close();
+  if (fetch_thread_.joinable()) {
+    fetch_thread_.join();
+  }
+  for (auto &t : decode_threads_) {
+    t.join();
+  }
+  decode_threads_.clear();
+  if (emit_thread_.joinable()) {
+    emit_thread_.join();
+  }
+  auto stats = GetStats();
+  VLOG(1) << "PipelinedReader stats: batch_num=" << stats.batch_num
+          << ", read_ms=" << stats.read_ms << ", decode_ms=" << stats.decode_ms
+          << ", reorder_wait_ms=" << stats.reorder_wait_ms
+          << ", consume_wait_ms=" << stats.consume_wait_ms;
+}
+
+void PipelinedReader::SetException(std::exception_ptr e) {
+  {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    if (exception_ == nullptr) {
+      exception_ = e;
+    }
+  }
+  reorder_cv_.notify_all();
+  free_slots_.Close();
+  work_queue_.Close();
+}
+
+void PipelinedReader::FetchLoop() {
+  size_t seq = 0;
+  size_t slot = 0;
+  while (free_slots_.Receive(&slot)) {
+    auto &input = slots_[slot].input;
+    int64_t start = NowNs();
+    try {
+      reader_->ReadNext(&input);
+    } catch (...) {
+      SetException(std::current_exception());
+      break;
+    }
+    read_ns_ += NowNs() - start;
+    if (input.empty() || !work_queue_.Send(std::make_pair(seq, slot))) {
+      break;
+    }
+    ++seq;
+  }
+  {
+    std::lock_guard<std::mutex> lock(reorder_mutex_);
+    total_num_ = seq;
+    fetch_done_ = true;
+  }
+  reorder_cv_.notify_all();
+  work_queue_.Close();
+}
+
+void PipelinedReader::DecodeLoop() {
+  std::pair<size_t, size_t> item;
+  while (work_queue_.Receive(&item)) {
+    auto &slot = slots_[item.second];
+    // Tensors still referenced by the consumer must not be overwritten, they
+    // are dropped here and reallocated by decode_fn_.
+    for (auto &t : slot.output) {
+      if (t.Holder() != nullptr && t.Holder().use_count() > 1) {
+        t = phi::DenseTensor();
+      }
+    }
+    int64_t start = NowNs();
+    try {
+      decode_fn_(slot.input, &slot.output);
+    } catch (...) {
+      SetException(std::current_exception());
+      break;
+    }
+    decode_ns_ += NowNs() - start;
+    {
+      std::lock_guard<std::mutex> lock(reorder_mutex_);
+      ready_slots_[item.first % ready_slots_.size()] =
+          static_cast<int64_t>(item.second);
+    }
+    reorder_cv_.notify_all();
+  }
+}
+
+void PipelinedReader::EmitLoop() {
+  for (size_t seq = 0;; ++seq) {
+    int64_t slot = -1;
+    {
+      int64_t start = NowNs();
+      std::unique_lock<std::mutex> lock(reorder_mutex_);
+      auto &ready = ready_slots_[seq % ready_slots_.size()];
+      reorder_cv_.wait(lock, [&] {
+        return ready != -1 || stopped_ || exception_ != nullptr ||
+               (fetch_done_ && seq >= total_num_);
+      });
+      reorder_wait_ns_ += NowNs() - start;
+      if (ready == -1 || stopped_ || exception_ != nullptr) {
+        break;
+      }
+      slot = ready;
+      ready = -1;
+    }
+    // The pushed tensors share the allocations of the slot, they are reused
+    // by the next decode into this slot once the consumer releases them.
+    TensorVec out = slots_[slot].output;
+    if (!out_queue_.Push(std::move(out))) {
+      break;
+    }
+    ++batch_num_;
+    if (!free_slots_.Send(static_cast<size_t>(slot))) {
+      break;
+    }
+  }
+  out_queue_.Close();
+}
+
+void PipelinedReader::ShutdownImpl() {
+  VLOG(1) << "ShutdownImpl";
+  reader_->Shutdown();
+  Stop();
+}
+
+void PipelinedReader::StartImpl() {
+  reader_->Start();
+  Launch();
+}
+
+void PipelinedReader::ReadNextImpl(paddle::framework::LoDTensorArray *out) {
+  int64_t start = NowNs();
+  bool success = false;
+  *out = out_queue_.Pop(&success);
+  consume_wait_ns_ += NowNs() - start;
+  if (!success) {
+    out->clear();
+    std::exception_ptr e = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(reorder_mutex_);
+      std::swap(e, exception_);
+    }
+    if (e != nullptr) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+PipelinedReaderStats PipelinedReader::GetStats() const {
+  PipelinedReaderStats stats;
+  stats.batch_num = batch_num_.load();
+  stats.read_ms = static_cast<double>(read_ns_.load()) / 1e6;
+  stats.decode_ms = static_cast<double>(decode_ns_.load()) / 1e6;
+  stats.reorder_wait_ms = static_cast<double>(reorder_wait_ns_.load()) / 1e6;
+  stats.consume_wait_ms = static_cast<double>(consume_wait_ns_.load()) / 1e6;
+  return stats;
+}
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,127 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/reader.h"
+#include "paddle/fluid/operators/reader/blocking_queue.h"
+#include "paddle/fluid/operators/reader/lod_tensor_blocking_queue.h"
+
+namespace paddle {
+namespace operators {
+namespace reader {
+
+struct PipelinedReaderStats {
+  int64_t batch_num{0};
+  // time spent in the underlying reader
+  double read_ms{0.};
+  // time spent in the decode function, summed over all workers
+  double decode_ms{0.};
+  // time the emitter waited for the next in-order batch
+  double reorder_wait_ms{0.};
+  // time ReadNext waited for a batch
+  double consume_wait_ms{0.};
+};
+
+// PipelinedReader is a CPU oriented decorated reader. Compared with
+// BufferedReader, which reads and copies batches on a single thread, it
+// splits the work into stages:
+//
+//   fetch thread -> N decode workers -> reorder buffer -> emitter thread
+//                                                         -> ReadNext
+//
+// Batches are read from the underlying reader into a fixed set of slots,
+// decoded concurrently by `decode_fn` into the slot's pre-allocated output
+// tensors, and handed to ReadNext in the original order through a
+// LoDTensorBlockingQueue. The number of slots bounds the batches in flight,
+// so a slow consumer back-pressures every stage.
+class PipelinedReader : public framework::DecoratedReader {
+  using TensorVec = paddle::framework::LoDTensorArray;
+
+ public:
+  // decode_fn transforms one batch of the underlying reader into the output
+  // batch. It is called concurrently from the decode workers and should
+  // write into `out` in place so its allocations are reused.
+  using DecodeFunc = std::function<void(const TensorVec& in, TensorVec* out)>;
+
+  PipelinedReader(const std::shared_ptr<framework::ReaderBase>& reader,
+                  size_t num_workers,
+                  size_t buffer_size,
+                  DecodeFunc decode_fn = nullptr);
+
+  ~PipelinedReader() override;
+
+  PipelinedReaderStats GetStats() const;
+
+ protected:
+  void ShutdownImpl() override;
+  void StartImpl() override;
+  void ReadNextImpl(paddle::framework::LoDTensorArray* out) override;
+
+ private:
+  struct Slot {
+    TensorVec input;
+    TensorVec output;
+  };
+
+  void Launch();
+  void Stop();
+  void FetchLoop();
+  void DecodeLoop();
+  void EmitLoop();
+  void SetException(std::exception_ptr e);
+
+  const size_t num_workers_;
+  const size_t buffer_size_;
+  DecodeFunc decode_fn_;
+
+  std::vector<Slot> slots_;
+  BlockingQueue<size_t> free_slots_;
+  // (sequence id, slot id) waiting to be decoded
+  BlockingQueue<std::pair<size_t, size_t>> work_queue_;
+  LoDTensorBlockingQueue out_queue_;
+
+  // reorder buffer, indexed by sequence id modulo the number of slots
+  std::mutex reorder_mutex_;
+  std::condition_variable reorder_cv_;
+  std::vector<int64_t> ready_slots_;
+  size_t total_num_{0};
+  bool fetch_done_{false};
+  bool stopped_{false};
+  std::exception_ptr exception_{nullptr};
+
+  std::thread fetch_thread_;
+  std::vector<std::thread> decode_threads_;
+  std::thread emit_thread_;
+
+  std::atomic<int64_t> batch_num_{0};
+  std::atomic<int64_t> read_ns_{0};
+  std::atomic<int64_t> decode_ns_{0};
+  std::atomic<int64_t> reorder_wait_ns_{0};
+  std::atomic<int64_t> consume_wait_ns_{0};
+};
+
+}  // namespace reader
+}  // namespace operators
+}  // namespace paddle
@@ -16,8 +16,10 @@ limitations under the License. */
 #include <algorithm>
 #include <chrono>
 #include <codecvt>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <numeric>
 #include <string>
 #include <unordered_map>
@@ -76,6 +78,290 @@ inline bool IsPunctuation(const wchar_t& ch) {
   return false;
 }
 
+namespace {
+
+enum CharClass : uint8_t {
+  kWordChar = 0,
+  // chinese characters and punctuation are tokens by themselves
+  kSplitChar = 1,
+  kSpaceChar = 2,
+  kClassMask = 3,
+  // characters dropped before lowering, see BasicTokenizer::Tokenize
+  kSkipChar = 4,
+};
+
+inline uint8_t ComputeCharFlags(uint32_t ch) {
+  auto wch = static_cast<wchar_t>(ch);
+  uint8_t flags = kWordChar;
+  if (IsChineseChar(wch) || IsPunctuation(wch)) {
+    flags = kSplitChar;
+  } else if (IsWhiteSpace(wch)) {
+    flags = kSpaceChar;
+  }
+  if (ch == 0 || ch == 0xfffd || IsControl(wch)) {
+    flags |= kSkipChar;
+  }
+  return flags;
+}
+
+// The char flags and lower case of the basic multilingual plane, computed
+// once with utf8proc so the per character work of the tokenizer is a table
+// lookup. Characters out of the plane are rare and computed on the fly.
+struct CharTable {
+  static constexpr uint32_t kSize = 65536;
+
+  CharTable() : flags(kSize), lower(kSize) {
+    for (uint32_t i = 0; i < kSize; ++i) {
+      flags[i] = ComputeCharFlags(i);
+      lower[i] = static_cast<uint32_t>(utf8proc_tolower(static_cast<int>(i)));
+    }
+  }
+
+  uint8_t Flags(uint32_t ch) const {
+    return ch < kSize ? flags[ch] : ComputeCharFlags(ch);
+  }
+
+  uint32_t Lower(uint32_t ch) const {
+    return ch < kSize ? lower[ch]
+                      : static_cast<uint32_t>(
+                            utf8proc_tolower(static_cast<int>(ch)));
+  }
+
+  vector<uint8_t> flags;
+  vector<uint32_t> lower;
+};
+
+const CharTable& GetCharTable() {
+  static const CharTable table;
+  return table;
+}
+
+// Decodes the utf-8 `text` into `chars`, whose capacity is reused between
+// calls. It follows framework::ConvertStrToWstr: malformed sequences and
+// overlong forms are rejected, a truncated sequence at the end is dropped.
+bool DecodeUTF8(const string& text, vector<uint32_t>* chars, size_t* len) {
+  if (chars->size() < text.size()) {
+    chars->resize(text.size());
+  }
+  const auto* src = reinterpret_cast<const uint8_t*>(text.data());
+  const size_t size = text.size();
+  uint32_t* dst = chars->data();
+  size_t i = 0, n = 0;
+  while (i < size) {
+    // ascii fast path, 8 bytes at a time
+    if (i + 8 <= size) {
+      uint64_t block;
+      std::memcpy(&block, src + i, sizeof(block));
+      if ((block & 0x8080808080808080ULL) == 0) {
+        for (size_t k = 0; k < 8; ++k) {
+          dst[n + k] = src[i + k];
+        }
+        i += 8;
+        n += 8;
+        continue;
+      }
+    }
+    uint32_t c = src[i];
+    if (c < 0x80) {
+      dst[n++] = c;
+      ++i;
+      continue;
+    }
+    size_t bytes = 0;
+    uint32_t min = 0;
+    if ((c & 0xE0) == 0xC0) {
+      bytes = 2, c &= 0x1F, min = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+      bytes = 3, c &= 0x0F, min = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+      bytes = 4, c &= 0x07, min = 0x10000;
+    } else {
+      return false;
+    }
+    if (i + bytes > size) {
+      break;
+    }
+    for (size_t k = 1; k < bytes; ++k) {
+      uint32_t next = src[i + k];
+      if ((next & 0xC0) != 0x80) {
+        return false;
+      }
+      c = (c << 6) | (next & 0x3F);
+    }
+    if (c < min || c > 0x10FFFF) {
+      return false;
+    }
+    dst[n++] = c;
+    i += bytes;
+  }
+  *len = n;
+  return true;
+}
+
+// Converts a vocab token to code points, joining utf-16 surrogate pairs
+// on platforms where wchar_t is 16 bits.
+void WstrToCodePoints(const wstring& token, vector<uint32_t>* chars) {
+  chars->clear();
+  for (size_t i = 0; i < token.size(); ++i) {
+    auto c = static_cast<uint32_t>(token[i]);
+    if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF &&
+        i + 1 < token.size()) {
+      auto low = static_cast<uint32_t>(token[i + 1]);
+      if (low >= 0xDC00 && low <= 0xDFFF) {
+        c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+        ++i;
+      }
+    }
+    chars->push_back(c);
+  }
+}
+
+}  // namespace
+
+WordPieceTrie::WordPieceTrie(const framework::Vocab& vocab) {
+  size_t total_chars = 0;
+  for (auto& item : vocab) {
+    total_chars += item.first.size();
+  }
+  // every char of a token adds at most one edge, and "##" tokens are
+  // inserted twice
+  size_t capacity = 16;
+  shift_ = 60;
+  while (capacity < total_chars * 4) {
+    capacity <<= 1;
+    --shift_;
+  }
+  keys_.assign(capacity, kEmptyKey);
+  children_.assign(capacity, -1);
+  values_.reserve(total_chars / 2 + 2);
+  // the two roots
+  values_.assign(2, -1);
+  for (auto& children : root_children_) {
+    std::fill(children, children + kNumAsciiChars, -1);
+  }
+
+  vector<uint32_t> chars;
+  for (auto& item : vocab) {
+    WstrToCodePoints(item.first, &chars);
+    if (std::any_of(chars.begin(), chars.end(), [](uint32_t c) {
+          return c > 0x10FFFF;
+        })) {
+      continue;
+    }
+    Insert(0, chars.data(), chars.size(), item.second);
+    if (chars.size() > 2 && chars[0] == '#' && chars[1] == '#') {
+      Insert(1, chars.data() + 2, chars.size() - 2, item.second);
+    }
+  }
+}
+
+size_t WordPieceTrie::Slot(uint64_t key) const {
+  return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> shift_);
+}
+
+int32_t WordPieceTrie::Child(int32_t node, uint32_t ch) const {
+  if (node < 2 && ch < kNumAsciiChars) {
+    return root_children_[node][ch];
+  }
+  const uint64_t key = (static_cast<uint64_t>(node) << 21) | ch;
+  const size_t mask = keys_.size() - 1;
+  for (size_t slot = Slot(key);; slot = (slot + 1) & mask) {
+    if (keys_[slot] == key) {
+      return children_[slot];
+    }
+    if (keys_[slot] == kEmptyKey) {
+      return -1;
+    }
+  }
+}
+
+int32_t WordPieceTrie::AddChild(int32_t node, uint32_t ch) {
+  int32_t child = Child(node, ch);
+  if (child >= 0) {
+    return child;
+  }
+  child = static_cast<int32_t>(values_.size());
+  values_.push_back(-1);
+  if (node < 2 && ch < kNumAsciiChars) {
+    root_children_[node][ch] = child;
+    return child;
+  }
+  const uint64_t key = (static_cast<uint64_t>(node) << 21) | ch;
+  const size_t mask = keys_.size() - 1;
+  size_t slot = Slot(key);
+  while (keys_[slot] != kEmptyKey) {
+    slot = (slot + 1) & mask;
+  }
+  keys_[slot] = key;
+  children_[slot] = child;
+  return child;
+}
+
+void WordPieceTrie::Insert(int32_t root,
+                           const uint32_t* text,
+                           size_t len,
+                           int32_t id) {
+  int32_t node = root;
+  for (size_t i = 0; i < len; ++i) {
+    node = AddChild(node, text[i]);
+  }
+  values_[node] = id;
+}
+
+int64_t WordPieceTrie::Find(const uint32_t* text, size_t len) const {
+  int32_t node = 0;
+  for (size_t i = 0; i < len && node >= 0; ++i) {
+    node = Child(node, text[i]);
+  }
+  return node >= 0 && len > 0 ? values_[node] : -1;
+}
+
+size_t WordPieceTrie::LongestPrefix(const uint32_t* text,
+                                    size_t len,
+                                    bool suffix,
+                                    int64_t* id) const {
+  size_t match = 0;
+  int32_t node = suffix ? 1 : 0;
+  for (size_t i = 0; i < len; ++i) {
+    node = Child(node, text[i]);
+    if (node < 0) {
+      break;
+    }
+    if (values_[node] >= 0) {
+      match = i + 1;
+      *id = values_[node];
+    }
+  }
+  return match;
+}
+
+std::shared_ptr<const WordPieceTrie> WordPieceTrie::Get(
+    const framework::Vocab* vocab) {
+  struct Entry {
+    uint64_t version;
+    std::shared_ptr<const WordPieceTrie> trie;
+  };
+  static std::mutex mutex;
+  static unordered_map<const framework::Vocab*, Entry> cache;
+  // a model rarely holds more than a couple of vocabs, the cache is only
+  // bounded against vocabs created and destroyed repeatedly
+  static constexpr size_t kMaxCacheSize = 16;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = cache.find(vocab);
+  if (it != cache.end() && it->second.version == vocab->version()) {
+    return it->second.trie;
+  }
+  if (cache.size() >= kMaxCacheSize) {
+    cache.clear();
+  }
+  auto trie = std::make_shared<const WordPieceTrie>(*vocab);
+  VLOG(3) << "Build WordPieceTrie of vocab " << vocab << " with "
+          << vocab->size() << " tokens";
+  cache[vocab] = Entry{vocab->version(), trie};
+  return trie;
+}
+
 BasicTokenizer::BasicTokenizer(bool do_lower_case /* = true */)
     : do_lower_case_(do_lower_case) {}
 
@@ -191,7 +477,8 @@ BertTokenizer::BertTokenizer(const framework::Vocab* vocab,
       padding_site_(padding_site),
       vocab_(vocab),
       basic_tokenizer_(do_lower_case_),
-      word_piece_tokenizer_(vocab_, unk_token) {
+      word_piece_tokenizer_(vocab_, unk_token),
+      trie_(WordPieceTrie::Get(vocab)) {
   unk_token_id_ = vocab_->at(unk_token_);
   pad_token_id_ = vocab_->at(pad_token_);
   cls_token_id_ = vocab_->at(cls_token_);
@@ -207,31 +494,84 @@ BertTokenizer::BertTokenizer(const framework::Vocab* vocab,
                                                    sep_token_id_});
 }
 
+void BertTokenizer::WordPieceTokenize(const uint32_t* word,
+                                      size_t len,
+                                      vector<int64_t>* token_ids) const {
+  if (len > word_piece_tokenizer_.max_input_chars_per_word()) {
+    token_ids->emplace_back(unk_token_id_);
+    return;
+  }
+  const size_t mark = token_ids->size();
+  size_t start = 0;
+  while (start < len) {
+    int64_t id = 0;
+    size_t match =
+        trie_->LongestPrefix(word + start, len - start, start > 0, &id);
+    if (match == 0) {
+      // the word is unknown as a whole, drop the pieces found so far
+      token_ids->resize(mark);
+      token_ids->emplace_back(unk_token_id_);
+      return;
+    }
+    token_ids->emplace_back(id);
+    start += match;
+  }
+}
+
+// It produces the same ids as running BasicTokenizer and WordPieceTokenizer
+// one after another, but works on the decoded code points in place: a word is
+// normalized into the front of the buffer and handed to WordPiece as soon as
+// it ends, so no string is allocated per token.
 void BertTokenizer::Tokenize(const string& text,
                              vector<int64_t>* split_token_ids) const {
-  std::vector<std::wstring> tmp_tokens;
-  basic_tokenizer_.Tokenize(text, &tmp_tokens);
-  if (tmp_tokens.empty()) return;
-  split_token_ids->reserve(tmp_tokens.size());
-  for (auto& w_token : tmp_tokens) {
-    const auto& vec_size = w_token.size();
-    if (vec_size == 1) {
-      if (IsChineseChar(w_token[0])) {
-        auto vocab_it = vocab_->find(w_token);
-        if (vocab_it != vocab_->end()) {
-          split_token_ids->emplace_back(vocab_it->second);
+  thread_local vector<uint32_t> chars;
+  size_t len = 0;
+  if (!DecodeUTF8(text, &chars, &len)) {
+    VLOG(3) << "The string " << text << " was converted to unicode failedly! ";
+    return;
+  }
+  const CharTable& table = GetCharTable();
+  uint32_t* buffer = chars.data();
+  // chars of the current word, it is written behind the read position
+  size_t word_len = 0;
+  auto FlushWord = [&]() {
+    if (word_len > 0) {
+      WordPieceTokenize(buffer, word_len, split_token_ids);
+      word_len = 0;
+    }
+  };
+  for (size_t i = 0; i < len; ++i) {
+    uint32_t ch = buffer[i];
+    uint8_t flags = table.Flags(ch);
+    if (flags & kSkipChar) {
+      continue;
+    }
+    if (do_lower_case_) {
+      uint32_t lower = table.Lower(ch);
+      if (lower != ch) {
+        ch = lower;
+        flags = table.Flags(ch);
+      }
+    }
+    switch (flags & kClassMask) {
+      case kSplitChar:
+        FlushWord();
+        if (IsChineseChar(static_cast<wchar_t>(ch))) {
+          int64_t id = trie_->Find(&ch, 1);
+          split_token_ids->emplace_back(id >= 0 ? id : unk_token_id_);
         } else {
-          split_token_ids->emplace_back(unk_token_id_);
+          WordPieceTokenize(&ch, 1, split_token_ids);
         }
-      } else {
-        word_piece_tokenizer_.Tokenize(w_token, split_token_ids);
-      }
-    } else if (vec_size > 1) {
-      word_piece_tokenizer_.Tokenize(w_token, split_token_ids);
-    } else {
-      continue;
+        break;
+      case kSpaceChar:
+        FlushWord();
+        break;
+      default:
+        buffer[word_len++] = ch;
+        break;
     }
   }
+  FlushWord();
 }
 
 void BertTokenizer::BuildInputsWithSpecialTokens(
@@ -308,14 +648,18 @@ void BertTokenizer::TruncateSequence(
 int64_t BertTokenizer::GetPadTokenID() const { return pad_token_id_; }
 
 int BertTokenizer::Encode(
-    unordered_map<string, vector<int64_t>>* encoded_inputs,
+    vector<int64_t>* input_ids,
+    vector<int64_t>* token_type_ids,
     const string& text,
     const string& text_pair /* = "" */,
     bool is_split_into_words /* = false */,
     const size_t max_seq_len /* = 0 */,
     bool pad_to_max_seq_len /* = false */) const {
-  vector<int64_t> ids;
-  vector<int64_t> pair_ids;
+  // scratch buffers reused by the sequences tokenized on this thread
+  thread_local vector<int64_t> ids;
+  thread_local vector<int64_t> pair_ids;
+  ids.clear();
+  pair_ids.clear();
   if (!is_split_into_words) {
     Tokenize(text, &ids);
     if (ids.empty()) return 0;
@@ -324,19 +668,14 @@ int BertTokenizer::Encode(
       if (pair_ids.empty()) return 0;
     }
   } else {
-    std::wstring unicode_text;
-    bool status_a = framework::ConvertStrToWstr(text, &unicode_text);
-    if (!status_a) {
+    thread_local vector<uint32_t> chars;
+    size_t len = 0;
+    if (!DecodeUTF8(text, &chars, &len)) {
       return 0;
     }
-    for (size_t i = 0; i < unicode_text.size(); i++) {
-      wstring token = unicode_text.substr(i, 1);
-      auto it = vocab_->find(token);
-      if (it != vocab_->end()) {
-        ids.emplace_back(it->second);
-      } else {
-        ids.emplace_back(unk_token_id_);
-      }
+    for (size_t i = 0; i < len; i++) {
+      int64_t id = trie_->Find(&chars[i], 1);
+      ids.emplace_back(id >= 0 ? id : unk_token_id_);
     }
   }
 
@@ -359,15 +698,10 @@ int BertTokenizer::Encode(
   }
 
   // Add special tokens
-  vector<int64_t> sequence;
-  BuildInputsWithSpecialTokens(&sequence, ids, pair_ids);
-  size_t seq_len = sequence.size();
-  vector<int64_t> token_type_ids;
-  CreateTokenTypeIdsFromSequences(&token_type_ids, ids, pair_ids);
+  BuildInputsWithSpecialTokens(input_ids, ids, pair_ids);
+  size_t seq_len = input_ids->size();
+  CreateTokenTypeIdsFromSequences(token_type_ids, ids, pair_ids);
 
-  // Build output dictionary
-  encoded_inputs->emplace("input_ids", sequence);
-  encoded_inputs->emplace("token_type_ids", token_type_ids);
   // Check lengths
   if (max_seq_len > 0 && seq_len > max_seq_len) {
     VLOG(3) << "There is something wrong with the input sequence length."
@@ -383,23 +717,39 @@ int BertTokenizer::Encode(
   }
 
   if (needs_to_be_padded) {
-    int64_t difference = static_cast<int64_t>(max_seq_len - seq_len);
-    size_t pad_start = max_seq_len - 1 - difference;
-    encoded_inputs->at("token_type_ids").resize(max_seq_len);
-    for (size_t i = max_seq_len - 1; i > pad_start; i--) {
-      encoded_inputs->at("token_type_ids")[i] = pad_token_id_;
-    }
-
-    encoded_inputs->at("input_ids").resize(max_seq_len);
-    for (size_t i = max_seq_len - 1; i > pad_start; i--) {
-      encoded_inputs->at("input_ids")[i] = pad_token_id_;
-    }
+    token_type_ids->resize(max_seq_len, pad_token_id_);
+    input_ids->resize(max_seq_len, pad_token_id_);
   }
   return 1;
 }
 
+int BertTokenizer::Encode(
+    unordered_map<string, vector<int64_t>>* encoded_inputs,
+    const string& text,
+    const string& text_pair /* = "" */,
+    bool is_split_into_words /* = false */,
+    const size_t max_seq_len /* = 0 */,
+    bool pad_to_max_seq_len /* = false */) const {
+  vector<int64_t> input_ids;
+  vector<int64_t> token_type_ids;
+  int status = Encode(&input_ids,
+                      &token_type_ids,
+                      text,
+                      text_pair,
+                      is_split_into_words,
+                      max_seq_len,
+                      pad_to_max_seq_len);
+  // the outputs are only built once the input is tokenized successfully
+  if (!input_ids.empty()) {
+    encoded_inputs->emplace("input_ids", std::move(input_ids));
+    encoded_inputs->emplace("token_type_ids", std::move(token_type_ids));
+  }
+  return status;
+}
+
 void BertTokenizer::BatchEncode(
-    vector<unordered_map<string, vector<int64_t>>>* batch_encode_inputs,
+    vector<vector<int64_t>>* batch_input_ids,
+    vector<vector<int64_t>>* batch_token_type_ids,
     const framework::Strings& batch_text,
     const framework::Strings& batch_text_pair /* = vector<string>() */,
     bool is_split_into_words /* = false */,
@@ -411,36 +761,64 @@ void BertTokenizer::BatchEncode(
   }
 
   size_t batch_size = batch_text.size();
+  batch_input_ids->resize(batch_size);
+  batch_token_type_ids->resize(batch_size);
+  // The sequences are independent, each thread tokenizes into its own
+  // scratch buffers and writes only the outputs of its sequences.
 #ifdef PADDLE_WITH_MKLML
-#pragma omp parallel for
+#pragma omp parallel for schedule(dynamic, 16)
 #endif
   for (size_t i = 0; i < batch_size; i++) {
-    unordered_map<string, vector<int64_t>> res;
+    auto& input_ids = batch_input_ids->at(i);
+    auto& token_type_ids = batch_token_type_ids->at(i);
     if (has_text_pair) {
-      auto status = Encode(&res,
+      auto status = Encode(&input_ids,
+                           &token_type_ids,
                            batch_text[i],
                            batch_text_pair[i],
                            is_split_into_words,
                            max_seq_len,
                            pad_to_max_seq_len);
       if (!status) {
-        res["input_ids"] =
-            std::vector<int64_t>{cls_token_id_, sep_token_id_, cls_token_id_};
-        res["token_type_ids"] = std::vector<int64_t>{0, 0, 1};
+        input_ids = {cls_token_id_, sep_token_id_, cls_token_id_};
+        token_type_ids = {0, 0, 1};
       }
     } else {
-      auto status = Encode(&res,
+      auto status = Encode(&input_ids,
+                           &token_type_ids,
                            batch_text[i],
                            {},
                            is_split_into_words,
                            max_seq_len,
                            pad_to_max_seq_len);
-
       if (!status) {
-        res["input_ids"] = std::vector<int64_t>{cls_token_id_, sep_token_id_};
-        res["token_type_ids"] = std::vector<int64_t>{0, 0};
+        input_ids = {cls_token_id_, sep_token_id_};
+        token_type_ids = {0, 0};
       }
     }
+  }
+}
+
+void BertTokenizer::BatchEncode(
+    vector<unordered_map<string, vector<int64_t>>>* batch_encode_inputs,
+    const framework::Strings& batch_text,
+    const framework::Strings& batch_text_pair /* = vector<string>() */,
+    bool is_split_into_words /* = false */,
+    const size_t max_seq_len /* = 0 */,
+    bool pad_to_max_seq_len /* = false */) const {
+  vector<vector<int64_t>> batch_input_ids;
+  vector<vector<int64_t>> batch_token_type_ids;
+  BatchEncode(&batch_input_ids,
+              &batch_token_type_ids,
+              batch_text,
+              batch_text_pair,
+              is_split_into_words,
+              max_seq_len,
+              pad_to_max_seq_len);
+  for (size_t i = 0; i < batch_text.size(); i++) {
+    unordered_map<string, vector<int64_t>> res;
+    res["input_ids"] = std::move(batch_input_ids[i]);
+    res["token_type_ids"] = std::move(batch_token_type_ids[i]);
     batch_encode_inputs->at(i) = std::move(res);
   }
 }
@@ -13,6 +13,8 @@ limitations under the License. */
 
 #include <utf8proc.h>
 
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -59,6 +61,7 @@ class WordPieceTokenizer {
                               const wstring& unk_token = L"[UNK]",
                               const size_t max_input_chars_per_word = 100);
   void Tokenize(const wstring& text, vector<int64_t>* output) const;
+  size_t max_input_chars_per_word() const { return max_input_chars_per_word_; }
 
  private:
   const framework::Vocab* vocab_;
@@ -67,6 +70,49 @@ class WordPieceTokenizer {
   size_t max_input_chars_per_word_;
 };
 
+// WordPieceTrie indexes a Vocab by unicode code points, so the greedy
+// longest-match-first search of WordPiece is one walk over the word instead
+// of a hash lookup (and a substring) per candidate length. Tokens starting
+// with "##" are also indexed without the prefix under a second root, which
+// is used for every piece but the first one of a word.
+class WordPieceTrie {
+ public:
+  explicit WordPieceTrie(const framework::Vocab& vocab);
+
+  // Returns the id of text[0, len), or -1 if it is not in the vocab.
+  int64_t Find(const uint32_t* text, size_t len) const;
+  // Returns the length of the longest prefix of text[0, len) in the vocab
+  // and writes its id to `id`, returns 0 if there is none. `suffix` searches
+  // the "##" continuation tokens.
+  size_t LongestPrefix(const uint32_t* text,
+                       size_t len,
+                       bool suffix,
+                       int64_t* id) const;
+
+  // Returns the trie of `vocab`. It is built on first use and rebuilt after
+  // the vocab is modified.
+  static std::shared_ptr<const WordPieceTrie> Get(
+      const framework::Vocab* vocab);
+
+ private:
+  static constexpr uint64_t kEmptyKey = ~0ULL;
+  static constexpr int32_t kNumAsciiChars = 128;
+
+  int32_t Child(int32_t node, uint32_t ch) const;
+  int32_t AddChild(int32_t node, uint32_t ch);
+  void Insert(int32_t root, const uint32_t* text, size_t len, int32_t id);
+  size_t Slot(uint64_t key) const;
+
+  // token id of every node, -1 if the node is not the end of a token
+  vector<int32_t> values_;
+  // open addressing table of the edges, keyed by (node << 21) | code point
+  vector<uint64_t> keys_;
+  vector<int32_t> children_;
+  int shift_{0};
+  // ascii edges of the two roots, looked up directly
+  int32_t root_children_[2][kNumAsciiChars];
+};
+
 class BertTokenizer {
  public:
   explicit BertTokenizer(const framework::Vocab* vocab,
@@ -92,6 +138,13 @@ class BertTokenizer {
                         const size_t num_tokens_to_remove = 0,
                         const size_t stride = 0) const;
   int64_t GetNumSpecialTokensToAdd(const bool pair = false) const;
+  int Encode(vector<int64_t>* input_ids,
+             vector<int64_t>* token_type_ids,
+             const string& text,
+             const string& text_pair = "",
+             bool is_split_into_words = false,
+             const size_t max_seq_len = 0,
+             bool pad_to_max_seq_len = false) const;
   int Encode(unordered_map<string, vector<int64_t>>* encoded_inputs,
              const string& text,
              const string& text_pair = "",
@@ -105,6 +158,14 @@ class BertTokenizer {
       bool is_split_into_words = false,
       const size_t max_seq_len = 0,
       bool pad_to_max_seq_len = false) const;
+  void BatchEncode(
+      vector<vector<int64_t>>* batch_input_ids,
+      vector<vector<int64_t>>* batch_token_type_ids,
+      const framework::Strings& batch_text,
+      const framework::Strings& batch_text_pair = framework::Strings(),
+      bool is_split_into_words = false,
+      const size_t max_seq_len = 0,
+      bool pad_to_max_seq_len = false) const;
 
   int64_t GetPadTokenID() const;
 
@@ -120,6 +181,11 @@ class BertTokenizer {
   vector<wstring> all_special_tokens_;
   unordered_set<int64_t> all_special_token_ids_;
   InvVocab inv_vocab_;
+  std::shared_ptr<const WordPieceTrie> trie_;
+
+  void WordPieceTokenize(const uint32_t* word,
+                         size_t len,
+                         vector<int64_t>* token_ids) const;
 };
 
 template <typename T, typename DeviceContext>
@@ -150,17 +216,19 @@ class FasterTokenizerKernel : public framework::OpKernel<T> {
     size_t batch_max_seq_len = 0;
     size_t batch_size = text->size();
 
-    vector<unordered_map<string, vector<int64_t>>> batch_encode_inputs(
-        batch_size);
+    vector<vector<int64_t>> batch_input_ids(batch_size);
+    vector<vector<int64_t>> batch_seg_ids(batch_size);
     if (text_pair) {
-      tokenizer.BatchEncode(&batch_encode_inputs,
+      tokenizer.BatchEncode(&batch_input_ids,
+                            &batch_seg_ids,
                             *text,
                             *text_pair,
                             is_split_into_words,
                             max_seq_len,
                             pad_to_max_seq_len);
     } else {
-      tokenizer.BatchEncode(&batch_encode_inputs,
+      tokenizer.BatchEncode(&batch_input_ids,
+                            &batch_seg_ids,
                             *text,
                             framework::Strings(),
                             is_split_into_words,
@@ -169,10 +237,8 @@ class FasterTokenizerKernel : public framework::OpKernel<T> {
     }
 
     for (size_t i = 0; i < batch_size; ++i) {
-      size_t seq_len = batch_encode_inputs[i]["input_ids"].size();
-      if (seq_len > batch_max_seq_len) {
-        batch_max_seq_len = seq_len;
-      }
+      batch_max_seq_len =
+          std::max(batch_max_seq_len, batch_input_ids[i].size());
     }
 
     input_ids->Resize(
@@ -186,8 +252,8 @@ class FasterTokenizerKernel : public framework::OpKernel<T> {
 
     auto pad_token_id = tokenizer.GetPadTokenID();
     for (size_t i = 0; i < batch_size; i++) {
-      auto& encoder_input_ids = batch_encode_inputs[i]["input_ids"];
-      auto& encoder_seg_ids = batch_encode_inputs[i]["token_type_ids"];
+      auto& encoder_input_ids = batch_input_ids[i];
+      auto& encoder_seg_ids = batch_seg_ids[i];
       const size_t& seq_len = encoder_input_ids.size();
       // Copy the memory
       std::memcpy(input_ids_data + i * batch_max_seq_len,
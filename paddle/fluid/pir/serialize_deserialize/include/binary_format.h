@@ -0,0 +1,132 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "paddle/common/enforce.h"
+
+namespace pir {
+/**
+ * The binary format of pir program, written by WriteModule(binary = true)
+ * and recognized by ReadModule from its magic:
+ *
+ *   magic | format version | pir version | trainable
+ *   section index: number of sections, then kind, offset and size of each
+ *   sections: strings | types | attributes | program
+ *
+ * All the integers are varints. Op names (compressed like the json format),
+ * attribute names and keyword argument names are interned in the strings
+ * section. Every distinct type and attribute is stored once, as the msgpack
+ * of its json in the json format, so it is parsed once on loading and the
+ * same parse functions are shared by the two formats.
+ *
+ * The program section holds the block of the module op. A value is referred
+ * to by its id, the ids are given to block arguments and op results in the
+ * order they are written starting from 1, and 0 is the null value. An op is
+ *
+ *   name | operands | result types | attributes | result attributes (only
+ *   if trainable) | regions
+ *
+ * and every region is prefixed with its size in bytes. The ids are scoped
+ * by regions: the values defined in a region continue the ids in scope at
+ * its beginning and go out of scope at its end, so the ops after a region
+ * reuse its ids. The ids outside a region don't depend on its content, and
+ * a reader can skip it without decoding and read it later.
+ *
+ * IMPORTANT!!! like schema.h, the layout can't be changed without bumping
+ * kBinaryFormatVersion.
+ */
+#define BINARY_MAGIC "PIRB"
+constexpr size_t kBinaryMagicSize = 4;
+constexpr uint64_t kBinaryFormatVersion = 1;
+
+enum class BinarySection : uint64_t {
+  kStrings = 0,
+  kTypes = 1,
+  kAttributes = 2,
+  kProgram = 3,
+  kNumSections = 4,
+};
+
+inline bool HasBinaryMagic(const std::string& data) {
+  return data.size() >= kBinaryMagicSize &&
+         std::memcmp(data.data(), BINARY_MAGIC, kBinaryMagicSize) == 0;
+}
+
+inline void WriteVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+inline void WriteBytes(const std::string& bytes, std::string* out) {
+  WriteVarint(bytes.size(), out);
+  out->append(bytes);
+}
+
+/**
+ * BinaryCursor reads the varints and bytes of the binary format from a
+ * range of memory, every read is checked against the end of the range.
+ */
+class BinaryCursor {
+ public:
+  BinaryCursor(const char* begin, const char* end) : pos_(begin), end_(end) {}
+
+  uint64_t ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      PADDLE_ENFORCE_LT(pos_,
+                        end_,
+                        common::errors::InvalidArgument(
+                            "The binary pir program is truncated."));
+      uint8_t byte = static_cast<uint8_t>(*pos_++);
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        return value;
+      }
+    }
+    PADDLE_THROW(common::errors::InvalidArgument(
+        "The binary pir program has a malformed varint."));
+    return 0;
+  }
+
+  // Returns the beginning of the next `size` bytes and moves past them.
+  const char* ReadBytes(uint64_t size) {
+    PADDLE_ENFORCE_LE(size,
+                      static_cast<uint64_t>(end_ - pos_),
+                      common::errors::InvalidArgument(
+                          "The binary pir program is truncated."));
+    const char* begin = pos_;
+    pos_ += size;
+    return begin;
+  }
+
+  std::string ReadString() {
+    uint64_t size = ReadVarint();
+    return std::string(ReadBytes(size), size);
+  }
+
+  const char* pos() const { return pos_; }
+  bool AtEnd() const { return pos_ == end_; }
+
+ private:
+  const char* pos_;
+  const char* end_;
+};
+
+}  // namespace pir
@@ -14,7 +14,11 @@
 #pragma once
 
 #include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include "paddle/common/enforce.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/binary_format.h"
 #include "paddle/fluid/pir/serialize_deserialize/include/schema.h"
 #include "paddle/fluid/pir/serialize_deserialize/include/third_party.h"
 #include "paddle/fluid/pir/serialize_deserialize/include/version_compat.h"
@@ -56,4 +60,87 @@ class ProgramReader {
   pir::Operation* ReadParameterOp(Json* op_json);
 };
 
+/**
+ * BinaryProgramReader is used to deserialize pir program from the binary
+ * format described in binary_format.h. The types and attributes are parsed
+ * on their first use and shared by all the ops using them.
+ */
+class BinaryProgramReader {
+ public:
+  /** data is the whole content of the file, which should outlive the
+   * reader. The header and the section index are checked here.*/
+  BinaryProgramReader(const uint64_t version, const std::string& data);
+
+  BinaryProgramReader(BinaryProgramReader&&) = delete;
+  BinaryProgramReader(const BinaryProgramReader&) = delete;
+  BinaryProgramReader& operator=(const BinaryProgramReader&) = delete;
+  BinaryProgramReader& operator=(BinaryProgramReader&&);
+
+  uint64_t file_version() const { return file_version_; }
+  bool trainable() const { return trainable_; }
+
+  /** With lazy_regions, the regions of the ops in the module block are
+   * skipped by their size prefix and left empty, ReadLazyRegions reads them
+   * later, so the top level ops can be inspected without decoding the
+   * bodies of the control flow ops.*/
+  void RecoverProgram(pir::Program* recover_program,
+                      pir::PatchBuilder* builder,
+                      bool lazy_regions = false);
+  /** Reads the regions skipped by RecoverProgram, with the same builder.*/
+  void ReadLazyRegions();
+  size_t num_lazy_regions() const { return lazy_regions_.size(); }
+  ~BinaryProgramReader() = default;
+
+ private:
+  uint64_t current_version;
+  uint64_t file_version_ = 0;
+  bool trainable_ = false;
+  pir::PatchBuilder* patch_builder = nullptr;
+
+  /** the [begin, end) of every section, indexed by BinarySection.*/
+  std::vector<std::pair<const char*, const char*>> sections_;
+
+  std::vector<std::string> strings_;
+  /** the msgpack of the types and attributes, and their parse results.*/
+  std::vector<std::pair<const char*, uint64_t>> type_bytes_;
+  std::vector<std::pair<const char*, uint64_t>> attr_bytes_;
+  std::vector<pir::Type> types_;
+  std::vector<pir::Attribute> attrs_;
+  std::vector<bool> type_parsed_;
+  std::vector<bool> attr_parsed_;
+  /** the registered OpInfo of the op names, by the index of the name.*/
+  std::unordered_map<uint64_t, pir::OpInfo> op_infos_;
+
+  /** values_[id] is the value of id, values_[0] is the null value. The
+   * values defined in a region are popped at its end, see binary_format.h.*/
+  std::vector<pir::Value> values_;
+
+  /** A region skipped by RecoverProgram, its bytes and the number of the
+   * values in scope at its beginning.*/
+  struct LazyRegion {
+    pir::Region* region;
+    const char* begin;
+    uint64_t size;
+    size_t scope_size;
+  };
+  bool lazy_ = false;
+  size_t region_depth_ = 0;
+  std::vector<LazyRegion> lazy_regions_;
+
+  BinaryCursor SectionCursor(BinarySection section) const;
+  void ReadTable(BinarySection section,
+                 std::vector<std::pair<const char*, uint64_t>>* entries);
+  const std::string& GetString(uint64_t id) const;
+  pir::Type GetType(uint64_t id);
+  pir::Attribute GetAttribute(uint64_t id);
+  pir::Value GetValue(uint64_t id) const;
+
+  void ReadRegion(BinaryCursor* cursor, pir::Region* region);
+  void ReadRegionBytes(const char* begin, uint64_t size, pir::Region* region);
+  void ReadBlock(BinaryCursor* cursor, pir::Block* block);
+  pir::Operation* ReadOp(BinaryCursor* cursor);
+  void ReadAttributes(BinaryCursor* cursor, pir::AttributeMap* attributes);
+  void ApplyAttributePatches(Json* patch, pir::AttributeMap* attributes);
+};
+
 }  // namespace pir
@@ -12,6 +12,10 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #pragma once
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "paddle/fluid/pir/serialize_deserialize/include/third_party.h"
 #include "paddle/pir/include/core/program.h"
 
@@ -81,4 +85,56 @@ class ProgramWriter {
   Json WriteParameterOP(const pir::Operation& op);
 };
 
+/**
+ * BinaryProgramWriter is used to serialize pir program to the binary format
+ * described in binary_format.h. It writes the same ops and attributes as
+ * ProgramWriter.
+ */
+class BinaryProgramWriter {
+ public:
+  explicit BinaryProgramWriter(const uint64_t version, const bool trainable)
+      : version_(version), trainable_(trainable) {}
+
+  BinaryProgramWriter(BinaryProgramWriter&&) = delete;
+  BinaryProgramWriter(const BinaryProgramWriter&) = delete;
+  BinaryProgramWriter& operator=(const BinaryProgramWriter&) = delete;
+  BinaryProgramWriter& operator=(BinaryProgramWriter&&);
+
+  /** GetProgramBinary returns the whole content of the file, which is used
+   * by writeModulde api when binary is set.*/
+  std::string GetProgramBinary(const pir::Program* program);
+  ~BinaryProgramWriter() = default;
+
+ private:
+  uint64_t version_;
+  bool trainable_;
+
+  /** The interned strings, types and attributes, each maps to its index in
+   * the section, and the section is the concatenation of the entries.*/
+  std::unordered_map<std::string, uint64_t> string_ids_;
+  std::unordered_map<pir::Type, uint64_t> type_ids_;
+  std::unordered_map<pir::Attribute, uint64_t> attr_ids_;
+  std::string strings_;
+  std::string types_;
+  std::string attrs_;
+
+  /** The values in scope in the order of their ids, the id of
+   * scope_values_[i] is i + 1. The values defined in a region go out of
+   * scope at its end, so their ids are reused after it.*/
+  std::vector<pir::Value> scope_values_;
+  std::unordered_map<pir::Value, uint64_t> value_ids_;
+
+  uint64_t InternString(const std::string& str);
+  uint64_t InternType(const pir::Type& type);
+  uint64_t InternAttribute(const pir::Attribute& attr);
+  uint64_t DefineValue(const pir::Value& value);
+
+  void WriteRegion(const pir::Region& region, std::string* out);
+  void WriteBlock(pir::Block* block, std::string* out);
+  void WriteOp(const pir::Operation& op, std::string* out);
+  void WriteAttributes(
+      const std::vector<std::pair<std::string, pir::Attribute>>& attrs,
+      std::string* out);
+};
+
 }  // namespace pir
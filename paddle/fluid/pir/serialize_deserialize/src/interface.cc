@@ -14,7 +14,9 @@
 
 #include "paddle/fluid/pir/serialize_deserialize/include/interface.h"
 #include <stdio.h>
+#include <iterator>
 #include "paddle/common/enforce.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/binary_format.h"
 #include "paddle/fluid/pir/serialize_deserialize/include/ir_deserialize.h"
 #include "paddle/fluid/pir/serialize_deserialize/include/ir_serialize.h"
 #include "paddle/phi/common/port.h"
@@ -31,7 +33,8 @@ void WriteModule(const pir::Program& program,
                  const uint64_t& pir_version,
                  bool overwrite,
                  bool readable,
-                 bool trainable) {
+                 bool trainable,
+                 bool binary) {
   PADDLE_ENFORCE_EQ(
       FileExists(file_path) && !overwrite,
       false,
@@ -40,20 +43,25 @@ void WriteModule(const pir::Program& program,
           file_path,
           overwrite));
 
-  // write base code
-  Json total;
-
-  total[BASE_CODE] = {
-      {MAGIC, PIR}, {PIRVERSION, pir_version}, {TRAINABLE, trainable}};
-
-  ProgramWriter writer(pir_version, trainable);
-  // write program
-  total[PROGRAM] = writer.GetProgramJson(&program);
   std::string total_str;
-  if (readable) {
-    total_str = total.dump(4);
+  if (binary) {
+    BinaryProgramWriter writer(pir_version, trainable);
+    total_str = writer.GetProgramBinary(&program);
   } else {
-    total_str = total.dump();
+    // write base code
+    Json total;
+
+    total[BASE_CODE] = {
+        {MAGIC, PIR}, {PIRVERSION, pir_version}, {TRAINABLE, trainable}};
+
+    ProgramWriter writer(pir_version, trainable);
+    // write program
+    total[PROGRAM] = writer.GetProgramJson(&program);
+    if (readable) {
+      total_str = total.dump(4);
+    } else {
+      total_str = total.dump();
+    }
   }
 
   MkDirRecursively(DirName(file_path).c_str());
@@ -66,11 +74,40 @@ void WriteModule(const pir::Program& program,
   fout.close();
 }
 
+namespace {
+std::string PatchYamlPath() {
+  std::string cur_file = std::string(__FILE__);
+  return cur_file.substr(0, cur_file.rfind('/')) + "/patch.yaml";
+}
+
+bool ReadBinaryModule(const std::string& data,
+                      pir::Program* program,
+                      const uint64_t& pir_version) {
+  BinaryProgramReader reader(pir_version, data);
+  PatchBuilder builder(pir_version);
+  if (reader.file_version() != pir_version) {
+    builder.BuildPatch(PatchYamlPath());
+  }
+  reader.RecoverProgram(program, &builder);
+  return reader.trainable();
+}
+}  // namespace
+
 bool ReadModule(const std::string& file_path,
                 pir::Program* program,
                 const uint64_t& pir_version) {
-  std::ifstream f(file_path);
-  Json data = Json::parse(f);
+  std::ifstream f(file_path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(f),
+                    true,
+                    common::errors::Unavailable(
+                        "Cannot open %s to load program.", file_path));
+  std::string content((std::istreambuf_iterator<char>(f)),
+                      std::istreambuf_iterator<char>());
+  if (HasBinaryMagic(content)) {
+    return ReadBinaryModule(content, program, pir_version);
+  }
+
+  Json data = Json::parse(content);
   PatchBuilder builder(pir_version);
 
   if (data.contains(BASE_CODE) && data[BASE_CODE].contains(MAGIC) &&
@@ -78,10 +115,7 @@ bool ReadModule(const std::string& file_path,
     uint64_t file_version =
         data.at(BASE_CODE).at(PIRVERSION).template get<uint64_t>();
     if (file_version != pir_version) {
-      std::string cur_file = std::string(__FILE__);
-      std::string yaml_file =
-          cur_file.substr(0, cur_file.rfind('/')) + "/patch.yaml";
-      builder.BuildPatch(yaml_file);  // TODO(czy) : find file patch
+      builder.BuildPatch(PatchYamlPath());  // TODO(czy) : find file patch
     }
   } else {
     PADDLE_THROW(common::errors::InvalidArgument("Invalid model file."));
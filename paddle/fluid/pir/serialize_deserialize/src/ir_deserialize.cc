@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "paddle/fluid/pir/serialize_deserialize/include/ir_deserialize.h"
+#include <array>
 #include "paddle/fluid/pir/serialize_deserialize/include/deserialize_utils.h"
 namespace pir {
 void ProgramReader::RecoverProgram(Json* program_json,
@@ -275,4 +276,291 @@ pir::Type ProgramReader::ReadType(Json* type_json) {
   return pir::parseType(type_json);
 }
 
+BinaryProgramReader::BinaryProgramReader(const uint64_t version,
+                                         const std::string& data)
+    : current_version(version) {
+  PADDLE_ENFORCE_EQ(
+      HasBinaryMagic(data),
+      true,
+      common::errors::InvalidArgument("Invalid binary model file."));
+  const char* end = data.data() + data.size();
+  BinaryCursor cursor(data.data() + kBinaryMagicSize, end);
+  uint64_t format_version = cursor.ReadVarint();
+  PADDLE_ENFORCE_LE(
+      format_version,
+      kBinaryFormatVersion,
+      common::errors::InvalidArgument(
+          "The binary format version of the file is %d, but only %d and "
+          "older ones can be read.",
+          format_version,
+          kBinaryFormatVersion));
+  file_version_ = cursor.ReadVarint();
+  trainable_ = cursor.ReadVarint() != 0;
+
+  uint64_t num_sections = cursor.ReadVarint();
+  std::vector<std::array<uint64_t, 3>> index(num_sections);
+  for (auto& entry : index) {
+    for (auto& field : entry) {
+      field = cursor.ReadVarint();
+    }
+  }
+  const char* payload = cursor.pos();
+  auto num_kinds = static_cast<uint64_t>(BinarySection::kNumSections);
+  sections_.assign(num_kinds, {nullptr, nullptr});
+  for (auto& [kind, offset, size] : index) {
+    PADDLE_ENFORCE_LE(offset + size,
+                      static_cast<uint64_t>(end - payload),
+                      common::errors::InvalidArgument(
+                          "The section %d of the binary pir program is out of "
+                          "the file.",
+                          kind));
+    // sections added by newer writers are skipped
+    if (kind < num_kinds) {
+      sections_[kind] = {payload + offset, payload + offset + size};
+    }
+  }
+  for (uint64_t kind = 0; kind < num_kinds; ++kind) {
+    PADDLE_ENFORCE_NOT_NULL(
+        sections_[kind].first,
+        common::errors::InvalidArgument(
+            "The binary pir program misses the section %d.", kind));
+  }
+}
+
+void BinaryProgramReader::RecoverProgram(pir::Program* recover_program,
+                                         pir::PatchBuilder* builder,
+                                         bool lazy_regions) {
+  patch_builder = builder;
+  lazy_ = lazy_regions;
+  lazy_regions_.clear();
+  BinaryCursor strings_cursor = SectionCursor(BinarySection::kStrings);
+  strings_.resize(strings_cursor.ReadVarint());
+  for (auto& str : strings_) {
+    str = strings_cursor.ReadString();
+  }
+  ReadTable(BinarySection::kTypes, &type_bytes_);
+  types_.resize(type_bytes_.size());
+  type_parsed_.assign(type_bytes_.size(), false);
+  ReadTable(BinarySection::kAttributes, &attr_bytes_);
+  attrs_.resize(attr_bytes_.size());
+  attr_parsed_.assign(attr_bytes_.size(), false);
+
+  values_.assign(1, pir::Value());
+  BinaryCursor program_cursor = SectionCursor(BinarySection::kProgram);
+  ReadBlock(&program_cursor, &recover_program->module_op().block());
+  PADDLE_ENFORCE_EQ(program_cursor.AtEnd(),
+                    true,
+                    common::errors::InvalidArgument(
+                        "The binary pir program has bytes after the program."));
+  VLOG(6) << "Finish binary to program.";
+}
+
+void BinaryProgramReader::ReadLazyRegions() {
+  // Every region only sees the values before it, so the regions are read
+  // from the last one, whose scope is the largest, and the values of the
+  // module block after a region are dropped before reading it.
+  for (auto it = lazy_regions_.rbegin(); it != lazy_regions_.rend(); ++it) {
+    values_.resize(it->scope_size);
+    ReadRegionBytes(it->begin, it->size, it->region);
+  }
+  lazy_regions_.clear();
+  VLOG(6) << "Finish reading the lazy regions.";
+}
+
+BinaryCursor BinaryProgramReader::SectionCursor(BinarySection section) const {
+  auto& range = sections_[static_cast<uint64_t>(section)];
+  return BinaryCursor(range.first, range.second);
+}
+
+void BinaryProgramReader::ReadTable(
+    BinarySection section,
+    std::vector<std::pair<const char*, uint64_t>>* entries) {
+  BinaryCursor cursor = SectionCursor(section);
+  entries->resize(cursor.ReadVarint());
+  for (auto& entry : *entries) {
+    entry.second = cursor.ReadVarint();
+    entry.first = cursor.ReadBytes(entry.second);
+  }
+}
+
+const std::string& BinaryProgramReader::GetString(uint64_t id) const {
+  PADDLE_ENFORCE_LT(
+      id,
+      strings_.size(),
+      common::errors::InvalidArgument("Unknown string id %d.", id));
+  return strings_[id];
+}
+
+pir::Type BinaryProgramReader::GetType(uint64_t id) {
+  PADDLE_ENFORCE_LT(
+      id,
+      types_.size(),
+      common::errors::InvalidArgument("Unknown type id %d.", id));
+  if (!type_parsed_[id]) {
+    auto& bytes = type_bytes_[id];
+    Json type_json =
+        Json::from_msgpack(bytes.first, bytes.first + bytes.second);
+    types_[id] = pir::parseType(&type_json);
+    type_parsed_[id] = true;
+  }
+  return types_[id];
+}
+
+pir::Attribute BinaryProgramReader::GetAttribute(uint64_t id) {
+  PADDLE_ENFORCE_LT(
+      id,
+      attrs_.size(),
+      common::errors::InvalidArgument("Unknown attribute id %d.", id));
+  if (!attr_parsed_[id]) {
+    auto& bytes = attr_bytes_[id];
+    Json attr_json =
+        Json::from_msgpack(bytes.first, bytes.first + bytes.second);
+    attrs_[id] = pir::parseAttr(&attr_json);
+    attr_parsed_[id] = true;
+  }
+  return attrs_[id];
+}
+
+pir::Value BinaryProgramReader::GetValue(uint64_t id) const {
+  PADDLE_ENFORCE_LT(
+      id,
+      values_.size(),
+      common::errors::InvalidArgument(
+          "The value %d is used before it is defined.", id));
+  return values_[id];
+}
+
+void BinaryProgramReader::ReadRegion(BinaryCursor* cursor,
+                                     pir::Region* region) {
+  uint64_t size = cursor->ReadVarint();
+  const char* begin = cursor->ReadBytes(size);
+  if (lazy_ && region_depth_ == 0) {
+    lazy_regions_.push_back({region, begin, size, values_.size()});
+    return;
+  }
+  ReadRegionBytes(begin, size, region);
+}
+
+void BinaryProgramReader::ReadRegionBytes(const char* begin,
+                                          uint64_t size,
+                                          pir::Region* region) {
+  size_t scope_size = values_.size();
+  ++region_depth_;
+  BinaryCursor region_cursor(begin, begin + size);
+  uint64_t num_blocks = region_cursor.ReadVarint();
+  for (uint64_t i = 0; i < num_blocks; ++i) {
+    region->emplace_back();
+    ReadBlock(&region_cursor, &(region->back()));
+  }
+  PADDLE_ENFORCE_EQ(region_cursor.AtEnd(),
+                    true,
+                    common::errors::InvalidArgument(
+                        "The region of the binary pir program has %d bytes "
+                        "left after its blocks.",
+                        size));
+  --region_depth_;
+  values_.resize(scope_size);
+}
+
+void BinaryProgramReader::ReadBlock(BinaryCursor* cursor, pir::Block* block) {
+  uint64_t num_args = cursor->ReadVarint();
+  for (uint64_t i = 0; i < num_args; ++i) {
+    values_.push_back(block->AddArg(GetType(cursor->ReadVarint())));
+  }
+  uint64_t num_kwargs = cursor->ReadVarint();
+  for (uint64_t i = 0; i < num_kwargs; ++i) {
+    const std::string& key = GetString(cursor->ReadVarint());
+    values_.push_back(block->AddKwarg(key, GetType(cursor->ReadVarint())));
+  }
+  uint64_t num_ops = cursor->ReadVarint();
+  for (uint64_t i = 0; i < num_ops; ++i) {
+    block->push_back(ReadOp(cursor));
+  }
+  VLOG(6) << "read block size" << block->size() << ".";
+}
+
+pir::Operation* BinaryProgramReader::ReadOp(BinaryCursor* cursor) {
+  uint64_t name_id = cursor->ReadVarint();
+  const std::string& op_name = GetString(name_id);
+
+  std::vector<pir::Value> inputs(cursor->ReadVarint());
+  for (auto& input : inputs) {
+    input = GetValue(cursor->ReadVarint());
+  }
+  std::vector<pir::Type> output_types(cursor->ReadVarint());
+  for (auto& type : output_types) {
+    type = GetType(cursor->ReadVarint());
+  }
+  pir::AttributeMap attributes;
+  ReadAttributes(cursor, &attributes);
+  if (trainable_) {
+    ReadAttributes(cursor, &attributes);
+  }
+  // deal with patches
+  if (patch_builder->HasOpPatch(op_name)) {
+    Json op_patch = patch_builder->GetJsonOpPatch(op_name);
+    ApplyAttributePatches(&op_patch, &attributes);
+    VLOG(8) << op_name << " has been patched: " << op_patch;
+  }
+  size_t num_regions = cursor->ReadVarint();
+
+  auto it = op_infos_.find(name_id);
+  if (it == op_infos_.end()) {
+    std::string full_name = op_name;
+    GetDecompressOpName(&full_name);
+    pir::OpInfo op_info =
+        pir::IrContext::Instance()->GetRegisteredOpInfo(full_name);
+    PADDLE_ENFORCE_EQ(
+        static_cast<bool>(op_info),
+        true,
+        common::errors::InvalidArgument("Op %s is not registered.", full_name));
+    it = op_infos_.emplace(name_id, op_info).first;
+  }
+  pir::Operation* op = Operation::Create(
+      inputs, attributes, output_types, it->second, num_regions);
+  for (uint32_t i = 0; i < op->num_results(); i++) {
+    values_.push_back(op->result(i));
+  }
+  for (size_t i = 0; i < num_regions; ++i) {
+    ReadRegion(cursor, &(op->region(i)));
+  }
+  VLOG(4) << "Finish Read Operation " << op->name() << ".";
+  return op;
+}
+
+void BinaryProgramReader::ReadAttributes(BinaryCursor* cursor,
+                                         pir::AttributeMap* attributes) {
+  uint64_t num_attrs = cursor->ReadVarint();
+  for (uint64_t i = 0; i < num_attrs; ++i) {
+    const std::string& name = GetString(cursor->ReadVarint());
+    attributes->insert({name, GetAttribute(cursor->ReadVarint())});
+  }
+}
+
+// The patches of patch.yaml are json merge patches of the ops in the json
+// format, here each of their attributes is renamed, deleted or set in place.
+void BinaryProgramReader::ApplyAttributePatches(
+    Json* patch, pir::AttributeMap* attributes) {
+  for (auto* key : {ATTRS, OPRESULTS_ATTRS}) {
+    if (!patch->contains(key)) {
+      continue;
+    }
+    for (auto& item : patch->at(key)) {
+      auto attr_name = item.at(NAME).template get<std::string>();
+      if (item.contains("NEW_NAME")) {
+        auto node = attributes->extract(attr_name);
+        if (!node.empty()) {
+          node.key() = item.at("NEW_NAME").template get<std::string>();
+          attributes->insert(std::move(node));
+        }
+      } else if (!item.contains(ATTR_TYPE) || item.at(ATTR_TYPE).is_null()) {
+        attributes->erase(attr_name);
+        VLOG(6) << "Attribute " << attr_name << " Deleted.";
+      } else {
+        (*attributes)[attr_name] = pir::parseAttr(&item.at(ATTR_TYPE));
+      }
+    }
+  }
+}
+
 }  // namespace pir
@@ -14,6 +14,7 @@
 
 #include "paddle/fluid/pir/serialize_deserialize/include/ir_serialize.h"
 #include "paddle/fluid/pir/dialect/operator/interface/op_yaml_info.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/binary_format.h"
 #include "paddle/fluid/pir/serialize_deserialize/include/serialize_utils.h"
 #include "paddle/pir/include/core/dialect.h"
 #include "paddle/pir/include/core/operation.h"
@@ -22,6 +23,75 @@
 
 namespace pir {
 
+namespace {
+
+/* delete cf.stack_create / cf.tuple_push */
+void EraseStackOps(pir::Block* block) {
+  std::vector<pir::Operation*> delete_ops;
+  for (auto op : block->ops()) {
+    if (op->isa<pir::StackCreateOp>()) {
+      delete_ops.push_back(op);
+    }
+  }
+  VLOG(6) << "program before delete stack op :" << *(block->parent_program());
+  for (auto op : delete_ops) {
+    VLOG(0) << "Delete cf.stack_create / cf.tuple_push.";
+    auto stack_op = op->dyn_cast<pir::StackCreateOp>();
+    if (stack_op.inlet().HasOneUse()) {
+      auto tuple_push_op = stack_op.tuple_push_op();
+      auto block_in = tuple_push_op->GetParent();
+      block_in->erase(*tuple_push_op);
+    }
+    if (stack_op.outlet().HasOneUse()) {
+      auto tuple_pop_op = stack_op.tuple_pop_op();
+      auto block_in = tuple_pop_op->GetParent();
+      block_in->erase(*tuple_pop_op);
+    }
+    block->erase(*op);
+  }
+  VLOG(6) << "program after delete stack op :" << *(block->parent_program());
+}
+
+using NamedAttributes = std::vector<std::pair<std::string, pir::Attribute>>;
+
+/* the attributes of op needed to rebuild it: for pd_op ops the ones in
+ * opinfo, otherwise all of them but the opresult ones.*/
+NamedAttributes OpinfoAttributes(pir::Operation* op,
+                                 const AttributeMap& attr_map) {
+  NamedAttributes attrs;
+  if (op->dialect()->name() == "pd_op" &&
+      op->dyn_cast<paddle::dialect::OpYamlInfoInterface>()) {
+    auto [_1, attr_info, _3, _4, _5] =
+        op->dyn_cast<paddle::dialect::OpYamlInfoInterface>().GetOpInfo();
+    for (const auto& val : attr_info) {
+      if (attr_map.find(val.name) != attr_map.end()) {
+        attrs.emplace_back(val.name, attr_map.at(val.name));
+      }
+    }
+  } else {
+    for (auto& attr : attr_map) {
+      if (attr.first != "stop_gradient" && attr.first != "persistable" &&
+          attr.first != "op_callstack") {
+        attrs.emplace_back(attr.first, attr.second);
+      }
+    }
+  }
+  return attrs;
+}
+
+/* the attributes of op's opresults, only needed for training.*/
+NamedAttributes OtherAttributes(const AttributeMap& attr_map) {
+  NamedAttributes attrs;
+  for (auto& attr : attr_map) {
+    if (attr.first == "stop_gradient" || attr.first == "persistable") {
+      attrs.emplace_back(attr.first, attr.second);
+    }
+  }
+  return attrs;
+}
+
+}  // namespace
+
 Json ProgramWriter::GetProgramJson(const pir::Program* program) {
   program_json = WriteProgram(program);
   VLOG(6) << "Finish program to json.";
@@ -84,30 +154,7 @@ Json ProgramWriter::WriteBlock(pir::Block* block,
 
   Json ops_json = Json::array();
 
-  /* delete cf.stack_create / cf.tuple_push */
-  std::vector<pir::Operation*> delete_ops;
-  for (auto op : block->ops()) {
-    if (op->isa<pir::StackCreateOp>()) {
-      delete_ops.push_back(op);
-    }
-  }
-  VLOG(6) << "program before delete stack op :" << *(block->parent_program());
-  for (auto op : delete_ops) {
-    VLOG(0) << "Delete cf.stack_create / cf.tuple_push.";
-    auto stack_op = op->dyn_cast<pir::StackCreateOp>();
-    if (stack_op.inlet().HasOneUse()) {
-      auto tuple_push_op = stack_op.tuple_push_op();
-      auto block_in = tuple_push_op->GetParent();
-      block_in->erase(*tuple_push_op);
-    }
-    if (stack_op.outlet().HasOneUse()) {
-      auto tuple_pop_op = stack_op.tuple_pop_op();
-      auto block_in = tuple_pop_op->GetParent();
-      block_in->erase(*tuple_pop_op);
-    }
-    block->erase(*op);
-  }
-  VLOG(6) << "program after delete stack op :" << *(block->parent_program());
+  EraseStackOps(block);
   for (auto op : block->ops()) {
     auto op_json = WriteOp(*op);
     ops_json.emplace_back(op_json);
@@ -290,25 +337,8 @@ Json ProgramWriter::WriteAttributesMapOpinfo(pir::Operation* op,
                                              const AttributeMap& attr_map) {
   Json attrs_json = Json::array();
   VLOG(6) << "Start write Opinfo AttributeMap ...";
-  if (op->dialect()->name() == "pd_op" &&
-      op->dyn_cast<paddle::dialect::OpYamlInfoInterface>()) {
-    auto [_1, attr_info, _3, _4, _5] =
-        op->dyn_cast<paddle::dialect::OpYamlInfoInterface>().GetOpInfo();
-    if (attr_info.size() != 0) {
-      for (const auto& val : attr_info) {
-        if (attr_map.find(val.name) != attr_map.end()) {
-          attrs_json.emplace_back(
-              WriteAttribute(val.name, attr_map.at(val.name)));
-        }
-      }
-    }
-  } else {
-    for (auto& attr : attr_map) {
-      if (attr.first != "stop_gradient" && attr.first != "persistable" &&
-          attr.first != "op_callstack") {
-        attrs_json.emplace_back(WriteAttribute(attr.first, attr.second));
-      }
-    }
+  for (auto& attr : OpinfoAttributes(op, attr_map)) {
+    attrs_json.emplace_back(WriteAttribute(attr.first, attr.second));
   }
 
   VLOG(6) << "Finish write Opinfo AttributeMap. ";
@@ -317,11 +347,8 @@ Json ProgramWriter::WriteAttributesMapOpinfo(pir::Operation* op,
 
 Json ProgramWriter::WriteAttributesMapOther(const AttributeMap& attr_map) {
   Json operesult_attrs_json = Json::array();
-  for (auto& attr : attr_map) {
-    if (attr.first == "stop_gradient" || attr.first == "persistable") {
-      operesult_attrs_json.emplace_back(
-          WriteAttribute(attr.first, attr.second));
-    }
+  for (auto& attr : OtherAttributes(attr_map)) {
+    operesult_attrs_json.emplace_back(WriteAttribute(attr.first, attr.second));
   }
 
   VLOG(6) << "Finish write Other AttributeMap. ";
@@ -342,4 +369,169 @@ Json ProgramWriter::WriteType(const pir::Type& type) {
   VLOG(6) << "Finish write Type. ";
   return pir::writeType(type);
 }
+
+std::string BinaryProgramWriter::GetProgramBinary(
+    const pir::Program* program) {
+  auto top_level_op = program->module_op();
+  std::string program_bytes;
+  WriteBlock(&top_level_op.block(), &program_bytes);
+
+  auto with_size = [](size_t size, const std::string& entries) {
+    std::string section;
+    WriteVarint(size, &section);
+    section.append(entries);
+    return section;
+  };
+  // in the order of BinarySection
+  std::vector<std::string> sections = {with_size(string_ids_.size(), strings_),
+                                       with_size(type_ids_.size(), types_),
+                                       with_size(attr_ids_.size(), attrs_),
+                                       std::move(program_bytes)};
+
+  std::string binary(BINARY_MAGIC, kBinaryMagicSize);
+  WriteVarint(kBinaryFormatVersion, &binary);
+  WriteVarint(version_, &binary);
+  WriteVarint(trainable_ ? 1 : 0, &binary);
+  WriteVarint(sections.size(), &binary);
+  uint64_t offset = 0;
+  for (size_t i = 0; i < sections.size(); ++i) {
+    WriteVarint(i, &binary);
+    WriteVarint(offset, &binary);
+    WriteVarint(sections[i].size(), &binary);
+    offset += sections[i].size();
+  }
+  for (auto& section : sections) {
+    binary.append(section);
+  }
+  VLOG(6) << "Finish program to binary, " << string_ids_.size()
+          << " strings, " << type_ids_.size() << " types, " << attr_ids_.size()
+          << " attributes, " << binary.size() << " bytes.";
+  return binary;
+}
+
+uint64_t BinaryProgramWriter::InternString(const std::string& str) {
+  auto it = string_ids_.find(str);
+  if (it != string_ids_.end()) {
+    return it->second;
+  }
+  uint64_t id = string_ids_.size();
+  string_ids_.emplace(str, id);
+  WriteBytes(str, &strings_);
+  return id;
+}
+
+uint64_t BinaryProgramWriter::InternType(const pir::Type& type) {
+  auto it = type_ids_.find(type);
+  if (it != type_ids_.end()) {
+    return it->second;
+  }
+  uint64_t id = type_ids_.size();
+  type_ids_.emplace(type, id);
+  auto bytes = Json::to_msgpack(pir::writeType(type));
+  WriteBytes(std::string(bytes.begin(), bytes.end()), &types_);
+  return id;
+}
+
+uint64_t BinaryProgramWriter::InternAttribute(const pir::Attribute& attr) {
+  auto it = attr_ids_.find(attr);
+  if (it != attr_ids_.end()) {
+    return it->second;
+  }
+  uint64_t id = attr_ids_.size();
+  attr_ids_.emplace(attr, id);
+  auto bytes = Json::to_msgpack(pir::writeAttr(attr));
+  WriteBytes(std::string(bytes.begin(), bytes.end()), &attrs_);
+  return id;
+}
+
+uint64_t BinaryProgramWriter::DefineValue(const pir::Value& value) {
+  scope_values_.push_back(value);
+  value_ids_[value] = scope_values_.size();
+  return scope_values_.size();
+}
+
+void BinaryProgramWriter::WriteRegion(const pir::Region& region,
+                                      std::string* out) {
+  size_t scope_size = scope_values_.size();
+  std::string region_bytes;
+  WriteVarint(region.size(), &region_bytes);
+  for (auto block : region.blocks()) {
+    WriteBlock(block, &region_bytes);
+  }
+  WriteBytes(region_bytes, out);
+  for (size_t i = scope_size; i < scope_values_.size(); ++i) {
+    value_ids_.erase(scope_values_[i]);
+  }
+  scope_values_.resize(scope_size);
+}
+
+void BinaryProgramWriter::WriteBlock(pir::Block* block, std::string* out) {
+  WriteVarint(block->args_size(), out);
+  for (auto arg : block->args()) {
+    WriteVarint(InternType(arg.type()), out);
+    DefineValue(arg);
+  }
+  WriteVarint(block->kwargs_size(), out);
+  for (auto item : block->kwargs()) {
+    WriteVarint(InternString(item.first), out);
+    WriteVarint(InternType(item.second.type()), out);
+    DefineValue(item.second);
+  }
+
+  EraseStackOps(block);
+  WriteVarint(block->size(), out);
+  for (auto op : block->ops()) {
+    WriteOp(*op, out);
+  }
+}
+
+void BinaryProgramWriter::WriteOp(const pir::Operation& op,
+                                  std::string* out) {
+  auto op_name = op.name();
+  GetCompressOpName(&op_name);
+  WriteVarint(InternString(op_name), out);
+
+  WriteVarint(op.num_operands(), out);
+  for (auto operand : op.operands()) {
+    uint64_t id = 0;  // NULL_VALUE
+    if (operand.source()) {
+      auto it = value_ids_.find(operand.source());
+      PADDLE_ENFORCE_NE(it,
+                        value_ids_.end(),
+                        common::errors::InvalidArgument(
+                            "The operand of %s is not defined before it.",
+                            op.name()));
+      id = it->second;
+    }
+    WriteVarint(id, out);
+  }
+
+  WriteVarint(op.num_results(), out);
+  for (auto& result : op.results()) {
+    WriteVarint(InternType(result.type()), out);
+    DefineValue(result);
+  }
+
+  auto* mutable_op = const_cast<pir::Operation*>(&op);
+  WriteAttributes(OpinfoAttributes(mutable_op, op.attributes()), out);
+  if (trainable_) {
+    WriteAttributes(OtherAttributes(op.attributes()), out);
+  }
+
+  WriteVarint(op.num_regions(), out);
+  for (size_t i = 0; i < op.num_regions(); ++i) {
+    WriteRegion(op.region(i), out);
+  }
+  VLOG(8) << "Finish write Operation " << op.name() << " to binary.";
+}
+
+void BinaryProgramWriter::WriteAttributes(
+    const std::vector<std::pair<std::string, pir::Attribute>>& attrs,
+    std::string* out) {
+  WriteVarint(attrs.size(), out);
+  for (auto& attr : attrs) {
+    WriteVarint(InternString(attr.first), out);
+    WriteVarint(InternAttribute(attr.second), out);
+  }
+}
 }  // namespace pir
@@ -0,0 +1,220 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/pir/transforms/onednn/onednn_quantize_pass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <utility>
+
+#include "paddle/common/errors.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/pir/dialect/operator/ir/onednn_op.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
+#include "paddle/fluid/pir/dialect/operator/utils/utils.h"
+#include "paddle/fluid/pir/utils/general_functions.h"
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/enforce.h"
+
+#include "paddle/pir/include/core/builder.h"
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/builtin_op.h"
+#include "paddle/pir/include/core/builtin_type.h"
+#include "paddle/pir/include/pass/pass.h"
+
+namespace {
+
+// For every op of GetOneDNNQuantizableOps, whether its input is unsigned and
+// the scale bringing the max of the input to 1.0. The ops of scale 0 are left
+// in fp32.
+using QuantizeScales = std::vector<std::pair<bool, float>>;
+
+bool IsQuantizable(pir::Operation* op) {
+  if (op->isa<paddle::onednn::dialect::FusedConv2dOp>()) {
+    // The residual of an int8 conv is quantized with a scale of its own,
+    // which is not calibrated.
+    if (op->operand_source(3) ||
+        op->attribute<pir::BoolAttribute>("fuse_residual_connection").data()) {
+      return false;
+    }
+  } else if (!op->isa<paddle::onednn::dialect::FcOp>()) {
+    return false;
+  }
+  if (op->attribute<pir::StrAttribute>("mkldnn_data_type").AsString() !=
+      "float32") {
+    return false;
+  }
+  auto input_type = op->operand_source(0)
+                        .type()
+                        .dyn_cast<paddle::dialect::DenseTensorType>();
+  if (!input_type || !input_type.dtype().isa<pir::Float32Type>()) {
+    return false;
+  }
+  // The weights are quantized by the kernel, with the scales computed here
+  // from the parameter.
+  auto* weight_op = op->operand_source(1).defining_op();
+  return weight_op && (weight_op->isa<pir::ParameterOp>() ||
+                       weight_op->isa<pir::ConstantTensorOp>());
+}
+
+class OneDNNQuantizePass : public pir::Pass {
+ public:
+  OneDNNQuantizePass() : pir::Pass("onednn_quantize_pass", 3) {}
+
+  bool Initialize(pir::IrContext* context) override {
+    PADDLE_ENFORCE_EQ(
+        Has(pir::Pass::kParamScopeAttr),
+        true,
+        phi::errors::InvalidArgument(
+            "Pass initialize failed."
+            "When using OneDNNQuantizePass, scope attribute is required!"
+            "Use Set method to set the scope attribute."));
+    PADDLE_ENFORCE_EQ(
+        Has("quantize_scales"),
+        true,
+        phi::errors::InvalidArgument(
+            "Pass initialize failed."
+            "When using OneDNNQuantizePass, quantize_scales attribute is "
+            "required! Use Set method to set the quantize_scales attribute."));
+    scope_ = &Get<paddle::framework::Scope>(pir::Pass::kParamScopeAttr);
+    scales_ = &Get<QuantizeScales>("quantize_scales");
+    return true;
+  }
+
+  void Run(pir::Operation* op) override {
+    auto module_op = op->dyn_cast<pir::ModuleOp>();
+    PADDLE_ENFORCE_NOT_NULL(
+        module_op,
+        phi::errors::PreconditionNotMet(
+            "onednn_quantize_pass should run on module op."));
+    auto ops = pir::GetOneDNNQuantizableOps(&module_op.block());
+    PADDLE_ENFORCE_EQ(
+        ops.size(),
+        scales_->size(),
+        phi::errors::InvalidArgument(
+            "The program has %d ops to quantize, but %d scales are given.",
+            ops.size(),
+            scales_->size()));
+
+    int64_t num_rewrites_{0};
+    pir::IrContext* ctx = pir::IrContext::Instance();
+    pir::Builder builder(ctx, &module_op.block());
+    for (size_t i = 0; i < ops.size(); ++i) {
+      bool is_unsigned = (*scales_)[i].first;
+      float scale = (*scales_)[i].second;
+      if (scale <= 0.f || !std::isfinite(scale)) {
+        continue;
+      }
+      pir::Operation* quant_op = ops[i];
+      float scale_in = (is_unsigned ? 255.f : 127.f) * scale;
+
+      builder.set_insertion_point(quant_op);
+      pir::Value input = quant_op->operand_source(0);
+      auto quantize = builder.Build<paddle::onednn::dialect::QuantizeOp>(
+          input, !is_unsigned, scale_in, 0.f, "NHWC", false);
+      // The kernel of the consumer is chosen by the int8 type of its input.
+      auto input_type =
+          input.type().dyn_cast<paddle::dialect::DenseTensorType>();
+      quantize.result(0).set_type(paddle::dialect::DenseTensorType::get(
+          ctx,
+          paddle::dialect::TransToIrDataType(
+              is_unsigned ? phi::DataType::UINT8 : phi::DataType::INT8, ctx),
+          input_type.dims(),
+          input_type.data_layout(),
+          input_type.lod(),
+          input_type.offset()));
+      quant_op->operand(0).set_source(quantize.result(0));
+
+      std::vector<pir::Attribute> scale_weights;
+      for (float weight_scale : WeightScales(quant_op)) {
+        scale_weights.push_back(pir::FloatAttribute::get(ctx, weight_scale));
+      }
+      quant_op->set_attribute("scale_in",
+                              pir::FloatAttribute::get(ctx, scale_in));
+      quant_op->set_attribute("scale_weights",
+                              pir::ArrayAttribute::get(ctx, scale_weights));
+      // The int8 result is dequantized by the kernel itself.
+      quant_op->set_attribute("force_fp32_output",
+                              pir::BoolAttribute::get(ctx, true));
+      quant_op->set_attribute("mkldnn_data_type",
+                              pir::StrAttribute::get(ctx, "int8"));
+      num_rewrites_++;
+    }
+    AddStatistics(num_rewrites_);
+  }
+
+  bool CanApplyOn(pir::Operation* op) const override {
+    return op->isa<pir::ModuleOp>() && op->num_regions() > 0;
+  }
+
+ private:
+  // The scales bringing the max of every output channel of the weights to
+  // the int8 range, the filters of conv are [oc, ic, h, w] and the weights of
+  // fc are [ic, oc].
+  std::vector<float> WeightScales(pir::Operation* op) const {
+    std::string name = pir::GetParameterNameFromValue(op->operand_source(1));
+    auto* var = scope_->FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var,
+        phi::errors::InvalidArgument("Parameter var [%s] not in scope.", name));
+    const auto& weight = var->Get<phi::DenseTensor>();
+    PADDLE_ENFORCE_EQ(
+        weight.dtype(),
+        phi::DataType::FLOAT32,
+        phi::errors::InvalidArgument(
+            "Only fp32 weights can be quantized, but [%s] is %s.",
+            name,
+            weight.dtype()));
+    const float* data = weight.data<float>();
+    bool is_fc = op->isa<paddle::onednn::dialect::FcOp>();
+    int64_t channels = is_fc ? weight.dims()[weight.dims().size() - 1]
+                             : weight.dims()[0];
+    int64_t inner = weight.numel() / channels;
+    std::vector<float> max_abs(channels, 0.f);
+    for (int64_t i = 0; i < weight.numel(); ++i) {
+      int64_t c = is_fc ? i % channels : i / inner;
+      max_abs[c] = std::max(max_abs[c], std::abs(data[i]));
+    }
+    std::vector<float> scales(channels);
+    std::transform(max_abs.begin(),
+                   max_abs.end(),
+                   scales.begin(),
+                   [](float max) { return max > 0.f ? 127.f / max : 1.f; });
+    return scales;
+  }
+
+  paddle::framework::Scope* scope_{nullptr};
+  const QuantizeScales* scales_{nullptr};
+};
+
+}  // namespace
+
+namespace pir {
+
+std::vector<Operation*> GetOneDNNQuantizableOps(Block* block) {
+  std::vector<Operation*> ops;
+  for (auto& op : *block) {
+    if (IsQuantizable(&op)) {
+      ops.push_back(&op);
+    }
+  }
+  return ops;
+}
+
+std::unique_ptr<Pass> CreateOneDNNQuantizePass() {
+  return std::make_unique<OneDNNQuantizePass>();
+}
+
+}  // namespace pir
@@ -0,0 +1,33 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "paddle/pir/include/core/dll_decl.h"
+
+namespace pir {
+
+class Block;
+class Operation;
+class Pass;
+
+// The ops the onednn_quantize_pass runs in int8, in the order of the block.
+// The "quantize_scales" attribute of the pass is indexed the same.
+IR_API std::vector<Operation*> GetOneDNNQuantizableOps(Block* block);
+
+IR_API std::unique_ptr<Pass> CreateOneDNNQuantizePass();
+
+}  // namespace pir
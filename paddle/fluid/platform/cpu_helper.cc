@@ -57,5 +57,23 @@ void SetNumThreads(int num_threads) {
 #endif
 }
 
+void SetNumThreadsLocal(int num_threads) {
+#ifdef PADDLE_WITH_MKLML
+  if (num_threads == 0) {
+    phi::dynload::MKL_Set_Num_Threads_Local(0);
+    return;
+  }
+  int real_num_threads = num_threads > 1 ? num_threads : 1;
+  // overrides the global MKL setting on this thread, and the OpenMP
+  // nthreads-var is a per-thread ICV
+  phi::dynload::MKL_Set_Num_Threads_Local(real_num_threads);
+  omp_set_num_threads(real_num_threads);
+#else
+  if (num_threads != 0) {
+    SetNumThreads(num_threads);
+  }
+#endif
+}
+
 }  // namespace platform
 }  // namespace paddle
@@ -22,5 +22,12 @@ namespace platform {
 //! Set the number of threads in use.
 void SetNumThreads(int num_threads);
 
+//! Set the number of threads used by the calling thread only. With MKLML
+//! it sets the MKL and OpenMP threads of this thread, so that threads
+//! running concurrently may use different numbers. Other libraries fall
+//! back to SetNumThreads, whose setting is process-wide. A num_threads of
+//! 0 makes the calling thread use the process-wide setting again.
+void SetNumThreadsLocal(int num_threads);
+
 }  // namespace platform
 }  // namespace paddle
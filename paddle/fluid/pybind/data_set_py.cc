@@ -297,6 +297,9 @@ void BindDataset(py::module *m) {
       .def("clear_sample_state",
            &framework::Dataset::ClearSampleState,
            py::call_guard<py::gil_scoped_release>())
+      .def("get_record_pool_memory_size",
+           &framework::Dataset::GetRecordPoolMemorySize,
+           py::call_guard<py::gil_scoped_release>())
       .def("get_pv_data_size",
            &framework::Dataset::GetPvDataSize,
            py::call_guard<py::gil_scoped_release>())
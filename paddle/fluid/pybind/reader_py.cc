@@ -30,11 +30,13 @@
 #include "paddle/fluid/imperative/tracer.h"
 #include "paddle/fluid/operators/reader/buffered_reader.h"
 #include "paddle/fluid/operators/reader/lod_tensor_blocking_queue.h"
+#include "paddle/fluid/operators/reader/pipelined_reader.h"
 #include "paddle/fluid/operators/reader/py_reader.h"
 #include "paddle/phi/common/place.h"
 #include "pybind11/stl.h"
 
 COMMON_DECLARE_bool(reader_queue_speed_test_mode);
+COMMON_DECLARE_int32(reader_pipeline_num_workers);
 
 // disable auto conversion to list in Python
 PYBIND11_MAKE_OPAQUE(paddle::framework::LoDTensorArray);
@@ -176,7 +178,13 @@ class MultiDeviceFeedReader {
       auto &p = dst_places[i];
       auto *holder = new framework::ReaderHolder();
       auto reader = create_or_get_reader(i);
-      if (use_double_buffer) {
+      if (use_double_buffer && phi::is_cpu_place(p) &&
+          FLAGS_reader_pipeline_num_workers > 0) {
+        VLOG(10) << "Creating " << i << "-th PipelinedReader";
+        holder->Reset(
+            framework::MakeDecoratedReader<operators::reader::PipelinedReader>(
+                reader, FLAGS_reader_pipeline_num_workers, 2));
+      } else if (use_double_buffer) {
         VLOG(10) << "Creating " << i << "-th BufferedReader";
         holder->Reset(
             framework::MakeDecoratedReader<operators::reader::BufferedReader>(
@@ -995,6 +995,76 @@ void BindTensor(pybind11::module &m) {  // NOLINT
                     >>> metainfo = tensor.value().get_tensor()._share_filename()
                     >>> tensor_from_shared = paddle.to_tensor(paddle.base.core.LoDTensor._new_shared_filename(metainfo))
         )DOC")
+      .def("_share_ring_arena",
+           [](phi::DenseTensor &self) -> py::object {
+             if (!self.IsInitialized() || self.numel() == 0 ||
+                 !phi::is_cpu_place(self.place())) {
+               return py::none();
+             }
+             auto *ring_allocation =
+                 dynamic_cast<memory::allocation::RingArenaAllocation *>(
+                     self.Holder().get());
+             if (ring_allocation == nullptr) {
+               auto arena =
+                   memory::allocation::GetLocalSharedMemoryRingArena();
+               if (arena == nullptr) {
+                 return py::none();
+               }
+               size_t data_size =
+                   self.numel() * phi::SizeOf(self.dtype());
+               auto shared_holder = arena->Allocate(data_size);
+               if (shared_holder == nullptr) {
+                 return py::none();
+               }
+               memory::Copy(phi::CPUPlace(), shared_holder->ptr(),
+                            phi::CPUPlace(), self.data(), data_size);
+               self.ResetHolder(shared_holder);
+               ring_allocation = shared_holder.get();
+             }
+             // the reference is adopted by _new_shared_ring_arena
+             ring_allocation->incref();
+             int type_idx = static_cast<int>(self.type());
+             return py::make_tuple(ring_allocation->ipc_name(),
+                                   ring_allocation->position(),
+                                   ring_allocation->size(), type_idx,
+                                   common::vectorize(self.dims()), self.lod());
+           },
+           R"DOC(
+           Serialize CPU lod tensor in the shared memory ring arena of the
+           current process to tuple. The tensor is copied into the arena
+           first if needed.
+
+           Returns:
+               tuple|None: contains ipc name of the arena, offset, data size,
+                      data type, tensor dims and lod information. None if
+                      the arena is disabled or full.
+       )DOC")
+      .def("_new_shared_ring_arena",
+           [](py::tuple t) {
+             if (t.size() != 6)
+               throw std::runtime_error("Invalid Tensor meta info state!");
+
+             phi::DenseTensor tensor;
+             const std::string &ipc_name = t[0].cast<std::string>();
+             uint64_t position = t[1].cast<uint64_t>();
+             size_t size = t[2].cast<size_t>();
+             auto arena =
+                 memory::allocation::OpenSharedMemoryRingArena(ipc_name);
+             tensor.ResetHolderWithType(
+                 arena->Rebuild(position, size),
+                 static_cast<phi::DataType>(t[3].cast<int>()));
+             tensor.Resize(common::make_ddim(t[4].cast<std::vector<int>>()));
+             tensor.set_lod(t[5].cast<framework::LoD>());
+
+             return tensor;
+           },
+           R"DOC(
+           Deserialize CPU lod tensor from a shared memory ring arena.
+
+           Params:
+               tuple: contains ipc name of the arena, offset, data size,
+                      data type, tensor dims and lod information.
+        )DOC")
       .def("_shared_incref",
            [](phi::DenseTensor &self) {
              auto *mmap_allocation = dynamic_cast<
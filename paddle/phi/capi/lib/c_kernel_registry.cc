@@ -168,7 +168,8 @@ void PD_RegisterPhiKernel(const char* kernel_name_cstr,
                        out_args_type);
 
   args_def_fn_wrapper(kernel_key, &kernel);
-  phi::KernelFactory::Instance().kernels()[kernel_name][kernel_key] = kernel;
+  phi::KernelFactory::Instance().RegisterKernel(
+      kernel_name, kernel_key, kernel);
 }
 
 PD_REGISTER_CAPI(kernel_registry);
@@ -53,7 +53,8 @@ void CustomKernelMap::RegisterCustomKernels() {
               pair.first,
               info_pair.first));
 
-      kernels[pair.first][info_pair.first] = info_pair.second;
+      KernelFactory::Instance().RegisterKernel(
+          pair.first, info_pair.first, info_pair.second);
 
       VLOG(3) << "Succeed in registering kernel [" << pair.first << ":"
               << info_pair.first
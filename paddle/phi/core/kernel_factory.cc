@@ -368,6 +368,42 @@ KernelResult KernelFactory::SelectKernelOrThrowError(
   return {kernel_iter->second, false, false};
 }
 
+KernelResult KernelResultCache::SelectKernelOrThrowError(
+    const char* kernel_name,
+    const KernelKey& kernel_key,
+    bool use_strided_kernel) {
+#if defined(PADDLE_WITH_XPU) || defined(PADDLE_WITH_XPU_KP)
+  // The selection also depends on the xpu op lists of the current device,
+  // the xpu black list and FLAGS_run_kp_kernel, which are not in the key.
+  return KernelFactory::Instance().SelectKernelOrThrowError(
+      kernel_name, kernel_key, use_strided_kernel);
+#else
+  uint32_t key = static_cast<uint32_t>(kernel_key.backend()) |
+                 static_cast<uint32_t>(kernel_key.layout()) << 8 |
+                 static_cast<uint32_t>(kernel_key.dtype()) << 16 |
+                 static_cast<uint32_t>(use_strided_kernel) << 24 |
+                 static_cast<uint32_t>(FLAGS_use_stride_kernel) << 25 |
+                 static_cast<uint32_t>(FLAGS_enable_api_kernel_fallback)
+                     << 26;
+  uint64_t version = KernelFactory::Instance().kernels_version();
+  for (const Entry& entry : entries_) {
+    if (entry.version == version && entry.key == key) {
+      return {*entry.kernel, entry.has_fallback_cpu, entry.is_stride_kernel};
+    }
+  }
+
+  KernelResult result = KernelFactory::Instance().SelectKernelOrThrowError(
+      kernel_name, kernel_key, use_strided_kernel);
+  entries_[next_entry_] = {version,
+                           key,
+                           &result.kernel,
+                           result.has_fallback_cpu,
+                           result.is_stride_kernel};
+  next_entry_ = (next_entry_ + 1) % kNumEntries;
+  return result;
+#endif
+}
+
 const KernelArgsDef& KernelFactory::GetFirstKernelArgsDef(
     const std::string& kernel_name) const {
   auto iter = kernels_.find(kernel_name);
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <map>
 #include <ostream>
 #include <unordered_map>
@@ -317,8 +319,28 @@ class KernelFactory {
  public:
   static KernelFactory& Instance();
 
+  // The kernels are changed with RegisterKernel and ClearKernels, not
+  // through this map, so that the KernelResultCaches are invalidated.
   KernelNameMap& kernels() { return kernels_; }
 
+  // The version is bumped after the change, so a cache filled during it
+  // keeps the old version and is not used afterwards.
+  void RegisterKernel(const std::string& kernel_name,
+                      const KernelKey& kernel_key,
+                      const Kernel& kernel) {
+    kernels_[kernel_name][kernel_key] = kernel;
+    kernels_version_.fetch_add(1, std::memory_order_release);
+  }
+
+  void ClearKernels() {
+    kernels_.clear();
+    kernels_version_.fetch_add(1, std::memory_order_release);
+  }
+
+  uint64_t kernels_version() const {
+    return kernels_version_.load(std::memory_order_acquire);
+  }
+
   bool HasCompatiblePhiKernel(const std::string& op_type) const;
 
   bool HasStructuredKernel(const std::string& op_type) const;
@@ -353,10 +375,46 @@ class KernelFactory {
 
   KernelNameMap kernels_;
 
+  // Starts from 1, as 0 marks an empty entry of KernelResultCache.
+  std::atomic<uint64_t> kernels_version_{1};
+
   // Get the low precision kernel list of current module.
   std::map<const std::string, OpCount> low_precision_kernels_;
 };
 
+/**
+ * KernelResultCache keeps the kernels selected at a call site of
+ * SelectKernelOrThrowError for its last few kernel keys. The kernel name of a
+ * call site never changes, so a kernel is found again by its key and the
+ * flags the selection depends on, without looking up the name and the
+ * fallbacks. The caches are invalidated whenever the kernels are changed.
+ *
+ * It is meant to be a thread_local at the call site, e.g. in the generated
+ * apis, so it has no locks and is trivially destructible.
+ */
+class KernelResultCache {
+ public:
+  KernelResult SelectKernelOrThrowError(const char* kernel_name,
+                                        const KernelKey& kernel_key,
+                                        bool use_strided_kernel = false);
+
+ private:
+  struct Entry {
+    // 0 if the entry is empty.
+    uint64_t version = 0;
+    uint32_t key = 0;
+    const Kernel* kernel = nullptr;
+    bool has_fallback_cpu = false;
+    bool is_stride_kernel = false;
+  };
+
+  static constexpr size_t kNumEntries = 4;
+
+  std::array<Entry, kNumEntries> entries_;
+  // The entry replaced by the next miss.
+  size_t next_entry_ = 0;
+};
+
 inline std::ostream& operator<<(std::ostream& os, const KernelKey& kernel_key) {
   os << "(" << kernel_key.backend() << ", " << kernel_key.layout() << ", "
      << kernel_key.dtype() << ")";
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include "paddle/phi/infermeta/strings/unary.h"
 
+#include "paddle/phi/core/enforce.h"
 #include "paddle/phi/core/infermeta_utils.h"
 
 namespace phi::strings {
@@ -30,4 +31,24 @@ void CreateLikeInferMeta(const MetaTensor& x, MetaTensor* out) {
   out->set_layout(x.layout());
 }
 
+void SplitInferMeta(const MetaTensor& x, int max_tokens, MetaTensor* out) {
+  PADDLE_ENFORCE_GT(max_tokens,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "The max_tokens of strings split must be greater "
+                        "than 0, but received %d.",
+                        max_tokens));
+  auto out_dims = common::vectorize(x.dims());
+  out_dims.push_back(max_tokens);
+  out->set_dims(common::make_ddim(out_dims));
+  out->set_dtype(DataType::PSTRING);
+  out->set_layout(DataLayout::PSTRING_UNION);
+}
+
+void HashBucketInferMeta(const MetaTensor& x, MetaTensor* out) {
+  out->set_dims(x.dims());
+  out->set_dtype(DataType::INT64);
+  out->set_layout(DataLayout::NCHW);
+}
+
 }  // namespace phi::strings
@@ -27,5 +27,9 @@ void UnchangedInferMeta(const StringTensorMeta& x_meta, MetaTensor* out);
 
 void CreateLikeInferMeta(const MetaTensor& x, MetaTensor* out);
 
+void SplitInferMeta(const MetaTensor& x, int max_tokens, MetaTensor* out);
+
+void HashBucketInferMeta(const MetaTensor& x, MetaTensor* out);
+
 }  // namespace strings
 }  // namespace phi
@@ -21,7 +21,7 @@
 #include "paddle/phi/backends/cpu/cpu_context.h"
 #include "paddle/phi/core/kernel_registry.h"
 #include "paddle/phi/core/tensor_utils.h"
-#include "paddle/phi/kernels/funcs/adam_functors.h"
+#include "paddle/phi/kernels/cpu/multi_tensor_adam.h"
 #include "paddle/phi/kernels/funcs/jit/kernels.h"
 
 PD_DECLARE_int32(inner_op_parallelism);
@@ -240,33 +240,26 @@ void MergedAdamKernel(
                         "is %d, the size of Input(param) is %d.",
                         beta2_pow.size(),
                         param_num));
-  T beta1_ = beta1.to<T>();
-  T beta2_ = beta2.to<T>();
-  T epsilon_ = epsilon.to<T>();
-
-  for (size_t idx = 0; idx < param_num; idx++) {
-    phi::funcs::AdamFunctor<T, phi::funcs::CPUAdam> functor(
-        beta1_,
-        beta2_,
-        epsilon_,
-        beta1_pow[idx]->data<T>(),
-        beta2_pow[idx]->data<T>(),
-        moment1[idx]->data<T>(),
-        dev_ctx.template Alloc<T>(moment1_out[idx]),
-        moment2[idx]->data<T>(),
-        dev_ctx.template Alloc<T>(moment2_out[idx]),
-        learning_rate[idx]->data<T>(),
-        grad[idx]->data<T>(),
-        param[idx]->data<T>(),
-        dev_ctx.template Alloc<T>(param_out[idx]));
-    functor(param[idx]->numel());
-    if (!use_global_beta_pow) {
-      dev_ctx.template Alloc<T>(beta1_pow_out[idx])[0] =
-          beta1_ * beta1_pow[idx]->data<T>()[0];
-      dev_ctx.template Alloc<T>(beta2_pow_out[idx])[0] =
-          beta2_ * beta2_pow[idx]->data<T>()[0];
-    }
-  }
+  CPUMultiTensorAdam<T, Context>(dev_ctx,
+                                 param,
+                                 grad,
+                                 learning_rate,
+                                 moment1,
+                                 moment2,
+                                 beta1_pow,
+                                 beta2_pow,
+                                 beta1.to<T>(),
+                                 beta2.to<T>(),
+                                 epsilon.to<T>(),
+                                 false,
+                                 static_cast<T>(1.0),
+                                 static_cast<T>(0.0),
+                                 use_global_beta_pow,
+                                 param_out,
+                                 moment1_out,
+                                 moment2_out,
+                                 beta1_pow_out,
+                                 beta2_pow_out);
 }
 
 }  // namespace phi
@@ -20,6 +20,7 @@
 
 #include "paddle/phi/kernels/adam_kernel.h"
 #include "paddle/phi/kernels/adamw_kernel.h"
+#include "paddle/phi/kernels/cpu/multi_tensor_adam.h"
 
 namespace phi {
 
@@ -96,6 +97,32 @@ void FusedAdamKernel(
                         beta2_pows.size(),
                         params_num));
 
+  // The params without master params are updated in one multi tensor apply,
+  // instead of a kernel for each which is slow for many small params.
+  if (!master_params && !skip_update) {
+    CPUMultiTensorAdam<T, Context>(dev_ctx,
+                                   params,
+                                   grads,
+                                   {&learning_rate},
+                                   moments1,
+                                   moments2,
+                                   beta1_pows,
+                                   beta2_pows,
+                                   beta1.to<T>(),
+                                   beta2.to<T>(),
+                                   epsilon.to<T>(),
+                                   use_adamw,
+                                   static_cast<T>(1.0),
+                                   static_cast<T>(weight_decay),
+                                   use_global_beta_pow,
+                                   params_out,
+                                   moments1_out,
+                                   moments2_out,
+                                   beta1_pows_out,
+                                   beta2_pows_out);
+    return;
+  }
+
   for (size_t idx = 0; idx < params_num; idx++) {
     auto master_params_tmp = TensorPtrToOptionalTensor(master_params, idx);
     if (!use_adamw) {
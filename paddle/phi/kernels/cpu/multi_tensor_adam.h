@@ -0,0 +1,137 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <math.h>  // for sqrt of the same precision as AdamDenseKernel
+
+#include <vector>
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/cpu_multi_tensor_apply.h"
+#include "paddle/phi/kernels/funcs/jit/kernels.h"
+
+namespace phi {
+
+// Updates all the params by adam, or by adamw with the decay of coeff, with
+// the jit kernels of AdamDenseKernel and AdamwDenseKernel in one multi
+// tensor apply. learning_rates holds one learning rate for all the params or
+// one for each.
+template <typename T, typename Context>
+void CPUMultiTensorAdam(
+    const Context& dev_ctx,
+    const std::vector<const DenseTensor*>& params,
+    const std::vector<const DenseTensor*>& grads,
+    const std::vector<const DenseTensor*>& learning_rates,
+    const std::vector<const DenseTensor*>& moments1,
+    const std::vector<const DenseTensor*>& moments2,
+    const std::vector<const DenseTensor*>& beta1_pows,
+    const std::vector<const DenseTensor*>& beta2_pows,
+    T beta1,
+    T beta2,
+    T epsilon,
+    bool use_adamw,
+    T lr_ratio,
+    T coeff,
+    bool use_global_beta_pow,
+    const std::vector<DenseTensor*>& params_out,
+    const std::vector<DenseTensor*>& moments1_out,
+    const std::vector<DenseTensor*>& moments2_out,
+    const std::vector<DenseTensor*>& beta1_pows_out,
+    const std::vector<DenseTensor*>& beta2_pows_out) {
+  size_t params_num = params.size();
+  // The bias corrections of every param, and the pointers of its tensors
+  struct AdamArgs {
+    T lr;
+    T old_lr;
+    T eps;
+    const T* grad;
+    const T* mom1;
+    const T* mom2;
+    const T* param;
+    T* mom1_out;
+    T* mom2_out;
+    T* param_out;
+  };
+  std::vector<AdamArgs> args(params_num);
+  for (size_t idx = 0; idx < params_num; ++idx) {
+    const DenseTensor* learning_rate =
+        learning_rates.size() == 1 ? learning_rates[0] : learning_rates[idx];
+    T beta1_p = beta1_pows[idx]->data<T>()[0];
+    T beta2_p = beta2_pows[idx]->data<T>()[0];
+    AdamArgs& arg = args[idx];
+    arg.old_lr = learning_rate->data<T>()[0];
+    arg.lr = -arg.old_lr * (sqrt(1 - beta2_p) / (1 - beta1_p));
+    arg.eps = epsilon * sqrt(1 - beta2_p);
+    arg.grad = grads[idx]->data<T>();
+    arg.mom1 = moments1[idx]->data<T>();
+    arg.mom2 = moments2[idx]->data<T>();
+    arg.param = params[idx]->data<T>();
+    arg.mom1_out = dev_ctx.template Alloc<T>(moments1_out[idx]);
+    arg.mom2_out = dev_ctx.template Alloc<T>(moments2_out[idx]);
+    arg.param_out = dev_ctx.template Alloc<T>(params_out[idx]);
+    if (!use_global_beta_pow) {
+      dev_ctx.template Alloc<T>(beta1_pows_out[idx])[0] = beta1 * beta1_p;
+      dev_ctx.template Alloc<T>(beta2_pows_out[idx])[0] = beta2 * beta2_p;
+    }
+  }
+
+  std::vector<int64_t> numels = funcs::TensorNumels(params);
+  if (use_adamw) {
+    auto adamw = phi::jit::KernelFuncs<phi::jit::AdamWTuple<T>,
+                                       phi::CPUPlace>::Cache()
+                     .At(1);
+    funcs::CPUMultiTensorApply(
+        numels, [&](size_t idx, int64_t offset, int64_t numel) {
+          const AdamArgs& arg = args[idx];
+          adamw(beta1,
+                beta2,
+                arg.lr,
+                arg.eps,
+                arg.old_lr,
+                lr_ratio,
+                coeff,
+                numel,
+                arg.grad + offset,
+                arg.mom1 + offset,
+                arg.mom2 + offset,
+                arg.param + offset,
+                arg.mom1_out + offset,
+                arg.mom2_out + offset,
+                arg.param_out + offset);
+        });
+  } else {
+    auto adam =
+        phi::jit::KernelFuncs<phi::jit::AdamTuple<T>, phi::CPUPlace>::Cache()
+            .At(phi::jit::adam_attr_t(beta1, beta2));
+    funcs::CPUMultiTensorApply(
+        numels, [&](size_t idx, int64_t offset, int64_t numel) {
+          const AdamArgs& arg = args[idx];
+          adam(beta1,
+               beta2,
+               arg.lr,
+               arg.eps,
+               numel,
+               arg.grad + offset,
+               arg.mom1 + offset,
+               arg.mom2 + offset,
+               arg.param + offset,
+               arg.mom1_out + offset,
+               arg.mom2_out + offset,
+               arg.param_out + offset);
+        });
+  }
+}
+
+}  // namespace phi
@@ -0,0 +1,130 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "paddle/phi/core/dense_tensor.h"
+
+namespace phi {
+namespace funcs {
+
+// The cpu counterpart of multi_tensor_apply.h, for the optimizers updating
+// many parameters in one kernel. Every tensor is split into chunks of
+// kCPUMultiTensorChunkSize elements from its beginning, like the single
+// tensor kernels, so the results are the same. The chunks of all the tensors
+// are grouped in order into work items of about the same number of
+// elements, which are run by the OpenMP threads. Small tensors share a work
+// item and a large one spans many.
+constexpr int64_t kCPUMultiTensorChunkSize = 512;
+
+struct CPUTensorChunk {
+  size_t tensor_id;
+  int64_t offset;
+  int64_t numel;
+};
+
+class CPUMultiTensorChunks {
+ public:
+  explicit CPUMultiTensorChunks(const std::vector<int64_t> &numels) {
+    int64_t total_numel = 0;
+    for (size_t i = 0; i < numels.size(); ++i) {
+      for (int64_t offset = 0; offset < numels[i];
+           offset += kCPUMultiTensorChunkSize) {
+        chunks_.push_back(CPUTensorChunk{
+            i,
+            offset,
+            std::min(kCPUMultiTensorChunkSize, numels[i] - offset)});
+      }
+      total_numel += numels[i];
+    }
+
+#ifdef PADDLE_WITH_MKLML
+    int64_t num_threads = std::max(omp_get_max_threads(), 1);
+#else
+    int64_t num_threads = 1;
+#endif
+    // A few work items per thread to balance them, of at least a chunk and
+    // small enough for their inputs to stay in the cache.
+    int64_t work_numel = total_numel / (num_threads * 4);
+    work_numel = std::max(work_numel, kCPUMultiTensorChunkSize);
+    work_numel = std::min(work_numel, kMaxWorkNumel);
+
+    work_begins_.push_back(0);
+    int64_t numel = 0;
+    for (size_t i = 0; i < chunks_.size(); ++i) {
+      numel += chunks_[i].numel;
+      if (numel >= work_numel) {
+        work_begins_.push_back(i + 1);
+        numel = 0;
+      }
+    }
+    if (work_begins_.back() != chunks_.size()) {
+      work_begins_.push_back(chunks_.size());
+    }
+  }
+
+  int64_t num_works() const {
+    return static_cast<int64_t>(work_begins_.size()) - 1;
+  }
+
+  // Calls functor(tensor_id, offset, numel) for every chunk of the work item
+  template <typename Functor>
+  void RunWork(int64_t work_id, const Functor &functor) const {
+    for (size_t i = work_begins_[work_id]; i < work_begins_[work_id + 1];
+         ++i) {
+      functor(chunks_[i].tensor_id, chunks_[i].offset, chunks_[i].numel);
+    }
+  }
+
+ private:
+  static constexpr int64_t kMaxWorkNumel = 64 * 1024;
+
+  std::vector<CPUTensorChunk> chunks_;
+  std::vector<size_t> work_begins_;
+};
+
+// Calls functor(tensor_id, offset, numel) for every chunk of the tensors of
+// numels, on the OpenMP threads.
+template <typename Functor>
+void CPUMultiTensorApply(const std::vector<int64_t> &numels,
+                         const Functor &functor) {
+  CPUMultiTensorChunks chunks(numels);
+  int64_t num_works = chunks.num_works();
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for schedule(dynamic) if (num_works > 1)
+#endif
+  for (int64_t i = 0; i < num_works; ++i) {
+    chunks.RunWork(i, functor);
+  }
+}
+
+inline std::vector<int64_t> TensorNumels(
+    const std::vector<const DenseTensor *> &tensors) {
+  std::vector<int64_t> numels;
+  numels.reserve(tensors.size());
+  for (const DenseTensor *tensor : tensors) {
+    numels.push_back(tensor->numel());
+  }
+  return numels;
+}
+
+}  // namespace funcs
+}  // namespace phi
@@ -20,6 +20,7 @@
 #include "paddle/common/macros.h"
 #include "paddle/phi/common/amp_type_traits.h"
 #include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/kernels/funcs/cpu_multi_tensor_apply.h"
 #include "paddle/phi/kernels/funcs/for_range.h"
 #include "paddle/phi/kernels/impl/momentum_kernel_impl.h"
 #include "paddle/phi/kernels/merged_momentum_kernel.h"
@@ -85,6 +86,87 @@ struct MergedMomentumKernelParam
   }
 };
 
+// Updates all the params in one multi tensor apply on cpu, where a kernel
+// for each param or a loop over all the params for each element is slow.
+template <typename MT, typename MPType, typename T>
+void CPUMergedMomentum(
+    const std::vector<const DenseTensor *> &params,
+    const std::vector<const DenseTensor *> &grads,
+    const std::vector<const DenseTensor *> &lrs,
+    const paddle::optional<std::vector<const DenseTensor *>> &master_params_opt,
+    float mu,
+    bool use_nesterov,
+    const std::vector<std::string> &regularization_methods,
+    const std::vector<float> &regularization_coeffs,
+    float rescale_grad,
+    const bool multi_precision,
+    const std::vector<DenseTensor *> &params_out,
+    const std::vector<DenseTensor *> &velocities_out,
+    const std::vector<DenseTensor *> &master_params_out) {
+  struct MomentumArgs {
+    MT lr;
+    bool l2_decay;
+    MT regularization_coeff;
+    const T *grad;
+    const MT *master_param;
+    T *param_out;
+    MT *velocity_out;
+    MT *master_param_out;
+  };
+  size_t n = params.size();
+  std::vector<MomentumArgs> args(n);
+  for (size_t idx = 0; idx < n; ++idx) {
+    MomentumArgs &arg = args[idx];
+    arg.lr = static_cast<MT>(
+        (lrs.size() > 1 ? lrs[idx] : lrs[0])->data<MPType>()[0]);
+    arg.l2_decay = regularization_methods.size() > 0 &&
+                   regularization_methods[idx] == "l2_decay";
+    arg.regularization_coeff =
+        arg.l2_decay ? static_cast<MT>(regularization_coeffs[idx])
+                     : static_cast<MT>(0.0);
+    arg.grad = grads[idx]->data<T>();
+    // The params and velocities are updated in place.
+    arg.param_out = params_out[idx]->data<T>();
+    arg.velocity_out = velocities_out[idx]->data<MT>();
+    arg.master_param =
+        multi_precision ? master_params_opt.get()[idx]->data<MT>() : nullptr;
+    arg.master_param_out =
+        multi_precision ? master_params_out[idx]->data<MT>() : nullptr;
+  }
+
+  const MT mu_ = static_cast<MT>(mu);
+  // Like the per param kernels this replaces, only the path of a single lr
+  // without nesterov or regularization rescales the grads. The momentum
+  // kernel on cpu never does, and merged_momentum agrees with it elsewhere.
+  const bool use_rescale_grad = lrs.size() == 1 && use_nesterov == false &&
+                                regularization_methods.size() == 0;
+  const MT rescale_grad_ =
+      static_cast<MT>(use_rescale_grad ? rescale_grad : 1.0f);
+  funcs::CPUMultiTensorApply(
+      funcs::TensorNumels(params),
+      [&](size_t idx, int64_t offset, int64_t numel) {
+        const MomentumArgs &arg = args[idx];
+        for (int64_t i = offset; i < offset + numel; ++i) {
+          const MT param = arg.master_param
+                               ? arg.master_param[i]
+                               : static_cast<MT>(arg.param_out[i]);
+          MT grad = static_cast<MT>(arg.grad[i]) * rescale_grad_;
+          if (arg.l2_decay) {
+            grad += arg.regularization_coeff * param;
+          }
+          const MT velocity_out = arg.velocity_out[i] * mu_ + grad;
+          const MT param_out =
+              use_nesterov ? param - (grad + velocity_out * mu_) * arg.lr
+                           : param - arg.lr * velocity_out;
+          arg.velocity_out[i] = velocity_out;
+          arg.param_out[i] = static_cast<T>(param_out);
+          if (arg.master_param_out) {
+            arg.master_param_out[i] = param_out;
+          }
+        }
+      });
+}
+
 template <typename MT, typename Context, typename MPType, typename T>
 void MergedMomentumInnerCompute(
     const Context &ctx,
@@ -229,6 +311,24 @@ void MergedMomentumInnerCompute(
           << ",  regularization_coeffs.size(): "
           << regularization_coeffs.size();
 
+  if (ctx.GetPlace().GetType() == phi::AllocationType::CPU) {
+    CPUMergedMomentum<MT, MPType, T>(params,
+                                     grads,
+                                     lrs,
+                                     master_params_opt,
+                                     mu,
+                                     use_nesterov,
+                                     regularization_methods,
+                                     regularization_coeffs,
+                                     rescale_grad,
+                                     multi_precision,
+                                     params_out,
+                                     velocities_out,
+                                     master_params_out);
+    VLOG(10) << "Launch MergedMomentum cpu kernel.";
+    return;
+  }
+
   if (lrs.size() == 1 && use_nesterov == false &&
       regularization_methods.size() == 0) {
 #define PADDLE_LAUNCH_MERGED_MOMENTUM_KERNEL(kMultiPrecision)              \
@@ -284,20 +384,7 @@ void MergedMomentumInnerCompute(
           multi_precision ? master_params_opt.get()[idx]->data<MT>() : nullptr;
       MT *master_out_data =
           multi_precision ? master_params_out[idx]->data<MT>() : nullptr;
-      if (ctx.GetPlace().GetType() == phi::AllocationType::CPU) {
-        phi::CPUDenseMomentumFunctor<MT> functor;
-        functor(params[idx],
-                grads[idx],
-                velocities[idx],
-                lr_temp,
-                static_cast<MT>(mu),
-                use_nesterov,
-                regularization_flag,
-                regularization_coeff,
-                params_out[idx],
-                velocities_out[idx]);
-        VLOG(10) << "Launch MergedMomentum cpu kernel.";
-      } else if (ctx.GetPlace().GetType() == phi::AllocationType::GPU) {
+      if (ctx.GetPlace().GetType() == phi::AllocationType::GPU) {
         phi::funcs::ForRange<Context> for_range(
             static_cast<const Context &>(ctx), params[idx]->numel());
         const auto grad_type = grads[idx]->dtype();
@@ -0,0 +1,128 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Vectorized helpers for the ascii part of strings on CPU. They process 16
+// bytes at a time with SSE2 when available, the scalar tails are written
+// branch free so that compilers vectorize them on other targets.
+namespace phi {
+namespace strings {
+
+// Returns whether all the n bytes are ascii.
+inline bool IsAscii(const char* str, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  __m128i acc = _mm_setzero_si128();
+  for (; i + 16 <= n; i += 16) {
+    acc = _mm_or_si128(
+        acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i)));
+  }
+  if (_mm_movemask_epi8(acc) != 0) {
+    return false;
+  }
+#endif
+  uint8_t tail = 0;
+  for (; i < n; ++i) {
+    tail |= static_cast<uint8_t>(str[i]);
+  }
+  return (tail & 0x80) == 0;
+}
+
+// Converts the case of n ascii chars from in to out, bytes which are not
+// [A-Z] (lower) or [a-z] (upper) are copied as is, utf-8 sequences included.
+// in and out may be the same buffer.
+template <bool kToUpper>
+inline void AsciiCaseConvert(const char* in, char* out, size_t n) {
+  constexpr char kFirst = kToUpper ? 'a' : 'A';
+  size_t i = 0;
+#if defined(__SSE2__)
+  // signed compares, bytes >= 0x80 are negative and never in range
+  const __m128i lower_bound = _mm_set1_epi8(kFirst - 1);
+  const __m128i upper_bound = _mm_set1_epi8(kFirst + 26);
+  const __m128i flip = _mm_set1_epi8(0x20);
+  for (; i + 16 <= n; i += 16) {
+    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(chars, lower_bound),
+                                     _mm_cmplt_epi8(chars, upper_bound));
+    chars = _mm_xor_si128(chars, _mm_and_si128(in_range, flip));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), chars);
+  }
+#endif
+  for (; i < n; ++i) {
+    auto c = static_cast<uint8_t>(in[i]);
+    uint8_t in_range = static_cast<uint8_t>(c - kFirst) < 26;
+    out[i] = static_cast<char>(c ^ (in_range << 5));
+  }
+}
+
+// Returns the position of the first byte in [pos, n) which is not ascii, n
+// if there is none.
+inline size_t FindNonAscii(const char* str, size_t pos, size_t n) {
+#if defined(__SSE2__)
+  for (; pos + 16 <= n; pos += 16) {
+    int mask = _mm_movemask_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + pos)));
+    if (mask != 0) {
+      return pos + __builtin_ctz(mask);
+    }
+  }
+#endif
+  for (; pos < n; ++pos) {
+    if (static_cast<uint8_t>(str[pos]) >= 0x80) {
+      break;
+    }
+  }
+  return pos;
+}
+
+inline bool IsAsciiSpace(uint8_t c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// Returns the position of the first byte in [pos, n) which is ascii
+// whitespace or not ascii, n if there is none. Used to skip over the plain
+// ascii part of a word.
+inline size_t FindSpaceOrNonAscii(const char* str, size_t pos, size_t n) {
+#if defined(__SSE2__)
+  // ' ' and '\t'..'\r' are all <= 0x20, and bytes >= 0x80 are negative
+  const __m128i bound = _mm_set1_epi8(0x21);
+  for (; pos + 16 <= n; pos += 16) {
+    __m128i chars =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + pos));
+    int mask = _mm_movemask_epi8(_mm_cmplt_epi8(chars, bound));
+    if (mask != 0) {
+      break;
+    }
+  }
+#endif
+  for (; pos < n; ++pos) {
+    auto c = static_cast<uint8_t>(str[pos]);
+    if (c >= 0x80 || IsAsciiSpace(c)) {
+      break;
+    }
+  }
+  return pos;
+}
+
+}  // namespace strings
+}  // namespace phi
@@ -29,12 +29,14 @@ namespace strings {
 
 using pstring = dtype::pstring;
 struct AsciiToLower {
+  static constexpr bool kToUpper = false;
   HOSTDEVICE char operator()(char in) const {
     return ('A' <= in && in <= 'Z') ? in - ('Z' - 'z') : in;
   }
 };
 
 struct AsciiToUpper {
+  static constexpr bool kToUpper = true;
   HOSTDEVICE char operator()(char in) const {
     return ('a' <= in && in <= 'z') ? in ^ 0x20 : in;
   }
@@ -42,6 +44,7 @@ struct AsciiToUpper {
 
 template <typename Context>
 struct UTF8ToLower {
+  static constexpr bool kToUpper = false;
   HOSTDEVICE UTF8ToLower(const uint8_t* unicode_flag_map,
                          const uint16_t* cases_map)
       : unicode_flag_map_(unicode_flag_map), cases_map_(cases_map) {}
@@ -57,6 +60,7 @@ struct UTF8ToLower {
 
 template <typename Context>
 struct UTF8ToUpper {
+  static constexpr bool kToUpper = true;
   HOSTDEVICE UTF8ToUpper(const uint8_t* unicode_flag_map,
                          const uint16_t* cases_map)
       : unicode_flag_map_(unicode_flag_map), cases_map_(cases_map) {}
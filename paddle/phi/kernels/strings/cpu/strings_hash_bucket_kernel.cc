@@ -0,0 +1,59 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/strings/strings_hash_bucket_kernel.h"
+
+extern "C" {
+#include <xxhash.h>
+}
+
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/enforce.h"
+#include "paddle/phi/core/kernel_registry.h"
+
+using pstring = ::phi::dtype::pstring;
+
+namespace phi::strings {
+
+template <typename ContextT>
+void StringToHashBucketKernel(const ContextT& dev_ctx,
+                              const StringTensor& x,
+                              int64_t num_buckets,
+                              int64_t seed,
+                              DenseTensor* out) {
+  PADDLE_ENFORCE_GT(num_buckets,
+                    0,
+                    phi::errors::InvalidArgument(
+                        "The num_buckets of strings_to_hash_bucket must be "
+                        "greater than 0, but received %d.",
+                        num_buckets));
+  const pstring* in_ptr = x.data();
+  out->Resize(x.dims());
+  int64_t* out_ptr = dev_ctx.template Alloc<int64_t>(out);
+  auto num = x.numel();
+  auto buckets = static_cast<uint64_t>(num_buckets);
+  for (int64_t i = 0; i < num; ++i) {
+    uint64_t hash = XXH64(
+        in_ptr[i].data(), in_ptr[i].size(), static_cast<uint64_t>(seed));
+    out_ptr[i] = static_cast<int64_t>(hash % buckets);
+  }
+}
+
+}  // namespace phi::strings
+
+PD_REGISTER_KERNEL_FOR_ALL_DTYPE(
+    strings_to_hash_bucket,
+    CPU,
+    ALL_LAYOUT,
+    phi::strings::StringToHashBucketKernel<phi::CPUContext>) {}
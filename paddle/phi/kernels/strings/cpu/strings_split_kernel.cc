@@ -0,0 +1,133 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/phi/kernels/strings/strings_split_kernel.h"
+
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/kernel_registry.h"
+#include "paddle/phi/kernels/strings/ascii_utils.h"
+#include "paddle/phi/kernels/strings/strings_lower_upper_kernel.h"
+#include "paddle/phi/kernels/strings/unicode.h"
+
+using pstring = ::phi::dtype::pstring;
+
+namespace phi::strings {
+
+namespace {
+
+// Returns the end of the token starting at pos, the ascii part of a token is
+// skipped 16 bytes at a time and only non ascii chars are decoded.
+size_t FindTokenEnd(const char* str,
+                    size_t pos,
+                    size_t size,
+                    const uint8_t* unicode_flag_map) {
+  while (pos < size) {
+    pos = FindSpaceOrNonAscii(str, pos, size);
+    if (pos >= size || static_cast<uint8_t>(str[pos]) < 0x80) {
+      break;
+    }
+    // non ascii char, whitespace only if utf-8 is enabled
+    uint32_t bytes = BytesInUtf8Char(static_cast<uint8_t>(str[pos]));
+    if (unicode_flag_map != nullptr && bytes > 1 && pos + bytes <= size) {
+      uint32_t utf8 = 0;
+      UTF8ToUInt32(str + pos, &utf8);
+      uint32_t unicode = UTF8ToUnicode(utf8);
+      if (unicode <= 0xFFFF && IsSpace(unicode_flag_map[unicode])) {
+        break;
+      }
+    }
+    // an invalid or truncated sequence is taken as a single byte, so pos
+    // never goes past the end
+    pos += bytes > 1 && pos + bytes <= size ? bytes : 1;
+  }
+  return pos;
+}
+
+// Returns the size of the whitespace starting at pos, 0 if there is none.
+size_t SpaceSize(const char* str,
+                 size_t pos,
+                 size_t size,
+                 const uint8_t* unicode_flag_map) {
+  auto c = static_cast<uint8_t>(str[pos]);
+  if (c < 0x80) {
+    return IsAsciiSpace(c) ? 1 : 0;
+  }
+  if (unicode_flag_map == nullptr) {
+    return 0;
+  }
+  uint32_t bytes = BytesInUtf8Char(c);
+  if (bytes <= 1 || pos + bytes > size) {
+    return 0;
+  }
+  uint32_t utf8 = 0;
+  UTF8ToUInt32(str + pos, &utf8);
+  uint32_t unicode = UTF8ToUnicode(utf8);
+  return unicode <= 0xFFFF && IsSpace(unicode_flag_map[unicode]) ? bytes : 0;
+}
+
+}  // namespace
+
+template <typename ContextT>
+void StringSplitKernel(const ContextT& dev_ctx,
+                       const StringTensor& x,
+                       int max_tokens,
+                       bool lower_case,
+                       bool use_utf8_encoding,
+                       StringTensor* out) {
+  const pstring* in_ptr = x.data();
+  pstring* out_ptr = dev_ctx.template Alloc<pstring>(out);
+  const uint8_t* unicode_flag_map =
+      use_utf8_encoding ? GetUniFlagMap() : nullptr;
+  auto num = x.numel();
+  for (int64_t i = 0; i < num; ++i) {
+    const char* str = in_ptr[i].data();
+    size_t size = in_ptr[i].size();
+    pstring* tokens = out_ptr + i * max_tokens;
+    int count = 0;
+    size_t pos = 0;
+    while (pos < size && count < max_tokens) {
+      size_t space = SpaceSize(str, pos, size, unicode_flag_map);
+      if (space > 0) {
+        pos += space;
+        continue;
+      }
+      size_t end = FindTokenEnd(str, pos, size, unicode_flag_map);
+      tokens[count++].assign(str + pos, end - pos);
+      pos = end;
+    }
+    for (int j = count; j < max_tokens; ++j) {
+      tokens[j].clear();
+    }
+  }
+
+  if (lower_case) {
+    // the tokens are converted in place
+    auto total = static_cast<size_t>(num * max_tokens);
+    if (use_utf8_encoding) {
+      UTF8CaseConverter<ContextT, UTF8ToLower>()(
+          dev_ctx, out_ptr, out_ptr, total);
+    } else {
+      AsciiCaseConverter<ContextT, AsciiToLower>()(
+          dev_ctx, out_ptr, out_ptr, total);
+    }
+  }
+}
+
+}  // namespace phi::strings
+
+PD_REGISTER_KERNEL_FOR_ALL_DTYPE(
+    strings_split,
+    CPU,
+    ALL_LAYOUT,
+    phi::strings::StringSplitKernel<phi::CPUContext>) {}
@@ -0,0 +1,46 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/dense_tensor.h"
+#include "paddle/phi/core/string_tensor.h"
+#include "paddle/phi/infermeta/strings/unary.h"
+
+namespace phi {
+namespace strings {
+
+// Maps every string of x to XXH64(string, seed) % num_buckets, the feature
+// hashing of raw strings without materializing any intermediate tensor.
+template <typename ContextT>
+void StringToHashBucketKernel(const ContextT& dev_ctx,
+                              const StringTensor& x,
+                              int64_t num_buckets,
+                              int64_t seed,
+                              DenseTensor* out);
+
+template <typename ContextT>
+DenseTensor StringToHashBucket(const ContextT& dev_ctx,
+                               const StringTensor& x,
+                               int64_t num_buckets,
+                               int64_t seed = 0) {
+  DenseTensor dense_out;
+  MetaTensor meta_out(&dense_out);
+  HashBucketInferMeta(x, &meta_out);
+  StringToHashBucketKernel(dev_ctx, x, num_buckets, seed, &dense_out);
+  return dense_out;
+}
+
+}  // namespace strings
+}  // namespace phi
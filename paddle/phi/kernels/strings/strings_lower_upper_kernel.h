@@ -19,6 +19,7 @@ limitations under the License. */
 #include "paddle/phi/api/lib/utils/allocator.h"
 #include "paddle/phi/core/string_tensor.h"
 #include "paddle/phi/infermeta/strings/unary.h"
+#include "paddle/phi/kernels/strings/ascii_utils.h"
 #include "paddle/phi/kernels/strings/case_utils.h"
 
 using pstring = ::phi::dtype::pstring;
@@ -86,8 +87,9 @@ struct AsciiCaseConverter {
                   pstring* out,
                   size_t num) const {
     for (size_t i = 0; i < num; ++i) {
-      std::transform(
-          in[i].begin(), in[i].end(), out[i].mdata(), CharConverter());
+      out[i].resize_uninitialized(in[i].size());
+      AsciiCaseConvert<CharConverter::kToUpper>(
+          in[i].data(), out[i].mdata(), in[i].size());
     }
   }
 };
@@ -100,20 +102,44 @@ struct UTF8CaseConverter {
                   const pstring* in,
                   pstring* out,
                   size_t num) const {
+    using Converter = CharConverter<DeviceContext>;
     auto unicode_flag_map = GetUniFlagMap();
     auto cases_map = GetCharCasesMap();
+    Converter converter(unicode_flag_map, cases_map);
+    // a converted char takes at most 3 bytes and its source at least 1
+    std::vector<char> result;
     for (size_t i = 0; i < num; ++i) {
-      uint32_t unicode_len = GetUnicodeStrLen(in[i].data(), in[i].size());
-      std::vector<uint32_t> unicode_in(unicode_len, 0);
-      GetUnicodeStr(in[i].data(), unicode_in.data(), unicode_len);
-      std::transform(unicode_in.begin(),
-                     unicode_in.end(),
-                     unicode_in.begin(),
-                     CharConverter<DeviceContext>(unicode_flag_map, cases_map));
-      uint32_t utf8_len = GetUTF8StrLen(unicode_in.data(), unicode_len);
-      std::vector<char> result(utf8_len, 0);
-      GetUTF8Str(unicode_in.data(), result.data(), unicode_len);
-      out[i] = result.data();
+      const char* src = in[i].data();
+      size_t size = in[i].size();
+      if (IsAscii(src, size)) {
+        out[i].resize_uninitialized(size);
+        AsciiCaseConvert<Converter::kToUpper>(src, out[i].mdata(), size);
+        continue;
+      }
+      result.resize(size * 3);
+      char* dst = result.data();
+      for (size_t pos = 0; pos < size;) {
+        size_t ascii_end = FindNonAscii(src, pos, size);
+        if (ascii_end > pos) {
+          AsciiCaseConvert<Converter::kToUpper>(
+              src + pos, dst, ascii_end - pos);
+          dst += ascii_end - pos;
+          pos = ascii_end;
+          continue;
+        }
+        uint32_t bytes = BytesInUtf8Char(static_cast<uint8_t>(src[pos]));
+        if (bytes == 0 || pos + bytes > size) {
+          // invalid or truncated sequence, kept as is
+          *dst++ = src[pos++];
+          continue;
+        }
+        uint32_t utf8 = 0;
+        UTF8ToUInt32(src + pos, &utf8);
+        uint32_t unicode = converter(UTF8ToUnicode(utf8));
+        dst += UnicodeToUTF8Char(UnicodeToUTF8(unicode), dst);
+        pos += bytes;
+      }
+      out[i].assign(result.data(), dst - result.data());
     }
   }
 };
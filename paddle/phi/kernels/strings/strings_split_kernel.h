@@ -0,0 +1,50 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include "paddle/phi/core/string_tensor.h"
+#include "paddle/phi/infermeta/strings/unary.h"
+
+namespace phi {
+namespace strings {
+
+// Splits every string of x on whitespace (unicode whitespace if
+// use_utf8_encoding) into its first max_tokens tokens, optionally lower
+// cased. out has the shape of x plus a last dimension of max_tokens, missing
+// tokens are empty strings.
+template <typename ContextT>
+void StringSplitKernel(const ContextT& dev_ctx,
+                       const StringTensor& x,
+                       int max_tokens,
+                       bool lower_case,
+                       bool use_utf8_encoding,
+                       StringTensor* out);
+
+template <typename ContextT>
+StringTensor StringSplit(const ContextT& dev_ctx,
+                         const StringTensor& x,
+                         int max_tokens,
+                         bool lower_case,
+                         bool use_utf8_encoding) {
+  StringTensor string_out;
+  MetaTensor meta_out(&string_out);
+  SplitInferMeta(x, max_tokens, &meta_out);
+  StringSplitKernel(
+      dev_ctx, x, max_tokens, lower_case, use_utf8_encoding, &string_out);
+  return string_out;
+}
+
+}  // namespace strings
+}  // namespace phi
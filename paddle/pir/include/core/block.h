@@ -41,6 +41,11 @@ class IR_API Block {
   Block() = default;
   ~Block();
 
+  // The blocks share the free lists of the operations, as they are created
+  // and erased with them.
+  static void *operator new(std::size_t size);
+  static void operator delete(void *ptr, std::size_t size);
+
   Region *GetParent() const { return parent_; }
   Operation *GetParentOp() const;
 
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <memory>
 #include <type_traits>
 #include <unordered_map>
@@ -25,8 +27,7 @@ namespace pir {
 ///
 /// \brief The implementation of the class StorageManager.
 ///
-// struct StorageManagerImpl;
-struct ParametricStorageManager;
+struct StorageManagerImpl;
 
 ///
 /// \brief A utility class for getting or creating Storage class instances.
@@ -40,13 +41,25 @@ struct ParametricStorageManager;
 /// provide method 'bool operator==(const ParamKey &) const', used to compare
 /// Storage instance and ParamKey instance.
 ///
+/// The instances are kept in hash-partitioned shards. Looking up an existing
+/// instance takes no lock, only creating a new one locks its shard, and the
+/// instances are allocated from the arenas of the shards.
+///
 class IR_API StorageManager {
  public:
   ///
   /// \brief This class is the base class of all storage classes,
   /// and any type of storage needs to inherit from this class.
   ///
-  class StorageBase {
+  class IR_API StorageBase {
+   public:
+    ///
+    /// \brief The storages created by a StorageManager are allocated from
+    /// its arena, and their memory is released all at once with it.
+    ///
+    static void *operator new(std::size_t size);
+    static void operator delete(void *ptr);
+
    protected:
     StorageBase() = default;
   };
@@ -137,16 +150,7 @@ class IR_API StorageManager {
   void RegisterParameterlessStorageImpl(
       TypeId type_id, std::function<StorageBase *()> constructor);
 
-  // This map is a mapping between type id and parametric type storage.
-  std::unordered_map<TypeId, std::unique_ptr<ParametricStorageManager>>
-      parametric_instance_;
-
-  pir::SpinLock parametric_instance_lock_;
-
-  // This map is a mapping between type id and parameterless type storage.
-  std::unordered_map<TypeId, StorageBase *> parameterless_instance_;
-
-  pir::SpinLock parameterless_instance_lock_;
+  std::unique_ptr<StorageManagerImpl> impl_;
 };
 
 }  // namespace pir
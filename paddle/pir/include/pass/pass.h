@@ -16,6 +16,9 @@
 
 #include <any>
 #include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -32,6 +35,7 @@ class Operation;
 
 namespace detail {
 class PassAdaptor;
+class PatternRewritePassCopy;
 }
 
 namespace detail {
@@ -88,6 +92,14 @@ class IR_API Pass {
 
   const detail::PassInfo& pass_info() const { return pass_info_; }
 
+  // Returns a copy of the pass, with the state set by its constructor and
+  // setters, for another thread of a parallel PassManager to run. Returns
+  // nullptr by default, which keeps the pipeline sequential. A pass only
+  // returns a copy if it rewrites nothing outside the op it runs on, e.g.
+  // constant folding inserts into the enclosing block, so it can't. The
+  // attributes set with Set are shared with the copy by the PassManager.
+  virtual std::unique_ptr<Pass> Clone() const { return nullptr; }
+
   // Get a reference to the attributed previously set.
   template <typename AttrType>
   AttrType& Get(const std::string& attr_name) const {
@@ -189,6 +201,7 @@ class IR_API Pass {
 
   friend class PassManager;
   friend class detail::PassAdaptor;
+  friend class CombinedPatternRewritePass;
 
   std::unordered_map<std::string, std::any> attrs_;
   std::unordered_map<std::string, std::function<void(void)>> attr_dels_;
@@ -201,6 +214,13 @@ class IR_API PatternRewritePass : public Pass {
                      const std::vector<std::string>& dependents = {})
       : Pass(name, opt_level, dependents) {}
 
+  // A copy which shares the patterns and the config of this pass once it
+  // is initialized, so the patterns must be safe to apply on several
+  // threads at once. The copy changes nothing outside the op it runs on;
+  // the ops outside erased by the patterns are erased after the copies
+  // have run.
+  std::unique_ptr<Pass> Clone() const override;
+
  protected:
   virtual RewritePatternSet InitializePatterns(IrContext* context) = 0;
 
@@ -214,6 +234,69 @@ class IR_API PatternRewritePass : public Pass {
   FrozenRewritePatternSet patterns_;
 
   GreedyRewriteConfig config_;
+
+  friend class CombinedPatternRewritePass;
+  friend class detail::PatternRewritePassCopy;
+};
+
+/// Applies the patterns of several PatternRewritePasses in one change driven
+/// traversal, instead of one traversal per pass. The patterns are indexed by
+/// their root ops, and tried in the order of their benefits, then in the
+/// order of the passes. So it only fits the passes whose patterns don't rely
+/// on all the rewrites of the passes before them being done.
+///
+/// The passes are configured, e.g. with Set, before they are combined. On an
+/// op, only the patterns of the passes which can apply on it are used.
+/// Their rewrite configs must agree on the traversal order, the strictness
+/// and the rewrite limit, which is checked when they are combined; the most
+/// iterations of them are allowed.
+class IR_API CombinedPatternRewritePass : public Pass {
+ public:
+  explicit CombinedPatternRewritePass(
+      std::vector<std::unique_ptr<Pass>>&& passes);
+
+  // A copy which combines the passes of this one, if all of them can be
+  // copied. It changes nothing outside the op it runs on, as the copies of
+  // PatternRewritePass.
+  std::unique_ptr<Pass> Clone() const override;
+
+ protected:
+  bool Initialize(IrContext* context) override;
+
+  void Run(Operation* op) override;
+
+  bool CanApplyOn(Operation* op) const override;
+
+ private:
+  explicit CombinedPatternRewritePass(const CombinedPatternRewritePass* origin);
+
+  const std::vector<std::unique_ptr<Pass>>& passes() const {
+    return origin_ ? origin_->passes_ : passes_;
+  }
+
+  // The patterns of the passes which can apply on the op.
+  const FrozenRewritePatternSet& GetPatterns(Operation* op);
+
+  std::vector<std::unique_ptr<Pass>> passes_;
+
+  // The pass copied, whose passes are used.
+  const CombinedPatternRewritePass* origin_{nullptr};
+
+  // The ops outside the ops a copy ran on, which its patterns erased.
+  std::vector<Operation*> ops_erased_outside_;
+
+  GreedyRewriteConfig config_;
+
+  // Guards the InitializePatterns of the passes, shared by the copies.
+  mutable std::mutex passes_mutex_;
+
+  IrContext* context_{nullptr};
+
+  // The patterns of each subset of the passes, keyed by whether every pass
+  // is in the subset.
+  std::map<std::vector<bool>, FrozenRewritePatternSet> patterns_;
+
+  friend class detail::PassAdaptor;
 };
 
 }  // namespace pir
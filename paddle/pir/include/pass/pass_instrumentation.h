@@ -35,7 +35,8 @@ class PassInstrumentation {
   // A callback to run before a pass pipeline is executed.
   virtual void RunBeforePipeline(Operation* op) {}
 
-  // A callback to run after a pass pipeline is executed.
+  // A callback to run after a pass pipeline is executed, including the
+  // pipelines of the ops nested in op.
   virtual void RunAfterPipeline(Operation* op) {}
 
   // A callback to run before a pass is executed.
@@ -115,6 +115,17 @@ class IR_API PassManager {
 
   void AddInstrumentation(std::unique_ptr<PassInstrumentation> pi);
 
+  // Runs the pipelines of the sibling ops with regions (if, while,
+  // cinn_op.group, etc.) on num_threads threads, 0 for all the cores. Two ops
+  // run concurrently only if they don't use the same value from above, so
+  // that their rewrites never touch the same use list. Every thread runs its
+  // own copies of the passes made by Pass::Clone, so if any pass can't be
+  // copied, e.g. one inserting into the enclosing block, the ops run in
+  // turn. IR printing also keeps the pipeline sequential.
+  void EnableParallel(int num_threads = 0);
+
+  int num_threads() const { return num_threads_; }
+
  private:
   bool Initialize(IrContext *context);
 
@@ -129,6 +140,10 @@ class IR_API PassManager {
 
   bool disable_log_{false};
 
+  int num_threads_{1};
+
+  bool ir_printing_{false};
+
   std::vector<std::unique_ptr<Pass>> passes_;
 
   std::unique_ptr<Pass> pass_adaptor_;
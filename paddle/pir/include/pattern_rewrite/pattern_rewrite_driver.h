@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <vector>
+
 #include "paddle/pir/include/core/dll_decl.h"
 #include "paddle/pir/include/core/region.h"
 
@@ -57,6 +59,18 @@ class IR_API GreedyRewriteConfig {
   /// - ExistingOps: only pre-existing ops are added to the worklist.
   GreedyRewriteStrictness strict_mode = GreedyRewriteStrictness::AnyOp;
 
+  /// Traverse the region only once, afterwards only the ops touched by a
+  /// rewrite, their users and the producers of the erased ops are processed
+  /// again, until no op is left. The work is bounded by `max_iterations`
+  /// traversals of the region.
+  bool use_change_driven_worklist = false;
+
+  /// If set, the rewrite changes nothing outside `region`: the ops outside
+  /// are not added to the worklist, and the ops outside erased by the
+  /// patterns are appended here instead, for the caller to erase. So the
+  /// regions of different ops can be rewritten on different threads.
+  std::vector<Operation*>* ops_erased_outside{nullptr};
+
   static constexpr int64_t kNoLimit = -1;
 };
 
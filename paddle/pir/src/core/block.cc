@@ -20,6 +20,7 @@
 #include "paddle/common/enforce.h"
 #include "paddle/pir/include/core/operation.h"
 #include "paddle/pir/include/core/region.h"
+#include "paddle/pir/src/core/ir_allocator.h"
 
 namespace pir {
 Block::~Block() {  // NOLINT
@@ -33,6 +34,15 @@ Block::~Block() {  // NOLINT
   ClearKwargs();
   ClearArgs();
 }
+
+void *Block::operator new(std::size_t size) {
+  return detail::IrAllocate(size);
+}
+
+void Block::operator delete(void *ptr, std::size_t size) {
+  detail::IrDeallocate(ptr, size);
+}
+
 void Block::push_back(Operation *op) { insert(ops_.end(), op); }
 
 void Block::push_front(Operation *op) { insert(ops_.begin(), op); }
@@ -17,6 +17,7 @@
 #include "paddle/pir/include/core/block_argument.h"
 #include "paddle/pir/include/core/builtin_attribute.h"
 #include "paddle/pir/include/core/operation_utils.h"
+#include "paddle/pir/src/core/ir_allocator.h"
 #include "paddle/pir/src/core/value_impl.h"
 
 #include "paddle/common/enforce.h"
@@ -53,6 +54,11 @@ class BlockArgumentImpl : public ValueImpl {
     attributes_[key] = value;
   }
 
+  static void *operator new(std::size_t size) { return IrAllocate(size); }
+  static void operator delete(void *ptr, std::size_t size) {
+    IrDeallocate(ptr, size);
+  }
+
  private:
   BlockArgumentImpl(Type type, Block *owner, uint32_t index)
       : ValueImpl(type, BLOCK_ARG_IDX),
@@ -0,0 +1,209 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/pir/src/core/ir_allocator.h"
+
+#include <mutex>
+
+#include "paddle/common/enforce.h"
+#include "paddle/pir/include/core/spin_lock.h"
+#include "paddle/pir/include/core/utils.h"
+
+namespace pir {
+namespace detail {
+namespace {
+constexpr size_t kAlignment = 16;
+constexpr size_t kMaxPooledSize = 2048;
+constexpr size_t kNumSizeClasses = kMaxPooledSize / kAlignment;
+constexpr size_t kChunkSize = 256 * 1024;
+// The number of blocks a thread fetches from or returns to the shared lists
+// at once.
+constexpr size_t kBatchSize = 32;
+
+struct FreeBlock {
+  FreeBlock *next;
+};
+
+size_t SizeClass(size_t size) { return (size + kAlignment - 1) / kAlignment; }
+
+size_t ClassSize(size_t size_class) { return size_class * kAlignment; }
+
+// The free lists shared by all threads, and the chunks the blocks are carved
+// from. The chunks are never released, as a block may still be cached by any
+// thread.
+class CentralPool {
+ public:
+  static CentralPool &Instance() {
+    // Never destroyed, the thread caches are flushed into it at thread exit,
+    // which may be after the static objects are destroyed.
+    static CentralPool *pool = new CentralPool();
+    return *pool;
+  }
+
+  // Returns a list of up to kBatchSize blocks of the size class, and the
+  // number of blocks in it.
+  size_t Fetch(size_t size_class, FreeBlock **list) {
+    std::lock_guard<pir::SpinLock> guard(lock_);
+    FreeBlock *head = nullptr;
+    size_t count = 0;
+    for (; count < kBatchSize && free_lists_[size_class]; ++count) {
+      FreeBlock *block = free_lists_[size_class];
+      free_lists_[size_class] = block->next;
+      block->next = head;
+      head = block;
+    }
+    size_t block_size = ClassSize(size_class);
+    for (; count < kBatchSize; ++count) {
+      if (static_cast<size_t>(chunk_end_ - chunk_cur_) < block_size) {
+        NewChunk();
+      }
+      auto *block = reinterpret_cast<FreeBlock *>(chunk_cur_);
+      chunk_cur_ += block_size;
+      block->next = head;
+      head = block;
+    }
+    *list = head;
+    return count;
+  }
+
+  void Release(size_t size_class, FreeBlock *head, FreeBlock *tail) {
+    std::lock_guard<pir::SpinLock> guard(lock_);
+    tail->next = free_lists_[size_class];
+    free_lists_[size_class] = head;
+  }
+
+ private:
+  CentralPool() = default;
+
+  // The rest of the last chunk is less than a block, and is left unused.
+  void NewChunk() {
+    chunk_cur_ = static_cast<char *>(aligned_malloc(kChunkSize, kAlignment));
+    PADDLE_ENFORCE_NOT_NULL(
+        chunk_cur_,
+        phi::errors::ResourceExhausted(
+            "Failed to allocate %d bytes for the pir operations.",
+            kChunkSize));
+    chunk_end_ = chunk_cur_ + kChunkSize;
+  }
+
+  pir::SpinLock lock_;
+  FreeBlock *free_lists_[kNumSizeClasses + 1] = {};
+  char *chunk_cur_ = nullptr;
+  char *chunk_end_ = nullptr;
+};
+
+struct FreeList {
+  FreeBlock *head;
+  size_t count;
+};
+
+// The cache is trivially destructible, so it is still usable for the objects
+// freed by the destructors of other thread_locals after it's flushed.
+struct ThreadCache {
+  FreeList lists[kNumSizeClasses + 1];
+  bool flushed;
+};
+
+thread_local ThreadCache thread_cache = {};
+
+struct ThreadCacheFlusher {
+  ~ThreadCacheFlusher() {
+    for (size_t size_class = 1; size_class <= kNumSizeClasses; ++size_class) {
+      FreeList &list = thread_cache.lists[size_class];
+      if (list.head) {
+        FreeBlock *tail = list.head;
+        while (tail->next) tail = tail->next;
+        CentralPool::Instance().Release(size_class, list.head, tail);
+      }
+      list = {nullptr, 0};
+    }
+    thread_cache.flushed = true;
+  }
+};
+
+thread_local ThreadCacheFlusher thread_cache_flusher;
+
+// Uses the flusher so that it's destroyed with the thread, before a thread
+// caches any block.
+void TouchFlusher() { (void)&thread_cache_flusher; }
+}  // namespace
+
+void *IrAllocate(size_t size) {
+  size_t size_class = SizeClass(size);
+#if defined(__SANITIZE_ADDRESS__)
+  // Leave the objects to the sanitizer to check their lifetimes.
+  size_class = kNumSizeClasses + 1;
+#endif
+  if (size_class > kNumSizeClasses || size_class == 0) {
+    void *ptr = aligned_malloc(size, kAlignment);
+    PADDLE_ENFORCE_NOT_NULL(
+        ptr,
+        phi::errors::ResourceExhausted(
+            "Failed to allocate %d bytes for the pir operations.", size));
+    return ptr;
+  }
+  if (thread_cache.flushed) {
+    FreeBlock *list = nullptr;
+    size_t count = CentralPool::Instance().Fetch(size_class, &list);
+    FreeBlock *tail = list;
+    while (tail->next) tail = tail->next;
+    if (count > 1) {
+      CentralPool::Instance().Release(size_class, list->next, tail);
+    }
+    return list;
+  }
+  FreeList &list = thread_cache.lists[size_class];
+  if (!list.head) {
+    TouchFlusher();
+    list.count = CentralPool::Instance().Fetch(size_class, &list.head);
+  }
+  FreeBlock *block = list.head;
+  list.head = block->next;
+  --list.count;
+  return block;
+}
+
+void IrDeallocate(void *ptr, size_t size) {
+  if (!ptr) return;
+  size_t size_class = SizeClass(size);
+#if defined(__SANITIZE_ADDRESS__)
+  size_class = kNumSizeClasses + 1;
+#endif
+  if (size_class > kNumSizeClasses || size_class == 0) {
+    aligned_free(ptr);
+    return;
+  }
+  auto *block = static_cast<FreeBlock *>(ptr);
+  if (thread_cache.flushed) {
+    CentralPool::Instance().Release(size_class, block, block);
+    return;
+  }
+  FreeList &list = thread_cache.lists[size_class];
+  if (!list.head) TouchFlusher();
+  block->next = list.head;
+  list.head = block;
+  // Return a batch to the shared lists, so the blocks freed by one thread can
+  // be reused by the others.
+  if (++list.count > 2 * kBatchSize) {
+    FreeBlock *tail = list.head;
+    for (size_t i = 1; i < kBatchSize; ++i) tail = tail->next;
+    FreeBlock *head = list.head;
+    list.head = tail->next;
+    list.count -= kBatchSize;
+    CentralPool::Instance().Release(size_class, head, tail);
+  }
+}
+
+}  // namespace detail
+}  // namespace pir
@@ -0,0 +1,39 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <cstddef>
+
+#include "paddle/pir/include/core/dll_decl.h"
+
+namespace pir {
+namespace detail {
+///
+/// \brief The allocator of the operations (with their results, operands,
+/// block operands and regions), blocks and block arguments.
+///
+/// The memory is kept in free lists of 16-byte size classes and reused by the
+/// next object of the same class, instead of being returned to malloc. Every
+/// thread caches a few free blocks of each class, and exchanges them with the
+/// shared lists in batches. Objects larger than the biggest size class are
+/// allocated with aligned_malloc.
+///
+IR_API void *IrAllocate(size_t size);
+
+/// Size must be the same as the one the memory was allocated with.
+IR_API void IrDeallocate(void *ptr, size_t size);
+
+}  // namespace detail
+}  // namespace pir
@@ -25,6 +25,7 @@
 #include "paddle/pir/include/core/region.h"
 #include "paddle/pir/include/core/utils.h"
 #include "paddle/pir/src/core/block_operand_impl.h"
+#include "paddle/pir/src/core/ir_allocator.h"
 #include "paddle/pir/src/core/op_result_impl.h"
 
 namespace pir {
@@ -33,6 +34,28 @@ using detail::OpOperandImpl;
 using detail::OpOutlineResultImpl;
 using detail::OpResultImpl;
 
+namespace {
+size_t ResultMemSize(uint32_t num_results) {
+  return num_results > OUTLINE_RESULT_IDX
+             ? sizeof(detail::OpOutlineResultImpl) *
+                       (num_results - OUTLINE_RESULT_IDX) +
+                   sizeof(detail::OpInlineResultImpl) * OUTLINE_RESULT_IDX
+             : sizeof(detail::OpInlineResultImpl) * num_results;
+}
+
+// The memory size of the operation, with its results, operands, block
+// operands and regions.
+size_t OperationMemSize(uint32_t num_results,
+                        uint32_t num_operands,
+                        uint32_t num_regions,
+                        uint32_t num_successors) {
+  return ResultMemSize(num_results) + sizeof(Operation) +
+         sizeof(detail::OpOperandImpl) * num_operands +
+         sizeof(detail::BlockOperandImpl) * num_successors +
+         sizeof(Region) * num_regions;
+}
+}  // namespace
+
 Operation *Operation::Create(OperationArgument &&argument) {
   Operation *op = Create(argument.inputs,
                          argument.attributes,
@@ -63,21 +86,10 @@ Operation *Operation::Create(const std::vector<Value> &inputs,
   uint32_t num_operands = inputs.size();
   uint32_t num_successors = successors.size();
   uint32_t max_inline_result_num = MAX_INLINE_RESULT_IDX + 1;
-  size_t result_mem_size =
-      num_results > max_inline_result_num
-          ? sizeof(detail::OpOutlineResultImpl) *
-                    (num_results - max_inline_result_num) +
-                sizeof(detail::OpInlineResultImpl) * max_inline_result_num
-          : sizeof(detail::OpInlineResultImpl) * num_results;
-  size_t op_mem_size = sizeof(Operation);
-  size_t operand_mem_size = sizeof(detail::OpOperandImpl) * num_operands;
-  size_t block_operand_size = num_successors * sizeof(detail::BlockOperandImpl);
-  size_t region_mem_size = num_regions * sizeof(Region);
-  size_t base_size = result_mem_size + op_mem_size + operand_mem_size +
-                     region_mem_size + block_operand_size;
-  // 2. Malloc memory.
-  char *base_ptr =
-      reinterpret_cast<char *>(detail::aligned_malloc(base_size, 8));
+  size_t base_size = OperationMemSize(
+      num_results, num_operands, num_regions, num_successors);
+  // 2. Allocate memory.
+  char *base_ptr = reinterpret_cast<char *>(detail::IrAllocate(base_size));
 
   auto name = op_info ? op_info.name() : "";
   VLOG(10) << "Create Operation [" << name
@@ -228,17 +240,14 @@ void Operation::Destroy() {
   }
 
   // 7. Free memory.
-  size_t result_mem_size =
-      num_results_ > OUTLINE_RESULT_IDX
-          ? sizeof(detail::OpOutlineResultImpl) *
-                    (num_results_ - OUTLINE_RESULT_IDX) +
-                sizeof(detail::OpInlineResultImpl) * OUTLINE_RESULT_IDX
-          : sizeof(detail::OpInlineResultImpl) * num_results_;
-  void *aligned_ptr = reinterpret_cast<char *>(this) - result_mem_size;
+  void *aligned_ptr = reinterpret_cast<char *>(this) -
+                      ResultMemSize(num_results_);
+  size_t base_size = OperationMemSize(
+      num_results_, num_operands_, num_regions_, num_successors_);
 
   VLOG(10) << "Destroy Operation [" << name() << "]: {ptr = " << aligned_ptr
-           << ", size = " << result_mem_size << "} done.";
-  detail::aligned_free(aligned_ptr);
+           << ", size = " << base_size << "} done.";
+  detail::IrDeallocate(aligned_ptr, base_size);
 }
 
 IrContext *Operation::ir_context() const { return info_.ir_context(); }
@@ -15,60 +15,243 @@
 #include "paddle/pir/include/core/storage_manager.h"
 
 #include <glog/logging.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "paddle/common/enforce.h"
 
 namespace pir {
-// This is a structure for creating, caching, and looking up Storage of
-// parametric types.
-struct ParametricStorageManager {
-  using StorageBase = StorageManager::StorageBase;
+namespace {
+constexpr std::size_t kStorageAlignment = alignof(std::max_align_t);
 
-  explicit ParametricStorageManager(std::function<void(StorageBase *)> destroy)
-      : destroy_(destroy) {}
+// A bump pointer allocator, whose memory is released all at once when it is
+// destroyed.
+class StorageArena {
+ public:
+  StorageArena() = default;
 
-  ~ParametricStorageManager() {  // NOLINT
-    for (const auto &instance : parametric_instances_) {
-      destroy_(instance.second);
+  ~StorageArena() {
+    for (char *block : blocks_) {
+      ::operator delete(block);
     }
-    parametric_instances_.clear();
-  }
-
-  // Get the storage of parametric type, if not in the cache, create and
-  // insert the cache.
-  StorageBase *GetOrCreate(std::size_t hash_value,
-                           std::function<bool(StorageBase *)> equal_func,
-                           std::function<StorageBase *()> constructor) {
-    if (parametric_instances_.count(hash_value) != 0) {
-      auto pr = parametric_instances_.equal_range(hash_value);
-      while (pr.first != pr.second) {
-        if (equal_func(pr.first->second)) {
-          VLOG(10) << "Found a cached parametric storage of: [param_hash="
-                   << hash_value << ", storage_ptr=" << pr.first->second
-                   << "].";
-          return pr.first->second;
-        }
-        ++pr.first;
+  }
+
+  void *Allocate(std::size_t size) {
+    size = (size + kStorageAlignment - 1) & ~(kStorageAlignment - 1);
+    if (size > static_cast<std::size_t>(end_ - cur_)) {
+      std::size_t block_size = std::max(size, kBlockSize);
+      cur_ = static_cast<char *>(::operator new(block_size));
+      end_ = cur_ + block_size;
+      blocks_.push_back(cur_);
+    }
+    void *ptr = cur_;
+    cur_ += size;
+    return ptr;
+  }
+
+ private:
+  static constexpr std::size_t kBlockSize = 16 * 1024;
+
+  std::vector<char *> blocks_;
+  char *cur_ = nullptr;
+  char *end_ = nullptr;
+};
+
+// The arena StorageBase::operator new allocates from, which is set by the
+// StorageManager while it creates a storage.
+thread_local StorageArena *current_arena = nullptr;
+
+class ArenaScope {
+ public:
+  explicit ArenaScope(StorageArena *arena) : last_(current_arena) {
+    current_arena = arena;
+  }
+  ~ArenaScope() { current_arena = last_; }
+
+ private:
+  StorageArena *last_;
+};
+
+// Every storage is preceded by the arena it's allocated from, nullptr for
+// the ones allocated out of a StorageManager.
+constexpr std::size_t kStorageHeader = kStorageAlignment;
+static_assert(kStorageHeader >= sizeof(StorageArena *),
+              "the header can't hold the arena of a storage.");
+
+using StorageBase = StorageManager::StorageBase;
+using DestroyFunc = std::function<void(StorageBase *)>;
+
+// A node of the hash chains, which is never changed after it's published.
+struct StorageEntry {
+  TypeId type_id;
+  std::size_t hash_value;
+  StorageBase *storage;
+  // nullptr for the parameterless storages, which are never destroyed.
+  const DestroyFunc *destroy;
+  StorageEntry *next;
+};
+
+struct StorageTable {
+  explicit StorageTable(std::size_t num_buckets)
+      : mask(num_buckets - 1),
+        buckets(new std::atomic<StorageEntry *>[num_buckets]) {
+    for (std::size_t i = 0; i < num_buckets; ++i) {
+      buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  std::size_t mask;
+  std::unique_ptr<std::atomic<StorageEntry *>[]> buckets;
+};
+
+std::size_t MixHash(TypeId type_id, std::size_t hash_value) {
+  uint64_t key = std::hash<TypeId>()(type_id) ^
+                 (hash_value + 0x9e3779b9 + (hash_value << 6));
+  return static_cast<std::size_t>(key * 0x9e3779b97f4a7c15ULL);
+}
+}  // namespace
+
+// A shard of the storages, the readers walk the chains of its current table
+// without locking, and the writers insert under its lock. When growing, the
+// entries are copied to a new table, and the old ones are kept alive for the
+// readers still walking them.
+struct StorageShard {
+  static constexpr std::size_t kInitBuckets = 16;
+
+  StorageShard() {
+    tables.emplace_back(std::make_unique<StorageTable>(kInitBuckets));
+    table.store(tables.back().get(), std::memory_order_release);
+  }
+
+  template <typename EqualFunc>
+  StorageBase *Find(TypeId type_id,
+                    std::size_t hash_value,
+                    std::size_t mixed_hash,
+                    const EqualFunc &equal_func) const {
+    const StorageTable *current = table.load(std::memory_order_acquire);
+    for (StorageEntry *entry =
+             current->buckets[mixed_hash & current->mask].load(
+                 std::memory_order_acquire);
+         entry;
+         entry = entry->next) {
+      if (entry->hash_value == hash_value && entry->type_id == type_id &&
+          equal_func(entry->storage)) {
+        return entry->storage;
       }
     }
-    StorageBase *storage = constructor();
-    parametric_instances_.emplace(hash_value, storage);
-    VLOG(10) << "No cache found, construct and cache a new parametric storage "
-                "of: [param_hash="
-             << hash_value << ", storage_ptr=" << storage << "].";
-    return storage;
+    return nullptr;
   }
 
+  // Must be called with the lock held.
+  void Insert(TypeId type_id,
+              std::size_t hash_value,
+              std::size_t mixed_hash,
+              StorageBase *storage,
+              const DestroyFunc *destroy) {
+    StorageTable *current = table.load(std::memory_order_relaxed);
+    if (size + 1 > (current->mask + 1) * 2) {
+      current = Grow(current);
+    }
+    auto *entry = NewEntry(type_id, hash_value, storage, destroy);
+    auto &bucket = current->buckets[mixed_hash & current->mask];
+    entry->next = bucket.load(std::memory_order_relaxed);
+    bucket.store(entry, std::memory_order_release);
+    ++size;
+  }
+
+  template <typename Func>
+  void ForEach(const Func &func) const {
+    const StorageTable *current = table.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i <= current->mask; ++i) {
+      for (StorageEntry *entry =
+               current->buckets[i].load(std::memory_order_acquire);
+           entry;
+           entry = entry->next) {
+        func(entry);
+      }
+    }
+  }
+
+  pir::SpinLock lock;
+  // The storages and entries of the shard are allocated from its arena.
+  StorageArena arena;
+  std::atomic<StorageTable *> table;
+  std::vector<std::unique_ptr<StorageTable>> tables;
+  std::size_t size = 0;
+
  private:
-  // In order to prevent hash conflicts, the unordered_multimap data structure
-  // is used for storage.
-  std::unordered_multimap<size_t, StorageBase *> parametric_instances_;
-  std::function<void(StorageBase *)> destroy_;
+  StorageEntry *NewEntry(TypeId type_id,
+                         std::size_t hash_value,
+                         StorageBase *storage,
+                         const DestroyFunc *destroy) {
+    return new (arena.Allocate(sizeof(StorageEntry)))
+        StorageEntry{type_id, hash_value, storage, destroy, nullptr};
+  }
+
+  StorageTable *Grow(StorageTable *current) {
+    auto grown = std::make_unique<StorageTable>((current->mask + 1) * 2);
+    ForEach([&](StorageEntry *entry) {
+      auto *copy = NewEntry(
+          entry->type_id, entry->hash_value, entry->storage, entry->destroy);
+      auto &bucket = grown->buckets[MixHash(entry->type_id, entry->hash_value) &
+                                    grown->mask];
+      copy->next = bucket.load(std::memory_order_relaxed);
+      bucket.store(copy, std::memory_order_relaxed);
+    });
+    VLOG(10) << "Grow a storage shard of " << size << " storages to "
+             << grown->mask + 1 << " buckets.";
+    tables.emplace_back(std::move(grown));
+    table.store(tables.back().get(), std::memory_order_release);
+    return tables.back().get();
+  }
 };
 
-StorageManager::StorageManager() = default;
+struct StorageManagerImpl {
+  static constexpr std::size_t kNumShards = 32;
+
+  ~StorageManagerImpl() {
+    for (auto &shard : shards) {
+      shard.ForEach([](StorageEntry *entry) {
+        if (entry->destroy) (*entry->destroy)(entry->storage);
+      });
+    }
+  }
+
+  StorageShard &GetShard(std::size_t mixed_hash) {
+    return shards[(mixed_hash >> 32) % kNumShards];
+  }
+
+  StorageShard shards[kNumShards];
+
+  // The destroy functions of the registered parametric storages.
+  std::unordered_map<TypeId, DestroyFunc> parametric_destroys;
+  pir::SpinLock parametric_destroys_lock;
+};
+
+void *StorageManager::StorageBase::operator new(std::size_t size) {
+  StorageArena *arena = current_arena;
+  char *base = static_cast<char *>(
+      arena ? arena->Allocate(kStorageHeader + size)
+            : ::operator new(kStorageHeader + size));
+  *reinterpret_cast<StorageArena **>(base) = arena;
+  return base + kStorageHeader;
+}
+
+void StorageManager::StorageBase::operator delete(void *ptr) {
+  if (!ptr) return;
+  char *base = static_cast<char *>(ptr) - kStorageHeader;
+  // The memory from an arena is released with the arena.
+  if (*reinterpret_cast<StorageArena **>(base) == nullptr) {
+    ::operator delete(base);
+  }
+}
+
+StorageManager::StorageManager() : impl_(new StorageManagerImpl()) {}
 
 StorageManager::~StorageManager() = default;
 
@@ -77,45 +260,75 @@ StorageManager::StorageBase *StorageManager::GetParametricStorageImpl(
     std::size_t hash_value,
     std::function<bool(const StorageBase *)> equal_func,
     std::function<StorageBase *()> constructor) {
-  std::lock_guard<pir::SpinLock> guard(parametric_instance_lock_);
-  VLOG(10) << "Try to get a parametric storage of: [TypeId_hash="
-           << std::hash<pir::TypeId>()(type_id) << ", param_hash=" << hash_value
-           << "].";
-  if (parametric_instance_.find(type_id) == parametric_instance_.end()) {
-    IR_THROW("The input data pointer is null.");
+  std::size_t mixed_hash = MixHash(type_id, hash_value);
+  StorageShard &shard = impl_->GetShard(mixed_hash);
+  if (auto *storage =
+          shard.Find(type_id, hash_value, mixed_hash, equal_func)) {
+    return storage;
+  }
+
+  const DestroyFunc *destroy = nullptr;
+  {
+    std::lock_guard<pir::SpinLock> guard(impl_->parametric_destroys_lock);
+    auto iter = impl_->parametric_destroys.find(type_id);
+    if (iter == impl_->parametric_destroys.end()) {
+      IR_THROW("The input data pointer is null.");
+    }
+    destroy = &iter->second;
+  }
+
+  std::lock_guard<pir::SpinLock> guard(shard.lock);
+  // Another thread may have created it before the lock.
+  if (auto *storage =
+          shard.Find(type_id, hash_value, mixed_hash, equal_func)) {
+    return storage;
   }
-  ParametricStorageManager &parametric_storage = *parametric_instance_[type_id];
-  return parametric_storage.GetOrCreate(hash_value, equal_func, constructor);
+  StorageBase *storage = nullptr;
+  {
+    ArenaScope scope(&shard.arena);
+    storage = constructor();
+  }
+  shard.Insert(type_id, hash_value, mixed_hash, storage, destroy);
+  VLOG(10) << "No cache found, construct and cache a new parametric storage "
+              "of: [TypeId_hash="
+           << std::hash<pir::TypeId>()(type_id) << ", param_hash=" << hash_value
+           << ", storage_ptr=" << storage << "].";
+  return storage;
 }
 
 StorageManager::StorageBase *StorageManager::GetParameterlessStorageImpl(
     TypeId type_id) {
-  std::lock_guard<pir::SpinLock> guard(parameterless_instance_lock_);
-  VLOG(10) << "Try to get a parameterless storage of: [TypeId_hash="
-           << std::hash<pir::TypeId>()(type_id) << "].";
-  if (parameterless_instance_.find(type_id) == parameterless_instance_.end())
-    IR_THROW("TypeId not found in IrContext.");
-  StorageBase *parameterless_instance = parameterless_instance_[type_id];
-  return parameterless_instance;
+  std::size_t mixed_hash = MixHash(type_id, 0);
+  auto *storage = impl_->GetShard(mixed_hash).Find(
+      type_id, 0, mixed_hash, [](const StorageBase *) { return true; });
+  if (!storage) IR_THROW("TypeId not found in IrContext.");
+  return storage;
 }
 
 void StorageManager::RegisterParametricStorageImpl(
     TypeId type_id, std::function<void(StorageBase *)> destroy) {
-  std::lock_guard<pir::SpinLock> guard(parametric_instance_lock_);
+  std::lock_guard<pir::SpinLock> guard(impl_->parametric_destroys_lock);
   VLOG(10) << "Register a parametric storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << "].";
-  parametric_instance_.emplace(
-      type_id, std::make_unique<ParametricStorageManager>(destroy));
+  impl_->parametric_destroys.emplace(type_id, std::move(destroy));
 }
 
 void StorageManager::RegisterParameterlessStorageImpl(
     TypeId type_id, std::function<StorageBase *()> constructor) {
-  std::lock_guard<pir::SpinLock> guard(parameterless_instance_lock_);
   VLOG(10) << "Register a parameterless storage of: [TypeId_hash="
            << std::hash<pir::TypeId>()(type_id) << "].";
-  if (parameterless_instance_.find(type_id) != parameterless_instance_.end())
+  std::size_t mixed_hash = MixHash(type_id, 0);
+  StorageShard &shard = impl_->GetShard(mixed_hash);
+  auto any = [](const StorageBase *) { return true; };
+  std::lock_guard<pir::SpinLock> guard(shard.lock);
+  if (shard.Find(type_id, 0, mixed_hash, any))
     IR_THROW("storage class already registered");
-  parameterless_instance_.emplace(type_id, constructor());
+  StorageBase *storage = nullptr;
+  {
+    ArenaScope scope(&shard.arena);
+    storage = constructor();
+  }
+  shard.Insert(type_id, 0, mixed_hash, storage, nullptr);
 }
 
 }  // namespace pir
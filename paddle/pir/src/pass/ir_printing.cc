@@ -84,6 +84,7 @@ class IRPrinting : public PassInstrumentation {
 };
 
 void PassManager::EnableIRPrinting(std::unique_ptr<IRPrinterOption> option) {
+  ir_printing_ = true;
   AddInstrumentation(std::make_unique<IRPrinting>(std::move(option)));
 }
 
@@ -13,6 +13,16 @@
 // limitations under the License.
 
 #include "paddle/pir/include/pass/pass.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
 #include "paddle/pir/include/core/ir_context.h"
 #include "paddle/pir/include/core/operation.h"
 #include "paddle/pir/include/core/program.h"
@@ -75,6 +85,7 @@ bool PatternRewritePass::Initialize(IrContext* context) {
           "InitializePatterns() function of class [%s]",
           name()));
   patterns_ = FrozenRewritePatternSet(std::move(ps));
+  config_ = InitializeConfig();
   return true;
 }
 
@@ -86,11 +97,140 @@ GreedyRewriteConfig PatternRewritePass::InitializeConfig() {
 }
 
 void PatternRewritePass::Run(Operation* op) {
+  auto [_, num_rewrites] = ApplyPatternsGreedily(op, patterns_, config_);
+  AddStatistics(num_rewrites);
+}
+
+std::unique_ptr<Pass> PatternRewritePass::Clone() const {
+  return std::make_unique<detail::PatternRewritePassCopy>(this);
+}
+
+detail::PatternRewritePassCopy::PatternRewritePassCopy(
+    const PatternRewritePass* origin)
+    : Pass(origin->name(),
+           origin->pass_info().opt_level,
+           origin->pass_info().dependents),
+      origin_(origin) {}
+
+void detail::PatternRewritePassCopy::Run(Operation* op) {
+  GreedyRewriteConfig config = origin_->config_;
+  config.ops_erased_outside = &ops_erased_outside_;
   auto [_, num_rewrites] =
-      ApplyPatternsGreedily(op, patterns_, InitializeConfig());
+      ApplyPatternsGreedily(op, origin_->patterns_, config);
   AddStatistics(num_rewrites);
 }
 
+bool detail::PatternRewritePassCopy::CanApplyOn(Operation* op) const {
+  return origin_->CanApplyOn(op);
+}
+
+CombinedPatternRewritePass::CombinedPatternRewritePass(
+    std::vector<std::unique_ptr<Pass>>&& passes)
+    : Pass("combined_pattern_rewrite_pass", 0), passes_(std::move(passes)) {
+  std::string name = "combined_pattern_rewrite_pass(";
+  for (size_t i = 0; i < passes_.size(); ++i) {
+    auto* pass = dynamic_cast<PatternRewritePass*>(passes_[i].get());
+    PADDLE_ENFORCE_NOT_NULL(
+        pass,
+        phi::errors::InvalidArgument(
+            "Only PatternRewritePasses can be combined, but [%s] is not.",
+            passes_[i]->name()));
+    GreedyRewriteConfig config = pass->InitializeConfig();
+    if (i == 0) {
+      config_ = config;
+    } else {
+      PADDLE_ENFORCE_EQ(
+          config.use_top_down_traversal == config_.use_top_down_traversal &&
+              config.max_num_rewrites == config_.max_num_rewrites &&
+              config.strict_mode == config_.strict_mode,
+          true,
+          phi::errors::InvalidArgument(
+              "The rewrite config of [%s] differs from the one of the passes "
+              "before it, so it can't be combined with them.",
+              pass->name()));
+      if (config_.max_iterations != GreedyRewriteConfig::kNoLimit) {
+        config_.max_iterations =
+            config.max_iterations == GreedyRewriteConfig::kNoLimit
+                ? config.max_iterations
+                : std::max(config_.max_iterations, config.max_iterations);
+      }
+    }
+    PADDLE_ENFORCE_EQ(config.region == nullptr,
+                      true,
+                      phi::errors::InvalidArgument(
+                          "[%s] rewrites a given region only, so it can't "
+                          "be combined.",
+                          pass->name()));
+    name += (i ? "," : "") + pass->name();
+    // Skipped by the PassManager if any of the passes would be.
+    pass_info_.opt_level =
+        std::max(pass_info_.opt_level, passes_[i]->pass_info().opt_level);
+  }
+  pass_info_.name = name + ")";
+  config_.use_change_driven_worklist = true;
+}
+
+CombinedPatternRewritePass::CombinedPatternRewritePass(
+    const CombinedPatternRewritePass* origin)
+    : Pass(origin->name(), origin->pass_info().opt_level),
+      origin_(origin),
+      config_(origin->config_) {
+  config_.ops_erased_outside = &ops_erased_outside_;
+}
+
+std::unique_ptr<Pass> CombinedPatternRewritePass::Clone() const {
+  for (auto& pass : passes()) {
+    if (!pass->Clone()) return nullptr;
+  }
+  // The patterns are made for each copy, as they are cached on demand.
+  return std::unique_ptr<Pass>(new CombinedPatternRewritePass(this));
+}
+
+bool CombinedPatternRewritePass::Initialize(IrContext* context) {
+  context_ = context;
+  return true;
+}
+
+const FrozenRewritePatternSet& CombinedPatternRewritePass::GetPatterns(
+    Operation* op) {
+  auto& passes = this->passes();
+  std::vector<bool> applied(passes.size());
+  for (size_t i = 0; i < passes.size(); ++i) {
+    applied[i] = passes[i]->CanApplyOn(op);
+  }
+  auto iter = patterns_.find(applied);
+  if (iter != patterns_.end()) return iter->second;
+
+  RewritePatternSet combined(context_);
+  // The copies on the worker threads share the passes.
+  std::lock_guard<std::mutex> guard(origin_ ? origin_->passes_mutex_
+                                            : passes_mutex_);
+  for (size_t i = 0; i < passes.size(); ++i) {
+    if (!applied[i]) continue;
+    RewritePatternSet ps =
+        static_cast<PatternRewritePass*>(passes[i].get())
+            ->InitializePatterns(context_);
+    for (auto& pattern : ps.native_patterns()) {
+      combined.Add(std::move(pattern));
+    }
+  }
+  return patterns_
+      .emplace(applied, FrozenRewritePatternSet(std::move(combined)))
+      .first->second;
+}
+
+void CombinedPatternRewritePass::Run(Operation* op) {
+  auto [_, num_rewrites] = ApplyPatternsGreedily(op, GetPatterns(op), config_);
+  AddStatistics(num_rewrites);
+}
+
+bool CombinedPatternRewritePass::CanApplyOn(Operation* op) const {
+  auto& passes = this->passes();
+  return std::any_of(passes.begin(), passes.end(), [op](const auto& pass) {
+    return pass->CanApplyOn(op);
+  });
+}
+
 //----------------------------------------------------------------------------------------------//
 // PassAdaptor
 //----------------------------------------------------------------------------------------------//
@@ -102,10 +242,17 @@ void detail::PassAdaptor::RunImpl(Operation* op,
                                   uint8_t opt_level,
                                   bool verify) {
   auto last_am = analysis_manager();
+  bool parallel = pm_->num_threads_ > 1 && !pm_->ir_printing_;
 
   for (size_t i = 0; i < op->num_regions(); ++i) {
     auto& region = op->region(i);
     for (auto& block : region) {
+      if (parallel) {
+        if (!RunParallel(
+                &block, last_am.GetPassInstrumentor(), opt_level, verify))
+          return SignalPassFailure();
+        continue;
+      }
       for (auto& op : block) {
         AnalysisManagerHolder am(&op, last_am.GetPassInstrumentor());
         if (!RunPipeline(*pm_, &op, am, opt_level, verify))
@@ -116,6 +263,188 @@ void detail::PassAdaptor::RunImpl(Operation* op,
   return;
 }
 
+namespace {
+// Splits ops into the groups which can be rewritten concurrently: the ops
+// using a same value from above, or values of a same op, are in one group.
+// The groups and the ops in them keep the order of ops.
+std::vector<std::vector<Operation*>> GroupIndependentOps(
+    const std::vector<Operation*>& ops) {
+  std::vector<size_t> parent(ops.size());
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&](size_t i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+
+  std::unordered_map<Value, size_t> users;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    std::unordered_set<Value> defined;
+    ops[i]->Walk([&](Operation* op) {
+      for (auto& region : *op) {
+        for (auto& block : region) {
+          defined.insert(block.args().begin(), block.args().end());
+          for (auto& kwarg : block.kwargs()) {
+            defined.insert(kwarg.second);
+          }
+        }
+      }
+      if (op != ops[i]) {
+        for (auto result : op->results()) {
+          defined.insert(result);
+        }
+      }
+    });
+    ops[i]->Walk([&](Operation* op) {
+      for (auto value : op->operands_source()) {
+        if (!value || defined.count(value)) continue;
+        // The patterns may check the uses of all the results of the op
+        // defining a value, so it is keyed by its first result.
+        if (auto* defining_op = value.defining_op()) {
+          value = defining_op->result(0);
+        }
+        auto iter = users.find(value);
+        if (iter == users.end()) {
+          users.emplace(value, i);
+        } else {
+          parent[find(i)] = find(iter->second);
+        }
+      }
+    });
+  }
+
+  std::vector<std::vector<Operation*>> groups;
+  std::unordered_map<size_t, size_t> group_index;
+  for (size_t i = 0; i < ops.size(); ++i) {
+    auto iter = group_index.emplace(find(i), groups.size()).first;
+    if (iter->second == groups.size()) groups.emplace_back();
+    groups[iter->second].push_back(ops[i]);
+  }
+  return groups;
+}
+}  // namespace
+
+bool detail::PassAdaptor::RunParallel(Block* block,
+                                      PassInstrumentor* instrumentor,
+                                      uint8_t opt_level,
+                                      bool verify) {
+  // Most of the passes skip the ops without regions, run them here first.
+  std::vector<Operation*> region_ops;
+  for (auto& op : *block) {
+    if (op.num_regions() > 0) {
+      region_ops.push_back(&op);
+      continue;
+    }
+    AnalysisManagerHolder am(&op, instrumentor);
+    if (!RunPipeline(*pm_, &op, am, opt_level, verify)) return false;
+  }
+
+  auto groups = GroupIndependentOps(region_ops);
+  size_t num_workers =
+      std::min(static_cast<size_t>(pm_->num_threads_), groups.size());
+  // The nested ops of a worker run in turn on the copies of the passes.
+  std::vector<std::unique_ptr<PassManager>> worker_pms;
+  for (size_t worker = 0; worker < num_workers; ++worker) {
+    worker_pms.push_back(
+        std::make_unique<PassManager>(pm_->context(), pm_->opt_level_));
+    if (!ClonePasses(*pm_, worker_pms.back().get())) {
+      num_workers = 0;
+      break;
+    }
+  }
+  if (num_workers < 2) {
+    for (auto* op : region_ops) {
+      AnalysisManagerHolder am(op, instrumentor);
+      if (!RunPipeline(*pm_, op, am, opt_level, verify)) return false;
+    }
+    return true;
+  }
+  VLOG(4) << "Run the pipelines of " << region_ops.size() << " ops in "
+          << groups.size() << " groups on " << num_workers << " threads.";
+
+  std::atomic<size_t> next_group{0};
+  std::atomic<bool> failed{false};
+  std::vector<std::exception_ptr> errors(num_workers);
+  auto work = [&](size_t worker) {
+    try {
+      PassManager& worker_pm = *worker_pms[worker];
+      for (auto& pass : worker_pm.passes()) {
+        PADDLE_ENFORCE_EQ(pass->Initialize(pm_->context()),
+                          true,
+                          phi::errors::PreconditionNotMet(
+                              "Failed to initialize the copy of pass %s for "
+                              "a worker thread.",
+                              pass->name()));
+      }
+      for (size_t i = next_group++; i < groups.size() && !failed;
+           i = next_group++) {
+        for (auto* op : groups[i]) {
+          AnalysisManagerHolder am(op, instrumentor);
+          if (!RunPipeline(worker_pm, op, am, opt_level, verify)) {
+            failed = true;
+            break;
+          }
+        }
+      }
+    } catch (...) {
+      errors[worker] = std::current_exception();
+      failed = true;
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t worker = 1; worker < num_workers; ++worker) {
+    threads.emplace_back(work, worker);
+  }
+  work(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (auto& error : errors) {
+    if (error) std::rethrow_exception(error);
+  }
+  // The copies left the ops outside their ops to erase.
+  for (auto& worker_pm : worker_pms) {
+    for (auto& pass : worker_pm->passes()) {
+      if (auto* copy = dynamic_cast<PatternRewritePassCopy*>(pass.get())) {
+        EraseOps(&copy->ops_erased_outside_);
+      } else if (auto* combined =
+                     dynamic_cast<CombinedPatternRewritePass*>(pass.get())) {
+        EraseOps(&combined->ops_erased_outside_);
+      }
+    }
+  }
+  return !failed;
+}
+
+void detail::PassAdaptor::EraseOps(std::vector<Operation*>* ops) {
+  std::unordered_set<Operation*> erased;
+  for (auto* op : *ops) {
+    if (erased.insert(op).second) op->Erase();
+  }
+  ops->clear();
+}
+
+bool detail::PassAdaptor::ClonePasses(const PassManager& pm,
+                                      PassManager* worker_pm) {
+  for (auto& pass : pm.passes()) {
+    auto clone = pass->Clone();
+    if (!clone) {
+      VLOG(4) << "Run the nested pipelines in turn, for " << pass->name()
+              << " can't be copied.";
+      return false;
+    }
+    // The attributes stay owned by pass.
+    for (auto& attr : pass->attrs_) {
+      clone->Erase(attr.first);
+      clone->attrs_[attr.first] = attr.second;
+    }
+    worker_pm->AddPass(std::move(clone));
+  }
+  return true;
+}
+
 bool detail::PassAdaptor::RunPipeline(const PassManager& pm,
                                       Operation* op,
                                       AnalysisManager am,
@@ -134,15 +463,16 @@ bool detail::PassAdaptor::RunPipeline(const PassManager& pm,
     }
   }
 
-  if (instrumentor) {
-    instrumentor->RunAfterPipeline(op);
-  }
-
   // Apply pass manager on all nested ir.
   if (!RunPass(pm.pass_adaptor_.get(), op, am, opt_level, verify)) {
     return false;
   }
 
+  // After the nested ir, so that the pipeline of op covers them.
+  if (instrumentor) {
+    instrumentor->RunAfterPipeline(op);
+  }
+
   return true;
 }
 
@@ -196,6 +526,13 @@ bool PassManager::Run(Operation* op) {
   return detail::PassAdaptor::RunPipeline(*this, op, am, opt_level_, verify_);
 }
 
+void PassManager::EnableParallel(int num_threads) {
+  if (num_threads <= 0) {
+    num_threads = static_cast<int>(std::thread::hardware_concurrency());
+  }
+  num_threads_ = std::max(num_threads, 1);
+}
+
 bool PassManager::Initialize(IrContext* context) {
   for (auto& pass : passes()) {
     if (!pass->Initialize(context)) return false;
@@ -215,7 +552,9 @@ void PassManager::AddInstrumentation(std::unique_ptr<PassInstrumentation> pi) {
 //----------------------------------------------------------------------------------------------//
 namespace detail {
 struct PassInstrumentorImpl {
-  // TODO(wilber): Support multi-thread.
+  // The callbacks come from the worker threads of a parallel pass manager,
+  // so they are made one at a time.
+  std::mutex mutex;
   std::vector<std::unique_ptr<PassInstrumentation>> instrumentations;
 };
 }  // namespace detail
@@ -227,6 +566,7 @@ PassInstrumentor::~PassInstrumentor() = default;
 
 void PassInstrumentor::RunBeforePipeline(Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforePipeline(op);
   }
@@ -234,6 +574,7 @@ void PassInstrumentor::RunBeforePipeline(Operation* op) {
 
 void PassInstrumentor::RunAfterPipeline(Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -243,6 +584,7 @@ void PassInstrumentor::RunAfterPipeline(Operation* op) {
 
 void PassInstrumentor::RunBeforePass(Pass* pass, Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforePass(pass, op);
   }
@@ -250,6 +592,7 @@ void PassInstrumentor::RunBeforePass(Pass* pass, Operation* op) {
 
 void PassInstrumentor::RunAfterPass(Pass* pass, Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -261,6 +604,7 @@ void PassInstrumentor::RunBeforeAnalysis(const std::string& name,
                                          TypeId id,
                                          Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto& instr : impl_->instrumentations) {
     instr->RunBeforeAnalysis(name, id, op);
   }
@@ -270,6 +614,7 @@ void PassInstrumentor::RunAfterAnalysis(const std::string& name,
                                         TypeId id,
                                         Operation* op) {
   if (op->num_regions() == 0) return;
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   for (auto it = impl_->instrumentations.rbegin();
        it != impl_->instrumentations.rend();
        ++it) {
@@ -279,6 +624,7 @@ void PassInstrumentor::RunAfterAnalysis(const std::string& name,
 
 void PassInstrumentor::AddInstrumentation(
     std::unique_ptr<PassInstrumentation> pi) {
+  std::lock_guard<std::mutex> guard(impl_->mutex);
   impl_->instrumentations.emplace_back(std::move(pi));
 }
 
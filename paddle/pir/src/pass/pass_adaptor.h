@@ -14,11 +14,16 @@
 
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "paddle/pir/include/pass/pass.h"
 
 namespace pir {
 
+class Block;
 class Operation;
+class PassInstrumentor;
 class PassManager;
 
 namespace detail {
@@ -34,6 +39,20 @@ class PassAdaptor final : public Pass {
  private:
   void RunImpl(Operation* op, uint8_t opt_level, bool verify);
 
+  // Runs the pipelines of the ops of block, the ops with regions on the
+  // threads of the pass manager. Returns false if any pipeline fails.
+  bool RunParallel(Block* block,
+                   PassInstrumentor* instrumentor,
+                   uint8_t opt_level,
+                   bool verify);
+
+  // Adds the copies of the passes of pm to worker_pm, sharing their
+  // attributes. Returns false if any pass can't be copied.
+  static bool ClonePasses(const PassManager& pm, PassManager* worker_pm);
+
+  // Erases the ops left to erase by the copies of the passes.
+  static void EraseOps(std::vector<Operation*>* ops);
+
   static bool RunPass(Pass* pass,
                       Operation* op,
                       AnalysisManager am,
@@ -52,6 +71,26 @@ class PassAdaptor final : public Pass {
   // For accessing RunPipeline.
   friend class pir::PassManager;
 };
+
+// The copy of a PatternRewritePass run by a worker thread of a parallel pass
+// manager, with the patterns and the config of the pass.
+class PatternRewritePassCopy final : public Pass {
+ public:
+  explicit PatternRewritePassCopy(const PatternRewritePass* origin);
+
+ protected:
+  void Run(Operation* op) override;
+
+  bool CanApplyOn(Operation* op) const override;
+
+ private:
+  const PatternRewritePass* origin_;
+
+  // The ops outside the ops it ran on, which the patterns erased.
+  std::vector<Operation*> ops_erased_outside_;
+
+  friend class PassAdaptor;
+};
 }  // namespace detail
 
 }  // namespace pir
@@ -17,7 +17,9 @@
 #include <ostream>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 #include "paddle/common/macros.h"
 #include "paddle/pir/include/core/operation.h"
@@ -40,6 +42,8 @@ class Timer {
 
   void Stop() { walk_time += std::chrono::steady_clock::now() - start_time_; }
 
+  void Add(const Timer& other) { walk_time += other.walk_time; }
+
   double GetTimePerSecond() const {
     return std::chrono::duration_cast<std::chrono::duration<double>>(walk_time)
         .count();
@@ -58,6 +62,7 @@ class PassTimer : public PassInstrumentation {
   ~PassTimer() override = default;
 
   void RunBeforePipeline(pir::Operation* op) override {
+    if (!root_) root_ = op;
     pipeline_timers_[op] = Timer();
     pipeline_timers_[op].Start();
   }
@@ -78,7 +83,12 @@ class PassTimer : public PassInstrumentation {
   }
 
   void RunAfterPass(Pass* pass, Operation* op) override {
-    pass_timers_[op][pass->name()].Stop();
+    auto& timer = pass_timers_[op][pass->name()];
+    timer.Stop();
+    if (op != root_) {
+      nested_timers_[pass->name()].Add(timer);
+      nested_threads_.insert(std::this_thread::get_id());
+    }
   }
 
  private:
@@ -111,16 +121,33 @@ class PassTimer : public PassInstrumentation {
          << "%)"
          << "  " << v.first << "\n";
     }
+
+    // The nested ops may run on many threads, their walk time is summed.
+    if (op != root_ || nested_timers_.empty()) return;
+    os << "\n  Nested Ops Walk Time on " << nested_threads_.size()
+       << " thread(s):\n";
+    os << "  ----Walk Time----  ----Name----\n";
+    for (auto& v : nested_timers_) {
+      os << "  " << std::fixed << std::setw(8) << std::setprecision(3)
+         << v.second.GetTimePerSecond() << "  " << v.first << "\n";
+    }
   }
 
  private:
   bool print_module_;
 
+  // The op the pass manager runs on.
+  Operation* root_{nullptr};
+
   std::unordered_map<Operation*, Timer> pipeline_timers_;
 
   std::unordered_map<Operation*,
                      std::unordered_map<std::string /*pass name*/, Timer>>
       pass_timers_;
+
+  std::unordered_map<std::string /*pass name*/, Timer> nested_timers_;
+
+  std::unordered_set<std::thread::id> nested_threads_;
 };
 
 void PassManager::EnablePassTiming(bool print_module) {
@@ -56,6 +56,8 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
   }
 
   std::pair<bool, int64_t> Simplify() {
+    if (config_.use_change_driven_worklist) return SimplifyChangeDriven();
+
     int64_t sum_num_rewrites = 0;
     int64_t num_rewrites = 0;
     int64_t iteration = 0;
@@ -65,23 +67,7 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
           config_.max_iterations != pir::GreedyRewriteConfig::kNoLimit)
         break;
       VLOG(6) << "Iteration[" << iteration << "] for PatternRewrite";
-      worklist_.clear();
-      worklist_map_.clear();
-
-      for (auto& block_item : region_) {
-        for (auto& op_item : block_item) {
-          worklist_.push_back(&op_item);
-        }
-      }
-      if (config_.use_top_down_traversal) {
-        // Reverse the list so out pop-back loop process them in-order.
-        std::reverse(worklist_.begin(), worklist_.end());
-      }
-      for (size_t i = 0; i < worklist_.size(); ++i) {
-        worklist_map_[worklist_[i]] = i;
-        VLOG(6) << "worklist[" << i << "] is " << worklist_[i]->name();
-      }
-
+      PopulateWorklist();
       num_rewrites = ProcessWorklist();
       sum_num_rewrites += num_rewrites;
     } while (num_rewrites != 0);
@@ -90,6 +76,42 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
   }
 
  private:
+  // Traverses the region once, the rewrites queue the ops they touch, and
+  // the process ends when the worklist is empty.
+  std::pair<bool, int64_t> SimplifyChangeDriven() {
+    PopulateWorklist();
+    if (config_.max_iterations != pir::GreedyRewriteConfig::kNoLimit) {
+      max_num_processed_ =
+          config_.max_iterations * static_cast<int64_t>(worklist_.size());
+    }
+    int64_t num_rewrites = ProcessWorklist();
+    // The removed ops leave nullptr in the worklist, only the ops in the
+    // map are still to be processed.
+    bool converged = worklist_map_.empty();
+    VLOG(6) << "Change driven PatternRewrite processed " << num_processed_
+            << " ops, " << num_rewrites << " rewrites.";
+    return std::make_pair(converged, num_rewrites);
+  }
+
+  void PopulateWorklist() {
+    worklist_.clear();
+    worklist_map_.clear();
+
+    for (auto& block_item : region_) {
+      for (auto& op_item : block_item) {
+        worklist_.push_back(&op_item);
+      }
+    }
+    if (config_.use_top_down_traversal) {
+      // Reverse the list so out pop-back loop process them in-order.
+      std::reverse(worklist_.begin(), worklist_.end());
+    }
+    for (size_t i = 0; i < worklist_.size(); ++i) {
+      worklist_map_[worklist_[i]] = i;
+      VLOG(6) << "worklist[" << i << "] is " << worklist_[i]->name();
+    }
+  }
+
   /// Process ops until the worklist is empty or `config.max_num_rewrites`
   /// is reached. Return `true` if any IR was changed.
   int64_t ProcessWorklist() {
@@ -99,6 +121,11 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
             config_.max_num_rewrites == pir::GreedyRewriteConfig::kNoLimit)) {
       auto* op = PopFromWorklist();
       if (op == nullptr) continue;
+      if (max_num_processed_ >= 0 && num_processed_++ >= max_num_processed_) {
+        // Put it back, the process didn't converge.
+        AddToWorklist(op);
+        break;
+      }
       VLOG(6) << "PopFromWorklist, get op: " << op->name();
 
       // TODO(wilber): ir is dead.
@@ -125,11 +152,28 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
     }
   }
 
-  void FinalizeRootUpdate(pir::Operation* op) override { AddToWorklist(op); }
+  void FinalizeRootUpdate(pir::Operation* op) override {
+    AddToWorklist(op);
+    if (config_.use_change_driven_worklist) {
+      // The users may match now, and won't be visited by another traversal.
+      for (uint32_t i = 0; i < op->num_results(); ++i) {
+        auto result = op->result(i);
+        for (auto it = result.use_begin(); it != result.use_end(); ++it) {
+          AddToWorklist(it->owner());
+        }
+      }
+    }
+  }
 
   void NotifyOperationRemoved(pir::Operation* op) override {
     for (uint32_t i = 0; i < op->num_operands(); ++i) {
-      AddOperandToWorklist(op->operand_source(i));
+      if (config_.use_change_driven_worklist) {
+        // No other traversal visits the producer, and it may match now that
+        // it has one user less, however many uses are left.
+        AddProducerToWorklist(op->operand_source(i));
+      } else {
+        AddOperandToWorklist(op->operand_source(i));
+      }
     }
 
     if (op->num_regions() == 0) {
@@ -150,6 +194,14 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
     }
   }
 
+  void EraseOp(pir::Operation* op) override {
+    if (config_.ops_erased_outside && !IsInRegion(op)) {
+      config_.ops_erased_outside->push_back(op);
+      return;
+    }
+    pir::PatternRewriter::EraseOp(op);
+  }
+
   void NotifyOperationInserted(pir::Operation* op) override {
     if (config_.strict_mode == pir::GreedyRewriteStrictness::ExistingAndNewOps)
       strict_mode_filtered_ops_.insert(op);
@@ -158,6 +210,7 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
 
   /// Add the given operation to the worklist.
   void AddToWorklist(pir::Operation* op) {
+    if (config_.ops_erased_outside && !IsInRegion(op)) return;
     if (config_.strict_mode == pir::GreedyRewriteStrictness::AnyOp ||
         strict_mode_filtered_ops_.count(op)) {
       if (worklist_map_.count(op)) return;
@@ -177,12 +230,27 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
     if (auto* def_op = operand.defining_op()) AddToWorklist(def_op);
   }
 
+  void AddProducerToWorklist(pir::Value operand) {
+    if (!operand) return;
+    if (auto* def_op = operand.defining_op()) AddToWorklist(def_op);
+  }
+
   void AddOperandsToWorklist(const std::vector<pir::Value> operands) {
     for (auto& v : operands) {
       AddOperandToWorklist(v);
     }
   }
 
+  bool IsInRegion(pir::Operation* op) const {
+    for (auto* block = op->GetParent(); block != nullptr;) {
+      auto* region = block->GetParent();
+      if (region == &region_) return true;
+      auto* parent_op = region ? region->GetParent() : nullptr;
+      block = parent_op ? parent_op->GetParent() : nullptr;
+    }
+    return false;
+  }
+
   /// Pop the next operation from the worklist
   pir::Operation* PopFromWorklist() {
     auto* op = worklist_.back();
@@ -207,6 +275,9 @@ class GreedyPatternRewriteDriver : public pir::PatternRewriter {
   std::unordered_set<pir::Operation*> strict_mode_filtered_ops_;
   pir::Region& region_;
   pir::PatternApplicator matcher_;
+  // The limit of ops to process in the change driven mode, -1 for no limit.
+  int64_t max_num_processed_ = -1;
+  int64_t num_processed_ = 0;
 };
 
 }  // namespace
@@ -168,6 +168,14 @@ def _rebuild_lodtensor_filedescriptor(
     return lodtensor
 
 
+def _rebuild_lodtensor_ring_arena(
+    cls, ipc_name, offset, size, type_idx, dims, lod
+):
+    return cls._new_shared_ring_arena(
+        (ipc_name, offset, size, type_idx, dims, lod)
+    )
+
+
 def _rebuild_cuda_tensor(
     cls, handle, offset_bytes, size, type_idx, dims, lod, device_idx
 ):
@@ -206,6 +214,18 @@ def _reduce_lodtensor(lodtensor):
             if dim == 0:
                 # Empty tensors have nothing be mapped.
                 return (_rebuild_lodtensor_empty, (type(lodtensor),))
+        # Pass the tensor through the ring arena of this process if enabled,
+        # fallback to a standalone shared memory file when it is full.
+        if (
+            paddle.base.core.globals()["FLAGS_dataloader_shm_ring_arena_size"]
+            > 0
+        ):
+            metadata = lodtensor._share_ring_arena()
+            if metadata is not None:
+                return (
+                    _rebuild_lodtensor_ring_arena,
+                    (type(lodtensor), *metadata),
+                )
         dataloader_use_file_descriptor = paddle.base.core.globals()[
             "FLAGS_dataloader_use_file_descriptor"
         ]
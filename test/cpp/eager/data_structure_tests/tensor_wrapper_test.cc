@@ -14,11 +14,20 @@
 
 #include "paddle/fluid/eager/tensor_wrapper.h"
 
+#include <cmath>
+
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
 #include "paddle/fluid/eager/utils.h"
 #include "test/cpp/eager/data_structure_tests/grad_node_test.h"
 
+COMMON_DECLARE_string(eager_saved_tensors_compression);
+COMMON_DECLARE_int64(eager_saved_tensors_memory_budget_mb);
+COMMON_DECLARE_string(eager_saved_tensors_spill_dir);
+COMMON_DECLARE_int64(eager_recompute_memory_budget_mb);
+COMMON_DECLARE_double(eager_recompute_max_flops_per_byte);
+
 TEST(TensorWrapper, Basic) {
   VLOG(6) << "Test Full reserved";
   paddle::Tensor et1;
@@ -80,3 +89,154 @@ TEST(TensorWrapper, Basic) {
   auto tw2 = egr::TensorWrapper(et3);
   CHECK(tw2.recover().initialized() == false);
 }
+
+TEST(TensorWrapper, SavedTensorsPool) {
+  // A 2MB activation, half of which is zeros like after relu
+  const int64_t numel = 512 * 1024;
+  phi::DenseTensorMeta meta =
+      phi::DenseTensorMeta(phi::DataType::FLOAT32, common::make_ddim({numel}));
+  std::shared_ptr<phi::DenseTensor> dt = std::make_shared<phi::DenseTensor>(
+      std::make_unique<paddle::experimental::DefaultAllocator>(phi::CPUPlace())
+          .get(),
+      meta);
+  auto* dt_ptr = dt->mutable_data<float>(phi::CPUPlace());
+  for (int64_t i = 0; i < numel; i++) {
+    dt_ptr[i] = i % 2 ? 0.0f : 1.0f + static_cast<float>(i % 100) / 7.0f;
+  }
+  paddle::Tensor et;
+  et.set_impl(dt);
+  auto grad_test_node = std::make_shared<eager_test::GradTestNode>(
+      /* val */ 5.0, /* in_num */ 2, /* out_num */ 2);
+  egr::Edge edge(grad_test_node, 1, 2);
+  et.set_autograd_meta(std::make_shared<egr::AutogradMeta>(edge));
+
+  auto& pool = egr::SavedTensorsPool::Instance();
+  auto check = [&](float rtol) {
+    int64_t memory_bytes = pool.memory_bytes();
+    auto tw = egr::TensorWrapper(et);
+    auto recovered = tw.recover();
+    const float* data = static_cast<const phi::DenseTensor*>(
+                            recovered.impl().get())
+                            ->data<float>();
+    CHECK_NE(data, dt_ptr);
+    for (int64_t i = 0; i < numel; i++) {
+      CHECK_LE(std::abs(data[i] - dt_ptr[i]), rtol * std::abs(dt_ptr[i]));
+    }
+    int64_t packed_bytes = pool.memory_bytes() + pool.spilled_bytes();
+    tw.clear();
+    CHECK_EQ(pool.memory_bytes(), memory_bytes);
+    return packed_bytes - memory_bytes;
+  };
+
+  // Losslessly packed by the zeros
+  FLAGS_eager_saved_tensors_compression = "zero";
+  CHECK_LT(check(0.0f), numel * 4 * 3 / 4);
+  // Downcast, halved and quartered
+  FLAGS_eager_saved_tensors_compression = "bf16";
+  CHECK_EQ(check(1.0f / 128), numel * 2);
+  FLAGS_eager_saved_tensors_compression = "fp8";
+  CHECK_EQ(check(1.0f / 8), numel);
+#if !defined(_WIN32)
+  // Not spilled without a spill directory
+  FLAGS_eager_saved_tensors_compression = "";
+  FLAGS_eager_saved_tensors_memory_budget_mb = 1;
+  {
+    auto kept_tw = egr::TensorWrapper(et);
+    CHECK_EQ(pool.spilled_bytes(), 0);
+  }
+  // Spilled beyond the budget of 1MB to the working directory of the test,
+  // in the build directory on disk
+  FLAGS_eager_saved_tensors_spill_dir = ".";
+  auto tw = egr::TensorWrapper(et);
+  CHECK_EQ(pool.spilled_bytes(), numel * 4);
+  tw.recover();
+  tw.clear();
+  CHECK_EQ(pool.spilled_bytes(), 0);
+  CHECK_EQ(check(0.0f), numel * 4);
+  FLAGS_eager_saved_tensors_memory_budget_mb = 0;
+  FLAGS_eager_saved_tensors_spill_dir = "";
+#endif
+  FLAGS_eager_saved_tensors_compression = "";
+}
+
+// Recomputes its output as the tensor it's given
+class RecomputeTestNode : public eager_test::GradTestNode {
+ public:
+  explicit RecomputeTestNode(const paddle::Tensor& out)
+      : GradTestNode(/* val */ 5.0, /* in_num */ 2, /* out_num */ 2),
+        out_(out) {}
+
+  double RecomputeFlopsPerElement() override { return 4; }
+
+  paddle::Tensor RecomputeForwardOutput() override {
+    num_recomputes_++;
+    return out_;
+  }
+
+  paddle::Tensor out_;
+  int num_recomputes_{0};
+};
+
+TEST(TensorWrapper, Recompute) {
+  // 1MB activations, recomputed by their grad nodes
+  const int64_t numel = 256 * 1024;
+  auto create_tensor = [&](bool is_activation) {
+    phi::DenseTensorMeta meta = phi::DenseTensorMeta(
+        phi::DataType::FLOAT32, common::make_ddim({numel}));
+    std::shared_ptr<phi::DenseTensor> dt = std::make_shared<phi::DenseTensor>(
+        std::make_unique<paddle::experimental::DefaultAllocator>(
+            phi::CPUPlace())
+            .get(),
+        meta);
+    dt->mutable_data<float>(phi::CPUPlace());
+    paddle::Tensor et;
+    et.set_impl(dt);
+    if (is_activation) {
+      auto recompute_test_node =
+          std::make_shared<RecomputeTestNode>(paddle::Tensor(dt));
+      egr::Edge edge(recompute_test_node, 1, 2);
+      et.set_autograd_meta(std::make_shared<egr::AutogradMeta>(edge));
+    }
+    return et;
+  };
+  paddle::Tensor et0 = create_tensor(true);
+  paddle::Tensor et1 = create_tensor(true);
+  paddle::Tensor et2 = create_tensor(true);
+  paddle::Tensor leaf = create_tensor(false);
+
+  auto& recompute = egr::ActivationRecompute::Instance();
+  recompute.ResetStats();
+  FLAGS_eager_recompute_memory_budget_mb = 1;
+  // Saved within the budget
+  auto saved = egr::TensorWrapper(et0);
+  CHECK_EQ(recompute.saved_bytes(), numel * 4);
+  // Saved again, charged once and not dropped since it's kept anyway
+  auto shared = egr::TensorWrapper(et0);
+  CHECK_EQ(recompute.saved_bytes(), numel * 4);
+  CHECK_EQ(recompute.dropped_bytes(), 0);
+  // Not charged as a leaf
+  auto saved_leaf = egr::TensorWrapper(leaf);
+  CHECK_EQ(recompute.saved_bytes(), numel * 4);
+  // Dropped beyond the budget, and recomputed by the grad node on recovery
+  auto dropped = egr::TensorWrapper(et1);
+  CHECK_EQ(recompute.saved_bytes(), numel * 4);
+  CHECK_EQ(recompute.dropped_bytes(), numel * 4);
+  auto* recompute_test_node = static_cast<RecomputeTestNode*>(
+      egr::EagerUtils::grad_node(et1).get());
+  CHECK_EQ(recompute_test_node->num_recomputes_, 0);
+  auto recovered = dropped.recover();
+  CHECK_EQ(recompute_test_node->num_recomputes_, 1);
+  CHECK_EQ(recovered.impl(), et1.impl());
+  CHECK_EQ(recompute.recomputed_flops(), numel * 4);
+  // Saved beyond the budget since it's too costly to recompute
+  FLAGS_eager_recompute_max_flops_per_byte = 0.5;
+  auto costly = egr::TensorWrapper(et2);
+  CHECK_EQ(recompute.saved_bytes(), numel * 4 * 2);
+  costly.clear();
+  shared.clear();
+  CHECK_EQ(recompute.saved_bytes(), numel * 4);
+  saved.clear();
+  CHECK_EQ(recompute.saved_bytes(), 0);
+  FLAGS_eager_recompute_max_flops_per_byte = 8.0;
+  FLAGS_eager_recompute_memory_budget_mb = -1;
+}
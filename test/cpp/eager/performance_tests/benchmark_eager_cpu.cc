@@ -17,12 +17,16 @@
 #include <paddle/fluid/framework/op_registry.h>
 
 #include <chrono>
+#include <cmath>
+#include <fstream>
 
 #include "gtest/gtest.h"
 #include "paddle/common/flags.h"
+#include "paddle/fluid/eager/activation_recompute.h"
 #include "paddle/fluid/eager/api/all.h"
 #include "paddle/fluid/eager/autograd_meta.h"
 #include "paddle/fluid/eager/backward.h"
+#include "paddle/fluid/eager/saved_tensors_pool.h"
 #include "paddle/fluid/imperative/tracer.h"
 #include "test/cpp/eager/performance_tests/benchmark_utils.h"
 #include "test/cpp/eager/test_utils.h"
@@ -33,6 +37,12 @@
 
 #include "paddle/phi/core/kernel_registry.h"
 
+COMMON_DECLARE_int32(eager_backward_num_threads);
+COMMON_DECLARE_string(eager_saved_tensors_compression);
+COMMON_DECLARE_int64(eager_saved_tensors_memory_budget_mb);
+COMMON_DECLARE_string(eager_saved_tensors_spill_dir);
+COMMON_DECLARE_int64(eager_recompute_memory_budget_mb);
+
 using namespace egr;            // NOLINT
 using namespace egr_utils_api;  // NOLINT
 
@@ -240,3 +250,273 @@ TEST(Benchmark, EagerIntermediateMLPCPU) {
     }
   }
 }
+
+TEST(Benchmark, EagerBackwardThreadsCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(phi::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  // The default engine, the engine on the calling thread and the engine
+  // running the branches on 4 threads.
+  for (int num_threads : {0, 1, BRANCHES_NUM_BRANCHES}) {
+    FLAGS_eager_backward_num_threads = num_threads;
+    for (const std::string mode : {"Accuracy", "Performance"}) {
+      phi::DDim ddim = common::make_ddim({BRANCHES_N, BRANCHES_N});
+      paddle::Tensor X =
+          eager_test::CreateTensorWithValue(ddim,
+                                            phi::CPUPlace(),
+                                            phi::DataType::FLOAT32,
+                                            phi::DataLayout::NCHW,
+                                            BRANCHES_X_VAL,
+                                            true);
+      RetainGradForTensor(X);
+
+      std::vector<paddle::Tensor> Ws;
+      for (size_t i = 0; i < BRANCHES_NUM_BRANCHES * BRANCHES_DEPTH; i++) {
+        Ws.emplace_back(
+            eager_test::CreateTensorWithValue(ddim,
+                                              phi::CPUPlace(),
+                                              phi::DataType::FLOAT32,
+                                              phi::DataLayout::NCHW,
+                                              BRANCHES_W_VAL,
+                                              true));
+      }
+
+      if (mode == "Accuracy") {
+        benchmark_eager_branches(X, Ws, true /* accuracy_check */);
+
+      } else if (mode == "Performance") {
+        auto t_start = std::chrono::high_resolution_clock::now();
+        benchmark_eager_branches(X, Ws);
+        auto t_end = std::chrono::high_resolution_clock::now();
+        double elapsed_time_ms =
+            std::chrono::duration<double, std::milli>(t_end - t_start).count();
+        std::cout << "Backward threads: " << num_threads
+                  << ", Duration: " << elapsed_time_ms << " ms" << std::endl;
+
+      } else {
+        PADDLE_THROW(phi::errors::Fatal("Unknown benchmark mode"));
+      }
+    }
+  }
+  FLAGS_eager_backward_num_threads = 0;
+}
+
+// The peak resident memory of the process in MB since the last call, or -1
+// if it's unknown.
+static double PeakResidentMB() {
+  double peak_mb = -1;
+  std::ifstream status("/proc/self/status");
+  for (std::string line; std::getline(status, line);) {
+    if (line.rfind("VmHWM:", 0) == 0) {
+      peak_mb = std::stod(line.substr(6)) / 1024;
+    }
+  }
+  std::ofstream("/proc/self/clear_refs") << "5";
+  return peak_mb;
+}
+
+TEST(Benchmark, EagerSavedTensorsCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(phi::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  // The weights of both signs, so that half of the activations are zeros
+  paddle::Tensor X =
+      create_pattern_tensor(common::make_ddim({SAVED_M, SAVED_N}), 1.0f, false);
+  std::vector<paddle::Tensor> Ws;
+  for (size_t i = 0; i < SAVED_NUM_LINEAR; i++) {
+    Ws.emplace_back(create_pattern_tensor(common::make_ddim({SAVED_N, SAVED_N}),
+                                          2.0f / std::sqrt(SAVED_N),
+                                          true));
+  }
+
+  // The grads of the weights after a step
+  auto leaf_grads = [&]() {
+    for (const auto& W : Ws) {
+      EagerUtils::unsafe_autograd_meta(W)->MutableGrad()->reset();
+    }
+    benchmark_eager_saved_tensors(X, Ws);
+    std::vector<std::vector<float>> grads;
+    for (const auto& W : Ws) {
+      auto* grad = static_cast<phi::DenseTensor*>(
+          EagerUtils::unsafe_autograd_meta(W)->Grad().impl().get());
+      grads.emplace_back(grad->data<float>(),
+                         grad->data<float>() + grad->numel());
+    }
+    return grads;
+  };
+
+  auto& pool = egr::SavedTensorsPool::Instance();
+  const int max_num_runs = 10;
+  // {compression, memory budget in MB}, "" and 0 save the tensors as they are
+  std::vector<std::pair<std::string, int64_t>> policies = {
+      {"", 0}, {"zero", 0}, {"bf16", 0}, {"fp8", 0}, {"", 16}, {"zero", 16}};
+  std::vector<std::vector<float>> expected_grads;
+  // Spilled to the working directory, in the build directory on disk
+  FLAGS_eager_saved_tensors_spill_dir = ".";
+  for (const auto& policy : policies) {
+    FLAGS_eager_saved_tensors_compression = policy.first;
+    FLAGS_eager_saved_tensors_memory_budget_mb = policy.second;
+    std::vector<std::vector<float>> grads = leaf_grads();
+    if (expected_grads.empty()) {
+      expected_grads = grads;
+    }
+    // The tensors saved in bf16 or fp8 give grads close to the baseline by
+    // their precision, the others the same grads
+    double tolerance = policy.first == "bf16"  ? 2e-2
+                       : policy.first == "fp8" ? 0.25
+                                               : 0.0;
+    ASSERT_EQ(grads.size(), expected_grads.size());
+    for (size_t i = 0; i < grads.size(); i++) {
+      ASSERT_EQ(grads[i].size(), expected_grads[i].size());
+      double error = 0, norm = 0;
+      for (size_t j = 0; j < grads[i].size(); j++) {
+        if (tolerance == 0) {
+          ASSERT_FLOAT_EQ(grads[i][j], expected_grads[i][j]);
+        }
+        error += std::pow(grads[i][j] - expected_grads[i][j], 2);
+        norm += std::pow(expected_grads[i][j], 2);
+      }
+      // The relative error of the grad of each weight
+      EXPECT_LE(std::sqrt(error), tolerance * std::sqrt(norm))
+          << "compression: \"" << policy.first << "\", weight " << i;
+    }
+    pool.ResetPeakMemoryBytes();
+    PeakResidentMB();
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < max_num_runs; i++) {
+      benchmark_eager_saved_tensors(X, Ws);
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double step_ms =
+        std::chrono::duration<double, std::milli>(t_end - t_start).count() /
+        max_num_runs;
+    std::cout << "Saved tensors compression: \"" << policy.first
+              << "\", budget: " << policy.second << " MB, step: " << step_ms
+              << " ms, peak packed: "
+              << pool.peak_memory_bytes() / (1024.0 * 1024.0)
+              << " MB, peak resident: " << PeakResidentMB() << " MB"
+              << std::endl;
+    ASSERT_EQ(pool.memory_bytes(), 0);
+    ASSERT_EQ(pool.spilled_bytes(), 0);
+  }
+  FLAGS_eager_saved_tensors_compression = "";
+  FLAGS_eager_saved_tensors_memory_budget_mb = 0;
+  FLAGS_eager_saved_tensors_spill_dir = "";
+}
+
+TEST(Benchmark, EagerRecomputeCPU) {
+  // Prepare Device Contexts
+  eager_test::InitEnv(phi::CPUPlace());
+
+  auto tracer = std::make_shared<paddle::imperative::Tracer>();
+  paddle::imperative::SetCurrentTracer(tracer);
+
+  paddle::Tensor X = create_pattern_tensor(
+      common::make_ddim({RECOMPUTE_M, RECOMPUTE_N}), 1.0f, false);
+  std::vector<paddle::Tensor> Ws;
+  for (size_t i = 0; i < RECOMPUTE_NUM_BLOCKS; i++) {
+    for (auto dims : {common::make_ddim({RECOMPUTE_N, 4 * RECOMPUTE_N}),
+                      common::make_ddim({4 * RECOMPUTE_N, RECOMPUTE_N})}) {
+      Ws.emplace_back(
+          create_pattern_tensor(dims, 1.0f / std::sqrt(dims[0]), true));
+    }
+  }
+  // The grad of the first weight after a step
+  auto first_grad = [&]() {
+    auto* meta = EagerUtils::unsafe_autograd_meta(Ws[0]);
+    meta->MutableGrad()->reset();
+    benchmark_eager_recompute(X, Ws);
+    auto* grad = static_cast<phi::DenseTensor*>(meta->Grad().impl().get());
+    return std::vector<float>(grad->data<float>(),
+                              grad->data<float>() + grad->numel());
+  };
+
+  auto& recompute = egr::ActivationRecompute::Instance();
+  const int max_num_runs = 10;
+  std::vector<float> expected_grad;
+  // The memory budgets in MB, the first one saves all the activations of
+  // about 18 MB and 0 recomputes all the cheap ones
+  for (int64_t budget : {1024, 12, 6, 0}) {
+    FLAGS_eager_recompute_memory_budget_mb = budget;
+    std::vector<float> grad = first_grad();
+    if (expected_grad.empty()) {
+      expected_grad = grad;
+    }
+    ASSERT_EQ(grad.size(), expected_grad.size());
+    for (size_t i = 0; i < grad.size(); i++) {
+      ASSERT_FLOAT_EQ(grad[i], expected_grad[i]);
+    }
+    recompute.ResetStats();
+    PeakResidentMB();
+
+    auto t_start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < max_num_runs; i++) {
+      benchmark_eager_recompute(X, Ws);
+    }
+    auto t_end = std::chrono::high_resolution_clock::now();
+    double step_ms =
+        std::chrono::duration<double, std::milli>(t_end - t_start).count() /
+        max_num_runs;
+    std::cout << "Recompute budget: " << budget << " MB, step: " << step_ms
+              << " ms, peak saved: "
+              << recompute.peak_saved_bytes() / (1024.0 * 1024.0)
+              << " MB, dropped: "
+              << recompute.dropped_bytes() / (1024.0 * 1024.0) / max_num_runs
+              << " MB, recomputed: "
+              << recompute.recomputed_flops() / 1e6 / max_num_runs
+              << " MFLOPs per step, peak resident: " << PeakResidentMB()
+              << " MB" << std::endl;
+    ASSERT_EQ(recompute.saved_bytes(), 0);
+  }
+  FLAGS_eager_recompute_memory_budget_mb = -1;
+}
+
+TEST(Benchmark, EagerKernelSelectionCPU) {
+  eager_test::InitEnv(phi::CPUPlace());
+
+  const int max_num_runs = 100000;
+  phi::KernelKey kernel_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+
+  // The kernel selection of every call of an api, before and after caching
+  // it at the call site.
+  auto t_start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < max_num_runs; i++) {
+    auto kernel_result =
+        phi::KernelFactory::Instance().SelectKernelOrThrowError(
+            "scale", kernel_key, true);
+    ASSERT_TRUE(kernel_result.kernel.IsValid());
+  }
+  auto t_end = std::chrono::high_resolution_clock::now();
+  double factory_ns =
+      std::chrono::duration<double, std::nano>(t_end - t_start).count() /
+      max_num_runs;
+
+  phi::KernelResultCache kernel_result_cache;
+  t_start = std::chrono::high_resolution_clock::now();
+  for (int i = 0; i < max_num_runs; i++) {
+    auto kernel_result =
+        kernel_result_cache.SelectKernelOrThrowError("scale", kernel_key, true);
+    ASSERT_TRUE(kernel_result.kernel.IsValid());
+  }
+  t_end = std::chrono::high_resolution_clock::now();
+  double cache_ns =
+      std::chrono::duration<double, std::nano>(t_end - t_start).count() /
+      max_num_runs;
+
+  EXPECT_EQ(&kernel_result_cache
+                 .SelectKernelOrThrowError("scale", kernel_key, true)
+                 .kernel,
+            &phi::KernelFactory::Instance()
+                 .SelectKernelOrThrowError("scale", kernel_key, true)
+                 .kernel);
+  std::cout << "Kernel selection per call: " << factory_ns
+            << " ns, cached: " << cache_ns << " ns" << std::endl;
+}
@@ -152,6 +152,92 @@ void benchmark_eager_intermediate_mlp(const paddle::Tensor& X,
   }
 }
 
+/* ------------------------ */
+/* ---- Eager Branches ---- */
+/* ------------------------ */
+void benchmark_eager_branches(const paddle::Tensor& X,
+                              const std::vector<paddle::Tensor>& Ws,
+                              bool accuracy_check) {
+  size_t max_num_runs = accuracy_check ? 1 : max_num_benchmark_runs / 40;
+  for (size_t i = 0; i < max_num_runs; i++) {
+    paddle::Tensor sum;
+    for (size_t b = 0; b < BRANCHES_NUM_BRANCHES; b++) {
+      paddle::Tensor input_tensor = X;
+      for (size_t d = 0; d < BRANCHES_DEPTH; d++) {
+        input_tensor = matmul_ad_func(
+            input_tensor, Ws[b * BRANCHES_DEPTH + d], false, false);
+      }
+      sum = b == 0 ? input_tensor
+                   : elementwise_add_dygraph_function(sum, input_tensor, {});
+    }
+    paddle::Tensor Out =
+        reduce_sum_dygraph_function(sum, {{"reduce_all", true}});
+
+    std::vector<paddle::Tensor> target_tensors = {Out};
+    Backward(target_tensors, {});
+
+    if (accuracy_check) {
+      // Every branch maps X to a matrix of ones
+      eager_test::CompareTensorWithValue<float>(
+          Out, BRANCHES_NUM_BRANCHES * BRANCHES_N * BRANCHES_N);
+      eager_test::CompareGradTensorWithValue<float>(X, BRANCHES_NUM_BRANCHES);
+    }
+  }
+}
+
+paddle::Tensor create_pattern_tensor(const phi::DDim& dims,
+                                     float scale,
+                                     bool is_leaf) {
+  paddle::Tensor tensor =
+      eager_test::CreateTensorWithValue(dims,
+                                        phi::CPUPlace(),
+                                        phi::DataType::FLOAT32,
+                                        phi::DataLayout::NCHW,
+                                        0.0,
+                                        is_leaf);
+  auto* dense = static_cast<phi::DenseTensor*>(tensor.impl().get());
+  float* data = dense->data<float>();
+  for (int64_t i = 0; i < dense->numel(); i++) {
+    data[i] = (static_cast<float>(i * 2654435761u % 2001) / 1000 - 1) * scale;
+  }
+  return tensor;
+}
+
+/* ----------------------------- */
+/* ---- Eager Saved Tensors ---- */
+/* ----------------------------- */
+void benchmark_eager_saved_tensors(const paddle::Tensor& X,
+                                   const std::vector<paddle::Tensor>& Ws) {
+  paddle::Tensor input_tensor = X;
+  for (const paddle::Tensor& W : Ws) {
+    input_tensor =
+        relu_ad_func(matmul_ad_func(input_tensor, W, false, false));
+  }
+  paddle::Tensor Out =
+      reduce_sum_dygraph_function(input_tensor, {{"reduce_all", true}});
+
+  std::vector<paddle::Tensor> target_tensors = {Out};
+  Backward(target_tensors, {});
+}
+
+/* ------------------------- */
+/* ---- Eager Recompute ---- */
+/* ------------------------- */
+void benchmark_eager_recompute(const paddle::Tensor& X,
+                               const std::vector<paddle::Tensor>& Ws) {
+  paddle::Tensor hidden = X;
+  for (size_t i = 0; i + 1 < Ws.size(); i += 2) {
+    paddle::Tensor ffn =
+        gelu_ad_func(matmul_ad_func(hidden, Ws[i], false, false), false);
+    hidden = add_ad_func(hidden, matmul_ad_func(ffn, Ws[i + 1], false, false));
+  }
+  paddle::Tensor Out =
+      reduce_sum_dygraph_function(hidden, {{"reduce_all", true}});
+
+  std::vector<paddle::Tensor> target_tensors = {Out};
+  Backward(target_tensors, {});
+}
+
 }  // namespace egr
 
 namespace paddle {
@@ -32,6 +32,28 @@
 #define MLP_B_VAL 3.0
 #define MLP_NUM_LINEAR 1000
 
+/* Branches Configurations */
+// Out = ReduceSum(X[N, N] x W[N, N] x ... x W[N, N] + ...)
+// with BRANCHES_NUM_BRANCHES independent chains of BRANCHES_DEPTH matmuls
+#define BRANCHES_N 128
+#define BRANCHES_X_VAL 1.0
+#define BRANCHES_W_VAL (1.0 / BRANCHES_N)
+#define BRANCHES_NUM_BRANCHES 4
+#define BRANCHES_DEPTH 8
+
+/* Saved Tensors Configurations */
+// Out = ReduceSum(Relu(... Relu(X[M, N] x W[N, N]) ... x W[N, N]))
+#define SAVED_M 256
+#define SAVED_N 1024
+#define SAVED_NUM_LINEAR 8
+
+/* Recompute Configurations */
+// H = H + Gelu(H[M, N] x W1[N, 4N]) x W2[4N, N] for RECOMPUTE_NUM_BLOCKS
+// feed forward blocks of transformer, Out = ReduceSum(H)
+#define RECOMPUTE_M 512
+#define RECOMPUTE_N 256
+#define RECOMPUTE_NUM_BLOCKS 4
+
 namespace egr {
 
 inline std::unordered_map<std::string, float> compute_mlp_expected_results() {
@@ -65,6 +87,28 @@ void benchmark_eager_intermediate_mlp(const paddle::Tensor& X,
                                       const std::vector<paddle::Tensor>& Bs,
                                       bool accuracy_check = false);
 
+/* ---- Eager Branches ---- */
+// Ws holds the BRANCHES_DEPTH weights of every branch in turn
+void benchmark_eager_branches(const paddle::Tensor& X,
+                              const std::vector<paddle::Tensor>& Ws,
+                              bool accuracy_check = false);
+
+// A float cpu tensor of dims, holding the same values of both signs in
+// [-scale, scale] on every run
+paddle::Tensor create_pattern_tensor(const phi::DDim& dims,
+                                     float scale,
+                                     bool is_leaf);
+
+/* ---- Eager Saved Tensors ---- */
+// A step of forward and backward, saving half zero activations
+void benchmark_eager_saved_tensors(const paddle::Tensor& X,
+                                   const std::vector<paddle::Tensor>& Ws);
+
+/* ---- Eager Recompute ---- */
+// A step of forward and backward, Ws holds W1 and W2 of every block in turn
+void benchmark_eager_recompute(const paddle::Tensor& X,
+                               const std::vector<paddle::Tensor>& Ws);
+
 }  // namespace egr
 
 namespace paddle {
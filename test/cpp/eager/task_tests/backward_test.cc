@@ -18,6 +18,7 @@
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/common/flags.h"
 #include "paddle/fluid/eager/accumulation/accumulation_node.h"
 #include "paddle/fluid/eager/api/all.h"
 #include "paddle/fluid/eager/api/generated/eager_generated/backwards/scale_node.h"
@@ -31,6 +32,8 @@
 PD_DECLARE_KERNEL(full, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 
+COMMON_DECLARE_int32(eager_backward_num_threads);
+
 namespace egr {
 
 TEST(Backward, SingleNodeEmptyGrad) {
@@ -342,4 +345,88 @@ TEST(Backward, WithAccumulation) {
   eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 2500.0);
 }
 
+// A node running the backward of another graph in its backward, like a
+// PyLayer calling backward, and passing its grads through.
+class NestedBackwardNode : public GradNodeBase {
+ public:
+  explicit NestedBackwardNode(const paddle::Tensor& inner_out)
+      : GradNodeBase(1, 1), inner_out_(inner_out) {}
+
+  paddle::small_vector<std::vector<paddle::Tensor>, kSlotSmallVectorSize>
+  operator()(paddle::small_vector<std::vector<paddle::Tensor>,
+                                  kSlotSmallVectorSize>& grads,  // NOLINT
+             bool create_graph = false,
+             bool is_new_grad = false) override {
+    Backward({inner_out_}, {});
+    return grads;
+  }
+
+  void ClearTensorWrappers() override {}
+
+  std::shared_ptr<GradNodeBase> Copy() const override {
+    return std::make_shared<NestedBackwardNode>(*this);
+  }
+
+  std::string name() override { return "NestedBackwardNode"; }
+
+ private:
+  paddle::Tensor inner_out_;
+};
+
+TEST(Backward, NestedBackwardOnThreads) {
+  eager_test::InitEnv(phi::CPUPlace());
+  phi::DDim ddim = common::make_ddim({4, 16});
+
+  paddle::Tensor inner_leaf =
+      eager_test::CreateTensorWithValue(ddim,
+                                        phi::CPUPlace(),
+                                        phi::DataType::FLOAT32,
+                                        phi::DataLayout::NCHW,
+                                        1.0 /*value*/,
+                                        true /*is_leaf*/);
+  egr_utils_api::RetainGradForTensor(inner_leaf);
+  paddle::Tensor inner_out = egr::scale(inner_leaf,
+                                        3.0 /*scale*/,
+                                        0.0 /*bias*/,
+                                        true /*bias_after_scale*/,
+                                        true /*trace_backward*/);
+
+  paddle::Tensor target_tensor =
+      eager_test::CreateTensorWithValue(ddim,
+                                        phi::CPUPlace(),
+                                        phi::DataType::FLOAT32,
+                                        phi::DataLayout::NCHW,
+                                        1.0 /*value*/,
+                                        false /*is_leaf*/);
+  paddle::Tensor leaf_tensor;
+  {
+    // target_tensor -> NestedBackwardNode -> leaf_tensor
+    auto node_ptr = std::make_shared<NestedBackwardNode>(inner_out);
+    node_ptr->SetDefaultGradInOutMeta();
+    AutogradMeta* auto_grad_meta = EagerUtils::autograd_meta(&target_tensor);
+    auto_grad_meta->SetGradNode(
+        std::dynamic_pointer_cast<GradNodeBase>(node_ptr));
+    auto_grad_meta->SetSingleOutRankWithSlot(0, 0);
+    auto_grad_meta->SetStopGradient(false);
+
+    AutogradMeta* auto_grad_meta1 = EagerUtils::autograd_meta(&leaf_tensor);
+    auto acc_node_ptr =
+        std::make_shared<egr::GradNodeAccumulation>(auto_grad_meta1);
+    auto_grad_meta1->SetGradNode(
+        std::dynamic_pointer_cast<GradNodeBase>(acc_node_ptr));
+    auto_grad_meta1->SetSingleOutRankWithSlot(0, 0);
+    auto_grad_meta1->SetStopGradient(false);
+    node_ptr->SetGradOutMeta(leaf_tensor, 0);
+  }
+
+  // The nested backward runs with the default engine instead of waiting for
+  // the threads taken by the outer backward.
+  FLAGS_eager_backward_num_threads = 2;
+  Backward({target_tensor}, {});
+  FLAGS_eager_backward_num_threads = 0;
+
+  eager_test::CompareGradTensorWithValue<float>(leaf_tensor, 1.0);
+  eager_test::CompareGradTensorWithValue<float>(inner_leaf, 3.0);
+}
+
 }  // namespace egr
@@ -0,0 +1,208 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/operators/string/faster_tokenizer_op.h"
+
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace operators {
+
+framework::Vocab MakeVocab() {
+  std::vector<std::wstring> tokens = {
+      L"[PAD]",   L"[UNK]", L"[CLS]", L"[SEP]",   L"[MASK]",  L"the",
+      L"quick",   L"brown", L"fox",   L"jump",    L"##s",     L"##ed",
+      L"##ing",   L"over",  L"lazy",  L"dog",     L"un",      L"##want",
+      L"##able",  L"a",     L"##b",   L"##c",     L"ab",      L"The",
+      L"Fox",     L",",     L".",     L"!",       L"?",       L"#",
+      L"中",  L"文", L"分", L"词", L"。", L"caf",
+      L"##é", L"é", L"na",  L"##ïve"};
+  framework::Vocab vocab;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    vocab.emplace(tokens[i], static_cast<int32_t>(i));
+  }
+  return vocab;
+}
+
+// The tokenization before WordPieceTrie, BasicTokenizer followed by
+// WordPieceTokenizer.
+void ReferenceTokenize(const framework::Vocab& vocab,
+                       bool do_lower_case,
+                       const std::string& text,
+                       std::vector<int64_t>* ids) {
+  BasicTokenizer basic_tokenizer(do_lower_case);
+  WordPieceTokenizer word_piece_tokenizer(&vocab);
+  std::vector<std::wstring> tokens;
+  basic_tokenizer.Tokenize(text, &tokens);
+  for (auto& token : tokens) {
+    if (token.size() == 1 && token[0] >= 0x4E00 && token[0] <= 0x9FFF) {
+      auto it = vocab.find(token);
+      ids->emplace_back(it != vocab.end() ? it->second : vocab.at(L"[UNK]"));
+    } else {
+      word_piece_tokenizer.Tokenize(token, ids);
+    }
+  }
+}
+
+std::vector<std::string> MakeCorpus(size_t num) {
+  std::vector<std::string> words = {
+      "the",   "The",    "THE",      "quick",   "brown",        "fox",
+      "Fox",   "jumps",  "jumped",   "jumping", "over",         "lazy",
+      "dog",   "dogs",   "unwant",   "unwantable", "abc",       "abcb",
+      "xyz",   "caf\xc3\xa9",         "na\xc3\xafve", "CAF\xc3\x89",
+      ",",     ".",      "!?",       "#tag",    "\xe4\xb8\xad\xe6\x96\x87",
+      "\xe5\x88\x86\xe8\xaf\x8d\xe3\x80\x82",  "\xe6\x97\xa5",
+      "\t",    "\n",     "\xe3\x80\x80",        "a\x01" "b",
+      "ab\xe2\x80\x8b" "c"};
+  std::mt19937 rng(2024);
+  std::uniform_int_distribution<size_t> word_dist(0, words.size() - 1);
+  std::uniform_int_distribution<size_t> len_dist(1, 64);
+  std::vector<std::string> corpus;
+  for (size_t i = 0; i < num; ++i) {
+    std::string text;
+    size_t len = len_dist(rng);
+    for (size_t j = 0; j < len; ++j) {
+      text += words[word_dist(rng)];
+      if (rng() % 3 != 0) {
+        text += " ";
+      }
+    }
+    corpus.emplace_back(std::move(text));
+  }
+  // a word longer than max_input_chars_per_word and malformed utf-8
+  corpus.emplace_back(std::string(150, 'a') + " fox");
+  corpus.emplace_back("fox \xe4\xb8");
+  corpus.emplace_back("fox \xe4\x41");
+  corpus.emplace_back("fox \xc0\xaf");
+  corpus.emplace_back("fox \xe4\x41 dog");
+  corpus.emplace_back("");
+  return corpus;
+}
+
+TEST(FasterTokenizer, SameAsReference) {
+  auto vocab = MakeVocab();
+  auto corpus = MakeCorpus(2000);
+  for (bool do_lower_case : {false, true}) {
+    BertTokenizer tokenizer(&vocab, do_lower_case);
+    for (auto& text : corpus) {
+      std::vector<int64_t> expected, actual;
+      ReferenceTokenize(vocab, do_lower_case, text, &expected);
+      tokenizer.Tokenize(text, &actual);
+      EXPECT_EQ(expected, actual) << text;
+    }
+  }
+}
+
+TEST(FasterTokenizer, BatchEncode) {
+  auto vocab = MakeVocab();
+  BertTokenizer tokenizer(&vocab, true);
+  framework::Strings text, text_pair;
+  text.push_back("The quick brown fox");
+  text.push_back("\xe4\xb8\xad\xe6\x96\x87");
+  text_pair.push_back("jumped over");
+  text_pair.push_back("");
+
+  std::vector<std::vector<int64_t>> input_ids, token_type_ids;
+  tokenizer.BatchEncode(
+      &input_ids, &token_type_ids, text, text_pair, false, 8, true);
+  ASSERT_EQ(input_ids.size(), 2UL);
+  // the longer sequence is truncated to fit max_seq_len
+  EXPECT_EQ(input_ids[0], std::vector<int64_t>({2, 5, 6, 7, 3, 9, 11, 3}));
+  EXPECT_EQ(token_type_ids[0], std::vector<int64_t>({0, 0, 0, 0, 0, 1, 1, 1}));
+  EXPECT_EQ(input_ids[1], std::vector<int64_t>({2, 30, 31, 3, 0, 0, 0, 0}));
+
+  std::vector<std::unordered_map<std::string, std::vector<int64_t>>> encoded(
+      2);
+  tokenizer.BatchEncode(&encoded, text, text_pair, false, 8, true);
+  EXPECT_EQ(encoded[0]["input_ids"], input_ids[0]);
+  EXPECT_EQ(encoded[1]["token_type_ids"], token_type_ids[1]);
+}
+
+TEST(FasterTokenizer, VocabUpdate) {
+  auto vocab = MakeVocab();
+  std::vector<int64_t> ids;
+  BertTokenizer(&vocab, false).Tokenize("foxes", &ids);
+  EXPECT_EQ(ids, std::vector<int64_t>({1}));
+
+  vocab.emplace(L"##es", 100);
+  ids.clear();
+  BertTokenizer(&vocab, false).Tokenize("foxes", &ids);
+  EXPECT_EQ(ids, std::vector<int64_t>({8, 100}));
+}
+
+TEST(FasterTokenizer, VocabMovedFrom) {
+  auto vocab = MakeVocab();
+  uint64_t version = vocab.version();
+  std::vector<int64_t> ids;
+  BertTokenizer(&vocab, false).Tokenize("foxes", &ids);
+  EXPECT_EQ(ids, std::vector<int64_t>({1}));
+
+  // the moved-from vocab is empty, its cached trie must not be reused
+  framework::Vocab other(std::move(vocab));
+  EXPECT_EQ(other.version(), version);
+  EXPECT_NE(vocab.version(), version);  // NOLINT
+  std::vector<std::wstring> tokens = {
+      L"[PAD]", L"[UNK]", L"[CLS]", L"[SEP]", L"[MASK]", L"fox"};
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    vocab.emplace(tokens[i], static_cast<int32_t>(i + 100));
+  }
+  ids.clear();
+  BertTokenizer(&vocab, false).Tokenize("fox", &ids);
+  EXPECT_EQ(ids, std::vector<int64_t>({105}));
+}
+
+TEST(FasterTokenizer, Benchmark) {
+  auto vocab = MakeVocab();
+  auto corpus = MakeCorpus(20000);
+  size_t total_bytes = 0;
+  for (auto& text : corpus) {
+    total_bytes += text.size();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  size_t reference_num = 0;
+  for (auto& text : corpus) {
+    std::vector<int64_t> ids;
+    ReferenceTokenize(vocab, true, text, &ids);
+    reference_num += ids.size();
+  }
+  double reference_sec = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+
+  BertTokenizer tokenizer(&vocab, true);
+  start = std::chrono::steady_clock::now();
+  size_t num = 0;
+  std::vector<int64_t> ids;
+  for (auto& text : corpus) {
+    ids.clear();
+    tokenizer.Tokenize(text, &ids);
+    num += ids.size();
+  }
+  double sec = std::chrono::duration<double>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  EXPECT_EQ(reference_num, num);
+
+  LOG(INFO) << "reference: " << total_bytes / reference_sec / 1e6
+            << " MB/s, trie: " << total_bytes / sec / 1e6 << " MB/s";
+}
+
+}  // namespace operators
+}  // namespace paddle
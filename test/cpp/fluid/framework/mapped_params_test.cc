@@ -0,0 +1,204 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/mapped_params.h"
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace framework {
+
+// Writes tensors of odd sizes and different dtypes the way save_combine does.
+std::vector<phi::DenseTensor> SaveParams(const std::string& path,
+                                         int64_t scale = 1) {
+  std::vector<phi::DenseTensor> tensors(4);
+  tensors[0].Resize({3, 7 * scale});
+  float* f = tensors[0].mutable_data<float>(phi::CPUPlace());
+  for (int64_t i = 0; i < tensors[0].numel(); ++i) {
+    f[i] = static_cast<float>(i) * 0.5f;
+  }
+  tensors[1].Resize({5});
+  int64_t* l = tensors[1].mutable_data<int64_t>(phi::CPUPlace());
+  for (int64_t i = 0; i < 5; ++i) {
+    l[i] = i * 1000;
+  }
+  tensors[1].set_lod({{0, 2, 5}});
+  tensors[2].Resize({1});
+  tensors[2].mutable_data<uint8_t>(phi::CPUPlace())[0] = 7;
+  tensors[3].Resize({129 * scale});
+  double* d = tensors[3].mutable_data<double>(phi::CPUPlace());
+  for (int64_t i = 0; i < tensors[3].numel(); ++i) {
+    d[i] = -static_cast<double>(i);
+  }
+
+  std::ofstream fout(path, std::ios::binary);
+  for (auto& tensor : tensors) {
+    SerializeToStream(fout, tensor);
+  }
+  return tensors;
+}
+
+void ExpectEqual(const phi::DenseTensor& a, const phi::DenseTensor& b) {
+  ASSERT_EQ(a.dims(), b.dims());
+  ASSERT_EQ(a.dtype(), b.dtype());
+  ASSERT_EQ(a.lod(), b.lod());
+  ASSERT_EQ(std::memcmp(a.data(), b.data(), a.memory_size()), 0);
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream fin(path, std::ios::binary);
+  std::stringstream ss;
+  ss << fin.rdbuf();
+  return ss.str();
+}
+
+TEST(MappedParams, LoadUnaligned) {
+  std::string path = "mapped_params_unaligned.pdiparams";
+  auto expected = SaveParams(path);
+  std::vector<phi::DenseTensor> tensors(expected.size());
+  std::vector<phi::DenseTensor*> outs;
+  for (auto& tensor : tensors) {
+    outs.push_back(&tensor);
+  }
+  auto stats = LoadCombinedParamsFromMappedFile(path, outs, phi::CPUPlace());
+  EXPECT_EQ(stats.tensor_num, expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ExpectEqual(tensors[i], expected[i]);
+  }
+  std::remove(path.c_str());
+}
+
+TEST(MappedParams, AlignAndMap) {
+  std::string path = "mapped_params.pdiparams";
+  std::string aligned_path = "mapped_params_aligned.pdiparams";
+  auto expected = SaveParams(path);
+  AlignCombinedParamsFile(path, aligned_path);
+
+  // the aligned file is still a valid params file
+  {
+    std::ifstream fin(aligned_path, std::ios::binary);
+    for (auto& tensor : expected) {
+      phi::DenseTensor loaded;
+      DeserializeFromStream(fin, &loaded);
+      ExpectEqual(loaded, tensor);
+    }
+    fin.peek();
+    EXPECT_TRUE(fin.eof());
+  }
+
+  std::string file_content = ReadFile(aligned_path);
+  std::vector<phi::DenseTensor> tensors(expected.size());
+  std::vector<phi::DenseTensor*> outs;
+  for (auto& tensor : tensors) {
+    outs.push_back(&tensor);
+  }
+  auto stats =
+      LoadCombinedParamsFromMappedFile(aligned_path, outs, phi::CPUPlace());
+  EXPECT_EQ(stats.tensor_num, expected.size());
+  EXPECT_EQ(stats.mapped_num, expected.size());
+  EXPECT_EQ(stats.copied_bytes, 0UL);
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ExpectEqual(tensors[i], expected[i]);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(tensors[i].data()) %
+                  kMappedParamsAlignment,
+              0UL);
+  }
+
+  // writes are private to the process
+  tensors[0].data<float>()[0] = 42.f;
+  EXPECT_EQ(ReadFile(aligned_path), file_content);
+
+  // aligning again keeps the file as is
+  std::string realigned_path = "mapped_params_realigned.pdiparams";
+  AlignCombinedParamsFile(aligned_path, realigned_path);
+  EXPECT_EQ(ReadFile(realigned_path), file_content);
+
+  // the mapping outlives the file
+  std::remove(path.c_str());
+  std::remove(aligned_path.c_str());
+  std::remove(realigned_path.c_str());
+  EXPECT_EQ(tensors[3].data<double>()[128], -128.);
+}
+
+TEST(MappedParams, PartialLoad) {
+  std::string path = "mapped_params_partial.pdiparams";
+  auto expected = SaveParams(path);
+  std::vector<phi::DenseTensor> tensors(expected.size() - 1);
+  std::vector<phi::DenseTensor*> outs;
+  for (auto& tensor : tensors) {
+    outs.push_back(&tensor);
+  }
+  EXPECT_ANY_THROW(
+      LoadCombinedParamsFromMappedFile(path, outs, phi::CPUPlace()));
+
+  tensors.resize(expected.size() + 1);
+  outs.clear();
+  for (auto& tensor : tensors) {
+    outs.push_back(&tensor);
+  }
+  EXPECT_ANY_THROW(
+      LoadCombinedParamsFromMappedFile(path, outs, phi::CPUPlace()));
+  std::remove(path.c_str());
+}
+
+TEST(MappedParams, LoadTime) {
+  std::string path = "mapped_params_large.pdiparams";
+  std::string aligned_path = "mapped_params_large_aligned.pdiparams";
+  auto expected = SaveParams(path, 1 << 20);
+  AlignCombinedParamsFile(path, aligned_path);
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::ifstream fin(aligned_path, std::ios::binary);
+    for (size_t i = 0; i < expected.size(); ++i) {
+      phi::DenseTensor loaded;
+      DeserializeFromStream(fin, &loaded);
+    }
+  }
+  double stream_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  std::vector<phi::DenseTensor> tensors(expected.size());
+  std::vector<phi::DenseTensor*> outs;
+  for (auto& tensor : tensors) {
+    outs.push_back(&tensor);
+  }
+  start = std::chrono::steady_clock::now();
+  auto stats =
+      LoadCombinedParamsFromMappedFile(aligned_path, outs, phi::CPUPlace());
+  double mmap_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  EXPECT_EQ(stats.mapped_num, expected.size());
+  LOG(INFO) << (stats.mapped_bytes >> 20) << " MB params, stream load "
+            << stream_ms << " ms, mmap load " << mmap_ms << " ms";
+  std::remove(path.c_str());
+  std::remove(aligned_path.c_str());
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,333 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "paddle/fluid/framework/data_feed.h"
+#include "paddle/fluid/framework/data_set.h"
+#include "paddle/fluid/framework/dataset_factory.h"
+
+namespace paddle {
+namespace framework {
+
+// fills a record the way the slot parser does, num feasigns per slot
+static void FillRecord(SlotRecord record, int slot_num, int num) {
+  std::vector<uint64_t> u64_values(num);
+  std::vector<float> float_values(num);
+  for (int i = 0; i < num; ++i) {
+    u64_values[i] = static_cast<uint64_t>(i);
+    float_values[i] = static_cast<float>(i);
+  }
+  for (int slot = 0; slot < slot_num; ++slot) {
+    record->slot_uint64_feasigns_.add_values(u64_values.data(), num);
+    record->slot_float_feasigns_.add_values(float_values.data(), num);
+  }
+}
+
+static int64_t MemoryBytes(const std::vector<SlotRecord>& records) {
+  int64_t bytes = 0;
+  for (auto* record : records) {
+    bytes += record->memory_bytes();
+  }
+  return bytes;
+}
+
+// waits until the release thread has moved the records written to the
+// channel into the shared free list
+static bool WaitForCapacity(SlotObjPool* pool, size_t expected) {
+  for (int i = 0; i < 1000; ++i) {
+    if (pool->capacity() == expected) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return pool->capacity() == expected;
+}
+
+// waits until the capacity of the pool stops changing, i.e. the release
+// thread has drained the channel
+static void WaitForRelease(SlotObjPool* pool) {
+  size_t last = pool->capacity();
+  for (int i = 0; i < 100; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    size_t now = pool->capacity();
+    if (now == last) {
+      return;
+    }
+    last = now;
+  }
+}
+
+// blocks the worker threads until released, so that their magazines stay
+// alive while the main thread inspects the pool
+class Latch {
+ public:
+  explicit Latch(int count) : count_(count) {}
+  void CountDown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--count_ == 0) {
+      cv_.notify_all();
+    }
+  }
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return count_ == 0; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int count_;
+};
+
+TEST(SlotObjPool, MultiThreadGetPut) {
+  const int kThreads = 8;
+  const int kBatch = 100;
+  const size_t kMaxCapacity = 500;
+  SlotObjPool pool(64);
+  pool.set_max_capacity(kMaxCapacity);
+
+  std::atomic<int> dirty_records(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&pool, &dirty_records, t]() {
+      std::vector<SlotRecord> records;
+      for (int round = 0; round < 50; ++round) {
+        pool.get(&records, kBatch);
+        for (auto* record : records) {
+          // records handed out again must have been reset
+          if (!record->slot_uint64_feasigns_.slot_values.empty() ||
+              !record->slot_float_feasigns_.slot_offsets.empty()) {
+            ++dirty_records;
+          }
+          FillRecord(record, 4, t + round % 7 + 1);
+        }
+        pool.put(&records);
+        EXPECT_TRUE(records.empty());
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(dirty_records.load(), 0);
+  // the exited threads returned their magazines to the shared free list
+  WaitForRelease(&pool);
+  ASSERT_GT(pool.capacity(), 0UL);
+  EXPECT_LE(pool.capacity(), kMaxCapacity);
+  EXPECT_GT(pool.memory_size(), 0);
+
+  std::vector<SlotRecord> records;
+  pool.get(&records, static_cast<int>(pool.capacity()));
+  for (auto* record : records) {
+    EXPECT_TRUE(record->slot_uint64_feasigns_.slot_values.empty());
+    EXPECT_TRUE(record->slot_float_feasigns_.slot_values.empty());
+  }
+  EXPECT_EQ(pool.capacity(), 0UL);
+  EXPECT_EQ(pool.memory_size(), 0);
+  for (auto* record : records) {
+    free_slotrecord(record);
+  }
+}
+
+TEST(SlotObjPool, DatasetMemoryAccounting) {
+  std::unique_ptr<Dataset> dataset =
+      DatasetFactory::CreateDataset("SlotRecordDataset");
+  SlotObjPool& pool = SlotRecordPool();
+  pool.clear();
+  EXPECT_EQ(dataset->GetRecordPoolMemorySize(), 0);
+
+  const int num = std::max(FLAGS_slotpool_local_cache_size / 2, 1);
+  std::vector<SlotRecord> records;
+  pool.get(&records, num);
+  for (auto* record : records) {
+    FillRecord(record, 8, 16);
+  }
+  // the feasign buffers are kept on reset, so the pool retains exactly the
+  // bytes of the records put back
+  int64_t bytes = MemoryBytes(records);
+  pool.put(&records);
+  if (FLAGS_slotpool_local_cache_size > 0) {
+    EXPECT_EQ(pool.memory_size(), bytes);
+  } else {
+    EXPECT_TRUE(WaitForCapacity(&pool, static_cast<size_t>(num)));
+  }
+  EXPECT_GT(pool.memory_size(), 0);
+  EXPECT_EQ(dataset->GetRecordPoolMemorySize(), pool.memory_size());
+
+  // records taken from the pool are no longer accounted to it
+  pool.get(&records, num);
+  EXPECT_EQ(dataset->GetRecordPoolMemorySize(), 0);
+  EXPECT_EQ(MemoryBytes(records), bytes);
+  pool.put(&records);
+  pool.clear();
+  EXPECT_EQ(dataset->GetRecordPoolMemorySize(), 0);
+
+  std::unique_ptr<Dataset> multi_slot_dataset =
+      DatasetFactory::CreateDataset("MultiSlotDataset");
+  EXPECT_EQ(multi_slot_dataset->GetRecordPoolMemorySize(), 0);
+}
+
+TEST(SlotObjPool, CapacityLimit) {
+  const size_t kMaxCapacity = 20;
+  SlotObjPool pool(16);
+  pool.set_max_capacity(kMaxCapacity);
+
+  // the magazine takes its local_cache_size, the rest overflows to the
+  // release thread, which frees what does not fit into max capacity
+  std::vector<SlotRecord> records;
+  pool.get(&records, 50);
+  pool.put(&records);
+  EXPECT_TRUE(WaitForCapacity(&pool, 16));
+
+  std::thread other([&]() {
+    std::vector<SlotRecord> records;
+    pool.get(&records, 10);
+    pool.put(&records);
+    // only the room left under max capacity is cached on this thread
+    EXPECT_EQ(pool.capacity(), kMaxCapacity);
+  });
+  other.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(pool.capacity(), kMaxCapacity);
+
+  // a pool without magazines enforces the limit in the release thread
+  SlotObjPool shared_pool(0);
+  shared_pool.set_max_capacity(kMaxCapacity);
+  shared_pool.get(&records, 15);
+  shared_pool.put(&records);
+  EXPECT_TRUE(WaitForCapacity(&shared_pool, 15));
+  for (int i = 0; i < 30; ++i) {
+    records.push_back(make_slotrecord());
+  }
+  shared_pool.put(&records);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_LE(shared_pool.capacity(), kMaxCapacity);
+  EXPECT_EQ(shared_pool.capacity(), 15UL);
+}
+
+TEST(SlotObjPool, ClearDropsAllThreads) {
+  const int kThreads = 4;
+  const int kCacheSize = 32;
+  SlotObjPool pool(kCacheSize);
+
+  Latch filled(kThreads);
+  Latch cleared(1);
+  Latch checked(kThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&]() {
+      std::vector<SlotRecord> records;
+      pool.get(&records, kCacheSize);
+      for (auto* record : records) {
+        FillRecord(record, 2, 8);
+      }
+      pool.put(&records);
+      filled.CountDown();
+      // stays alive with a full magazine until the pool is cleared
+      cleared.Wait();
+      // nothing is left in the magazine of this thread
+      pool.get(&records, 1);
+      EXPECT_TRUE(records[0]->slot_uint64_feasigns_.slot_values.empty());
+      EXPECT_EQ(records[0]->slot_uint64_feasigns_.slot_values.capacity(),
+                0UL);
+      free_slotrecord(records[0]);
+      checked.CountDown();
+    });
+  }
+  filled.Wait();
+  EXPECT_EQ(pool.capacity(), static_cast<size_t>(kThreads * kCacheSize));
+  EXPECT_GT(pool.memory_size(), 0);
+
+  pool.clear();
+  EXPECT_EQ(pool.capacity(), 0UL);
+  EXPECT_EQ(pool.memory_size(), 0);
+  cleared.CountDown();
+  checked.Wait();
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(pool.capacity(), 0UL);
+  EXPECT_EQ(pool.memory_size(), 0);
+}
+
+// Simulates the load of a SlotRecordDataset: the reader threads get a batch
+// of records, parse feasigns into them and hand them back after training.
+// Reports the load throughput and the peak of the bytes held by in-flight
+// and pooled records, with the pool and with malloc/free of every record.
+static void RunLoad(bool use_pool, double* records_per_sec, int64_t* peak) {
+  const int kThreads = 4;
+  const int kRounds = 200;
+  const int kBatch = 256;
+  SlotObjPool pool(use_pool ? 1024 : 0);
+  pool.disable_pool(!use_pool);
+
+  std::atomic<int64_t> in_flight(0);
+  std::atomic<int64_t> peak_bytes(0);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      std::vector<SlotRecord> records;
+      for (int round = 0; round < kRounds; ++round) {
+        pool.get(&records, kBatch);
+        for (auto* record : records) {
+          FillRecord(record, 16, 4 + (round + t) % 29);
+        }
+        int64_t bytes = MemoryBytes(records);
+        int64_t total = (in_flight += bytes) + pool.memory_size();
+        int64_t prev = peak_bytes.load();
+        while (total > prev &&
+               !peak_bytes.compare_exchange_weak(prev, total)) {
+          // prev is reloaded by the failed exchange
+        }
+        in_flight -= bytes;
+        pool.put(&records);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  *records_per_sec = kThreads * kRounds * kBatch / seconds;
+  *peak = peak_bytes.load();
+}
+
+TEST(SlotObjPool, LoadBenchmark) {
+  double pooled_rate = 0, unpooled_rate = 0;
+  int64_t pooled_peak = 0, unpooled_peak = 0;
+  RunLoad(false, &unpooled_rate, &unpooled_peak);
+  RunLoad(true, &pooled_rate, &pooled_peak);
+  LOG(INFO) << "slot record load: pool " << pooled_rate
+            << " records/s, peak " << pooled_peak << " bytes; malloc "
+            << unpooled_rate << " records/s, peak " << unpooled_peak
+            << " bytes";
+  EXPECT_GT(pooled_rate, 0);
+  EXPECT_GT(pooled_peak, 0);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,98 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/common/flags.h"
+#include "paddle/fluid/inference/capi_exp/pd_inference_api.h"
+
+PD_DEFINE_string(infer_model, "", "model path");
+
+namespace paddle {
+namespace inference {
+namespace analysis {
+
+struct AsyncRuns {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<int32_t> output_sizes;
+};
+
+void OnRunDone(void* user_data,
+               PD_Bool success,
+               PD_Tensor** outputs,
+               size_t output_num) {
+  auto* runs = static_cast<AsyncRuns*>(user_data);
+  EXPECT_TRUE(success);
+  EXPECT_EQ(output_num, 1u);
+  PD_OneDimArrayInt32* shape = PD_TensorGetShape(outputs[0]);
+  int32_t out_size = 1;
+  for (size_t i = 0; i < shape->size; ++i) {
+    out_size *= shape->data[i];
+  }
+  std::vector<float> out_data(out_size);
+  PD_TensorCopyToCpuFloat(outputs[0], out_data.data());
+  PD_OneDimArrayInt32Destroy(shape);
+
+  std::lock_guard<std::mutex> lock(runs->mutex);
+  runs->output_sizes.push_back(out_size);
+  runs->cv.notify_all();
+}
+
+TEST(PD_PredictorRunAsync, resnet50) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  PD_Config* config = PD_ConfigCreate();
+  PD_ConfigDisableGpu(config);
+  PD_ConfigSetModel(config,
+                    (model_dir + "/model").c_str(),
+                    (model_dir + "/params").c_str());
+  PD_Predictor* predictor = PD_PredictorCreate(config);
+  PD_OneDimArrayCstr* input_names = PD_PredictorGetInputNames(predictor);
+  PD_Tensor* input =
+      PD_PredictorGetInputHandle(predictor, input_names->data[0]);
+
+  AsyncRuns runs;
+  const size_t run_num = 4;
+  std::array<int32_t, 4> shape = {1, 3, 224, 224};
+  std::vector<float> data(1 * 3 * 224 * 224);
+  for (size_t i = 0; i < run_num; ++i) {
+    std::fill(data.begin(), data.end(), static_cast<float>(i) / run_num);
+    PD_TensorReshape(input, 4, shape.data());
+    PD_TensorCopyFromCpuFloat(input, data.data());
+    PD_PredictorRunAsync(predictor, OnRunDone, &runs);
+  }
+  {
+    std::unique_lock<std::mutex> lock(runs.mutex);
+    runs.cv.wait(lock, [&] { return runs.output_sizes.size() == run_num; });
+  }
+  for (int32_t out_size : runs.output_sizes) {
+    EXPECT_EQ(out_size, 1000);
+  }
+
+  PD_TensorDestroy(input);
+  PD_OneDimArrayCstrDestroy(input_names);
+  PD_PredictorDestroy(predictor);
+}
+
+}  // namespace analysis
+}  // namespace inference
+}  // namespace paddle
@@ -0,0 +1,87 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+std::string InputName(int i) { return "placeholder_" + std::to_string(i); }
+
+Config GetConfig(bool memory_optim, bool pir) {
+  Config config;
+  config.SetModel(FLAGS_infer_model);
+  config.DisableGpu();
+  config.EnableNewIR(pir);
+  config.EnableNewExecutor(pir);
+  config.SwitchIrOptim(true);
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_num_threads);
+  if (memory_optim) {
+    config.EnableMemoryOptim();
+  }
+  return config;
+}
+
+std::vector<float> RunOnce(Predictor* predictor, int len) {
+  std::vector<int> shape = {1, len, 1};
+  std::vector<int64_t> src_ids(len), sent_ids(len, 0), pos_ids(len);
+  for (int i = 0; i < len; ++i) {
+    src_ids[i] = 1 + (i * 37) % 1000;
+    pos_ids[i] = i;
+  }
+  std::vector<float> mask(len, 1.f);
+  const std::vector<int64_t>* ids[] = {&src_ids, &sent_ids, &pos_ids};
+  for (int i = 0; i < 3; ++i) {
+    auto handle = predictor->GetInputHandle(InputName(i));
+    handle->Reshape(shape);
+    handle->CopyFromCpu(ids[i]->data());
+  }
+  auto mask_handle = predictor->GetInputHandle(InputName(3));
+  mask_handle->Reshape(shape);
+  mask_handle->CopyFromCpu(mask.data());
+  EXPECT_TRUE(predictor->Run());
+
+  auto output = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto out_shape = output->shape();
+  std::vector<float> out(std::accumulate(
+      out_shape.begin(), out_shape.end(), 1, std::multiplies<int>()));
+  output->CopyToCpu(out.data());
+  return out;
+}
+
+// The memory_optimize_pass logs the peaks of the legacy program, the pir
+// executor those of the pir program when it makes its plan, for the longer
+// sequences again.
+void ExpectSameOutputs(bool pir) {
+  auto base = CreatePredictor(GetConfig(false, pir));
+  auto planned = CreatePredictor(GetConfig(true, pir));
+  for (int len : {16, 16, 64, 30, 128, 16}) {
+    auto expected = RunOnce(base.get(), len);
+    auto out = RunOnce(planned.get(), len);
+    ASSERT_EQ(out.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(out[i], expected[i], 1e-5);
+    }
+  }
+}
+
+TEST(MemoryOffsetPlan, ernie_same_outputs) { ExpectSameOutputs(false); }
+
+TEST(MemoryOffsetPlan, ernie_pir_same_outputs) { ExpectSameOutputs(true); }
+
+}  // namespace paddle_infer
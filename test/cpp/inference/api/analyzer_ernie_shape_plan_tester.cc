@@ -0,0 +1,160 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+const std::vector<int> kSeqLenBuckets = {16, 32, 64, 128};
+
+std::string InputName(int i) { return "placeholder_" + std::to_string(i); }
+
+Config GetConfig(bool plan_cache, bool buckets) {
+  Config config;
+  config.SetModel(FLAGS_infer_model);
+  config.DisableGpu();
+  config.EnableNewIR(true);
+  config.EnableNewExecutor(true);
+  config.SwitchIrOptim(true);
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_num_threads);
+  if (plan_cache) {
+    config.EnableShapePlanCache();
+  }
+  if (buckets) {
+    config.SetShapeBuckets(
+        {InputName(0), InputName(1), InputName(2), InputName(3)},
+        kSeqLenBuckets);
+  }
+  return config;
+}
+
+// Sequence lengths of short text requests, log-normal around 40 tokens.
+std::vector<int> SampleLengths(int num) {
+  std::mt19937 gen(2024);
+  std::lognormal_distribution<double> dist(std::log(40.), 0.6);
+  std::vector<int> lens(num);
+  for (auto& len : lens) {
+    len = std::min(128, std::max(4, static_cast<int>(dist(gen))));
+  }
+  return lens;
+}
+
+std::vector<float> RunOnce(Predictor* predictor, int len) {
+  std::vector<int> shape = {1, len, 1};
+  std::vector<int64_t> src_ids(len), sent_ids(len, 0), pos_ids(len);
+  for (int i = 0; i < len; ++i) {
+    src_ids[i] = 1 + (i * 37) % 1000;
+    pos_ids[i] = i;
+  }
+  std::vector<float> mask(len, 1.f);
+  const std::vector<int64_t>* ids[] = {&src_ids, &sent_ids, &pos_ids};
+  for (int i = 0; i < 3; ++i) {
+    auto handle = predictor->GetInputHandle(InputName(i));
+    handle->Reshape(shape);
+    handle->CopyFromCpu(ids[i]->data());
+  }
+  auto mask_handle = predictor->GetInputHandle(InputName(3));
+  mask_handle->Reshape(shape);
+  mask_handle->CopyFromCpu(mask.data());
+  EXPECT_TRUE(predictor->Run());
+
+  auto output = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto out_shape = output->shape();
+  std::vector<float> out(std::accumulate(
+      out_shape.begin(), out_shape.end(), 1, std::multiplies<int>()));
+  output->CopyToCpu(out.data());
+  return out;
+}
+
+TEST(ShapePlanCache, ernie_same_outputs) {
+  auto base = CreatePredictor(GetConfig(false, false));
+  auto cached = CreatePredictor(GetConfig(true, false));
+  auto bucketed = CreatePredictor(GetConfig(true, true));
+  for (int len : {7, 30, 7, 64, 100, 30}) {
+    auto expected = RunOnce(base.get(), len);
+    auto cached_out = RunOnce(cached.get(), len);
+    auto bucketed_out = RunOnce(bucketed.get(), len);
+    ASSERT_EQ(cached_out.size(), expected.size());
+    ASSERT_EQ(bucketed_out.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(cached_out[i], expected[i]);
+      // the padding is masked out
+      EXPECT_NEAR(bucketed_out[i], expected[i], 1e-4);
+    }
+  }
+  auto stats = cached->GetShapePlanCacheStats();
+  EXPECT_EQ(stats.hit_num, 2UL);
+  EXPECT_EQ(stats.plan_num, 4UL);
+  // 7 and 30 fall into buckets 16 and 32, 64 and 100 into 64 and 128
+  stats = bucketed->GetShapePlanCacheStats();
+  EXPECT_EQ(stats.hit_num, 2UL);
+  EXPECT_EQ(stats.plan_num, 4UL);
+  // the caller gets the inputs it fed back
+  for (int i = 0; i < 4; ++i) {
+    auto shape = bucketed->GetInputHandle(InputName(i))->shape();
+    EXPECT_EQ(shape, std::vector<int>({1, 30, 1}));
+  }
+
+  // the clones replay the plans of the predictor they are cloned from
+  auto clone = cached->Clone();
+  auto expected = RunOnce(base.get(), 64);
+  auto clone_out = RunOnce(clone.get(), 64);
+  ASSERT_EQ(clone_out.size(), expected.size());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(clone_out[i], expected[i]);
+  }
+  stats = clone->GetShapePlanCacheStats();
+  EXPECT_EQ(stats.hit_num, 3UL);
+  EXPECT_EQ(stats.plan_num, 4UL);
+}
+
+TEST(ShapePlanCache, ernie_length_distribution) {
+  const int request_num = 200;
+  auto lens = SampleLengths(request_num);
+  const char* mode_names[] = {
+      "no plan cache", "plan cache", "plan cache, buckets"};
+  for (auto mode : {0, 1, 2}) {
+    auto predictor = CreatePredictor(GetConfig(mode > 0, mode > 1));
+    std::vector<double> latencies;
+    for (int len : lens) {
+      auto start = std::chrono::steady_clock::now();
+      RunOnce(predictor.get(), len);
+      latencies.push_back(std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+    }
+    double mean =
+        std::accumulate(latencies.begin(), latencies.end(), 0.) / request_num;
+    std::sort(latencies.begin(), latencies.end());
+    auto stats = predictor->GetShapePlanCacheStats();
+    LOG(INFO) << mode_names[mode] << ": mean " << mean << " ms, p50 "
+              << latencies[request_num * 50 / 100] << " ms, p99 "
+              << latencies[request_num * 99 / 100] << " ms, hit rate "
+              << stats.hit_rate() << ", plans " << stats.plan_num;
+    if (mode == 2) {
+      EXPECT_LE(stats.plan_num, kSeqLenBuckets.size());
+    }
+  }
+}
+
+}  // namespace paddle_infer
@@ -19,6 +19,7 @@ limitations under the License. */
 #include "test/cpp/inference/api/tester_helper.h"
 
 PD_DEFINE_bool(enable_mkldnn, true, "Enable MKLDNN");
+PD_DEFINE_bool(enable_pir, false, "Quantize the PIR program");
 
 namespace paddle {
 namespace inference {
@@ -36,6 +37,10 @@ void SetConfig(AnalysisConfig *cfg) {
   cfg->SwitchSpecifyInputNames();
   cfg->SetCpuMathLibraryNumThreads(FLAGS_cpu_num_threads);
   if (FLAGS_enable_mkldnn) cfg->EnableMKLDNN();
+  if (FLAGS_enable_pir) {
+    cfg->EnableNewIR();
+    cfg->EnableNewExecutor();
+  }
 }
 
 TEST(Analyzer_int8_image_classification, quantization) {
@@ -55,9 +60,12 @@ TEST(Analyzer_int8_image_classification, quantization) {
     std::shared_ptr<std::vector<PaddleTensor>> warmup_data =
         ::paddle::inference::GetWarmupData(input_slots_all);
 
-    // INT8 implies FC oneDNN passes to be used
-    q_cfg.pass_builder()->AppendPass("fc_onednn_pass");
-    q_cfg.pass_builder()->AppendPass("fc_act_onednn_fuse_pass");
+    // INT8 implies FC oneDNN passes to be used, the PIR passes of oneDNN
+    // enable them already
+    if (!FLAGS_enable_pir) {
+      q_cfg.pass_builder()->AppendPass("fc_onednn_pass");
+      q_cfg.pass_builder()->AppendPass("fc_act_onednn_fuse_pass");
+    }
 
     // configure quantizer
     q_cfg.EnableMkldnnQuantizer();
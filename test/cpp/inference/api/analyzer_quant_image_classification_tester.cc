@@ -12,13 +12,16 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <chrono>
 #include <fstream>
 #include <iostream>
 
+#include "paddle/common/flags.h"
 #include "paddle/fluid/inference/api/paddle_analysis_config.h"
 #include "test/cpp/inference/api/tester_helper.h"
 
 PD_DEFINE_bool(enable_mkldnn, true, "Enable MKLDNN");
+COMMON_DECLARE_bool(pir_combine_pattern_passes);
 
 namespace paddle {
 namespace inference {
@@ -138,6 +141,36 @@ TEST(Analyzer_quant_image_classification, quantization) {
       &fp32_cfg, &int8_cfg, input_slots_all, FLAGS_with_accuracy_layer, 1);
 }
 
+// The dequant passes leading the pipeline run as one pass, which gives the
+// same outputs as running them one after another.
+TEST(Analyzer_quant_image_classification, combined_pattern_passes) {
+  AnalysisConfig cfg;
+  SetConfig(&cfg, FLAGS_int8_model);
+
+  std::vector<std::vector<PaddleTensor>> input_slots_all;
+  SetInput(&input_slots_all);
+  ASSERT_FALSE(input_slots_all.empty());
+
+  std::vector<PaddleTensor> outputs[2];
+  double seconds[2];
+  for (int combine = 0; combine < 2; ++combine) {
+    FLAGS_pir_combine_pattern_passes = combine;
+    // The passes run when the predictor is created.
+    auto start = std::chrono::steady_clock::now();
+    auto predictor = CreateTestPredictor(
+        reinterpret_cast<const PaddlePredictor::Config *>(&cfg));
+    seconds[combine] = std::chrono::duration<double>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    ASSERT_TRUE(predictor->Run(input_slots_all[0], &outputs[combine]));
+  }
+  FLAGS_pir_combine_pattern_passes = true;
+  CompareResult(outputs[1], outputs[0]);
+  LOG(INFO) << "Predictor with the passes one after another: "
+            << seconds[0] * 1000 << " ms, combined: " << seconds[1] * 1000
+            << " ms";
+}
+
 }  // namespace analysis
 }  // namespace inference
 }  // namespace paddle
@@ -49,6 +49,12 @@ class MkldnnQuantizerTest : public testing::Test {
     return mkldnn_quantizer->GetMaxScalingFactor(var_tensor, is_unsigned);
   }
 
+  std::pair<bool, phi::DenseTensor> GetPercentileScalingFactor(
+      const phi::DenseTensor& var_tensor, bool is_unsigned) const {
+    return mkldnn_quantizer->GetPercentileScalingFactor(var_tensor,
+                                                        is_unsigned);
+  }
+
   std::pair<bool, phi::DenseTensor> GetMaxChScalingFactor(
       const phi::DenseTensor& var_tensor, bool is_unsigned) const {
     return mkldnn_quantizer->GetMaxChScalingFactor(var_tensor, is_unsigned, 0);
@@ -252,6 +258,30 @@ TEST_F(MkldnnQuantizerTest, max_scaling_factor_unsigned) {
   ASSERT_NEAR(lod_tensor.data<double>()[0], 1.0 / max_val, abs_error);
 }
 
+TEST_F(MkldnnQuantizerTest, percentile_scaling_factor_unsigned) {
+  // a single outlier above the 99.99th percentile
+  const int64_t numel = 20000;
+  phi::DenseTensor var_tensor;
+  var_tensor.Resize(common::make_dim(numel));
+  auto* data = var_tensor.mutable_data<float>(phi::CPUPlace());
+  for (int64_t i = 0; i < numel - 1; ++i) {
+    data[i] = static_cast<float>(i) / numel;
+  }
+  data[numel - 1] = 100.f;
+
+  bool is_unsigned;
+  phi::DenseTensor lod_tensor;
+
+  std::tie(is_unsigned, lod_tensor) =
+      GetPercentileScalingFactor(var_tensor, true);
+
+  ASSERT_EQ(is_unsigned, true);
+  ASSERT_EQ(lod_tensor.numel(), 1);
+  ASSERT_NEAR(lod_tensor.data<double>()[0],
+              static_cast<double>(numel) / (numel - 2),
+              abs_error);
+}
+
 TEST_F(MkldnnQuantizerTest, max_scaling_factor_chwise_unsigned) {
   const auto& values = non_negative_values;
   auto max_val = *std::max_element(values.begin(), values.end());
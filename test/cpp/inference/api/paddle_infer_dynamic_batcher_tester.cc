@@ -0,0 +1,320 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <numeric>
+#include <stdexcept>
+#include <thread>  // NOLINT
+
+#include "paddle/fluid/inference/api/paddle_dynamic_batcher.h"
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+namespace services {
+
+using Tensors = DynamicBatcher::Tensors;
+
+template <typename T>
+paddle::PaddleTensor MakeTensor(const std::string& name,
+                                const std::vector<int>& shape,
+                                const std::vector<T>& data,
+                                DataType dtype) {
+  paddle::PaddleTensor tensor;
+  tensor.name = name;
+  tensor.shape = shape;
+  tensor.dtype = dtype;
+  tensor.data.Resize(data.size() * sizeof(T));
+  std::memcpy(tensor.data.data(), data.data(), data.size() * sizeof(T));
+  return tensor;
+}
+
+// Doubles input "x" of shape [N, 4] and outputs the batch size as [1].
+void DoubleRun(const Tensors& inputs, Tensors* outputs) {
+  auto& x = inputs[0];
+  const float* x_data = static_cast<const float*>(x.data.data());
+  std::vector<float> y(x.data.length() / sizeof(float));
+  for (size_t i = 0; i < y.size(); ++i) {
+    y[i] = x_data[i] * 2;
+  }
+  outputs->push_back(MakeTensor("y", x.shape, y, DataType::FLOAT32));
+  outputs->push_back(MakeTensor(
+      "batch_size", {1}, std::vector<int32_t>{x.shape[0]}, DataType::INT32));
+}
+
+TEST(DynamicBatcher, coalesce_and_scatter) {
+  DynamicBatcherConfig config;
+  config.max_batch_size = 16;
+  config.max_queue_delay_us = 20000;
+  DynamicBatcher batcher({DoubleRun, DoubleRun}, config);
+
+  const int thread_num = 8, request_num = 32;
+  std::vector<std::thread> threads;
+  std::atomic<int> max_batch_size{0};
+  for (int t = 0; t < thread_num; ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < request_num; ++i) {
+        float v = static_cast<float>(t * request_num + i);
+        auto outputs = batcher
+                           .Submit({MakeTensor("x",
+                                               {1, 4},
+                                               std::vector<float>(4, v),
+                                               DataType::FLOAT32)})
+                           .get();
+        ASSERT_EQ(outputs.size(), 2UL);
+        ASSERT_EQ(outputs[0].shape, std::vector<int>({1, 4}));
+        const float* y = static_cast<const float*>(outputs[0].data.data());
+        for (int j = 0; j < 4; ++j) {
+          ASSERT_EQ(y[j], v * 2);
+        }
+        int batch_size = *static_cast<int32_t*>(outputs[1].data.data());
+        ASSERT_LE(batch_size, config.max_batch_size);
+        int current = max_batch_size.load();
+        while (batch_size > current &&
+               !max_batch_size.compare_exchange_weak(current, batch_size)) {
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto stats = batcher.GetStats();
+  EXPECT_EQ(stats.request_num, static_cast<uint64_t>(thread_num * request_num));
+  EXPECT_EQ(stats.row_num, stats.request_num);
+  EXPECT_LT(stats.batch_num, stats.request_num);
+  EXPECT_GT(max_batch_size.load(), 1);
+}
+
+// Outputs the sum of every row of the padded input "ids" and its length.
+TEST(DynamicBatcher, padding_and_buckets) {
+  std::mutex mutex;
+  std::vector<int> run_lens;
+  auto run = [&](const Tensors& inputs, Tensors* outputs) {
+    auto& ids = inputs[0];
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      run_lens.push_back(ids.shape[1]);
+    }
+    const int64_t* data = static_cast<const int64_t*>(ids.data.data());
+    std::vector<int64_t> sums(ids.shape[0]);
+    for (int i = 0; i < ids.shape[0]; ++i) {
+      sums[i] = std::accumulate(
+          data + i * ids.shape[1], data + (i + 1) * ids.shape[1], int64_t(0));
+    }
+    outputs->push_back(
+        MakeTensor("sum", {ids.shape[0]}, sums, DataType::INT64));
+  };
+
+  DynamicBatcherConfig config;
+  config.max_batch_size = 8;
+  config.max_queue_delay_us = 5000;
+  config.padded_inputs = {"ids"};
+  config.pad_value = 1000;
+  config.seq_len_buckets = {4, 16};
+  DynamicBatcher batcher({run}, config);
+
+  std::vector<int> lens = {1, 3, 4, 5, 9, 16, 2, 20};
+  std::vector<std::future<Tensors>> futures;
+  for (int len : lens) {
+    std::vector<int64_t> ids(len, 1);
+    futures.push_back(batcher.Submit(
+        {MakeTensor("ids", {1, len}, ids, DataType::INT64)}));
+  }
+  for (size_t i = 0; i < lens.size(); ++i) {
+    auto outputs = futures[i].get();
+    int bucket = lens[i] <= 4 ? 4 : (lens[i] <= 16 ? 16 : lens[i]);
+    int64_t sum = *static_cast<int64_t*>(outputs[0].data.data());
+    EXPECT_EQ(sum, lens[i] + (bucket - lens[i]) * 1000) << lens[i];
+  }
+  for (int len : run_lens) {
+    EXPECT_TRUE(len == 4 || len == 16 || len == 20) << len;
+  }
+  EXPECT_GT(batcher.GetStats().padding_num, 0UL);
+}
+
+TEST(DynamicBatcher, full_queue_runs_first) {
+  DynamicBatcherConfig config;
+  config.max_batch_size = 2;
+  config.max_queue_delay_us = 60 * 1000 * 1000;
+  DynamicBatcher batcher({DoubleRun}, config);
+
+  // an older request of another shape waits for its deadline, the full
+  // queue behind it runs at once
+  auto waiting = batcher.Submit(
+      {MakeTensor("x", {1, 2}, std::vector<float>(2, 1.f), DataType::FLOAT32)});
+  std::vector<std::future<Tensors>> futures;
+  for (int i = 0; i < 2; ++i) {
+    futures.push_back(batcher.Submit({MakeTensor(
+        "x", {1, 4}, std::vector<float>(4, 1.f), DataType::FLOAT32)}));
+  }
+  for (auto& future : futures) {
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(10)),
+              std::future_status::ready);
+    auto outputs = future.get();
+    EXPECT_EQ(*static_cast<int32_t*>(outputs[1].data.data()), 2);
+  }
+  EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds(0)),
+            std::future_status::timeout);
+}
+
+// Outputs "x" with one sequence of x[i][0] + 1 rows for every row i.
+TEST(DynamicBatcher, scatter_lod) {
+  auto run = [](const Tensors& inputs, Tensors* outputs) {
+    auto& x = inputs[0];
+    const float* x_data = static_cast<const float*>(x.data.data());
+    std::vector<float> y;
+    std::vector<size_t> offsets = {0};
+    for (int i = 0; i < x.shape[0]; ++i) {
+      int len = static_cast<int>(x_data[i]) + 1;
+      y.insert(y.end(), len, x_data[i]);
+      offsets.push_back(offsets.back() + len);
+    }
+    outputs->push_back(MakeTensor(
+        "y", {static_cast<int>(y.size()), 1}, y, DataType::FLOAT32));
+    outputs->back().lod = {offsets};
+  };
+  DynamicBatcherConfig config;
+  config.max_batch_size = 3;
+  config.max_queue_delay_us = 60 * 1000 * 1000;
+  DynamicBatcher batcher({run}, config);
+
+  auto first = batcher.Submit(
+      {MakeTensor("x", {1, 1}, std::vector<float>{2.f}, DataType::FLOAT32)});
+  auto second = batcher.Submit({MakeTensor(
+      "x", {2, 1}, std::vector<float>{0.f, 1.f}, DataType::FLOAT32)});
+  auto outputs = first.get();
+  EXPECT_EQ(outputs[0].shape, std::vector<int>({3, 1}));
+  EXPECT_EQ(outputs[0].lod,
+            std::vector<std::vector<size_t>>({std::vector<size_t>{0, 3}}));
+  outputs = second.get();
+  EXPECT_EQ(outputs[0].shape, std::vector<int>({3, 1}));
+  EXPECT_EQ(outputs[0].lod,
+            std::vector<std::vector<size_t>>({std::vector<size_t>{0, 1, 3}}));
+  const float* y = static_cast<const float*>(outputs[0].data.data());
+  EXPECT_EQ(std::vector<float>(y, y + 3), std::vector<float>({0.f, 1.f, 1.f}));
+}
+
+TEST(DynamicBatcher, error) {
+  DynamicBatcherConfig config;
+  DynamicBatcher batcher(
+      {[](const Tensors& inputs, Tensors* outputs) {
+        throw std::runtime_error("run failed");
+      }},
+      config);
+  auto future = batcher.Submit(
+      {MakeTensor("x", {1}, std::vector<float>{1.f}, DataType::FLOAT32)});
+  EXPECT_THROW(future.get(), std::runtime_error);
+}
+
+struct LoadResult {
+  double qps{0.};
+  double p50_ms{0.};
+  double p90_ms{0.};
+  double p99_ms{0.};
+};
+
+// Closed loop load, each client sends the next request when the previous
+// one returns.
+LoadResult RunClosedLoop(int client_num,
+                         int request_num,
+                         const std::function<void(int client)>& request) {
+  std::vector<std::vector<double>> latencies(client_num);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> clients;
+  for (int c = 0; c < client_num; ++c) {
+    clients.emplace_back([&, c] {
+      for (int i = 0; i < request_num; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        request(c);
+        latencies[c].push_back(std::chrono::duration<double, std::milli>(
+                                   std::chrono::steady_clock::now() - begin)
+                                   .count());
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+  std::vector<double> all;
+  for (auto& latency : latencies) {
+    all.insert(all.end(), latency.begin(), latency.end());
+  }
+  std::sort(all.begin(), all.end());
+  LoadResult result;
+  result.qps = all.size() / sec;
+  result.p50_ms = all[all.size() * 50 / 100];
+  result.p90_ms = all[all.size() * 90 / 100];
+  result.p99_ms = all[all.size() * 99 / 100];
+  return result;
+}
+
+TEST(DynamicBatcher, resnet50_closed_loop) {
+  if (FLAGS_infer_model.empty()) {
+    return;
+  }
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_num_threads);
+
+  const int client_num = 16, request_num = 8;
+  const std::vector<int> in_shape = {1, 3, 224, 224};
+  std::vector<float> input(3 * 224 * 224, 0.5f);
+
+  PredictorPool pool(config, client_num);
+  auto in_name = pool.Retrieve(0)->GetInputNames()[0];
+  auto baseline = RunClosedLoop(client_num, request_num, [&](int client) {
+    auto* predictor = pool.Retrieve(client);
+    auto handle = predictor->GetInputHandle(in_name);
+    handle->Reshape(in_shape);
+    handle->CopyFromCpu(input.data());
+    ASSERT_TRUE(predictor->Run());
+  });
+
+  DynamicBatcherConfig batcher_config;
+  batcher_config.max_batch_size = 16;
+  batcher_config.max_queue_delay_us = 2000;
+  batcher_config.num_workers = 2;
+  DynamicBatcher batcher(config, batcher_config);
+  auto batched = RunClosedLoop(client_num, request_num, [&](int client) {
+    auto outputs =
+        batcher
+            .Submit({MakeTensor(in_name, in_shape, input, DataType::FLOAT32)})
+            .get();
+    ASSERT_EQ(outputs[0].shape[0], 1);
+  });
+
+  auto stats = batcher.GetStats();
+  LOG(INFO) << "clients: " << client_num << ", per request predictors: "
+            << baseline.qps << " qps, p50 " << baseline.p50_ms << " ms, p90 "
+            << baseline.p90_ms << " ms, p99 " << baseline.p99_ms << " ms";
+  LOG(INFO) << "dynamic batching: " << batched.qps << " qps, p50 "
+            << batched.p50_ms << " ms, p90 " << batched.p90_ms << " ms, p99 "
+            << batched.p99_ms << " ms, average batch "
+            << static_cast<double>(stats.row_num) / stats.batch_num;
+}
+
+}  // namespace services
+}  // namespace paddle_infer
@@ -0,0 +1,136 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+const char kOptimCacheDir[] = "./executor_plan_cache";
+
+Config GetConfig(bool save_optimized, bool use_optimized) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.EnableNewIR(true);
+  config.EnableNewExecutor(true);
+  config.SwitchIrOptim(true);
+  config.SetCpuMathLibraryNumThreads(1);
+  config.SetOptimCacheDir(kOptimCacheDir);
+  config.EnableSaveOptimModel(save_optimized);
+  config.UseOptimizedModel(use_optimized);
+  return config;
+}
+
+std::vector<float> RunOnce(Predictor* predictor) {
+  std::vector<int> in_shape = {1, 3, 224, 224};
+  std::vector<float> input(3 * 224 * 224, 0.5f);
+  auto input_t = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+  input_t->Reshape(in_shape);
+  input_t->CopyFromCpu(input.data());
+  EXPECT_TRUE(predictor->Run());
+  auto output_t = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto shape = output_t->shape();
+  std::vector<float> output(std::accumulate(
+      shape.begin(), shape.end(), 1, std::multiplies<int>()));
+  output_t->CopyToCpu(output.data());
+  return output;
+}
+
+void ExpectNear(const std::vector<float>& a, const std::vector<float>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_NEAR(a[i], b[i], 1e-5);
+  }
+}
+
+bool FileExists(const std::string& path) {
+  return static_cast<bool>(std::ifstream(path));
+}
+
+// Returns the outputs of the first run, logs the time to create the
+// predictor and to finish the first run. Sets plan_applied to whether the
+// predictor used the executor plan.
+std::vector<float> CreateAndRun(const Config& config,
+                                const std::string& tag,
+                                bool* plan_applied = nullptr) {
+  auto start = std::chrono::steady_clock::now();
+  auto predictor = CreatePredictor(config);
+  auto created = std::chrono::steady_clock::now();
+  auto output = RunOnce(predictor.get());
+  auto finished = std::chrono::steady_clock::now();
+  if (plan_applied != nullptr) {
+    *plan_applied =
+        experimental::InternalUtils::ExecutorPlanApplied(predictor.get());
+  }
+  LOG(INFO) << tag << ": create "
+            << std::chrono::duration<double, std::milli>(created - start)
+                   .count()
+            << " ms, first run "
+            << std::chrono::duration<double, std::milli>(finished - created)
+                   .count()
+            << " ms";
+  return output;
+}
+
+TEST(ExecutorPlan, startup) {
+  std::string plan_path = std::string(kOptimCacheDir) + "/_optimized.plan";
+  std::remove(plan_path.c_str());
+
+  bool plan_applied = true;
+  auto expected =
+      CreateAndRun(GetConfig(false, false), "original model", &plan_applied);
+  EXPECT_FALSE(plan_applied);
+  ExpectNear(CreateAndRun(GetConfig(true, false), "save optimized model"),
+             expected);
+  ASSERT_TRUE(FileExists(plan_path));
+
+  ExpectNear(
+      CreateAndRun(GetConfig(false, true), "with executor plan", &plan_applied),
+      expected);
+  EXPECT_TRUE(plan_applied);
+
+  std::string moved_path = plan_path + ".bak";
+  ASSERT_EQ(std::rename(plan_path.c_str(), moved_path.c_str()), 0);
+  ExpectNear(CreateAndRun(GetConfig(false, true),
+                          "without executor plan",
+                          &plan_applied),
+             expected);
+  EXPECT_FALSE(plan_applied);
+  ASSERT_EQ(std::rename(moved_path.c_str(), plan_path.c_str()), 0);
+}
+
+TEST(ExecutorPlan, corrupted_plan_is_ignored) {
+  auto expected = CreateAndRun(GetConfig(true, false), "save optimized model");
+  std::string plan_path = std::string(kOptimCacheDir) + "/_optimized.plan";
+  {
+    std::ofstream fout(plan_path, std::ios::binary | std::ios::trunc);
+    fout << "PDEXPLAN";
+  }
+  bool plan_applied = true;
+  ExpectNear(CreateAndRun(GetConfig(false, true),
+                          "truncated executor plan",
+                          &plan_applied),
+             expected);
+  EXPECT_FALSE(plan_applied);
+}
+
+}  // namespace paddle_infer
@@ -0,0 +1,78 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+Config GetConfig(bool memory_optim, bool pir) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.EnableNewIR(pir);
+  config.EnableNewExecutor(pir);
+  config.SwitchIrOptim(true);
+  config.SetCpuMathLibraryNumThreads(1);
+  if (memory_optim) {
+    config.EnableMemoryOptim();
+  }
+  return config;
+}
+
+std::vector<float> RunOnce(Predictor* predictor, int batch_size) {
+  std::vector<int> in_shape = {batch_size, 3, 224, 224};
+  std::vector<float> input(batch_size * 3 * 224 * 224);
+  for (size_t i = 0; i < input.size(); ++i) {
+    input[i] = static_cast<float>(i % 255) / 255.f;
+  }
+  auto input_t = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+  input_t->Reshape(in_shape);
+  input_t->CopyFromCpu(input.data());
+  EXPECT_TRUE(predictor->Run());
+
+  auto output_t = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto out_shape = output_t->shape();
+  std::vector<float> out(std::accumulate(
+      out_shape.begin(), out_shape.end(), 1, std::multiplies<int>()));
+  output_t->CopyToCpu(out.data());
+  return out;
+}
+
+void ExpectSameOutputs(bool pir) {
+  auto base = CreatePredictor(GetConfig(false, pir));
+  auto planned = CreatePredictor(GetConfig(true, pir));
+  for (int batch_size : {1, 1, 4, 2, 4, 1}) {
+    auto expected = RunOnce(base.get(), batch_size);
+    auto out = RunOnce(planned.get(), batch_size);
+    ASSERT_EQ(out.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_NEAR(out[i], expected[i], 1e-5);
+    }
+  }
+}
+
+// The first run shares whole variables, the executor places the tensors at
+// offsets after it, and again when a larger batch outgrows the plan.
+TEST(MemoryOffsetPlan, resnet50_same_outputs) { ExpectSameOutputs(false); }
+
+// The pir executor frees the tensors in the first run, and places them at
+// offsets after it. The peaks are logged when the plan is made.
+TEST(MemoryOffsetPlan, resnet50_pir_same_outputs) { ExpectSameOutputs(true); }
+
+}  // namespace paddle_infer
@@ -0,0 +1,174 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <mutex>               // NOLINT
+#include <numeric>
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+Config GetConfig() {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.SetCpuMathLibraryNumThreads(FLAGS_cpu_num_threads);
+  return config;
+}
+
+// The preprocessing of request i, which the async runs overlap with the
+// execution of request i - 1.
+void PrepareInput(int i, std::vector<float>* input) {
+  input->resize(3 * 224 * 224);
+  for (size_t j = 0; j < input->size(); ++j) {
+    float pixel = static_cast<float>((j * 7 + i * 131) % 256);
+    (*input)[j] = (pixel / 255.f - 0.45f) / 0.225f;
+  }
+}
+
+void SetInput(Predictor* predictor, const std::vector<float>& input) {
+  auto input_t = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+  input_t->Reshape({1, 3, 224, 224});
+  input_t->CopyFromCpu(input.data());
+}
+
+std::vector<float> GetOutput(const Tensor& output_t) {
+  auto shape = output_t.shape();
+  std::vector<float> out(
+      std::accumulate(shape.begin(), shape.end(), 1, std::multiplies<int>()));
+  output_t.CopyToCpu(out.data());
+  return out;
+}
+
+// Waits for the callbacks of the async runs.
+class RunCounter {
+ public:
+  void Done() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++done_;
+    cv_.notify_all();
+  }
+
+  void Wait(int num) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return done_ >= num; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int done_{0};
+};
+
+TEST(RunAsync, same_outputs_in_order) {
+  auto predictor = CreatePredictor(GetConfig());
+  const int request_num = 6;
+  std::vector<std::vector<float>> expected(request_num);
+  std::vector<float> input;
+  for (int i = 0; i < request_num; ++i) {
+    PrepareInput(i, &input);
+    SetInput(predictor.get(), input);
+    ASSERT_TRUE(predictor->Run());
+    auto output_t = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+    expected[i] = GetOutput(*output_t);
+  }
+
+  std::vector<std::vector<float>> outputs;
+  RunCounter counter;
+  for (int i = 0; i < request_num; ++i) {
+    PrepareInput(i, &input);
+    SetInput(predictor.get(), input);
+    predictor->RunAsync(
+        [&](bool success, std::vector<std::unique_ptr<Tensor>> outs) {
+          EXPECT_TRUE(success);
+          EXPECT_EQ(outs.size(), 1UL);
+          outputs.push_back(GetOutput(*outs[0]));
+          counter.Done();
+        });
+  }
+  counter.Wait(request_num);
+
+  ASSERT_EQ(outputs.size(), expected.size());
+  for (int i = 0; i < request_num; ++i) {
+    ASSERT_EQ(outputs[i].size(), expected[i].size());
+    for (size_t j = 0; j < expected[i].size(); ++j) {
+      EXPECT_NEAR(outputs[i][j], expected[i][j], 1e-5);
+    }
+  }
+}
+
+TEST(RunAsync, resnet50_throughput) {
+  auto predictor = CreatePredictor(GetConfig());
+  const int warmup_num = 2, request_num = 32;
+  std::vector<float> input;
+  std::vector<int> sync_labels, async_labels;
+  auto argmax = [](const std::vector<float>& out) {
+    return static_cast<int>(std::max_element(out.begin(), out.end()) -
+                            out.begin());
+  };
+
+  for (int i = 0; i < warmup_num; ++i) {
+    PrepareInput(i, &input);
+    SetInput(predictor.get(), input);
+    ASSERT_TRUE(predictor->Run());
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < request_num; ++i) {
+    PrepareInput(i, &input);
+    SetInput(predictor.get(), input);
+    ASSERT_TRUE(predictor->Run());
+    auto output_t = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+    sync_labels.push_back(argmax(GetOutput(*output_t)));
+  }
+  double sync_sec = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  RunCounter counter;
+  auto callback = [&](bool success, std::vector<std::unique_ptr<Tensor>> outs) {
+    EXPECT_TRUE(success);
+    async_labels.push_back(argmax(GetOutput(*outs[0])));
+    counter.Done();
+  };
+  for (int i = 0; i < warmup_num; ++i) {
+    PrepareInput(i, &input);
+    SetInput(predictor.get(), input);
+    predictor->RunAsync(callback);
+  }
+  counter.Wait(warmup_num);
+  async_labels.clear();
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < request_num; ++i) {
+    PrepareInput(i, &input);
+    SetInput(predictor.get(), input);
+    predictor->RunAsync(callback);
+  }
+  counter.Wait(warmup_num + request_num);
+  double async_sec = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  EXPECT_EQ(async_labels, sync_labels);
+  LOG(INFO) << "requests: " << request_num
+            << ", Run: " << request_num / sync_sec
+            << " qps, RunAsync: " << request_num / async_sec << " qps";
+}
+
+}  // namespace paddle_infer
@@ -0,0 +1,124 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <numeric>
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+Config GetConfig(bool run_stats, int trace_sample_interval = 0) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.EnableNewIR(true);
+  config.EnableNewExecutor(true);
+  config.SwitchIrOptim(true);
+  config.SetCpuMathLibraryNumThreads(1);
+  if (run_stats) {
+    config.EnableRunStats(trace_sample_interval);
+  }
+  return config;
+}
+
+void RunOnce(Predictor* predictor) {
+  std::vector<int> in_shape = {1, 3, 224, 224};
+  std::vector<float> input(3 * 224 * 224, 0.5f);
+  auto input_t = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+  input_t->Reshape(in_shape);
+  input_t->CopyFromCpu(input.data());
+  ASSERT_TRUE(predictor->Run());
+}
+
+TEST(RunStats, breakdown) {
+  const int run_num = 10;
+  auto predictor = CreatePredictor(GetConfig(true, 4));
+  for (int i = 0; i < run_num; ++i) {
+    RunOnce(predictor.get());
+  }
+  auto stats = predictor->GetRunStats();
+  EXPECT_EQ(stats.total.count, static_cast<uint64_t>(run_num));
+  EXPECT_EQ(stats.feed.count, static_cast<uint64_t>(run_num));
+  EXPECT_EQ(stats.execute.count, static_cast<uint64_t>(run_num));
+  EXPECT_EQ(stats.gc.count, static_cast<uint64_t>(run_num));
+  // ZeroCopyRun copies no outputs but still times the steps after the run
+  EXPECT_EQ(stats.fetch.count, static_cast<uint64_t>(run_num));
+  EXPECT_LE(stats.execute.mean_us + stats.fetch.mean_us, stats.total.mean_us);
+  EXPECT_LE(stats.gc.mean_us, stats.execute.mean_us);
+
+  ASSERT_FALSE(stats.instruction_groups.empty());
+  double group_us = 0;
+  for (auto& pair : stats.instruction_groups) {
+    EXPECT_EQ(pair.second.count, static_cast<uint64_t>(run_num));
+    group_us += pair.second.mean_us;
+  }
+  EXPECT_LE(group_us, stats.execute.mean_us);
+
+  // runs 0, 4 and 8 are sampled
+  ASSERT_EQ(stats.sampled_traces.size(), 3UL);
+  for (auto& trace : stats.sampled_traces) {
+    ASSERT_FALSE(trace.empty());
+    for (auto& event : trace) {
+      EXPECT_EQ(stats.instruction_groups.count(event.name), 1UL);
+    }
+  }
+
+  auto disabled = CreatePredictor(GetConfig(false));
+  RunOnce(disabled.get());
+  EXPECT_EQ(disabled->GetRunStats().total.count, 0UL);
+}
+
+double MedianLatencyMs(Predictor* predictor, int run_num) {
+  std::vector<double> latencies;
+  for (int i = 0; i < run_num; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    RunOnce(predictor);
+    latencies.push_back(std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start)
+                            .count());
+  }
+  // the median of the runs is less noisy than the mean
+  std::nth_element(latencies.begin(),
+                   latencies.begin() + latencies.size() / 2,
+                   latencies.end());
+  return latencies[latencies.size() / 2];
+}
+
+TEST(RunStats, overhead) {
+  const int warmup_num = 5;
+  const int run_num = 50;
+  auto base = CreatePredictor(GetConfig(false));
+  auto with_stats = CreatePredictor(GetConfig(true));
+  auto with_traces = CreatePredictor(GetConfig(true, 1));
+  for (int i = 0; i < warmup_num; ++i) {
+    RunOnce(base.get());
+    RunOnce(with_stats.get());
+    RunOnce(with_traces.get());
+  }
+  double base_ms = MedianLatencyMs(base.get(), run_num);
+  double stats_ms = MedianLatencyMs(with_stats.get(), run_num);
+  double traces_ms = MedianLatencyMs(with_traces.get(), run_num);
+  LOG(INFO) << "median latency without run stats " << base_ms
+            << " ms, with run stats " << stats_ms << " ms ("
+            << (stats_ms / base_ms - 1) * 100 << "%), tracing every run "
+            << traces_ms << " ms (" << (traces_ms / base_ms - 1) * 100
+            << "%)";
+}
+
+}  // namespace paddle_infer
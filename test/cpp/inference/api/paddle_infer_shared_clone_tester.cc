@@ -0,0 +1,133 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <numeric>
+#include <thread>  // NOLINT
+
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+
+Config GetConfig(bool shared_clone) {
+  std::string model_dir = FLAGS_infer_model + "/model";
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.EnableNewIR(true);
+  config.EnableNewExecutor(true);
+  config.SwitchIrOptim(true);
+  config.SetCpuMathLibraryNumThreads(1);
+  if (shared_clone) {
+    config.EnableSharedClone(true, 2);
+  }
+  return config;
+}
+
+std::vector<float> RunOnce(Predictor* predictor, float value) {
+  std::vector<int> in_shape = {1, 3, 224, 224};
+  std::vector<float> input(3 * 224 * 224, value);
+  auto input_t = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+  input_t->Reshape(in_shape);
+  input_t->CopyFromCpu(input.data());
+  EXPECT_TRUE(predictor->Run());
+  auto output_t = predictor->GetOutputHandle(predictor->GetOutputNames()[0]);
+  auto shape = output_t->shape();
+  std::vector<float> output(std::accumulate(
+      shape.begin(), shape.end(), 1, std::multiplies<int>()));
+  output_t->CopyToCpu(output.data());
+  return output;
+}
+
+void ExpectNear(const std::vector<float>& a, const std::vector<float>& b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); ++i) {
+    EXPECT_NEAR(a[i], b[i], 1e-5);
+  }
+}
+
+size_t GetProcessRSS() {
+  std::ifstream statm("/proc/self/statm");
+  size_t pages = 0, resident = 0;
+  statm >> pages >> resident;
+  return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+TEST(SharedClone, same_outputs) {
+  auto base = CreatePredictor(GetConfig(false));
+  auto expected_a = RunOnce(base.get(), 0.5f);
+  auto expected_b = RunOnce(base.get(), -1.f);
+
+  auto predictor = CreatePredictor(GetConfig(true));
+  ExpectNear(RunOnce(predictor.get(), 0.5f), expected_a);
+
+  const int clone_num = 4;
+  std::vector<std::unique_ptr<Predictor>> clones;
+  for (int i = 0; i < clone_num; ++i) {
+    clones.push_back(predictor->Clone());
+  }
+  std::vector<std::thread> threads;
+  for (int i = 0; i < clone_num; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < 4; ++j) {
+        bool a = (i + j) % 2 == 0;
+        ExpectNear(RunOnce(clones[i].get(), a ? 0.5f : -1.f),
+                   a ? expected_a : expected_b);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // the clones keep the shared persistables after the predictor is gone
+  predictor.reset();
+  ExpectNear(RunOnce(clones[0].get(), -1.f), expected_b);
+  // a clone of a clone shares the same program
+  auto clone = clones[1]->Clone();
+  ExpectNear(RunOnce(clone.get(), 0.5f), expected_a);
+}
+
+TEST(SharedClone, clone_overhead) {
+  const int clone_num = 8;
+  for (bool shared : {false, true}) {
+    auto predictor = CreatePredictor(GetConfig(shared));
+    RunOnce(predictor.get(), 0.5f);
+    size_t rss_before = GetProcessRSS();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::unique_ptr<Predictor>> clones;
+    for (int i = 0; i < clone_num; ++i) {
+      clones.push_back(predictor->Clone());
+    }
+    double clone_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+    for (auto& clone : clones) {
+      RunOnce(clone.get(), 0.5f);
+    }
+    size_t rss_after = GetProcessRSS();
+    LOG(INFO) << (shared ? "shared" : "default") << " clone: "
+              << clone_ms / clone_num << " ms per clone, "
+              << (rss_after > rss_before ? rss_after - rss_before : 0) /
+                     clone_num / 1024
+              << " KB per clone after one run";
+  }
+}
+
+}  // namespace paddle_infer
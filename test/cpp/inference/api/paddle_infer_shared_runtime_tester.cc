@@ -0,0 +1,345 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+
+#ifdef PADDLE_WITH_MKLML
+#include <omp.h>
+#endif
+
+#include "paddle/fluid/inference/api/paddle_shared_runtime.h"
+#include "test/cpp/inference/api/tester_helper.h"
+
+namespace paddle_infer {
+namespace services {
+
+SharedRuntimeConfig RuntimeConfig(int num_cores) {
+  SharedRuntimeConfig config;
+  config.num_cores = num_cores;
+  return config;
+}
+
+TEST(SharedRuntime, quotas) {
+  SharedRuntime runtime(RuntimeConfig(8));
+  int high = runtime.Attach(3);
+  int low = runtime.Attach(1);
+  auto stats = runtime.GetStats();
+  EXPECT_EQ(stats.model_quotas[high], 6);
+  EXPECT_EQ(stats.model_quotas[low], 2);
+
+  // A run alone may take the idle cores above its quota.
+  EXPECT_EQ(runtime.Acquire(low, 8), 8);
+  runtime.Release(low, 8);
+  EXPECT_EQ(runtime.Acquire(low, 16), 8);
+  runtime.Release(low, 8);
+
+  runtime.Detach(high);
+  EXPECT_EQ(runtime.GetStats().model_quotas[low], 8);
+  EXPECT_ANY_THROW(runtime.Acquire(high, 1));
+  EXPECT_ANY_THROW(runtime.Attach(0));
+  // called from destructors, so they only log
+  EXPECT_NO_THROW(runtime.Detach(high));
+  EXPECT_NO_THROW(runtime.Release(high, 1));
+  EXPECT_EQ(runtime.GetStats().busy_cores, 0);
+}
+
+// The waiting runs of the higher priority are admitted first, and they do
+// not take more than their quota while others wait.
+TEST(SharedRuntime, priority) {
+  SharedRuntime runtime(RuntimeConfig(4));
+  int high = runtime.Attach(3);
+  int low = runtime.Attach(1);
+  EXPECT_EQ(runtime.Acquire(low, 4), 4);
+
+  std::mutex mutex;
+  std::vector<int> admitted;
+  std::vector<int> granted;
+  auto run = [&](int model_id) {
+    int cores = runtime.Acquire(model_id, 4);
+    std::lock_guard<std::mutex> lock(mutex);
+    admitted.push_back(model_id);
+    granted.push_back(cores);
+  };
+  // The low priority run waits before the high priority one.
+  std::thread low_run(run, low);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  std::thread high_run(run, high);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  runtime.Release(low, 4);
+  high_run.join();
+  low_run.join();
+
+  ASSERT_EQ(admitted.size(), 2UL);
+  EXPECT_EQ(admitted[0], high);
+  // quota 3 of 4, the low priority run was waiting
+  EXPECT_EQ(granted[0], 3);
+  EXPECT_EQ(granted[1], 1);
+  EXPECT_EQ(runtime.GetStats().waited_run_num, 2UL);
+  runtime.Release(high, 3);
+  runtime.Release(low, 1);
+  EXPECT_EQ(runtime.GetStats().busy_cores, 0);
+}
+
+TEST(SharedRuntime, never_oversubscribed) {
+  const int num_cores = 6;
+  SharedRuntime runtime(RuntimeConfig(num_cores));
+  std::vector<int> models = {
+      runtime.Attach(1), runtime.Attach(2), runtime.Attach(4)};
+  std::atomic<int> busy{0};
+  std::atomic<int> max_busy{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 12; ++t) {
+    threads.emplace_back([&, t] {
+      int model_id = models[t % models.size()];
+      for (int i = 0; i < 50; ++i) {
+        int cores = runtime.Acquire(model_id, 1 + (t + i) % 4);
+        int now = busy.fetch_add(cores) + cores;
+        int current = max_busy.load();
+        while (now > current &&
+               !max_busy.compare_exchange_weak(current, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        busy.fetch_sub(cores);
+        runtime.Release(model_id, cores);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_LE(max_busy.load(), num_cores);
+  auto stats = runtime.GetStats();
+  EXPECT_EQ(stats.busy_cores, 0);
+  EXPECT_EQ(stats.run_num, 600UL);
+}
+
+struct LoadResult {
+  double qps{0.};
+  double p50_ms{0.};
+  double p99_ms{0.};
+};
+
+// Closed loop load, a client of every model runs a predictor of its own.
+std::vector<LoadResult> RunModels(std::vector<Config> configs,
+                                  int client_num,
+                                  int request_num) {
+  const std::vector<int> in_shape = {1, 3, 224, 224};
+  std::vector<float> input(3 * 224 * 224, 0.5f);
+  std::vector<std::vector<std::shared_ptr<Predictor>>> predictors;
+  for (auto& config : configs) {
+    predictors.emplace_back();
+    auto main_predictor = CreatePredictor(config);
+    for (int c = 1; c < client_num; ++c) {
+      predictors.back().push_back(main_predictor->Clone());
+    }
+    predictors.back().push_back(main_predictor);
+  }
+
+  std::vector<std::vector<double>> latencies(configs.size());
+  std::mutex mutex;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> clients;
+  for (size_t m = 0; m < configs.size(); ++m) {
+    for (int c = 0; c < client_num; ++c) {
+      clients.emplace_back([&, m, c] {
+        auto& predictor = predictors[m][c];
+        auto handle = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+        for (int i = 0; i < request_num; ++i) {
+          auto begin = std::chrono::steady_clock::now();
+          handle->Reshape(in_shape);
+          handle->CopyFromCpu(input.data());
+          ASSERT_TRUE(predictor->Run());
+          double ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - begin)
+                          .count();
+          std::lock_guard<std::mutex> lock(mutex);
+          latencies[m].push_back(ms);
+        }
+      });
+    }
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                             start)
+                   .count();
+  std::vector<LoadResult> results;
+  for (auto& latency : latencies) {
+    std::sort(latency.begin(), latency.end());
+    LoadResult result;
+    result.qps = latency.size() / sec;
+    result.p50_ms = latency[latency.size() * 50 / 100];
+    result.p99_ms = latency[latency.size() * 99 / 100];
+    results.push_back(result);
+  }
+  return results;
+}
+
+// The clones of a predictor run as the model of the predictor, which is
+// detached when the last of them is destroyed.
+TEST(SharedRuntime, clones_share_model) {
+  if (FLAGS_infer_model.empty()) {
+    return;
+  }
+  std::string model_dir = FLAGS_infer_model + "/model";
+  auto runtime = std::make_shared<SharedRuntime>(RuntimeConfig(4));
+  Config config;
+  config.SetModel(model_dir + "/model", model_dir + "/params");
+  config.DisableGpu();
+  config.SetSharedRuntime(runtime, 1);
+  auto predictor = CreatePredictor(config);
+  auto clone = predictor->Clone();
+  auto clone_of_clone = clone->Clone();
+  EXPECT_EQ(runtime->GetStats().model_quotas.size(), 1UL);
+  predictor.reset();
+  clone.reset();
+  EXPECT_EQ(runtime->GetStats().model_quotas.size(), 1UL);
+  clone_of_clone.reset();
+  EXPECT_TRUE(runtime->GetStats().model_quotas.empty());
+}
+
+// Two models served together, each asks for all the cores.
+TEST(SharedRuntime, resnet50_colocated) {
+  if (FLAGS_infer_model.empty()) {
+    return;
+  }
+  std::string model_dir = FLAGS_infer_model + "/model";
+  int num_cores =
+      std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+  auto runtime = std::make_shared<SharedRuntime>(RuntimeConfig(num_cores));
+  auto make_configs = [&](bool shared) {
+    std::vector<Config> configs(2);
+    for (size_t m = 0; m < configs.size(); ++m) {
+      configs[m].SetModel(model_dir + "/model", model_dir + "/params");
+      configs[m].DisableGpu();
+      configs[m].SetCpuMathLibraryNumThreads(num_cores);
+      if (shared) {
+        configs[m].SetSharedRuntime(runtime, m == 0 ? 3 : 1);
+      }
+    }
+    return configs;
+  };
+
+  const int client_num = 4, request_num = 8;
+  auto separate = RunModels(make_configs(false), client_num, request_num);
+  auto shared = RunModels(make_configs(true), client_num, request_num);
+  for (size_t m = 0; m < separate.size(); ++m) {
+    LOG(INFO) << "model " << m << ", separate threads: " << separate[m].qps
+              << " qps, p50 " << separate[m].p50_ms << " ms, p99 "
+              << separate[m].p99_ms << " ms; shared runtime: "
+              << shared[m].qps << " qps, p50 " << shared[m].p50_ms
+              << " ms, p99 " << shared[m].p99_ms << " ms";
+  }
+  auto stats = runtime->GetStats();
+  LOG(INFO) << "shared runtime: " << stats.run_num << " runs, "
+            << stats.waited_run_num << " waited " << stats.wait_ms << " ms";
+  EXPECT_EQ(stats.busy_cores, 0);
+  EXPECT_EQ(stats.run_num,
+            static_cast<uint64_t>(2 * client_num * request_num));
+}
+
+#ifdef PADDLE_WITH_MKLML
+// The models run concurrently, every run sees the threads granted to it on
+// its own thread, whatever the others are granted in the meantime.
+TEST(SharedRuntime, runs_keep_their_threads) {
+  if (FLAGS_infer_model.empty()) {
+    return;
+  }
+  std::string model_dir = FLAGS_infer_model + "/model";
+  const int num_cores = 4;
+  const int client_num = 4, request_num = 8;
+  auto runtime = std::make_shared<SharedRuntime>(RuntimeConfig(num_cores));
+  const std::vector<int> in_shape = {1, 3, 224, 224};
+  std::vector<float> input(3 * 224 * 224, 0.5f);
+
+  // The cores taken by the runs from their first op to their end, which is
+  // within their admission.
+  std::atomic<int> busy{0};
+  std::atomic<int> max_busy{0};
+  // The threads seen by the ops of the current run of every client.
+  std::vector<std::vector<int>> observed(client_num);
+  std::vector<std::shared_ptr<Predictor>> predictors;
+  for (int m = 0; m < 2; ++m) {
+    Config config;
+    config.SetModel(model_dir + "/model", model_dir + "/params");
+    config.DisableGpu();
+    config.SetCpuMathLibraryNumThreads(num_cores);
+    config.SetSharedRuntime(runtime, m == 0 ? 3 : 1);
+    auto main_predictor = CreatePredictor(config);
+    for (int c = 0; c < client_num / 2; ++c) {
+      predictors.push_back(main_predictor->Clone());
+    }
+  }
+  for (int c = 0; c < client_num; ++c) {
+    auto* run_threads = &observed[c];
+    predictors[c]->RegisterOutputHook(
+        [&, run_threads](const std::string&,
+                         const std::string&,
+                         const paddle::Tensor&) {
+          int threads = omp_get_max_threads();
+          if (run_threads->empty()) {
+            int now = busy.fetch_add(threads) + threads;
+            int current = max_busy.load();
+            while (now > current &&
+                   !max_busy.compare_exchange_weak(current, now)) {
+            }
+          }
+          run_threads->push_back(threads);
+        });
+  }
+
+  std::atomic<int> mixed_runs{0};
+  std::vector<std::thread> clients;
+  for (int c = 0; c < client_num; ++c) {
+    clients.emplace_back([&, c] {
+      auto& predictor = predictors[c];
+      auto& run_threads = observed[c];
+      auto handle = predictor->GetInputHandle(predictor->GetInputNames()[0]);
+      for (int i = 0; i < request_num; ++i) {
+        handle->Reshape(in_shape);
+        handle->CopyFromCpu(input.data());
+        run_threads.clear();
+        ASSERT_TRUE(predictor->Run());
+        ASSERT_FALSE(run_threads.empty());
+        busy.fetch_sub(run_threads.front());
+        EXPECT_GE(run_threads.front(), 1);
+        EXPECT_LE(run_threads.front(), num_cores);
+        if (std::count(run_threads.begin(),
+                       run_threads.end(),
+                       run_threads.front()) !=
+            static_cast<int64_t>(run_threads.size())) {
+          ++mixed_runs;
+        }
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  EXPECT_EQ(mixed_runs.load(), 0);
+  EXPECT_LE(max_busy.load(), num_cores);
+  EXPECT_EQ(runtime->GetStats().busy_cores, 0);
+}
+#endif
+
+}  // namespace services
+}  // namespace paddle_infer
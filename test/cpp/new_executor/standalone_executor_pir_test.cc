@@ -16,13 +16,20 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <numeric>
 #include <string>
 
 #include "paddle/phi/core/kernel_registry.h"
 
+#include "paddle/fluid/framework/new_executor/interpreter/executor_plan.h"
 #include "paddle/fluid/framework/new_executor/pir_interpreter.h"
+#include "paddle/fluid/framework/new_executor/run_stats.h"
+#include "paddle/fluid/framework/new_executor/shape_plan_cache.h"
 #include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
 #include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
@@ -45,6 +52,7 @@ PD_DECLARE_KERNEL(uniform, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(add, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(sqrt, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(less_than, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(nonzero, CPU, ALL_LAYOUT);
 
 bool simple_cmp(float a, float b) { return std::abs((a - b) / a) < 1e-5; }
 
@@ -98,6 +106,101 @@ TEST(StandaloneExecutor, run) {
   EXPECT_EQ(res3, true);
 }
 
+TEST(StandaloneExecutor, executor_plan) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto add_op =
+      builder.Build<paddle::dialect::AddOp>(op1->result(0), op2->result(0));
+  builder.Build<pir::ShadowOutputOp>(add_op->result(0), "out");
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+  auto place = phi::CPUPlace();
+
+  // runs the program with plan, returns whether the plan was applied and
+  // the plan, exported from the run if none was given
+  auto run = [&](std::shared_ptr<interpreter::ExecutorPlan> plan) {
+    interpreter::ExecutionConfig execution_config;
+    execution_config.executor_plan = plan;
+    Scope scope;
+    InterpreterCore test_core(
+        place, {}, kernel_program->block(), &scope, execution_config);
+    test_core.SetSkipGcVars({"out"});
+    test_core.Run({});
+    Scope* out_scope =
+        test_core.local_scope() == nullptr ? &scope : test_core.local_scope();
+    auto& out = out_scope->FindVar("out")->Get<phi::DenseTensor>();
+    for (int64_t i = 0; i < out.numel(); ++i) {
+      EXPECT_TRUE(simple_cmp(out.data<float>()[i], 2.0));
+    }
+    auto* impl = dynamic_cast<const PirInterpreter*>(test_core.Impl());
+    EXPECT_NE(impl, nullptr);
+    if (plan == nullptr) {
+      plan = impl->ExportExecutorPlan();
+    }
+    return std::make_pair(impl->ExecutorPlanApplied(), plan);
+  };
+
+  auto result = run(nullptr);
+  EXPECT_FALSE(result.first);
+  auto plan = result.second;
+  EXPECT_TRUE(run(plan).first);
+
+  // a plan freeing a variable after an instruction which does not exist is
+  // dropped
+  auto bad_plan = std::make_shared<interpreter::ExecutorPlan>(*plan);
+  ASSERT_FALSE(bad_plan->last_live_ops.empty());
+  bad_plan->last_live_ops.begin()->second.insert(1000);
+  EXPECT_FALSE(run(bad_plan).first);
+
+  // a plan file with a corrupted size field is ignored without allocating
+  // for the size read
+  std::string path = "standalone_executor_pir_test.plan";
+  ASSERT_TRUE(interpreter::SaveExecutorPlan(*plan, path));
+  auto loaded = interpreter::LoadExecutorPlan(path);
+  ASSERT_NE(loaded, nullptr);
+  EXPECT_EQ(loaded->trace_execute_order, plan->trace_execute_order);
+  EXPECT_EQ(*loaded->op_happens_before, *plan->op_happens_before);
+
+  // magic, version, build fingerprint and program fingerprint
+  size_t trace_size_offset = 8 + 8 + 8 + plan->build_fingerprint.size() + 8;
+  size_t matrix_size_offset = trace_size_offset + 8 +
+                              8 * plan->trace_execute_order.size() + 8 +
+                              8 * plan->dependency_count.size() + 8;
+  for (auto& pair : *plan->op_downstream_map) {
+    matrix_size_offset += 8 + 8 + 8 * pair.second.size();
+  }
+  std::vector<std::pair<size_t, uint64_t>> size_fields = {
+      {trace_size_offset, plan->trace_execute_order.size()},
+      {matrix_size_offset, plan->op_happens_before->size()}};
+  for (auto& [offset, saved_size] : size_fields) {
+    for (uint64_t size : {uint64_t{1} << 31, uint64_t{1} << 62}) {
+      ASSERT_TRUE(interpreter::SaveExecutorPlan(*plan, path));
+      {
+        std::fstream file(path,
+                          std::ios::binary | std::ios::in | std::ios::out);
+        uint64_t field = 0;
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(reinterpret_cast<char*>(&field), sizeof(field));
+        ASSERT_EQ(field, saved_size);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+      }
+      EXPECT_EQ(interpreter::LoadExecutorPlan(path), nullptr)
+          << "size " << size << " at offset " << offset;
+    }
+  }
+  std::remove(path.c_str());
+}
+
 TEST(StandaloneExecutor, run_feed_tensor) {
   pir::IrContext* ctx = pir::IrContext::Instance();
   pir::Program program(ctx);
@@ -176,6 +279,266 @@ TEST(StandaloneExecutor, run_feed_tensor) {
   EXPECT_EQ(res0, true);
 }
 
+TEST(StandaloneExecutor, shape_plan_cache) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  pir::OpInfo feed_op_info =
+      ctx->GetRegisteredOpInfo(paddle::dialect::FeedOp::name());
+  pir::Type dense_tensor_dtype =
+      paddle::dialect::DenseTensorType::get(ctx,
+                                            pir::Float32Type::get(ctx),
+                                            phi::DDim({-1, -1}),
+                                            phi::DataLayout::NCHW,
+                                            phi::LoD(),
+                                            0);
+  pir::AttributeMap attr_map;
+  attr_map.insert(std::pair<std::string, pir::Attribute>(
+      "name", pir::StrAttribute::get(ctx, "x")));
+  attr_map.insert(std::pair<std::string, pir::Attribute>(
+      "col", pir::Int32Attribute::get(ctx, 0)));
+  pir::Operation* feed_op =
+      pir::Operation::Create({}, attr_map, {dense_tensor_dtype}, feed_op_info);
+  program.block()->push_back(feed_op);
+
+  // the shape of add follows from the input shape, the one of nonzero
+  // from the input values
+  auto add_op = builder.Build<paddle::dialect::AddOp>(feed_op->result(0),
+                                                      feed_op->result(0));
+  auto nonzero_op = builder.Build<paddle::dialect::NonzeroOp>(add_op.out());
+  builder.Build<pir::ShadowOutputOp>(add_op.out(), "sum");
+  builder.Build<pir::ShadowOutputOp>(nonzero_op.out(), "index");
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  ShapePlanCache cache(4);
+  interpreter::ExecutionConfig execution_config;
+  execution_config.used_for_inference = true;
+  execution_config.shape_plan_cache = &cache;
+  auto place = phi::CPUPlace();
+  Scope scope;
+  InterpreterCore test_core(
+      place, {}, kernel_program->block(), &scope, execution_config);
+  test_core.SetSkipGcVars({"sum", "index"});
+
+  auto run = [&](const phi::DDim& dims, int nonzero_num) {
+    phi::DenseTensor x;
+    x.Resize(dims);
+    float* x_data = x.mutable_data<float>(place);
+    for (int64_t i = 0; i < x.numel(); ++i) {
+      x_data[i] = i < nonzero_num ? 1.f : 0.f;
+    }
+    test_core.Run({"x"}, {x});
+
+    Scope* out_scope =
+        test_core.local_scope() == nullptr ? &scope : test_core.local_scope();
+    auto& sum = out_scope->FindVar("sum")->Get<phi::DenseTensor>();
+    ASSERT_EQ(sum.dims(), dims);
+    for (int64_t i = 0; i < sum.numel(); ++i) {
+      EXPECT_EQ(sum.data<float>()[i], 2.f * x_data[i]);
+    }
+    auto& index = out_scope->FindVar("index")->Get<phi::DenseTensor>();
+    EXPECT_EQ(index.dims(), phi::make_ddim({nonzero_num, 2}));
+  };
+
+  run({2, 3}, 6);
+  run({4, 5}, 3);
+  run({2, 3}, 1);
+  run({4, 5}, 20);
+  run({2, 3}, 6);
+
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.miss_num, 2UL);
+  EXPECT_EQ(stats.hit_num, 3UL);
+  EXPECT_EQ(stats.plan_num, 2UL);
+
+  // another interpreter of the program, like the one of a cloned predictor,
+  // replays the plans recorded by the first one
+  Scope clone_scope;
+  InterpreterCore clone_core(
+      place, {}, kernel_program->block(), &clone_scope, execution_config);
+  clone_core.SetSkipGcVars({"sum", "index"});
+  phi::DenseTensor x;
+  x.Resize({4, 5});
+  float* x_data = x.mutable_data<float>(place);
+  std::fill(x_data, x_data + x.numel(), 1.f);
+  clone_core.Run({"x"}, {x});
+  Scope* out_scope = clone_core.local_scope() == nullptr
+                         ? &clone_scope
+                         : clone_core.local_scope();
+  EXPECT_EQ(out_scope->FindVar("sum")->Get<phi::DenseTensor>().dims(),
+            x.dims());
+  EXPECT_EQ(out_scope->FindVar("index")->Get<phi::DenseTensor>().dims(),
+            phi::make_ddim({20, 2}));
+  stats = cache.GetStats();
+  EXPECT_EQ(stats.hit_num, 4UL);
+  EXPECT_EQ(stats.plan_num, 2UL);
+}
+
+TEST(StandaloneExecutor, shape_plan_cache_tensor_attribute) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  pir::OpInfo feed_op_info =
+      ctx->GetRegisteredOpInfo(paddle::dialect::FeedOp::name());
+  auto create_feed = [&](const std::string& name,
+                         int col,
+                         pir::Type dtype,
+                         const phi::DDim& dims) {
+    pir::Type type = paddle::dialect::DenseTensorType::get(
+        ctx, dtype, dims, phi::DataLayout::NCHW, phi::LoD(), 0);
+    pir::AttributeMap attr_map;
+    attr_map.insert(std::pair<std::string, pir::Attribute>(
+        "name", pir::StrAttribute::get(ctx, name)));
+    attr_map.insert(std::pair<std::string, pir::Attribute>(
+        "col", pir::Int32Attribute::get(ctx, col)));
+    pir::Operation* feed_op =
+        pir::Operation::Create({}, attr_map, {type}, feed_op_info);
+    program.block()->push_back(feed_op);
+    return feed_op;
+  };
+  auto* x_feed =
+      create_feed("x", 0, pir::Float32Type::get(ctx), phi::DDim({-1, -1}));
+  auto* shape_feed =
+      create_feed("shape", 1, pir::Int64Type::get(ctx), phi::DDim({2}));
+
+  // the output shape of reshape follows from the values of the shape input,
+  // which are not part of the key of the plan
+  auto reshape_op = builder.Build<paddle::dialect::ReshapeOp>(
+      x_feed->result(0), shape_feed->result(0));
+  auto scale_op =
+      builder.Build<paddle::dialect::ScaleOp>(reshape_op.out(), 2.0, 0.0, true);
+  builder.Build<pir::ShadowOutputOp>(scale_op.out(), "out");
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  ShapePlanCache cache(4);
+  interpreter::ExecutionConfig execution_config;
+  execution_config.used_for_inference = true;
+  execution_config.shape_plan_cache = &cache;
+  auto place = phi::CPUPlace();
+  Scope scope;
+  InterpreterCore test_core(
+      place, {}, kernel_program->block(), &scope, execution_config);
+  test_core.SetSkipGcVars({"out"});
+
+  auto run = [&](int64_t rows, int64_t cols) {
+    phi::DenseTensor x;
+    x.Resize({2, 6});
+    float* x_data = x.mutable_data<float>(place);
+    std::iota(x_data, x_data + x.numel(), 0.f);
+    phi::DenseTensor shape;
+    shape.Resize({2});
+    int64_t* shape_data = shape.mutable_data<int64_t>(place);
+    shape_data[0] = rows;
+    shape_data[1] = cols;
+    test_core.Run({"x", "shape"}, {x, shape});
+
+    Scope* out_scope =
+        test_core.local_scope() == nullptr ? &scope : test_core.local_scope();
+    auto& out = out_scope->FindVar("out")->Get<phi::DenseTensor>();
+    ASSERT_EQ(out.dims(), phi::make_ddim({rows, cols}));
+    for (int64_t i = 0; i < out.numel(); ++i) {
+      EXPECT_EQ(out.data<float>()[i], 2.f * x_data[i]);
+    }
+  };
+
+  run(3, 4);
+  run(4, 3);
+  run(3, 4);
+  run(12, 1);
+
+  auto stats = cache.GetStats();
+  EXPECT_EQ(stats.plan_num, 1UL);
+  EXPECT_EQ(stats.hit_num, 3UL);
+}
+
+TEST(StandaloneExecutor, run_stats) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program(ctx);
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  paddle::dialect::FullOp op1 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  paddle::dialect::FullOp op2 = builder.Build<paddle::dialect::FullOp>(
+      std::vector<int64_t>{2, 2}, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto add_op =
+      builder.Build<paddle::dialect::AddOp>(op1->result(0), op2->result(0));
+  auto sum_op =
+      builder.Build<paddle::dialect::AddOp>(add_op->result(0), op1->result(0));
+  builder.Build<pir::ShadowOutputOp>(sum_op.out(), "out");
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+
+  RunStatsCollector run_stats(/*trace_sample_interval=*/2);
+  interpreter::ExecutionConfig execution_config;
+  execution_config.used_for_inference = true;
+  execution_config.run_stats = &run_stats;
+  auto place = phi::CPUPlace();
+  Scope scope;
+  InterpreterCore test_core(
+      place, {}, kernel_program->block(), &scope, execution_config);
+  test_core.SetSkipGcVars({"out"});
+
+  const int run_num = 5;
+  for (int i = 0; i < run_num; ++i) {
+    run_stats.BeginRun();
+    test_core.Run({});
+  }
+
+  auto summary = run_stats.Summarize();
+  const uint64_t timed_num = run_num;
+  EXPECT_EQ(summary.phases["gc"].count, timed_num);
+  // the phases of the predictor are not timed by the interpreter
+  EXPECT_EQ(summary.phases["total"].count, 0UL);
+  ASSERT_EQ(summary.instruction_groups.count("pd_op.add"), 1UL);
+  ASSERT_EQ(summary.instruction_groups.count("pd_op.full"), 1UL);
+  auto& add_group = summary.instruction_groups["pd_op.add"];
+  EXPECT_EQ(add_group.count, timed_num);
+  EXPECT_GT(add_group.max_ns, 0.);
+  EXPECT_LE(add_group.p50_ns, add_group.p99_ns);
+  EXPECT_LE(add_group.p99_ns, add_group.max_ns);
+
+  // runs 0, 2 and 4 are sampled
+  ASSERT_EQ(summary.sampled_traces.size(), 3UL);
+  auto& trace = summary.sampled_traces.back();
+  int add_num = 0;
+  for (size_t i = 0; i < trace.size(); ++i) {
+    add_num += trace[i].name == "pd_op.add";
+    if (i > 0) {
+      EXPECT_GE(trace[i].start_ns, trace[i - 1].start_ns);
+    }
+  }
+  EXPECT_EQ(add_num, 2);
+}
+
+TEST(RunStats, latency_histogram) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(histogram.Summarize().count, 0UL);
+  for (uint64_t ns = 1; ns <= 1000; ++ns) {
+    histogram.Add(ns * 1000);
+  }
+  auto summary = histogram.Summarize();
+  EXPECT_EQ(summary.count, 1000UL);
+  EXPECT_NEAR(summary.mean_ns, 500500., 1e-6);
+  EXPECT_EQ(summary.max_ns, 1000000.);
+  // the buckets are at most a quarter of their lower bound wide
+  EXPECT_NEAR(summary.p50_ns, 500000., 500000. * 0.25);
+  EXPECT_NEAR(summary.p90_ns, 900000., 900000. * 0.25);
+  EXPECT_NEAR(summary.p99_ns, 990000., 990000. * 0.25);
+}
+
 TEST(StandaloneExecutor, run_inplace_sqrt) {
   pir::IrContext* ctx = pir::IrContext::Instance();
   pir::Program program((ctx));
@@ -218,6 +581,59 @@ TEST(StandaloneExecutor, run_inplace_sqrt) {
   EXPECT_EQ(res3, true);
 }
 
+TEST(StandaloneExecutor, memory_offset_plan) {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  pir::Program program((ctx));
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Builder builder = pir::Builder(ctx, program.block());
+
+  std::vector<int64_t> shape{64, 64};
+  auto a = builder.Build<paddle::dialect::FullOp>(
+      shape, 1.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto b = builder.Build<paddle::dialect::FullOp>(
+      shape, 3.0, phi::DataType::FLOAT32, phi::CPUPlace());
+  auto c = builder.Build<paddle::dialect::AddOp>(a->result(0), b->result(0));
+  // the output of the inplace op shares the variable of c, and its slot
+  auto sqrt = builder.Build<paddle::dialect::Sqrt_Op>(c->result(0));
+  auto d = builder.Build<paddle::dialect::AddOp>(sqrt->result(0),
+                                                 a->result(0));
+  auto e = builder.Build<paddle::dialect::AddOp>(d->result(0), d->result(0));
+  auto out =
+      builder.Build<paddle::dialect::AddOp>(e->result(0), sqrt->result(0));
+  builder.Build<pir::ShadowOutputOp>(out->result(0), "out");
+
+  auto kernel_program = paddle::dialect::PdOpLowerToKernelPass(&program);
+  auto place = phi::CPUPlace();
+  interpreter::ExecutionConfig execution_config;
+  execution_config.used_for_inference = true;
+  execution_config.memory_offset_plan = true;
+  Scope scope;
+  InterpreterCore test_core(
+      place, {}, kernel_program->block(), &scope, execution_config);
+  test_core.SetSkipGcVars({"out"});
+  auto* impl = dynamic_cast<const PirInterpreter*>(test_core.Impl());
+  ASSERT_NE(impl, nullptr);
+
+  // the first run allocates the tensors and plans, the later ones run in
+  // the arena
+  for (int run = 0; run < 3; ++run) {
+    test_core.Run({});
+    Scope* out_scope =
+        test_core.local_scope() == nullptr ? &scope : test_core.local_scope();
+    auto& out_tensor = out_scope->FindVar("out")->Get<phi::DenseTensor>();
+    ASSERT_EQ(out_tensor.numel(), 64 * 64);
+    for (int64_t i = 0; i < out_tensor.numel(); ++i) {
+      ASSERT_TRUE(simple_cmp(out_tensor.data<float>()[i], 8.0))
+          << "run " << run << ", element " << i;
+    }
+  }
+  // a, b, c, d and e take 5 tensors without reuse, at most 3 of them are
+  // live at the same time
+  size_t tensor_size = 64 * 64 * sizeof(float);
+  EXPECT_GE(impl->MemoryPlanArenaSize(), 3 * tensor_size);
+  EXPECT_LT(impl->MemoryPlanArenaSize(), 5 * tensor_size);
+}
+
 TEST(StandaloneExecutor, if_op) {
   pir::IrContext* ctx = pir::IrContext::Instance();
   ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
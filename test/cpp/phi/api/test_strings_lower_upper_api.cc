@@ -25,6 +25,7 @@ limitations under the License. */
 
 PD_DECLARE_KERNEL(strings_lower, CPU, ALL_LAYOUT);
 PD_DECLARE_KERNEL(strings_upper, CPU, ALL_LAYOUT);
+PD_DECLARE_KERNEL(strings_split, CPU, ALL_LAYOUT);
 
 namespace paddle {
 namespace tests {
@@ -143,5 +144,35 @@ TEST(API, case_convert_utf8) {
   }
 }
 
+TEST(API, split) {
+  auto cpu = CPUPlace();
+  const auto alloc =
+      std::make_shared<paddle::experimental::DefaultAllocator>(cpu);
+  // 1. create tensor
+  const phi::DDim dims({2});
+  StringTensorMeta meta(dims);
+  auto cpu_strings_x = std::make_shared<phi::StringTensor>(
+      alloc.get(), phi::StringTensorMeta(meta));
+  phi::DeviceContextPool& pool = phi::DeviceContextPool::Instance();
+  auto* dev_ctx = pool.Get(phi::CPUPlace());
+
+  pstring* cpu_strings_x_data =
+      dev_ctx->template Alloc<pstring>(cpu_strings_x.get());
+  cpu_strings_x_data[0] = " Cheap  Flights to";
+  cpu_strings_x_data[1] = "NEW";
+  // 2. test API, the tokens are lower cased and padded with empty strings
+  paddle::Tensor x(cpu_strings_x);
+  auto out = paddle::experimental::strings::split(x, 2, true, false);
+
+  auto out_tensor = std::dynamic_pointer_cast<phi::StringTensor>(out.impl());
+  ASSERT_EQ(out_tensor->dims(), phi::DDim({2, 2}));
+  auto out_ptr = out_tensor->data();
+  std::string expected_results[] = {"cheap", "flights", "new", ""};  // NOLINT
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(std::string(out_ptr[i].data(), out_ptr[i].size()),
+              expected_results[i]);
+  }
+}
+
 }  // namespace tests
 }  // namespace paddle
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <iostream>
 #include <sstream>
+#include <string>
 
 #include "gtest/gtest.h"
 #include "paddle/phi/common/float16.h"
@@ -48,6 +49,29 @@ TEST(KernelFactory, SelectedKernelMap) {
   }
 }
 
+TEST(KernelResultCache, InvalidatedByRegisterKernel) {
+  const std::string kernel_name = "kernel_result_cache_test";
+  phi::KernelKey cpu_key(
+      phi::Backend::CPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  phi::KernelKey gpu_key(
+      phi::Backend::GPU, phi::DataLayout::ALL_LAYOUT, phi::DataType::FLOAT32);
+  auto& factory = phi::KernelFactory::Instance();
+  const phi::Kernel& scale = factory.SelectKernel("scale", cpu_key);
+  factory.RegisterKernel(kernel_name, cpu_key, scale);
+
+  // The gpu key falls back to the cpu kernel, until a gpu one is registered.
+  phi::KernelResultCache cache;
+  EXPECT_TRUE(
+      cache.SelectKernelOrThrowError(kernel_name.c_str(), gpu_key)
+          .has_fallback_cpu);
+  uint64_t version = factory.kernels_version();
+  factory.RegisterKernel(kernel_name, gpu_key, scale);
+  EXPECT_GT(factory.kernels_version(), version);
+  EXPECT_FALSE(
+      cache.SelectKernelOrThrowError(kernel_name.c_str(), gpu_key)
+          .has_fallback_cpu);
+}
+
 template <typename T, typename Context>
 void TestKernel(const Context& dev_ctx,
                 const DenseTensor& x,
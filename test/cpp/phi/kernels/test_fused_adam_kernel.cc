@@ -192,6 +192,33 @@ struct AdamInfo {
     }
   }
 
+  // Updates the params with merged_adam, which doesn't support adamw and
+  // master params.
+  void UpdateWithMergedAdam(const std::vector<DenseTensor> &grads) {
+    std::vector<const DenseTensor *> learning_rates(params.size(),
+                                                    &learning_rate);
+    MergedAdamKernel<T, Context>(*ctx,
+                                 ToConstTensorPtrVector(params),
+                                 ToConstTensorPtrVector(grads),
+                                 learning_rates,
+                                 ToConstTensorPtrVector(moment1s),
+                                 ToConstTensorPtrVector(moment2s),
+                                 ToConstTensorPtrVector(beta1_pows),
+                                 ToConstTensorPtrVector(beta2_pows),
+                                 paddle::none,
+                                 beta1,
+                                 beta2,
+                                 epsilon,
+                                 false,
+                                 false,
+                                 ToMutableTensorPtrVector(params),
+                                 ToMutableTensorPtrVector(moment1s),
+                                 ToMutableTensorPtrVector(moment2s),
+                                 ToMutableTensorPtrVector(beta1_pows),
+                                 ToMutableTensorPtrVector(beta2_pows),
+                                 {});
+  }
+
   static AdamInfo<T, Context> DeepCopy(const AdamInfo &other) {
     AdamInfo copied(*other.ctx,
                     other.shapes,
@@ -458,6 +485,34 @@ TEST(fused_adam, test_fp32_cpu) {
   }
 }
 
+// A model of many small params, updated by a kernel for each param and by
+// the fused kernel updating them in one multi tensor apply.
+TEST(fused_adam, test_many_params_cpu) {
+  auto shapes = GenerateRandomShapes(500, 16, 1024);
+  for (auto use_adamw : {false, true}) {
+    TestFusedAdamBase<float, CPUPlace>(
+        shapes, 0.0f, use_adamw, false, 0.9, 0.99, 0.1, 2);
+  }
+}
+
+TEST(merged_adam, test_fp32_cpu) {
+  auto shapes = GenerateRandomShapes(100, 16, 2048);
+  const auto &ctx = *phi::DeviceContextPool::Instance().GetByPlace(CPUPlace());
+  ctx.GetGenerator()->SetCurrentSeed(10);
+  AdamInfo<float, CPUContext> info1(ctx, shapes, 0.9, 0.99, 0.0, false, false);
+  auto info2 = AdamInfo<float, CPUContext>::DeepCopy(info1);
+  for (size_t i = 0; i < 5; ++i) {
+    auto grads = GenerateRandomTensorVectors<float>(ctx, shapes);
+    info1.Update(false, grads);
+    info2.UpdateWithMergedAdam(grads);
+  }
+  EXPECT_EQ(MaxDiff<float>(ctx, info1.beta1_pows, info2.beta1_pows), 0.0f);
+  EXPECT_EQ(MaxDiff<float>(ctx, info1.beta2_pows, info2.beta2_pows), 0.0f);
+  EXPECT_EQ(MaxDiff<float>(ctx, info1.params, info2.params), 0.0f);
+  EXPECT_EQ(MaxDiff<float>(ctx, info1.moment1s, info2.moment1s), 0.0f);
+  EXPECT_EQ(MaxDiff<float>(ctx, info1.moment2s, info2.moment2s), 0.0f);
+}
+
 #ifdef PADDLE_WITH_CUDA
 TEST(fused_adam, test_fp32_gpu) {
   auto shapes = GenerateRandomShapes(40, 0, 2 << 18);
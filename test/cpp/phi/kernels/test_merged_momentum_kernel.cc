@@ -0,0 +1,176 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/backends/cpu/cpu_context.h"
+#include "paddle/phi/core/generator.h"
+#include "paddle/phi/core/tensor_utils.h"
+#include "paddle/phi/kernels/full_kernel.h"
+#include "paddle/phi/kernels/gaussian_kernel.h"
+#include "paddle/phi/kernels/merged_momentum_kernel.h"
+#include "paddle/phi/kernels/momentum_kernel.h"
+
+namespace phi {
+
+static std::vector<DenseTensor> RandomTensors(
+    const CPUContext &ctx, const std::vector<int64_t> &numels) {
+  std::vector<DenseTensor> tensors(numels.size());
+  for (size_t i = 0; i < numels.size(); ++i) {
+    GaussianKernel<float, CPUContext>(ctx,
+                                      std::vector<int64_t>{numels[i]},
+                                      0.0f,
+                                      1.0f,
+                                      0,
+                                      DataType::FLOAT32,
+                                      &tensors[i]);
+  }
+  return tensors;
+}
+
+static std::vector<DenseTensor> CopyTensors(
+    const CPUContext &ctx, const std::vector<DenseTensor> &tensors) {
+  std::vector<DenseTensor> copied(tensors.size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    Copy<CPUContext>(ctx, tensors[i], CPUPlace(), true, &copied[i]);
+  }
+  return copied;
+}
+
+static std::vector<const DenseTensor *> ToConstPtrs(
+    const std::vector<DenseTensor> &tensors) {
+  std::vector<const DenseTensor *> results;
+  for (const auto &t : tensors) {
+    results.push_back(&t);
+  }
+  return results;
+}
+
+static std::vector<DenseTensor *> ToMutablePtrs(
+    std::vector<DenseTensor> *tensors) {
+  std::vector<DenseTensor *> results;
+  for (auto &t : *tensors) {
+    results.push_back(&t);
+  }
+  return results;
+}
+
+static void ExpectSameTensors(const std::vector<DenseTensor> &xs,
+                              const std::vector<DenseTensor> &ys) {
+  ASSERT_EQ(xs.size(), ys.size());
+  for (size_t i = 0; i < xs.size(); ++i) {
+    ASSERT_EQ(xs[i].numel(), ys[i].numel());
+    for (int64_t j = 0; j < xs[i].numel(); ++j) {
+      ASSERT_EQ(xs[i].data<float>()[j], ys[i].data<float>()[j])
+          << "param " << i << ", element " << j;
+    }
+  }
+}
+
+// merged_momentum on cpu, updating all the params in one multi tensor apply,
+// gives the same results as the momentum kernel for each param.
+static void TestMergedMomentum(bool use_nesterov,
+                               bool l2_decay,
+                               bool lr_per_param,
+                               float rescale_grad) {
+  const auto &ctx = *DeviceContextPool::Instance().GetByPlace(CPUPlace());
+  ctx.GetGenerator()->SetCurrentSeed(10);
+  std::vector<int64_t> numels;
+  for (int64_t i = 0; i < 50; ++i) {
+    numels.push_back(16 + i * 97 % 2000);
+  }
+  size_t n = numels.size();
+  std::vector<DenseTensor> params = RandomTensors(ctx, numels);
+  std::vector<DenseTensor> velocities(n);
+  for (size_t i = 0; i < n; ++i) {
+    FullKernel<float, CPUContext>(ctx,
+                                  std::vector<int64_t>{numels[i]},
+                                  0.0f,
+                                  DataType::FLOAT32,
+                                  &velocities[i]);
+  }
+  std::vector<DenseTensor> lrs(lr_per_param ? n : 1);
+  for (size_t i = 0; i < lrs.size(); ++i) {
+    FullKernel<float, CPUContext>(ctx,
+                                  std::vector<int64_t>{1},
+                                  1e-2f * static_cast<float>(i + 1),
+                                  DataType::FLOAT32,
+                                  &lrs[i]);
+  }
+  std::vector<DenseTensor> merged_params = CopyTensors(ctx, params);
+  std::vector<DenseTensor> merged_velocities = CopyTensors(ctx, velocities);
+
+  const float mu = 0.9f;
+  std::string regularization_method = l2_decay ? "l2_decay" : "";
+  std::vector<std::string> regularization_methods;
+  std::vector<float> regularization_coeffs;
+  if (l2_decay) {
+    regularization_methods.assign(n, regularization_method);
+    regularization_coeffs.assign(n, 1e-2f);
+  }
+  for (size_t step = 0; step < 3; ++step) {
+    std::vector<DenseTensor> grads = RandomTensors(ctx, numels);
+    for (size_t i = 0; i < n; ++i) {
+      MomentumDenseKernel<float, CPUContext>(ctx,
+                                             params[i],
+                                             grads[i],
+                                             velocities[i],
+                                             lrs[lr_per_param ? i : 0],
+                                             paddle::none,
+                                             mu,
+                                             use_nesterov,
+                                             regularization_method,
+                                             l2_decay ? 1e-2f : 0.0f,
+                                             false,
+                                             rescale_grad,
+                                             &params[i],
+                                             &velocities[i],
+                                             nullptr);
+    }
+    MergedMomentumKernel<float, CPUContext>(ctx,
+                                            ToConstPtrs(merged_params),
+                                            ToConstPtrs(grads),
+                                            ToConstPtrs(merged_velocities),
+                                            ToConstPtrs(lrs),
+                                            paddle::none,
+                                            mu,
+                                            use_nesterov,
+                                            regularization_methods,
+                                            regularization_coeffs,
+                                            false,
+                                            rescale_grad,
+                                            ToMutablePtrs(&merged_params),
+                                            ToMutablePtrs(&merged_velocities),
+                                            {});
+  }
+  ExpectSameTensors(params, merged_params);
+  ExpectSameTensors(velocities, merged_velocities);
+}
+
+TEST(merged_momentum, test_fp32_cpu) {
+  // The momentum kernel on cpu doesn't rescale the grads, and neither does
+  // merged_momentum unless it takes the path of a single lr without
+  // nesterov or regularization.
+  TestMergedMomentum(false, false, false, 1.0f);
+  TestMergedMomentum(true, false, false, 0.5f);
+  TestMergedMomentum(false, true, false, 0.5f);
+  TestMergedMomentum(true, true, true, 0.5f);
+  TestMergedMomentum(false, false, true, 0.5f);
+}
+
+}  // namespace phi
@@ -0,0 +1,229 @@
+/* Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glog/logging.h"
+
+#include "paddle/phi/api/lib/utils/allocator.h"
+#include "paddle/phi/backends/context_pool.h"
+#include "paddle/phi/common/pstring.h"
+#include "paddle/phi/core/string_tensor.h"
+#include "paddle/phi/kernels/strings/ascii_utils.h"
+#include "paddle/phi/kernels/strings/strings_hash_bucket_kernel.h"
+#include "paddle/phi/kernels/strings/strings_lower_upper_kernel.h"
+#include "paddle/phi/kernels/strings/strings_split_kernel.h"
+
+namespace phi {
+namespace tests {
+
+using DDim = phi::DDim;
+using pstring = ::phi::dtype::pstring;
+
+const phi::CPUContext& GetCPUContext() {
+  phi::DeviceContextPool& pool = phi::DeviceContextPool::Instance();
+  return *static_cast<phi::CPUContext*>(pool.Get(phi::CPUPlace()));
+}
+
+StringTensor MakeStringTensor(const std::vector<std::string>& strs) {
+  const DDim dims({static_cast<int64_t>(strs.size())});
+  const auto string_allocator =
+      std::make_unique<paddle::experimental::DefaultAllocator>(phi::CPUPlace());
+  StringTensor x(string_allocator.get(), StringTensorMeta(dims));
+  pstring* x_data = GetCPUContext().template Alloc<pstring>(&x);
+  for (size_t i = 0; i < strs.size(); ++i) {
+    x_data[i] = strs[i];
+  }
+  return x;
+}
+
+// Search queries of 4 to 80 chars, a few of them with non ascii words.
+std::vector<std::string> MakeQueries(size_t num) {
+  std::vector<std::string> words = {"Cheap",  "flights", "TO",    "new",
+                                    "York",   "weather", "2024",  "iPhone",
+                                    "case",   "How",     "to",    "cook",
+                                    "RICE",   "near",    "me",    "Caf\xc3\xa9",
+                                    "M\xc3\xbcnchen"};
+  std::mt19937 rng(2024);
+  std::vector<std::string> queries;
+  for (size_t i = 0; i < num; ++i) {
+    std::string query;
+    size_t len = 4 + rng() % 77;
+    while (query.size() < len) {
+      query += words[rng() % words.size()];
+      query += ' ';
+    }
+    queries.emplace_back(std::move(query));
+  }
+  return queries;
+}
+
+TEST(DEV_API, strings_ascii_utils) {
+  std::string str = "Hello, World! [abc] @XYZ` {az} \xc3\x89t\xc3\xa9 0123";
+  for (size_t n = 0; n <= str.size(); ++n) {
+    std::string lower(n, 0), upper(n, 0);
+    phi::strings::AsciiCaseConvert<false>(str.data(), &lower[0], n);
+    phi::strings::AsciiCaseConvert<true>(str.data(), &upper[0], n);
+    for (size_t i = 0; i < n; ++i) {
+      auto c = static_cast<unsigned char>(str[i]);
+      ASSERT_EQ(lower[i], c < 0x80 ? static_cast<char>(::tolower(c)) : str[i]);
+      ASSERT_EQ(upper[i], c < 0x80 ? static_cast<char>(::toupper(c)) : str[i]);
+    }
+    ASSERT_EQ(phi::strings::IsAscii(str.data(), n), n <= 31);
+  }
+  ASSERT_EQ(phi::strings::FindNonAscii(str.data(), 0, str.size()), 31UL);
+  ASSERT_EQ(phi::strings::FindSpaceOrNonAscii(str.data(), 0, str.size()), 6UL);
+}
+
+TEST(DEV_API, strings_split) {
+  auto x = MakeStringTensor({"  Cheap Flights\tto\n NEW York ",
+                             "",
+                             "Caf\xc3\xa9\xe3\x80\x80M\xc3\x9cNCHEN"});
+  auto out = phi::strings::StringSplit(GetCPUContext(), x, 4, true, true);
+  ASSERT_EQ(out.dims(), common::make_ddim({3, 4}));
+  const pstring* data = out.data();
+  std::vector<std::string> expected = {"cheap",
+                                       "flights",
+                                       "to",
+                                       "new",
+                                       "",
+                                       "",
+                                       "",
+                                       "",
+                                       "caf\xc3\xa9",
+                                       "m\xc3\xbcnchen",
+                                       "",
+                                       ""};
+  for (size_t i = 0; i < expected.size(); ++i) {
+    ASSERT_EQ(std::string(data[i].data(), data[i].size()), expected[i]);
+  }
+
+  // ascii mode keeps non ascii bytes and case
+  out = phi::strings::StringSplit(GetCPUContext(), x, 2, false, false);
+  data = out.data();
+  ASSERT_EQ(std::string(data[0].data(), data[0].size()), "Cheap");
+  ASSERT_EQ(std::string(data[4].data(), data[4].size()),
+            "Caf\xc3\xa9\xe3\x80\x80M\xc3\x9cNCHEN");
+}
+
+TEST(DEV_API, strings_split_truncated_utf8) {
+  // the last utf-8 sequence of each string is cut short
+  auto x = MakeStringTensor({"a string long enough for the heap \xe3\x80",
+                             "x \xf0\x9f\x98",
+                             "\xe3"});
+  auto out = phi::strings::StringSplit(GetCPUContext(), x, 8, false, true);
+  const pstring* data = out.data();
+  ASSERT_EQ(std::string(data[7].data(), data[7].size()), "\xe3\x80");
+  ASSERT_EQ(std::string(data[8].data(), data[8].size()), "x");
+  ASSERT_EQ(std::string(data[9].data(), data[9].size()), "\xf0\x9f\x98");
+  ASSERT_EQ(std::string(data[16].data(), data[16].size()), "\xe3");
+  ASSERT_EQ(data[17].size(), 0UL);
+}
+
+TEST(DEV_API, strings_to_hash_bucket) {
+  auto x = MakeStringTensor({"cheap", "flights", "cheap", ""});
+  auto out = phi::strings::StringToHashBucket(GetCPUContext(), x, 1000);
+  ASSERT_EQ(out.dims(), common::make_ddim({4}));
+  ASSERT_EQ(out.dtype(), phi::DataType::INT64);
+  const int64_t* ids = out.data<int64_t>();
+  ASSERT_EQ(ids[0], ids[2]);
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_GE(ids[i], 0);
+    ASSERT_LT(ids[i], 1000);
+  }
+  auto seeded = phi::strings::StringToHashBucket(GetCPUContext(), x, 1000, 7);
+  const int64_t* seeded_ids = seeded.data<int64_t>();
+  ASSERT_EQ(seeded_ids[0], seeded_ids[2]);
+
+  // the seed changes the bucket ids, only about one in num_buckets strings
+  // keeps its bucket by chance
+  std::vector<std::string> strs;
+  for (int i = 0; i < 1000; ++i) {
+    strs.push_back("query " + std::to_string(i));
+  }
+  auto y = MakeStringTensor(strs);
+  auto unseeded = phi::strings::StringToHashBucket(GetCPUContext(), y, 1000);
+  seeded = phi::strings::StringToHashBucket(GetCPUContext(), y, 1000, 7);
+  int num_same = 0;
+  for (int64_t i = 0; i < y.numel(); ++i) {
+    num_same +=
+        unseeded.data<int64_t>()[i] == seeded.data<int64_t>()[i] ? 1 : 0;
+  }
+  ASSERT_LT(num_same, 20);
+}
+
+TEST(DEV_API, strings_kernels_benchmark) {
+  auto queries = MakeQueries(100000);
+  auto x = MakeStringTensor(queries);
+  const auto& dev_ctx = GetCPUContext();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::string> scalar_out(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i) {
+    scalar_out[i].resize(queries[i].size());
+    std::transform(queries[i].begin(),
+                   queries[i].end(),
+                   scalar_out[i].begin(),
+                   phi::strings::AsciiToLower());
+  }
+  double scalar_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+  start = std::chrono::steady_clock::now();
+  auto ascii_out = phi::strings::StringLower(dev_ctx, x, false);
+  double ascii_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  for (size_t i = 0; i < queries.size(); ++i) {
+    ASSERT_EQ(std::string(ascii_out.data()[i].data(),
+                          ascii_out.data()[i].size()),
+              scalar_out[i]);
+  }
+
+  start = std::chrono::steady_clock::now();
+  auto utf8_out = phi::strings::StringLower(dev_ctx, x, true);
+  double utf8_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  start = std::chrono::steady_clock::now();
+  auto tokens = phi::strings::StringSplit(dev_ctx, x, 16, true, true);
+  double split_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+  start = std::chrono::steady_clock::now();
+  auto ids = phi::strings::StringToHashBucket(dev_ctx, tokens, 1 << 20);
+  double hash_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  ASSERT_EQ(ids.numel(), static_cast<int64_t>(queries.size()) * 16);
+
+  LOG(INFO) << queries.size() << " queries, scalar lower: " << scalar_ms
+            << " ms, ascii lower: " << ascii_ms
+            << " ms, utf8 lower: " << utf8_ms
+            << " ms, split+lower: " << split_ms
+            << " ms, hash bucket: " << hash_ms << " ms";
+}
+
+}  // namespace tests
+}  // namespace phi
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "paddle/pir/src/core/ir_allocator.h"
+
+// Every test uses its own sizes, so that the blocks freed by one test are
+// not reused by another one. The pool is bypassed with AddressSanitizer, so
+// the reuse is only checked without it.
+#if defined(__SANITIZE_ADDRESS__)
+#define IR_ALLOCATOR_POOLED 0
+#else
+#define IR_ALLOCATOR_POOLED 1
+#endif
+
+TEST(ir_allocator, reuse_same_size_class) {
+  void *ptr = pir::detail::IrAllocate(1000);
+  ASSERT_NE(ptr, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 16, 0u);
+  std::memset(ptr, 0xAB, 1000);
+  pir::detail::IrDeallocate(ptr, 1000);
+
+  // 995 and 1000 bytes are in the same 16-byte size class.
+  void *reused = pir::detail::IrAllocate(995);
+  if (IR_ALLOCATOR_POOLED) {
+    EXPECT_EQ(reused, ptr);
+  }
+  pir::detail::IrDeallocate(reused, 995);
+
+  // Larger than the biggest size class, not pooled.
+  void *large = pir::detail::IrAllocate(4096);
+  ASSERT_NE(large, nullptr);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % 16, 0u);
+  std::memset(large, 0xCD, 4096);
+  pir::detail::IrDeallocate(large, 4096);
+}
+
+TEST(ir_allocator, free_on_another_thread) {
+  const size_t size = 1500, num_blocks = 200;
+  std::vector<void *> blocks;
+  for (size_t i = 0; i < num_blocks; ++i) {
+    blocks.push_back(pir::detail::IrAllocate(size));
+    std::memset(blocks.back(), static_cast<int>(i), size);
+  }
+  std::set<void *> unique_blocks(blocks.begin(), blocks.end());
+  EXPECT_EQ(unique_blocks.size(), num_blocks);
+
+  std::thread freeing_thread([&] {
+    for (size_t i = 0; i < num_blocks; ++i) {
+      EXPECT_EQ(static_cast<unsigned char *>(blocks[i])[size - 1],
+                static_cast<unsigned char>(i));
+      pir::detail::IrDeallocate(blocks[i], size);
+    }
+  });
+  freeing_thread.join();
+
+  // The blocks freed by the other thread go back to the shared lists, in
+  // batches while it runs and the rest when it exits, so a new thread
+  // reuses them.
+  size_t num_reused = 0;
+  std::thread allocating_thread([&] {
+    std::vector<void *> new_blocks;
+    for (size_t i = 0; i < num_blocks / 2; ++i) {
+      new_blocks.push_back(pir::detail::IrAllocate(size));
+      num_reused += unique_blocks.count(new_blocks.back());
+    }
+    for (auto *block : new_blocks) {
+      pir::detail::IrDeallocate(block, size);
+    }
+  });
+  allocating_thread.join();
+  if (IR_ALLOCATOR_POOLED) {
+    EXPECT_EQ(num_reused, num_blocks / 2);
+  }
+}
+
+TEST(ir_allocator, flush_at_thread_exit) {
+  const size_t size = 1800, num_blocks = 10;
+  std::vector<void *> blocks;
+  // Too few blocks to be returned in a batch, they stay in the cache of
+  // the thread until it exits.
+  std::thread caching_thread([&] {
+    for (size_t i = 0; i < num_blocks; ++i) {
+      blocks.push_back(pir::detail::IrAllocate(size));
+    }
+    for (auto *block : blocks) {
+      pir::detail::IrDeallocate(block, size);
+    }
+  });
+  caching_thread.join();
+
+  std::set<void *> new_blocks;
+  std::thread allocating_thread([&] {
+    // Fetches the whole batch the first thread fetched.
+    std::vector<void *> allocated;
+    for (size_t i = 0; i < 4 * num_blocks; ++i) {
+      allocated.push_back(pir::detail::IrAllocate(size));
+    }
+    new_blocks.insert(allocated.begin(), allocated.end());
+    for (auto *block : allocated) {
+      pir::detail::IrDeallocate(block, size);
+    }
+  });
+  allocating_thread.join();
+  if (IR_ALLOCATOR_POOLED) {
+    for (auto *block : blocks) {
+      EXPECT_EQ(new_blocks.count(block), 1u);
+    }
+  }
+}
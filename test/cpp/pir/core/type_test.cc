@@ -12,8 +12,12 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
@@ -399,3 +403,48 @@ TEST(type_test, get_type_name) {
   auto name = pir::get_type_name<TestNamespace::TestClass>();
   EXPECT_EQ(name, "TestNamespace::TestClass");
 }
+
+TEST(type_test, multithread_uniquing_benchmark) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  pir::Type fp32_dtype = pir::Float32Type::get(ctx);
+  const int num_threads = 8;
+  const int num_shapes = 512;
+  const int num_rounds = 20;
+
+  // All the threads create the same types, most of them already exist after
+  // the first round.
+  std::vector<std::vector<pir::Type>> types(num_threads);
+  auto create_types = [&](int tid) {
+    for (int round = 0; round < num_rounds; ++round) {
+      types[tid].clear();
+      for (int i = 0; i < num_shapes; ++i) {
+        common::DDim dims = {(i + tid) % num_shapes + 1, 64};
+        pir::Type dense = pir::DenseTensorType::get(
+            ctx, fp32_dtype, dims, common::DataLayout::NCHW, {}, 0);
+        types[tid].push_back(pir::VectorType::get(ctx, {dense, fp32_dtype}));
+      }
+    }
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back(create_types, tid);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+
+  for (int tid = 1; tid < num_threads; ++tid) {
+    for (int i = 0; i < num_shapes; ++i) {
+      EXPECT_EQ(types[tid][i], types[0][(i + tid) % num_shapes]);
+    }
+  }
+  LOG(INFO) << num_threads << " threads created "
+            << num_threads * num_rounds * num_shapes * 2 << " types in " << ms
+            << " ms.";
+}
@@ -13,15 +13,24 @@
 // limitations under the License.
 
 #include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "glog/logging.h"
 
 // NOTE(zhangbo9674): File pd_op.h is generated by op_gen.py, see details in
 // paddle/fluid/pir/dialect/CMakeLists.txt.
 #include "paddle/fluid/pir/dialect/operator/interface/op_yaml_info.h"
+#include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
 #include "paddle/fluid/pir/dialect/operator/ir/op_type.h"
 #include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
 #include "paddle/fluid/pir/dialect/operator/utils/utils.h"
+#include "paddle/fluid/pir/transforms/general/identity_op_clean_pass.h"
+#include "paddle/fluid/pir/transforms/general/matmul_transpose_fuse_pass.h"
+#include "paddle/fluid/pir/transforms/general/remove_redundant_transpose_pass.h"
 #include "paddle/fluid/platform/errors.h"
 #include "paddle/phi/core/enforce.h"
 #include "paddle/phi/kernels/elementwise_add_kernel.h"
@@ -32,6 +41,8 @@
 #include "paddle/pir/include/core/ir_context.h"
 #include "paddle/pir/include/core/op_base.h"
 #include "paddle/pir/include/core/operation.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_dialect.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_op.h"
 #include "paddle/pir/include/pass/pass.h"
 #include "paddle/pir/include/pass/pass_manager.h"
 #include "test/cpp/pir/tools/macros_utils.h"
@@ -254,3 +265,251 @@ TEST(pass_manager, PassManager) {
 
   CHECK_EQ(pm.Run(&program), true);
 }
+
+// Erases the unused full ops in the branches of if ops but the first keep
+// ones of each branch.
+class EraseUnusedFullPass : public pir::Pass {
+ public:
+  explicit EraseUnusedFullPass(size_t keep)
+      : pir::Pass("erase_unused_full_pass", 1), keep_(keep) {}
+
+  std::unique_ptr<pir::Pass> Clone() const override {
+    return std::make_unique<EraseUnusedFullPass>(keep_);
+  }
+
+  void Run(pir::Operation *op) override {
+    int64_t num_erased = 0;
+    for (auto &region : *op) {
+      for (auto &block : region) {
+        std::vector<pir::Operation *> unused;
+        for (auto &inner_op : block) {
+          if (inner_op.isa<paddle::dialect::FullOp>() &&
+              inner_op.result(0).use_empty()) {
+            unused.push_back(&inner_op);
+          }
+        }
+        for (size_t i = keep_; i < unused.size(); ++i) {
+          block.erase(*unused[i]);
+          ++num_erased;
+        }
+      }
+    }
+    AddStatistics(num_erased);
+  }
+
+  bool CanApplyOn(pir::Operation *op) const override {
+    return op->isa<paddle::dialect::IfOp>();
+  }
+
+ private:
+  size_t keep_;
+};
+
+// num_ifs if ops with num_unused unused full ops in each branch, every two
+// of them use a same value from above.
+void BuildIfProgram(pir::Builder &builder,  // NOLINT
+                    int num_ifs,
+                    int num_unused) {
+  pir::Block *block = builder.block();
+  pir::Value shared;
+  for (int i = 0; i < num_ifs; ++i) {
+    builder.SetInsertionPointToBlockEnd(block);
+    auto cond = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{1}, true, phi::DataType::BOOL);
+    if (i % 2 == 0) {
+      shared = builder
+                   .Build<paddle::dialect::FullOp>(std::vector<int64_t>{2},
+                                                   1.0,
+                                                   phi::DataType::FLOAT32)
+                   .out();
+    }
+    auto if_op = builder.Build<paddle::dialect::IfOp>(
+        cond.out(), std::vector<pir::Type>{shared.type()});
+    for (auto *branch : {&if_op.true_block(), &if_op.false_block()}) {
+      builder.SetInsertionPointToStart(branch);
+      for (int j = 0; j < num_unused; ++j) {
+        builder.Build<paddle::dialect::FullOp>(
+            std::vector<int64_t>{2}, j, phi::DataType::FLOAT32);
+      }
+      auto scale = builder.Build<paddle::dialect::ScaleOp>(shared, 2.0, 0.0);
+      builder.Build<pir::YieldOp>(std::vector<pir::Value>{scale.out()});
+    }
+  }
+}
+
+double RunIfProgram(pir::Program *program, int num_threads) {
+  pir::PassManager pm(pir::IrContext::Instance());
+  pm.AddPass(std::make_unique<EraseUnusedFullPass>(/*keep=*/1));
+  pm.EnableParallel(num_threads);
+  pm.EnablePassTiming(true);
+  auto start = std::chrono::steady_clock::now();
+  CHECK_EQ(pm.Run(program), true);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+TEST(pass_manager, ParallelNestedPipelines) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::ControlFlowDialect>();
+  const int num_ifs = 200, num_unused = 50;
+
+  pir::Program sequential_program(ctx);
+  pir::Builder sequential_builder(ctx, sequential_program.block());
+  BuildIfProgram(sequential_builder, num_ifs, num_unused);
+  pir::Program parallel_program(ctx);
+  pir::Builder parallel_builder(ctx, parallel_program.block());
+  BuildIfProgram(parallel_builder, num_ifs, num_unused);
+
+  double sequential_sec = RunIfProgram(&sequential_program, 1);
+  double parallel_sec = RunIfProgram(&parallel_program, 4);
+
+  EXPECT_EQ(sequential_program.block()->size(),
+            parallel_program.block()->size());
+  for (auto &op : *parallel_program.block()) {
+    auto if_op = op.dyn_cast<paddle::dialect::IfOp>();
+    if (!if_op) continue;
+    // The kept full, the scale and the yield are left.
+    EXPECT_EQ(if_op.true_block().size(), 3u);
+    EXPECT_EQ(if_op.false_block().size(), 3u);
+  }
+  LOG(INFO) << num_ifs << " if ops, sequential: " << sequential_sec * 1000
+            << " ms, 4 threads: " << parallel_sec * 1000 << " ms";
+}
+
+// Inserts a full op before every if op, into the enclosing block, so it
+// can't be copied to run in parallel.
+class InsertFullBeforeIfPass : public pir::Pass {
+ public:
+  InsertFullBeforeIfPass() : pir::Pass("insert_full_before_if_pass", 1) {}
+
+  void Run(pir::Operation *op) override {
+    pir::Builder builder(pir::IrContext::Instance(), op->GetParent());
+    builder.set_insertion_point(op);
+    builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{2}, 0.0, phi::DataType::FLOAT32);
+  }
+
+  bool CanApplyOn(pir::Operation *op) const override {
+    return op->isa<paddle::dialect::IfOp>();
+  }
+};
+
+TEST(pass_manager, ParallelFallsBackForPassesNotCopied) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::ControlFlowDialect>();
+  const int num_ifs = 100;
+
+  pir::Program program(ctx);
+  pir::Builder builder(ctx, program.block());
+  BuildIfProgram(builder, num_ifs, 1);
+  size_t num_ops = program.block()->size();
+
+  pir::PassManager pm(ctx);
+  pm.AddPass(std::make_unique<InsertFullBeforeIfPass>());
+  pm.EnableParallel(4);
+  CHECK_EQ(pm.Run(&program), true);
+  EXPECT_EQ(program.block()->size(), num_ops + num_ifs);
+}
+
+// num_ifs if ops, whose branches have a transpose pair, a useless scale and
+// cast, and a matmul of a transposed input. The first transpose of the true
+// branch is in the enclosing block, and is erased by the rewrite of the
+// branch.
+void BuildFusibleIfProgram(pir::Builder &builder, int num_ifs) {  // NOLINT
+  pir::Block *block = builder.block();
+  for (int i = 0; i < num_ifs; ++i) {
+    builder.SetInsertionPointToBlockEnd(block);
+    auto cond = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{1}, true, phi::DataType::BOOL);
+    auto x = builder.Build<paddle::dialect::FullOp>(
+        std::vector<int64_t>{8, 8}, i, phi::DataType::FLOAT32);
+    auto transposed = builder.Build<paddle::dialect::TransposeOp>(
+        x.out(), std::vector<int>{1, 0});
+    auto if_op = builder.Build<paddle::dialect::IfOp>(
+        cond.out(), std::vector<pir::Type>{x.out().type()});
+    for (auto *branch : {&if_op.true_block(), &if_op.false_block()}) {
+      builder.SetInsertionPointToStart(branch);
+      pir::Value in = x.out();
+      if (branch == &if_op.true_block()) {
+        in = builder
+                 .Build<paddle::dialect::TransposeOp>(transposed.out(),
+                                                      std::vector<int>{1, 0})
+                 .out();
+      }
+      auto scale = builder.Build<paddle::dialect::ScaleOp>(in, 1.0, 0.0, true);
+      auto cast = builder.Build<paddle::dialect::CastOp>(
+          scale.out(), phi::DataType::FLOAT32);
+      auto weight = builder.Build<paddle::dialect::TransposeOp>(
+          cast.out(), std::vector<int>{1, 0});
+      auto matmul = builder.Build<paddle::dialect::MatmulOp>(
+          cast.out(), weight.out(), false, false);
+      builder.Build<pir::YieldOp>(std::vector<pir::Value>{matmul.out()});
+    }
+  }
+}
+
+double RunFusionPasses(pir::Program *program, int num_threads) {
+  pir::PassManager pm(pir::IrContext::Instance());
+  pm.AddPass(pir::CreateIdentityOpCleanPass());
+  pm.AddPass(pir::CreateRemoveRedundantTransposePass());
+  pm.AddPass(pir::CreateMatmulTransposeFusePass());
+  pm.EnableParallel(num_threads);
+  auto start = std::chrono::steady_clock::now();
+  CHECK_EQ(pm.Run(program), true);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// The names of the ops and the types of their operands, nested ops
+// included, in order.
+std::vector<std::string> DescribeOps(pir::Program *program) {
+  std::vector<std::string> ops;
+  program->module_op()->Walk([&](pir::Operation *op) {
+    std::ostringstream os;
+    os << op->name();
+    for (auto value : op->operands_source()) {
+      os << " " << value.type();
+    }
+    ops.push_back(os.str());
+  });
+  return ops;
+}
+
+TEST(pass_manager, ParallelFusionPasses) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::ControlFlowDialect>();
+  const int num_ifs = 500;
+
+  pir::Program sequential_program(ctx);
+  pir::Builder sequential_builder(ctx, sequential_program.block());
+  BuildFusibleIfProgram(sequential_builder, num_ifs);
+  pir::Program parallel_program(ctx);
+  pir::Builder parallel_builder(ctx, parallel_program.block());
+  BuildFusibleIfProgram(parallel_builder, num_ifs);
+
+  double sequential_sec = RunFusionPasses(&sequential_program, 1);
+  double parallel_sec = RunFusionPasses(&parallel_program, 4);
+
+  EXPECT_EQ(DescribeOps(&sequential_program), DescribeOps(&parallel_program));
+  for (auto &op : *parallel_program.block()) {
+    // erased after the branch was rewritten
+    EXPECT_FALSE(op.isa<paddle::dialect::TransposeOp>());
+    auto if_op = op.dyn_cast<paddle::dialect::IfOp>();
+    if (!if_op) continue;
+    for (auto *branch : {&if_op.true_block(), &if_op.false_block()}) {
+      for (auto &inner_op : *branch) {
+        EXPECT_FALSE(inner_op.isa<paddle::dialect::TransposeOp>());
+        EXPECT_FALSE(inner_op.isa<paddle::dialect::ScaleOp>());
+        EXPECT_FALSE(inner_op.isa<paddle::dialect::CastOp>());
+      }
+    }
+  }
+  LOG(INFO) << num_ifs << " if ops, fusion passes sequential: "
+            << sequential_sec * 1000 << " ms, 4 threads: "
+            << parallel_sec * 1000 << " ms";
+}
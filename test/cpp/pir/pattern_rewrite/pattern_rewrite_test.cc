@@ -12,7 +12,9 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <chrono>  // NOLINT
 #include <cstdint>
 #include <iostream>
 #include <memory>
@@ -429,6 +431,139 @@ TEST(pattern_rewrite, Patterns) {
   EXPECT_EQ(program.block()->size(), 17u);
 }
 
+// Runs TestPass and Conv2dBnFusePass one after another or combined, then
+// the other passes of the Patterns test, and returns the seconds taken.
+double RunCombinablePasses(pir::Program *program, bool combine) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  pir::PassManager pm(ctx);
+  if (combine) {
+    std::vector<std::unique_ptr<pir::Pass>> passes;
+    passes.push_back(std::make_unique<TestPass>());
+    passes.push_back(pir::CreateConv2dBnFusePass());
+    pm.AddPass(
+        std::make_unique<pir::CombinedPatternRewritePass>(std::move(passes)));
+  } else {
+    pm.AddPass(std::make_unique<TestPass>());
+    pm.AddPass(pir::CreateConv2dBnFusePass());
+  }
+  pm.AddPass(pir::CreateConv2dAddActFusePass());
+  pm.AddPass(pir::CreateConv2dAddFusePass());
+  std::unique_ptr<pir::Pass> constant_folding_pass =
+      pir::CreateConstantFoldingPass();
+  phi::Place place = phi::CPUPlace();
+  constant_folding_pass->SetNotOwned(pir::Pass::kPlaceAttr, &place);
+  constant_folding_pass->Set(pir::Pass::kParamScopeAttr,
+                             new paddle::framework::Scope());
+  pm.AddPass(std::move(constant_folding_pass));
+  pm.AddPass(pir::CreateDeadCodeEliminationPass());
+
+  auto start = std::chrono::steady_clock::now();
+  CHECK_EQ(pm.Run(program), true);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+TEST(pattern_rewrite, CombinedPatterns) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+
+  pir::Program sequential_program(ctx);
+  pir::Builder sequential_builder(ctx, sequential_program.block());
+  BuildProgram(sequential_builder);
+  pir::Program combined_program(ctx);
+  pir::Builder combined_builder(ctx, combined_program.block());
+  BuildProgram(combined_builder);
+  EXPECT_EQ(combined_program.block()->size(), 27u);
+
+  // The patterns of the two passes have different root ops, so matching
+  // them in one traversal gives the same program as running the passes one
+  // after another.
+  double sequential_sec = RunCombinablePasses(&sequential_program, false);
+  double combined_sec = RunCombinablePasses(&combined_program, true);
+
+  ASSERT_EQ(combined_program.block()->size(), 17u);
+  ASSERT_EQ(sequential_program.block()->size(),
+            combined_program.block()->size());
+  auto sequential_it = sequential_program.block()->begin();
+  for (auto &op : *combined_program.block()) {
+    auto &sequential_op = *sequential_it++;
+    EXPECT_EQ(sequential_op.name(), op.name());
+    ASSERT_EQ(sequential_op.num_operands(), op.num_operands());
+    for (uint32_t i = 0; i < op.num_operands(); ++i) {
+      EXPECT_EQ(sequential_op.operand_source(i).type(),
+                op.operand_source(i).type());
+    }
+  }
+  LOG(INFO) << "Passes one after another: " << sequential_sec * 1000
+            << " ms, combined: " << combined_sec * 1000 << " ms";
+}
+
+class BottomUpTestPass : public TestPass {
+ public:
+  pir::GreedyRewriteConfig InitializeConfig() override {
+    pir::GreedyRewriteConfig config;
+    config.max_iterations = 20;
+    return config;
+  }
+};
+
+TEST(pattern_rewrite, CombinedPatternsConfig) {
+  // The passes traversing the ops in another order can't be combined.
+  std::vector<std::unique_ptr<pir::Pass>> passes;
+  passes.push_back(std::make_unique<TestPass>());
+  passes.push_back(std::make_unique<BottomUpTestPass>());
+  EXPECT_THROW(pir::CombinedPatternRewritePass(std::move(passes)),
+               common::enforce::EnforceNotMet);
+}
+
+TEST(pattern_rewrite, ChangeDrivenWorklist) {
+  pir::IrContext *ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+
+  // A chain of transposes, every rewrite makes the next one match.
+  pir::Program program(ctx);
+  pir::Builder builder = pir::Builder(ctx, program.block());
+  pir::Value x = builder
+                     .Build<paddle::dialect::FullOp>(
+                         std::vector<int64_t>{4, 3, 16, 16},
+                         1.5,
+                         phi::DataType::FLOAT32,
+                         phi::CPUPlace())
+                     .out();
+  for (int i = 0; i < 8; ++i) {
+    x = builder
+            .Build<paddle::dialect::TransposeOp>(
+                x,
+                i % 2 ? std::vector<int>{0, 3, 1, 2}
+                      : std::vector<int>{0, 2, 3, 1})
+            .out();
+  }
+  builder.Build<paddle::dialect::FetchOp>(x, "out", 0);
+
+  pir::RewritePatternSet ps(ctx);
+  ps.Add<RedundantTransposeFusePattern>(ctx);
+  pir::FrozenRewritePatternSet patterns(std::move(ps));
+  pir::GreedyRewriteConfig config;
+  config.use_top_down_traversal = true;
+  config.use_change_driven_worklist = true;
+  auto [converged, num_rewrites] =
+      pir::ApplyPatternsGreedily(program.module_op(), patterns, config);
+  EXPECT_TRUE(converged);
+  EXPECT_EQ(num_rewrites, 7);
+
+  size_t num_transposes = 0;
+  for (auto &op : *program.block()) {
+    if (op.isa<paddle::dialect::TransposeOp>() && !op.result(0).use_empty()) {
+      ++num_transposes;
+    }
+  }
+  EXPECT_EQ(num_transposes, 1u);
+}
+
 void BuildConstantFoldingProgram(pir::Program *program,
                                  pir::IrContext *ctx,
                                  paddle::framework::Scope *scope) {
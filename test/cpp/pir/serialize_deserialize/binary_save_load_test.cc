@@ -0,0 +1,223 @@
+// Copyright (c) 2024 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/pir/dialect/operator/ir/control_flow_op.h"
+#include "paddle/fluid/pir/dialect/operator/ir/op_dialect.h"
+#include "paddle/fluid/pir/dialect/operator/ir/pd_op.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/interface.h"
+#include "paddle/fluid/pir/serialize_deserialize/include/ir_deserialize.h"
+#include "paddle/pir/include/core/builtin_attribute.h"
+#include "paddle/pir/include/core/builtin_dialect.h"
+#include "paddle/pir/include/core/builtin_op.h"
+#include "paddle/pir/include/core/operation.h"
+#include "paddle/pir/include/core/program.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_dialect.h"
+#include "paddle/pir/include/dialect/control_flow/ir/cf_op.h"
+
+namespace {
+
+pir::IrContext* InitContext() {
+  pir::IrContext* ctx = pir::IrContext::Instance();
+  ctx->GetOrRegisterDialect<paddle::dialect::OperatorDialect>();
+  ctx->GetOrRegisterDialect<pir::BuiltinDialect>();
+  ctx->GetOrRegisterDialect<pir::ControlFlowDialect>();
+  return ctx;
+}
+
+// A chain of adds of num_ops constants to a parameter.
+void BuildProgram(pir::IrContext* ctx, pir::Program* program, int num_ops) {
+  pir::Builder builder = pir::Builder(ctx, program->block());
+  std::vector<int64_t> shape = {64, 64};
+  auto full = builder.Build<paddle::dialect::FullOp>(shape, 1.0);
+  auto parameter = builder.Build<pir::ParameterOp>("w", full.out().type());
+  pir::Value x = parameter.result(0);
+  for (int i = 0; i < num_ops; ++i) {
+    auto y = builder.Build<paddle::dialect::FullOp>(shape, i % 16);
+    x = builder.Build<paddle::dialect::AddOp>(x, y.out()).out();
+  }
+  builder.Build<pir::ShadowOutputOp>(x, "out");
+}
+
+void ExpectSamePrograms(const pir::Program& expected,
+                        const pir::Program& actual) {
+  ASSERT_EQ(expected.block()->size(), actual.block()->size());
+  auto actual_it = actual.block()->begin();
+  for (auto& op : *expected.block()) {
+    const pir::Operation& actual_op = *actual_it++;
+    EXPECT_EQ(op.name(), actual_op.name());
+    ASSERT_EQ(op.num_results(), actual_op.num_results());
+    for (uint32_t i = 0; i < op.num_results(); ++i) {
+      EXPECT_EQ(op.result(i).type(), actual_op.result(i).type());
+    }
+    ASSERT_EQ(op.num_operands(), actual_op.num_operands());
+    for (auto& [name, attr] : actual_op.attributes()) {
+      if (name != "op_callstack") {
+        EXPECT_EQ(op.attribute(name), attr) << op.name() << " " << name;
+      }
+    }
+  }
+}
+
+double LoadSeconds(const std::string& file_path, pir::Program* program) {
+  auto start = std::chrono::steady_clock::now();
+  pir::ReadModule(file_path, program, /*pir_version*/ 1);
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// An if op whose blocks use a value defined before it, followed by adds
+// using values defined before and by the if op.
+void BuildIfProgram(pir::IrContext* ctx, pir::Program* program) {
+  pir::Builder builder = pir::Builder(ctx, program->block());
+  std::vector<int64_t> shape = {4};
+  auto x = builder.Build<paddle::dialect::FullOp>(shape, 1.0).out();
+  auto cond = builder
+                  .Build<paddle::dialect::FullOp>(
+                      std::vector<int64_t>{1}, true, phi::DataType::BOOL)
+                  .out();
+  auto if_op = builder.Build<paddle::dialect::IfOp>(
+      cond, std::vector<pir::Type>{x.type()});
+  for (auto* block : {&if_op.true_block(), &if_op.false_block()}) {
+    builder.SetInsertionPointToStart(block);
+    auto y = builder.Build<paddle::dialect::FullOp>(shape, 2.0).out();
+    auto z = builder.Build<paddle::dialect::AddOp>(x, y).out();
+    builder.Build<pir::YieldOp>(std::vector<pir::Value>{z});
+  }
+  builder.SetInsertionPointToBlockEnd(program->block());
+  auto w = builder.Build<paddle::dialect::AddOp>(x, if_op.result(0)).out();
+  builder.Build<pir::ShadowOutputOp>(w, "out");
+}
+
+const std::string& file_path) {
+  std::ifstream f(file_path, std::ios::binary | std::ios::ate);
+  return static_cast<size_t>(f.tellg());
+}
+
+}  // namespace
+
+TEST(BinarySaveLoadTest, same_as_json) {
+  pir::IrContext* ctx = InitContext();
+  pir::Program program(ctx);
+  BuildProgram(ctx, &program, 2000);
+
+  pir::WriteModule(program, "./test_json_program", 1, true, false, true);
+  pir::WriteModule(
+      program, "./test_binary_program", 1, true, false, true, true);
+
+  pir::Program json_program(ctx);
+  double json_sec = LoadSeconds("./test_json_program", &json_program);
+  pir::Program binary_program(ctx);
+  double binary_sec = LoadSeconds("./test_binary_program", &binary_program);
+
+  ExpectSamePrograms(program, binary_program);
+  ExpectSamePrograms(json_program, binary_program);
+
+  size_t json_size = FileSize("./test_json_program");
+  size_t binary_size = FileSize("./test_binary_program");
+  EXPECT_LT(binary_size, json_size);
+  LOG(INFO) << program.block()->size() << " ops, json: " << json_size
+            << " bytes loaded in " << json_sec * 1000
+            << " ms, binary: " << binary_size << " bytes loaded in "
+            << binary_sec * 1000 << " ms";
+}
+
+TEST(BinarySaveLoadTest, patch_older_version) {
+  pir::IrContext* ctx = InitContext();
+  pir::Program program(ctx);
+  BuildProgram(ctx, &program, 4);
+  auto data = pir::Builder(ctx, program.block())
+                  .Build<paddle::dialect::DataOp>("x",
+                                                  std::vector<int64_t>{4},
+                                                  phi::DataType::FLOAT32,
+                                                  phi::CPUPlace());
+  data->set_attribute(
+      "stop_gradient",
+      pir::ArrayAttribute::get(ctx, {pir::BoolAttribute::get(ctx, true)}));
+
+  pir::WriteModule(program, "./test_binary_v0", 0, true, false, true, true);
+  pir::Program new_program(ctx);
+  EXPECT_TRUE(pir::ReadModule("./test_binary_v0", &new_program, 1));
+
+  // the op patches of patch.yaml
+  for (auto& op : *new_program.block()) {
+    if (op.isa<pir::ParameterOp>()) {
+      EXPECT_EQ(op.attribute<pir::StrAttribute>("parameter_name").AsString(),
+                "fc_0");
+    } else if (op.isa<paddle::dialect::DataOp>()) {
+      auto stop_gradient = op.attribute<pir::ArrayAttribute>("stop_gradient");
+      EXPECT_FALSE(stop_gradient.at(0).dyn_cast<pir::BoolAttribute>().data());
+    }
+  }
+}
+
+TEST(BinarySaveLoadTest, lazy_regions) {
+  pir::IrContext* ctx = InitContext();
+  pir::Program program(ctx);
+  BuildIfProgram(ctx, &program);
+  pir::WriteModule(program, "./test_binary_if", 1, true, false, true, true);
+
+  std::ifstream f("./test_binary_if", std::ios::binary);
+  std::string data((std::istreambuf_iterator<char>(f)),
+                   std::istreambuf_iterator<char>());
+  pir::BinaryProgramReader reader(1, data);
+  pir::PatchBuilder builder(1);
+  pir::Program new_program(ctx);
+  reader.RecoverProgram(&new_program, &builder, /*lazy_regions*/ true);
+  ExpectSamePrograms(program, new_program);
+
+  // The ops after the if op are read right without its regions.
+  EXPECT_EQ(reader.num_lazy_regions(), 2u);
+  std::vector<pir::Operation*> ops;
+  for (auto& op : *new_program.block()) {
+    ops.push_back(&op);
+  }
+  auto if_op = ops[2]->dyn_cast<paddle::dialect::IfOp>();
+  ASSERT_TRUE(if_op);
+  EXPECT_TRUE(if_op->region(0).empty());
+  auto add = ops[3]->dyn_cast<paddle::dialect::AddOp>();
+  ASSERT_TRUE(add);
+  EXPECT_EQ(add.x(), ops[0]->result(0));
+  EXPECT_EQ(add.y(), if_op.result(0));
+
+  reader.ReadLazyRegions();
+  EXPECT_EQ(reader.num_lazy_regions(), 0u);
+  for (auto* block : {&if_op.true_block(), &if_op.false_block()}) {
+    ASSERT_EQ(block->size(), 3u);
+    auto block_add =
+        std::next(block->begin())->dyn_cast<paddle::dialect::AddOp>();
+    ASSERT_TRUE(block_add);
+    EXPECT_EQ(block_add.x(), ops[0]->result(0));
+    EXPECT_EQ(block_add.y(), block->front().result(0));
+    EXPECT_EQ(block->back().operand_source(0), block_add.out());
+  }
+
+  // The full read gives the same program.
+  pir::Program full_program(ctx);
+  pir::ReadModule("./test_binary_if", &full_program, 1);
+  ExpectSamePrograms(program, full_program);
+  auto full_if = std::next(full_program.block()->begin(), 2)
+                     ->dyn_cast<paddle::dialect::IfOp>();
+  ASSERT_TRUE(full_if);
+  EXPECT_EQ(full_if.true_block().size(), 3u);
+  EXPECT_EQ(full_if.false_block().size(), 3u);
+}
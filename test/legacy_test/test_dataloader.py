@@ -115,5 +115,49 @@ class TestDygraphDataLoader(unittest.TestCase):
             self.iter_loader_data(loader)
 
 
+class SequenceDataset(Dataset):
+    def __init__(self, num_samples):
+        self.num_samples = num_samples
+
+    def __getitem__(self, idx):
+        image = np.full([IMAGE_SIZE], idx, dtype='float32')
+        label = np.array([idx], dtype='int64')
+        return image, label
+
+    def __len__(self):
+        return self.num_samples
+
+
+class TestPipelinedReaderDataLoader(unittest.TestCase):
+    def setUp(self):
+        paddle.set_flags({'FLAGS_reader_pipeline_num_workers': 2})
+
+    def tearDown(self):
+        paddle.set_flags({'FLAGS_reader_pipeline_num_workers': 0})
+
+    def test_keep_order(self):
+        with base.dygraph.guard(paddle.CPUPlace()):
+            loader = DataLoader(
+                SequenceDataset(BATCH_NUM * BATCH_SIZE),
+                batch_size=BATCH_SIZE,
+                shuffle=False,
+                drop_last=True,
+                use_buffer_reader=True,
+                num_workers=0,
+            )
+            for _ in range(EPOCH_NUM):
+                batch_num = 0
+                for i, (image, label) in enumerate(loader()):
+                    expected = np.arange(
+                        i * BATCH_SIZE, (i + 1) * BATCH_SIZE
+                    ).reshape([BATCH_SIZE, 1])
+                    np.testing.assert_array_equal(label.numpy(), expected)
+                    np.testing.assert_array_equal(
+                        image.numpy()[:, :1], expected.astype('float32')
+                    )
+                    batch_num += 1
+                self.assertEqual(batch_num, BATCH_NUM)
+
+
 if __name__ == '__main__':
     unittest.main()